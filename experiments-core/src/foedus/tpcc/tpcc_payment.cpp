@@ -59,7 +59,8 @@ ErrorCode TpccClientTask::do_payment(Wid c_wid) {
   const WarehouseStaticData* w_record = reinterpret_cast<const WarehouseStaticData*>(w_address);
 
   // UPDATE WAREHOUSE SET YTD=YTD+amount
-  CHECK_ERROR_CODE(storages_.warehouses_ytd_.increment_record_oneshot<double>(
+  // YTD is only incremented in TPC-C, so it's a split counter that doesn't lock the record.
+  CHECK_ERROR_CODE(storages_.warehouses_ytd_.increment_record_split<double>(
     context_,
     wid,
     amount,
@@ -74,7 +75,7 @@ ErrorCode TpccClientTask::do_payment(Wid c_wid) {
   const DistrictStaticData* d_record = reinterpret_cast<const DistrictStaticData*>(d_address);
 
   // UPDATE DISTRICT SET YTD=YTD+amount
-  CHECK_ERROR_CODE(storages_.districts_ytd_.increment_record_oneshot<double>(
+  CHECK_ERROR_CODE(storages_.districts_ytd_.increment_record_split<double>(
     context_,
     wdid,
     amount,
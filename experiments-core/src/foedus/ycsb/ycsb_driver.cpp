@@ -127,6 +127,11 @@ DEFINE_bool(force_canonical_xlocks_in_precommit, true,
   "Whether precommit always releases all locks that violate canonical mode before taking X-locks");
 DEFINE_bool(enable_retrospective_lock_list, true, "Whether to use RLL after aborts");
 DEFINE_bool(extended_rw_lock, false, "whether to use the extended RW lock implementation");
+DEFINE_bool(cohort_rw_lock, false, "whether to use the simple RW lock with NUMA-cohort handoffs."
+  " Ignored if extended_rw_lock is set");
+DEFINE_bool(non_canonical_wait_die, false,
+  "Whether a non-canonical lock request waits (after restoring canonical mode) if the"
+  " transaction is older than the queued ones, rather than immediately aborting");
 
 DEFINE_bool(aggressive_release, true, "Enable aggressive lock-release to restore canonical mode");
 
@@ -323,8 +328,11 @@ int driver_main(int argc, char **argv) {
 
   options.xct_.force_canonical_xlocks_in_precommit_ = FLAGS_force_canonical_xlocks_in_precommit;
   options.xct_.enable_retrospective_lock_list_ = FLAGS_enable_retrospective_lock_list;
+  options.xct_.enable_non_canonical_wait_die_ = FLAGS_non_canonical_wait_die;
   if (FLAGS_extended_rw_lock) {
     options.xct_.mcs_implementation_type_ = xct::XctOptions::kMcsImplementationTypeExtended;
+  } else if (FLAGS_cohort_rw_lock) {
+    options.xct_.mcs_implementation_type_ = xct::XctOptions::kMcsImplementationTypeSimpleCohort;
   } else {
     options.xct_.mcs_implementation_type_ = xct::XctOptions::kMcsImplementationTypeSimple;
   }
@@ -333,6 +341,7 @@ int driver_main(int argc, char **argv) {
     << " enable_retrospective_lock_list: " << FLAGS_enable_retrospective_lock_list
     << " mcs_implementation_type_: " << options.xct_.mcs_implementation_type_
     << " aggressive_release: " << FLAGS_aggressive_release
+    << " non_canonical_wait_die: " << FLAGS_non_canonical_wait_die
     << std::endl;
 
   std::cout << "sort keys before accessing: " << FLAGS_sort_keys << std::endl;
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_ASSORTED_CRC32C_HPP_
+#define FOEDUS_ASSORTED_CRC32C_HPP_
+
+#include <stdint.h>
+
+namespace foedus {
+namespace assorted {
+
+/**
+ * @brief Computes CRC32C (Castagnoli polynomial, as in iSCSI/ext4) of the given bytes.
+ * @param[in] data bytes to checksum
+ * @param[in] length byte length of data
+ * @param[in] crc CRC32C of the bytes that precede data, or 0 to start a new checksum.
+ * Passing the result of a previous call lets the caller checksum discontiguous ranges.
+ * @return CRC32C of the bytes so far
+ * @ingroup ASSORTED
+ * @details
+ * On x86_64 CPUs with SSE4.2 this uses the crc32 instruction, which processes 8 bytes per
+ * cycle or so. Otherwise (or on other architectures) it falls back to a table-based software
+ * implementation. The choice is made once at runtime, so we don't need -msse4.2.
+ */
+uint32_t crc32c(const void* data, uint64_t length, uint32_t crc = 0);
+
+}  // namespace assorted
+}  // namespace foedus
+
+#endif  // FOEDUS_ASSORTED_CRC32C_HPP_
@@ -95,6 +95,32 @@ struct CacheOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   float       snapshot_cache_urgent_threshold_;
 
+  /**
+   * @brief Whether to read snapshot files through read-only memory mappings.
+   * @details
+   * Snapshot files are immutable once written, so each thread can mmap them and read pages
+   * by pointer instead of issuing a read() into a buffer for each page.
+   * This pays off when snapshot files fit in the OS page cache or live on tmpfs/NVM.
+   * When the snapshot cache is disabled, snapshot pages are then exposed directly from the
+   * mapping without any copy. When it is enabled, cache misses are served by a memcpy from the
+   * mapping instead of a read() syscall.
+   * Sequential scans also give madvise() hints to the kernel on the range they will read.
+   * Default is OFF.
+   */
+  bool        snapshot_file_mmap_;
+
+  /**
+   * @brief Whether to verify the checksum of each snapshot page read from snapshot files.
+   * @details
+   * SnapshotWriter always stores CRC32C of each page in PageHeader::checksum_.
+   * When this is ON, SnapshotFileSet recomputes it for every page it reads (or exposes from
+   * the mapping) and returns kErrorCodeCacheChecksumMismatch if they differ.
+   * CRC32C uses the hardware instruction when available, so the overhead is small compared to
+   * the I/O itself, but it still touches every byte of the page.
+   * Default is OFF.
+   */
+  bool        verify_snapshot_checksum_;
+
   EXTERNALIZABLE(CacheOptions);
 };
 }  // namespace cache
@@ -18,8 +18,11 @@
 #ifndef FOEDUS_CACHE_SNAPSHOT_FILE_SET_HPP_
 #define FOEDUS_CACHE_SNAPSHOT_FILE_SET_HPP_
 
+#include <stdint.h>
+
 #include <iosfwd>
 #include <map>
+#include <vector>
 
 #include "foedus/cxx11.hpp"
 #include "foedus/fwd.hpp"
@@ -45,6 +48,21 @@ namespace cache {
  * This design might hit the maximum number of file descriptors per process.
  * Check cat /proc/sys/fs/file-max if that happens. Google how to change it (soft AND hard limits).
  *
+ * @par Memory-mapped mode
+ * When CacheOptions::snapshot_file_mmap_ is ON, this object also maps each snapshot file
+ * when it opens the file. The mapping is private (copy-on-write) and writable because pages
+ * are handed out as non-const storage::Page*, so a stray write modifies only this process's
+ * copy instead of faulting. Reads are then served from the mapping, and
+ * get_mapped_pages() exposes pages by pointer without any copy. Snapshot files are immutable
+ * once they are written, so the mappings never need invalidation. If a page is beyond the
+ * mapped length, we map the file again with the current length. The old mapping stays until
+ * close_all() because pointers into it might be still in use. If the mmap failed, we silently
+ * fall back to usual reads.
+ *
+ * @par Checksum verification
+ * When CacheOptions::verify_snapshot_checksum_ is ON, every page this object reads or exposes
+ * is verified against PageHeader::checksum_, which SnapshotWriter computed before writing it.
+ *
  * @todo So far we really use std::map. But, this is not ideal in terms of performance.
  * node-id is up to 256, snapshots are almost always very few, so we can do array-based
  * something.
@@ -77,11 +95,54 @@ class SnapshotFileSet CXX11_FINAL : public DefaultInitializable {
   /** Read contiguous pages in one shot */
   ErrorCode read_pages(storage::SnapshotPagePointer page_id_begin, uint32_t page_count, void* out);
 
+  /** Whether this object maps snapshot files into memory. */
+  bool      is_mmap_enabled() const { return mmap_enabled_; }
+  /**
+   * @brief Returns a pointer to contiguous pages in the read-only mapping of the snapshot file.
+   * @param[in] page_id_begin first page to retrieve
+   * @param[in] page_count number of contiguous pages to retrieve
+   * @param[in] sequential whether the caller will sequentially read the pages. If true, we
+   * give madvise() hints to the kernel on the range.
+   * @param[out] out pointer to the first page. nullptr if the mmap mode is disabled or the range
+   * is not mapped, in which case the caller should use read_pages() instead.
+   * @details
+   * The returned pages must not be modified. They are valid until this object closes the files.
+   */
+  ErrorCode get_mapped_pages(
+    storage::SnapshotPagePointer page_id_begin,
+    uint32_t page_count,
+    bool sequential,
+    const storage::Page** out);
+
   friend std::ostream&    operator<<(std::ostream& o, const SnapshotFileSet& v);
 
  private:
+  /** A read-only mapping of one snapshot file. */
+  struct MappedFile {
+    const char* address_;
+    uint64_t    size_;
+  };
+
   Engine* const engine_;
+  const bool    mmap_enabled_;
+  const bool    verify_checksum_;
   std::map<snapshot::SnapshotId, std::map< thread::ThreadGroupId, fs::DirectIoFile* > > files_;
+  /** Mappings of the files in files_. Used only when mmap_enabled_. */
+  std::map<snapshot::SnapshotId, std::map< thread::ThreadGroupId, MappedFile > > mappings_;
+  /**
+   * Mappings we replaced with larger ones because the file grew. Pages in them might be still
+   * in use by the caller, so we unmap them only in close_all().
+   */
+  std::vector<MappedFile> retired_mappings_;
+
+  void      map_file(
+    snapshot::SnapshotId snapshot_id,
+    thread::ThreadGroupId node_id,
+    fs::DirectIoFile* file);
+  /** @return address of the given pages in the mapping, nullptr if not mapped */
+  const char* find_mapped(storage::SnapshotPagePointer page_id_begin, uint32_t page_count);
+  /** @return kErrorCodeCacheChecksumMismatch if any of the pages has a wrong checksum */
+  ErrorCode verify_checksums(const storage::Page* pages, uint32_t page_count) const;
 };
 }  // namespace cache
 }  // namespace foedus
@@ -34,6 +34,7 @@ class   LogManager;
 struct  LogManagerControlBlock;
 class   LogManagerPimpl;
 struct  LogOptions;
+class   LogSubscriber;
 class   Logger;
 class   LoggerRef;
 struct  LoggerControlBlock;
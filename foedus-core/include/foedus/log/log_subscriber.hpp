@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_LOG_LOG_SUBSCRIBER_HPP_
+#define FOEDUS_LOG_LOG_SUBSCRIBER_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/initializable.hpp"
+#include "foedus/log/epoch_history.hpp"
+#include "foedus/log/fwd.hpp"
+#include "foedus/log/log_id.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/storage/storage_id.hpp"
+
+namespace foedus {
+namespace log {
+/**
+ * @brief Delivers committed record logs of chosen storages in epoch order once they are durable.
+ * @ingroup LOG
+ * @details
+ * This is a change-data-capture interface for downstream systems. It reads the log files
+ * the loggers wrote, so it needs neither polling storages nor a separate scan-and-diff.
+ * Each next_epoch() call delivers all record logs of the chosen storages in the next durable
+ * epoch that has any. Within the epoch, logs are sorted by XctId, which is a valid
+ * serialization order. Logs of one transaction stay in the order they were written.
+ * @code{.cpp}
+ * LogSubscriber subscriber(engine, last_epoch_we_exported);
+ * subscriber.add_storage(orders.get_id());
+ * CHECK_ERROR(subscriber.initialize());
+ * while (true) {
+ *   ErrorCode code = subscriber.next_epoch(1000000);
+ *   if (code == kErrorCodeTimeout) { continue; }
+ *   for (uint32_t i = 0; i < subscriber.get_log_count(); ++i) {
+ *     export_change(subscriber.get_log(i));
+ *   }
+ *   persist_export_and(subscriber.get_consumed_epoch());
+ * }
+ * @endcode
+ *
+ * @par Resuming
+ * get_consumed_epoch() is the last epoch delivered (or skipped for having no logs). Save it
+ * with the exported data, and give it to the constructor to resume from the next epoch.
+ *
+ * This works after restart, too. Loggers keep their epoch histories only in memory, so
+ * after restart they know nothing about the logs written before it. If the consumed epoch is
+ * older than the durable epoch at restart, initialize() reads the log files written before
+ * restart once and rebuilds their epoch markers. This takes a while if there are many logs
+ * before restart. If the log files no longer have the logs right after the consumed epoch,
+ * initialize() fails with kErrorCodeLogSubscriberEpochUnavailable rather than silently
+ * skipping them.
+ *
+ * @par Memory and backpressure
+ * The subscriber reads log files only when next_epoch() is called, so a slow subscriber never
+ * slows down loggers or transactions. Logs just wait in the files until the subscriber catches
+ * up. The subscriber copies the chosen logs of one epoch into a buffer of a fixed size.
+ * If they don't fit, next_epoch() returns kErrorCodeLogSubscriberBufferTooSmall without
+ * consuming the epoch. Retry it with a subscriber of a larger buffer.
+ *
+ * This object is not thread-safe. Use it from one thread while the engine is running.
+ */
+class LogSubscriber CXX11_FINAL : public DefaultInitializable {
+ public:
+  enum Constants {
+    /** Default size of the buffer for the logs of one epoch. */
+    kDefaultBufferSize = 1 << 24,
+    /** Size of each read from log files. */
+    kIoBufferSize = 1 << 20,
+  };
+
+  /**
+   * @param[in] engine the engine whose logs we read
+   * @param[in] consumed_epoch logs upto this epoch are skipped. Invalid to read all logs.
+   * @param[in] buffer_size byte size of the buffer for the logs of one epoch
+   */
+  LogSubscriber(Engine* engine, Epoch consumed_epoch, uint64_t buffer_size = kDefaultBufferSize);
+
+  ErrorStack  initialize_once() CXX11_OVERRIDE;
+  ErrorStack  uninitialize_once() CXX11_OVERRIDE;
+
+  /**
+   * Adds a storage to receive logs of. If no storage is added, logs of all storages are
+   * delivered.
+   */
+  void        add_storage(storage::StorageId storage_id);
+
+  /**
+   * @brief Delivers the logs of the next durable epoch that has any logs of the storages.
+   * @param[in] wait_microseconds if we have consumed all durable epochs, waits for the
+   * durable epoch to advance for this duration. Same as LogManager::wait_until_durable().
+   * @return kErrorCodeTimeout if there was no logs to deliver within the duration,
+   * kErrorCodeLogSubscriberBufferTooSmall if the logs didn't fit in the buffer.
+   * @details
+   * Logs of the previous call are released. When this returns kErrorCodeOk, get_epoch()
+   * is the epoch of the delivered logs, and get_consumed_epoch() is the same epoch.
+   */
+  ErrorCode   next_epoch(int64_t wait_microseconds = -1);
+
+  /** Epoch of the logs delivered by the last next_epoch(). */
+  Epoch       get_epoch() const { return epoch_; }
+  /** Logs upto this epoch are consumed. Give this to the constructor to resume. */
+  Epoch       get_consumed_epoch() const { return consumed_epoch_; }
+  /** Number of logs delivered by the last next_epoch(). */
+  uint32_t    get_log_count() const { return log_offsets_.size(); }
+  /** Returns the log of the index. It is valid until the next next_epoch() call. */
+  const LogHeader* get_log(uint32_t index) const {
+    ASSERT_ND(index < log_offsets_.size());
+    return reinterpret_cast<const LogHeader*>(
+      reinterpret_cast<const char*>(buffer_.get_block()) + log_offsets_[index]);
+  }
+
+ private:
+  /** @return the first epoch after consumed_epoch_ with logs upto durable_epoch, or invalid */
+  Epoch       find_next_epoch(Epoch durable_epoch) const;
+  /** Reads the logs of the epoch from all loggers into buffer_ and sorts them. */
+  ErrorCode   read_epoch(Epoch epoch);
+  /**
+   * Reads the log files of the logger written before restart and collects the epoch markers
+   * into restart_histories_.
+   */
+  ErrorStack  restore_restart_history(LoggerId logger_id);
+  /** Same as LoggerRef::get_log_range() on the epoch histories before restart. */
+  LogRange    get_restart_range(LoggerId logger_id, Epoch epoch) const;
+  /**
+   * Reads the logs of the epoch in the range of the logger into buffer_.
+   * If markers is given, instead collects the epoch markers upto restart_epoch_ in the range.
+   */
+  ErrorCode   read_range(
+    LoggerId logger_id,
+    const LogRange& range,
+    Epoch epoch,
+    std::vector<EpochHistory>* markers = CXX11_NULLPTR);
+  /** Copies the log to buffer_ if it's a log of the epoch and the storages. */
+  ErrorCode   add_log(const LogHeader* header, Epoch epoch);
+  bool        is_subscribed(storage::StorageId storage_id) const;
+
+  Engine* const             engine_;
+  const uint64_t            buffer_size_;
+  /** @see get_consumed_epoch() */
+  Epoch                     consumed_epoch_;
+  /** @see get_epoch() */
+  Epoch                     epoch_;
+  /** Durable epoch when the engine started. Logs upto this epoch were written before restart. */
+  Epoch                     restart_epoch_;
+  /**
+   * Epoch markers each logger wrote before restart, rebuilt from the log files.
+   * Empty if consumed_epoch_ was not older than restart_epoch_ at initialize().
+   */
+  std::vector< std::vector<EpochHistory> > restart_histories_;
+  /**
+   * The first epoch marker each logger wrote after restart. Its position is the end of the
+   * logs before restart.
+   */
+  std::vector<EpochHistory> restart_markers_;
+  /** Storages to deliver logs of. Empty means all. */
+  std::vector<storage::StorageId> storages_;
+  /** Read buffer for direct I/O. */
+  memory::AlignedMemory     io_buffer_;
+  /** Logs of the current epoch. */
+  memory::AlignedMemory     buffer_;
+  /** Bytes used in buffer_. */
+  uint64_t                  buffer_used_;
+  /** Byte offsets of logs in buffer_, sorted by XctId. */
+  std::vector<uint64_t>     log_offsets_;
+};
+
+}  // namespace log
+}  // namespace foedus
+#endif  // FOEDUS_LOG_LOG_SUBSCRIBER_HPP_
@@ -79,6 +79,24 @@ class LoggerRef : public Attachable<LoggerControlBlock> {
    */
   LogRange get_log_range(Epoch prev_epoch, Epoch until_epoch);
 
+  /**
+   * @brief Returns the first epoch after the given epoch that this logger has an epoch mark of.
+   * @param[in] prev_epoch An invalid epoch means from the beginning.
+   * @return invalid epoch if there is no such mark yet
+   * @details
+   * This logger wrote no logs in epochs between the two. Used to skip empty epochs quickly.
+   */
+  Epoch    get_next_marked_epoch(Epoch prev_epoch) const;
+
+  /**
+   * @brief Returns the oldest epoch history this logger has in memory.
+   * @details
+   * This is the dummy epoch marker the logger wrote when the engine started, so its position
+   * is where the logs of this execution begin. The history is not persisted, so logs before
+   * this position (written before restart) have no history in memory.
+   */
+  EpochHistory get_oldest_epoch_history() const;
+
  protected:
   LoggerId  id_;
   uint16_t  numa_node_;
@@ -101,6 +101,8 @@ class NumaCoreMemory CXX11_FINAL : public DefaultInitializable {
   uint64_t get_retrospective_lock_list_capacity() const {
     return retrospective_lock_list_capacity_;
   }
+  /** @see xct::LearnedLockListCache::calculate_memory_size() */
+  void* get_learned_lock_list_memory() const { return learned_lock_list_memory_; }
 
   const SmallThreadLocalMemoryPieces& get_small_thread_local_memory_pieces() const {
     return small_thread_local_memory_pieces_;
@@ -198,6 +200,8 @@ class NumaCoreMemory CXX11_FINAL : public DefaultInitializable {
   /** Memory to hold thread's retrospective lock list */
   xct::LockEntry*                 retrospective_lock_list_memory_;
   uint64_t                                retrospective_lock_list_capacity_;
+  /** Memory to hold thread's learned lock lists */
+  void*                                   learned_lock_list_memory_;
 
   /** Pointer to this NUMA node's volatile page pool */
   PagePool*                               volatile_pool_;
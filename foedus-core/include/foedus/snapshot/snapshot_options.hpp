@@ -43,6 +43,9 @@ struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable
     kDefaultLogReducerReadIoBufferKb      = 1024,
     kDefaultSnapshotWriterPagePoolSizeMb  = 128,
     kDefaultSnapshotWriterIntermediatePoolSizeMb  = 16,
+    kDefaultComposerParallelThreads       = 4,
+    kDefaultSnapshotWriterAsyncBuffers    = 2,
+    kDefaultSnapshotWriterAsyncBufferMb   = 4,
   };
 
   /**
@@ -143,6 +146,40 @@ struct SnapshotOptions CXX11_FINAL : public virtual externalize::Externalizable
    */
   uint32_t                            snapshot_writer_intermediate_pool_size_mb_;
 
+  /**
+   * @brief Number of threads each reducer uses to install snapshot pointers of a masstree
+   * storage.
+   * @details
+   * Composition is parallel only across reducers: each reducer composes its partition of a
+   * storage on its own thread, and construct_root() then runs on one thread.
+   * Within one reducer, the only parallelized step is the last one of masstree's compose(),
+   * installing new snapshot pointers to volatile pages. The reducer splits the root's
+   * children into contiguous key ranges and runs them on this many threads, all of which are
+   * pinned to the reducer's NUMA node. Building pages stays serial because one SnapshotWriter
+   * assigns page IDs in write order.
+   * 1 means no parallelization. Default is 4.
+   */
+  uint16_t                            composer_parallel_threads_;
+
+  /**
+   * @brief Number of staging buffers each snapshot writer keeps for asynchronous writes.
+   * @details
+   * When this is more than 0, SnapshotWriter copies pages it is asked to dump into one of
+   * these buffers and returns immediately. A dedicated I/O thread writes out filled buffers
+   * to the snapshot file in order, so that composers can keep composing while previous pages
+   * are being written. With 2 or more buffers, the composer fills one while the I/O thread
+   * writes the other.
+   * 0 means the snapshot writer synchronously writes from its page pool as before.
+   * Default is 2.
+   */
+  uint16_t                            snapshot_writer_async_buffers_;
+
+  /**
+   * The size in MB of each staging buffer for asynchronous writes in snapshot writer.
+   * Used only when snapshot_writer_async_buffers_ > 0.
+   */
+  uint32_t                            snapshot_writer_async_buffer_mb_;
+
   /** Settings to emulate slower data device. */
   foedus::fs::DeviceEmulationOptions  emulation_;
 
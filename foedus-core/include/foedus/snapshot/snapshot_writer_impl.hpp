@@ -19,8 +19,14 @@
 #define FOEDUS_SNAPSHOT_SNAPSHOT_WRITER_IMPL_HPP_
 #include <stdint.h>
 
+#include <condition_variable>
+#include <deque>
 #include <iosfwd>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "foedus/assert_nd.hpp"
 #include "foedus/compiler.hpp"
@@ -68,6 +74,17 @@ namespace snapshot {
  * \b right-most pages in all levels. After dumping everything else, we repeat the compose phase
  * just like moving on to another storage.
  *
+ * @par Asynchronous Writes
+ * Unless SnapshotOptions::snapshot_writer_async_buffers_ is 0, the dump phase does not wait for
+ * the disk. We copy the pages to a few staging buffers and a dedicated I/O thread writes them
+ * out in the order they were dumped, so that the composer can start composing next pages
+ * (which overwrite the page pool) while the previous pages are being written.
+ * Errors in the I/O thread are reported by the next dump or flush_async_writes().
+ * close() flushes all staging buffers before making the file durable.
+ * A page dumped earlier might be still in the staging buffers, so a composer that reads back
+ * a page it wrote in the same snapshot (eg masstree re-opening a page it closed) must call
+ * flush_async_writes() before reading it from the file.
+ *
  * @note
  * This is a private implementation-details of \ref SNAPSHOT, thus file name ends with _impl.
  * Do not include this header from a client program. There is no case client program needs to
@@ -145,6 +162,14 @@ class SnapshotWriter final {
     return dump_general(intermediate_memory_, from_page, count);
   }
 
+  /**
+   * @brief Waits until all pages dumped so far are written to the file.
+   * @return the first error the asynchronous writes encountered, if any
+   * @details
+   * Does nothing in the synchronous mode. close() internally calls this.
+   */
+  ErrorCode flush_async_writes();
+
   std::string             to_string() const {
     return "SnapshotWriter-" + std::to_string(numa_node_) + (append_ ? "(append)" : "");
   }
@@ -213,7 +238,45 @@ class SnapshotWriter final {
    */
   storage::SnapshotPagePointer    next_page_id_;
 
+  /**
+   * Number of staging buffers for asynchronous writes. 0 means synchronous writes.
+   * @see SnapshotOptions::snapshot_writer_async_buffers_
+   */
+  const uint16_t                  async_buffer_count_;
+  /** Byte size of each staging buffer. Multiple of page size. */
+  const uint64_t                  async_buffer_size_;
+  /** All staging buffers in one allocation. Allocated on numa_node_ when we open the file. */
+  memory::AlignedMemory           async_buffers_;
+  /**
+   * The staging buffer we are currently filling. async_buffer_count_ if none.
+   * This and async_current_bytes_ are accessed only by the thread that uses this writer.
+   */
+  uint16_t                        async_current_;
+  /** Bytes filled in the current staging buffer. */
+  uint64_t                        async_current_bytes_;
+  /** The I/O thread that writes out staging buffers. Running only while the file is opened. */
+  std::thread                     async_thread_;
+  /** Protects all of the following. */
+  std::mutex                      async_mutex_;
+  /** Fired when a staging buffer is submitted or written out. */
+  std::condition_variable         async_cond_;
+  /** Filled staging buffers to write out, in this order. pair of (index, bytes). */
+  std::deque< std::pair<uint16_t, uint64_t> > async_queue_;
+  /** Staging buffers that are free to fill. */
+  std::vector<uint16_t>           async_free_buffers_;
+  /** Whether the I/O thread is writing out a buffer, which is not in async_queue_ any more. */
+  bool                            async_writing_;
+  /** Whether the I/O thread should exit. */
+  bool                            async_stop_requested_;
+  /** The first error the I/O thread encountered. Once set, we skip all following writes. */
+  ErrorCode                       async_error_;
+
   fs::Path  get_snapshot_file_path() const;
+  void      start_async_writes();
+  void      stop_async_writes();
+  void      handle_async_writes();
+  /** Hands over the current staging buffer to the I/O thread. Must hold async_mutex_. */
+  void      submit_current_buffer();
   ErrorCode dump_general(
     memory::AlignedMemory* buffer,
     memory::PagePoolOffset from_page,
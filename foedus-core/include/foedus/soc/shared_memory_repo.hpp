@@ -317,6 +317,7 @@ struct NodeMemoryAnchors {
     kLogReducerMemorySize = 1 << 12,
     kLoggerMemorySize = 1 << 21,
     kProcManagerMemorySize = 1 << 12,
+    kMcsReaderIndicatorMemorySize = 1 << 16,
     kMaxBoundaries = 1 << 12,
   };
 
@@ -386,6 +387,23 @@ struct NodeMemoryAnchors {
    */
   log::LoggerControlBlock** logger_memories_;
 
+  /**
+   * Reader indicators of this node for reader-biased read-locks.
+   * Array of xct::kMcsReaderIndicatorCount counters, indexed by xct::to_reader_indicator_index().
+   * Each counter is the number of threads in this node that hold a read-lock hashed to it
+   * in the reader-biased mode.
+   * Always 64kb.
+   */
+  uint32_t*           mcs_reader_indicator_memory_;
+
+  /**
+   * Previous-version table of this node for epoch-consistent reads.
+   * Array of XctOptions::previous_version_entries_per_node_ entries.
+   * Empty if the option is 0.
+   * @see xct::PreviousVersionTable
+   */
+  xct::PreviousVersion* previous_version_memory_;
+
   /**
    * Anchors for each thread. Index is node-local thread ordinal.
    */
@@ -26,6 +26,7 @@
 #include "foedus/compiler.hpp"
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/assorted/raw_atomics.hpp"
 #include "foedus/log/common_log_types.hpp"
 #include "foedus/log/log_type.hpp"
 #include "foedus/storage/record.hpp"
@@ -295,70 +296,121 @@ inline void ArrayIncrementLogType::populate(
   }
 }
 
+/**
+ * Split increments (see ArrayStorage::increment_record_split()) come without the record lock,
+ * so we atomically apply them. Otherwise we hold the lock, so a usual add suffices.
+ */
 template <typename T>
-inline void increment(T* payload, const T* addendum) {
-  *payload += *addendum;
+inline void increment(T* payload, const T* addendum, bool atomic) {
+  if (atomic) {
+    assorted::raw_atomic_fetch_add<T>(payload, *addendum);
+  } else {
+    *payload += *addendum;
+  }
+}
+
+/** There is no atomic fetch-add for floating points, so CAS on the bits instead. */
+template <typename T, typename BITS>
+inline void increment_floating(T* payload, const T* addendum, bool atomic) {
+  if (!atomic) {
+    *payload += *addendum;
+    return;
+  }
+  BITS* address = reinterpret_cast<BITS*>(payload);
+  BITS expected = *address;
+  while (true) {
+    T value;
+    std::memcpy(&value, &expected, sizeof(T));
+    value += *addendum;
+    BITS desired;
+    std::memcpy(&desired, &value, sizeof(T));
+    if (assorted::raw_atomic_compare_exchange_weak<BITS>(address, &expected, desired)) {
+      break;
+    }
+  }
+}
+
+template <>
+inline void increment<float>(float* payload, const float* addendum, bool atomic) {
+  increment_floating<float, uint32_t>(payload, addendum, atomic);
+}
+
+template <>
+inline void increment<double>(double* payload, const double* addendum, bool atomic) {
+  increment_floating<double, uint64_t>(payload, addendum, atomic);
 }
 
 inline void ArrayIncrementLogType::apply_record(
   thread::Thread* /*context*/,
   StorageId /*storage_id*/,
-  xct::RwLockableXctId* /*owner_id*/,
+  xct::RwLockableXctId* owner_id,
   char* payload) const {
+  // Split increments are in lock-free write set, which gives no owner_id.
+  const bool atomic = (owner_id == nullptr);
   switch (get_value_type()) {
     // 32 bit data types
     case kI8:
       increment<int8_t>(
         reinterpret_cast<int8_t*>(payload + payload_offset_),
-        reinterpret_cast<const int8_t*>(addendum_));
+        reinterpret_cast<const int8_t*>(addendum_),
+        atomic);
       break;
     case kI16:
       increment<int16_t>(
         reinterpret_cast<int16_t*>(payload + payload_offset_),
-        reinterpret_cast<const int16_t*>(addendum_));
+        reinterpret_cast<const int16_t*>(addendum_),
+        atomic);
       break;
     case kI32:
       increment<int32_t>(
         reinterpret_cast<int32_t*>(payload + payload_offset_),
-        reinterpret_cast<const int32_t*>(addendum_));
+        reinterpret_cast<const int32_t*>(addendum_),
+        atomic);
       break;
     case kBool:
     case kU8:
       increment<uint8_t>(
         reinterpret_cast<uint8_t*>(payload + payload_offset_),
-        reinterpret_cast<const uint8_t*>(addendum_));
+        reinterpret_cast<const uint8_t*>(addendum_),
+        atomic);
       break;
     case kU16:
       increment<uint16_t>(
         reinterpret_cast<uint16_t*>(payload + payload_offset_),
-        reinterpret_cast<const uint16_t*>(addendum_));
+        reinterpret_cast<const uint16_t*>(addendum_),
+        atomic);
       break;
     case kU32:
       increment<uint32_t>(
         reinterpret_cast<uint32_t*>(payload + payload_offset_),
-        reinterpret_cast<const uint32_t*>(addendum_));
+        reinterpret_cast<const uint32_t*>(addendum_),
+        atomic);
       break;
     case kFloat:
       increment<float>(
         reinterpret_cast<float*>(payload + payload_offset_),
-        reinterpret_cast<const float*>(addendum_));
+        reinterpret_cast<const float*>(addendum_),
+        atomic);
       break;
 
     // 64 bit data types
     case kI64:
       increment<int64_t>(
         reinterpret_cast<int64_t*>(payload + payload_offset_),
-        reinterpret_cast<const int64_t*>(addendum_ + 4));
+        reinterpret_cast<const int64_t*>(addendum_ + 4),
+        atomic);
       break;
     case kU64:
       increment<uint64_t>(
         reinterpret_cast<uint64_t*>(payload + payload_offset_),
-        reinterpret_cast<const uint64_t*>(addendum_ + 4));
+        reinterpret_cast<const uint64_t*>(addendum_ + 4),
+        atomic);
       break;
     case kDouble:
       increment<double>(
         reinterpret_cast<double*>(payload + payload_offset_),
-        reinterpret_cast<const double*>(addendum_ + 4));
+        reinterpret_cast<const double*>(addendum_ + 4),
+        atomic);
       break;
     default:
       ASSERT_ND(false);
@@ -21,7 +21,10 @@
 
 #include "foedus/assert_nd.hpp"
 #include "foedus/compiler.hpp"
+#include "foedus/epoch.hpp"
 #include "foedus/fwd.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/assorted/raw_atomics.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_id.hpp"
@@ -111,8 +114,35 @@ class ArrayPage final {
     return data_.interior_data[record];
   }
 
+  /**
+   * @return the latest epoch in which a split increment (ArrayStorage::increment_record_split())
+   * committed on a record in this page. Invalid if never.
+   */
+  Epoch                   get_split_increment_epoch() const {
+    return Epoch(assorted::atomic_load_acquire<Epoch::EpochInteger>(&split_increment_epoch_));
+  }
+  /**
+   * Raises get_split_increment_epoch() to the given epoch. Invoked by split increments
+   * before they verify the record, so that a writer who locks the record afterwards sees it.
+   */
+  void                    on_split_increment(Epoch commit_epoch) {
+    ASSERT_ND(commit_epoch.is_valid());
+    while (true) {
+      Epoch::EpochInteger cur = split_increment_epoch_;
+      if (Epoch(cur).is_valid() && Epoch(cur) >= commit_epoch) {
+        break;
+      }
+      Epoch::EpochInteger new_value = commit_epoch.value();
+      if (assorted::raw_atomic_compare_exchange_strong<Epoch::EpochInteger>(
+        &split_increment_epoch_,
+        &cur,
+        new_value)) {
+        break;
+      }
+    }
+  }
+
   uint8_t                 unused_dummy_func_reserved1() const { return reserved1_; }
-  uint32_t                unused_dummy_func_reserved2() const { return reserved2_; }
 
  private:
   /** common header */
@@ -125,7 +155,9 @@ class ArrayPage final {
   uint8_t             level_;         // +1 -> 43
 
   uint8_t             reserved1_;     // +1 -> 44
-  uint32_t            reserved2_;     // +4 -> 48
+
+  /** @see get_split_increment_epoch(). This is the only mutable field in the header. */
+  Epoch::EpochInteger split_increment_epoch_;  // +4 -> 48
 
   /**
    * The offset range this node is in charge of. Mainly for sanity checking.
@@ -134,7 +166,8 @@ class ArrayPage final {
    */
   ArrayRange          array_range_;   // +16 -> 64
 
-  // All variables up to here are immutable after the array storage is created.
+  // All variables up to here except split_increment_epoch_ are immutable after the array
+  // storage is created.
 
   /** Dynamic records in this page. */
   Data                data_;
@@ -305,6 +305,52 @@ class ArrayStorage CXX11_FINAL : public Storage<ArrayStorageControlBlock> {
     T value,
     uint16_t payload_offset);
 
+  /**
+   * @brief Commutative increment on a hot counter field that never conflicts with other
+   * split increments.
+   * @param[in] context Thread context
+   * @param[in] offset The offset in this array
+   * @param[in] value addendum
+   * @param[in] payload_offset We write to this byte position of the record.
+   * @tparam T primitive type. All integers and floats are allowed.
+   * @pre payload_offset + sizeof(T) <= get_payload_size()
+   * @pre payload_offset % sizeof(T) == 0
+   * @pre offset < get_array_size()
+   * @details
+   * increment_record_oneshot() still takes the record lock at commit, so concurrent increments
+   * on one hot record (eg TPC-C's warehouse/district YTD) serialize on one MCS lock.
+   * This method instead puts the log in the lock-free write set.
+   * At commit, the addendum is atomically added to the field without locking the record nor
+   * changing its TID. Thus, throughput scales with cores rather than with one lock.
+   *
+   * Snapshots and epoch-consistent reads rely on the TID epoch of records, so the first
+   * increment on a record in each epoch goes through increment_record_oneshot() instead,
+   * which moves the TID (and saves the previous version) under the lock as usual.
+   * Only increments on a record whose TID is already in the commit epoch are lock-free.
+   * Precommit checks it after the commit epoch is determined and aborts otherwise,
+   * in which case the retry takes the locked path.
+   * A writer that locks the record in the next epoch waits for lock-free increments of the
+   * previous epoch before it saves the previous version.
+   *
+   * This is a weaker contract, so the field must be declared "split" by the application:
+   *  \li The field must be modified only by this method. Other writes on the same bytes,
+   * which take the record lock, might lose concurrent split increments.
+   * Other fields in the same record can be written as usual.
+   *  \li Reads of the field see the value as of some point, but are not validated against
+   * concurrent split increments because the TID doesn't change. Use it for counters whose
+   * exact value is only needed after the workload quiesces or in snapshots, like phase
+   * reconciliation does for split data.
+   *
+   * Durability is the same as other increments. The log is written at commit and
+   * the snapshot composer merges it like other increment logs.
+   */
+  template <typename T>
+  ErrorCode  increment_record_split(
+    thread::Thread* context,
+    ArrayOffset offset,
+    T value,
+    uint16_t payload_offset);
+
 
   friend std::ostream& operator<<(std::ostream& o, const ArrayStorage& v);
 
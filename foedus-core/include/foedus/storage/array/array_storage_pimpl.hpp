@@ -163,6 +163,17 @@ class ArrayStoragePimpl final {
     T *payload,
     uint16_t payload_offset);
 
+  /**
+   * Reads a volatile record as of the consistent epoch of the kEpochConsistent transaction,
+   * using the previous-version table if the record was overwritten after the epoch.
+   * @see xct::PreviousVersionTable
+   */
+  ErrorCode   read_record_epoch_consistent(
+    thread::Thread* context,
+    Record* record,
+    void* payload,
+    uint16_t payload_offset,
+    uint16_t payload_count);
   ErrorCode   get_record_payload(
     thread::Thread* context,
     ArrayOffset offset,
@@ -221,6 +232,12 @@ class ArrayStoragePimpl final {
     ArrayOffset offset,
     T value,
     uint16_t payload_offset);
+  template <typename T>
+  ErrorCode  increment_record_split(
+    thread::Thread* context,
+    ArrayOffset offset,
+    T value,
+    uint16_t payload_offset);
 
   ErrorCode   lookup_for_read(
     thread::Thread* context,
@@ -354,6 +371,9 @@ static_assert(sizeof(ArrayStoragePimpl) <= kPageSize, "ArrayStoragePimpl is too
 static_assert(
   sizeof(ArrayStorageControlBlock) <= soc::GlobalMemoryAnchors::kStorageMemorySize,
   "ArrayStorageControlBlock is too large.");
+static_assert(
+  sizeof(ArrayStorageControlBlock) <= kStorageStatisticsOffset,
+  "ArrayStorageControlBlock overlaps with StorageStatistics.");
 
 }  // namespace array
 }  // namespace storage
@@ -34,11 +34,13 @@ struct  PageVersion;
 class   Partitioner;
 struct  PartitionerMetadata;
 struct  Record;
+struct  RecordPredicate;
 struct  StorageControlBlock;
 class   StorageFactory;
 class   StorageManager;
 struct  StorageManagerControlBlock;
 class   StorageManagerPimpl;
+struct  StorageStatistics;
 }  // namespace storage
 }  // namespace foedus
 #endif  // FOEDUS_STORAGE_FWD_HPP_
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_HASH_HASH_HINT_IMPL_HPP_
+#define FOEDUS_STORAGE_HASH_HASH_HINT_IMPL_HPP_
+
+#include <stdint.h>
+
+#include "foedus/compiler.hpp"
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/hash/fwd.hpp"
+#include "foedus/storage/hash/hash_id.hpp"
+
+namespace foedus {
+namespace storage {
+namespace hash {
+
+/**
+ * @brief Thread-local cache of volatile bin-head pages the thread recently visited.
+ * @ingroup HASH
+ * @details
+ * HashStoragePimpl::locate_bin() usually goes through a few intermediate pages to reach
+ * the bin-head page. With this cache, a lookup in a bin the thread recently visited
+ * directly jumps to the bin-head page.
+ * Entries are direct-mapped by storage ID and bin.
+ *
+ * Unlike masstree, volatile pages of a hash bin are never replaced or retired while
+ * they exist. They are dropped only in snapshotting, all pages in a bin at once.
+ * So, like masstree::MasstreeDescentPath, we discard all entries when the current or
+ * snapshot epoch changes. Snapshotting publishes the new snapshot epoch before it resumes
+ * transactions, so no transaction sees a dropped page through this cache. The caller also
+ * checks the storage ID and bin in the page itself. Only volatile pages are cached.
+ */
+struct HashBinHints {
+  enum Constants {
+    /** Number of entries. Must be a power of two. */
+    kSlots = 16,
+  };
+  struct Entry {
+    StorageId     storage_id_;
+    HashBin       bin_;
+    HashDataPage* page_;
+  };
+
+  /** Current global epoch as of the caching. */
+  Epoch::EpochInteger current_epoch_;
+  /** Snapshot epoch as of the caching. */
+  Epoch::EpochInteger snapshot_epoch_;
+  Entry               entries_[kSlots];
+
+  void clear() {
+    current_epoch_ = Epoch::kEpochInvalid;
+    snapshot_epoch_ = Epoch::kEpochInvalid;
+    for (uint16_t i = 0; i < kSlots; ++i) {
+      entries_[i].storage_id_ = 0;
+      entries_[i].bin_ = 0;
+      entries_[i].page_ = CXX11_NULLPTR;
+    }
+  }
+
+  static uint16_t to_slot(StorageId storage_id, HashBin bin) ALWAYS_INLINE {
+    return static_cast<uint16_t>((bin + storage_id * 7U) & (kSlots - 1U));
+  }
+
+  /** @return the cached bin-head page, nullptr if not cached or no longer usable */
+  HashDataPage* get(
+    StorageId storage_id,
+    HashBin bin,
+    Epoch current_epoch,
+    Epoch snapshot_epoch) const ALWAYS_INLINE {
+    if (current_epoch_ != current_epoch.value() || snapshot_epoch_ != snapshot_epoch.value()) {
+      return CXX11_NULLPTR;
+    }
+    const Entry& entry = entries_[to_slot(storage_id, bin)];
+    if (entry.storage_id_ == storage_id && entry.bin_ == bin) {
+      return entry.page_;
+    }
+    return CXX11_NULLPTR;
+  }
+
+  /** Caches the volatile bin-head page. */
+  void put(
+    StorageId storage_id,
+    HashBin bin,
+    Epoch current_epoch,
+    Epoch snapshot_epoch,
+    HashDataPage* page) {
+    if (current_epoch_ != current_epoch.value() || snapshot_epoch_ != snapshot_epoch.value()) {
+      clear();
+      current_epoch_ = current_epoch.value();
+      snapshot_epoch_ = snapshot_epoch.value();
+    }
+    Entry& entry = entries_[to_slot(storage_id, bin)];
+    entry.storage_id_ = storage_id;
+    entry.bin_ = bin;
+    entry.page_ = page;
+  }
+};
+
+}  // namespace hash
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_HASH_HASH_HINT_IMPL_HPP_
@@ -96,6 +96,33 @@ class HashStorage CXX11_FINAL : public Storage<HashStorageControlBlock> {
    */
   ErrorStack  hcc_reset_all_temperature_stat();
 
+  /** Output of estimate_bin_histogram() */
+  struct BinHistogram {
+    enum Constants {
+      /** Bins with this many records or more are counted in the last entry */
+      kMaxRecordCount = 16,
+    };
+    /** Number of bins we have checked */
+    uint32_t  sampled_bins_;
+    /** Total number of physical records in the checked bins, including deleted ones */
+    uint64_t  sampled_records_;
+    /** bins_[i] is the number of checked bins that had i records. */
+    uint32_t  bins_[kMaxRecordCount + 1];
+  };
+  /**
+   * @brief Estimates the distribution of records over hash bins.
+   * @param[in] sample_bins Number of bins to check. Bins are picked at an even stride.
+   * If this is larger than the number of bins, we check all bins.
+   * @param[out] out Histogram of records per bin
+   * @details
+   * This only reads volatile pages without any protection, so the result is approximate.
+   * Bins whose volatile pages are dropped after a snapshot are counted as empty.
+   * This is an on-demand sampling helper, not part of StorageStatistics, which is what
+   * StorageManager::get_statistics() maintains across snapshots.
+   * Defined in hash_storage_debug.cpp, right next to similar volatile-page walkers.
+   */
+  ErrorStack  estimate_bin_histogram(uint32_t sample_bins, BinHistogram* out);
+
   /**
    * @brief A super-expensive and single-thread only debugging feature to write out
    * gigantic human-readable texts to describe the hash storage in details.
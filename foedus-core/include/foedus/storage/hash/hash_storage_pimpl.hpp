@@ -133,6 +133,11 @@ class HashStoragePimpl final : public Attachable<HashStorageControlBlock> {
   ErrorStack  hcc_reset_all_temperature_stat_intermediate(VolatilePagePointer intermediate_page_id);
   ErrorStack  hcc_reset_all_temperature_stat_data(VolatilePagePointer head_page_id);
 
+  /** @see foedus::storage::hash::HashStorage::estimate_bin_histogram() */
+  ErrorStack  estimate_bin_histogram(uint32_t sample_bins, HashStorage::BinHistogram* out);
+  /** @return number of physical records in the volatile pages of the bin */
+  uint32_t    count_volatile_bin_records(HashBin bin);
+
   /** These are defined in hash_storage_debug.cpp */
   ErrorStack debugout_single_thread(
     Engine* engine,
@@ -459,6 +464,9 @@ static_assert(sizeof(HashStoragePimpl) <= kPageSize, "HashStoragePimpl is too la
 static_assert(
   sizeof(HashStorageControlBlock) <= soc::GlobalMemoryAnchors::kStorageMemorySize,
   "HashStorageControlBlock is too large.");
+static_assert(
+  sizeof(HashStorageControlBlock) <= kStorageStatisticsOffset,
+  "HashStorageControlBlock overlaps with StorageStatistics.");
 }  // namespace hash
 }  // namespace storage
 }  // namespace foedus
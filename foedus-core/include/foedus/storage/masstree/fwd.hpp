@@ -30,6 +30,7 @@ struct  MasstreeCommonLogType;
 struct  MasstreeCreateLogType;
 class   MasstreeCursor;
 struct  MasstreeDeleteLogType;
+struct  MasstreeDescentPath;
 struct  MasstreeInsertLogType;
 class   MasstreeIntermediatePage;
 struct  MasstreeMetadata;
@@ -38,6 +39,7 @@ class   MasstreePage;
 class   MasstreePartitioner;
 struct  MasstreePartitionerData;
 struct  MasstreePartitionerInDesignData;
+struct  MasstreeRecordBatch;
 class   MasstreeStorage;
 struct  MasstreeStorageControlBlock;
 class   MasstreeStorageFactory;
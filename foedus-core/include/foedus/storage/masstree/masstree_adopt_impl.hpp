@@ -59,12 +59,26 @@ namespace masstree {
  *
  * Locks taken in this sysxct:
  * \li Page-lock of the parent page and old page (will be retied).
+ * \li Page-locks of other children of the parent page adopted together (see below).
  *
- * So far this sysxct adopts only one child at a time.
- * TASK(Hideaki): Probably it helps by delaying and batching several adoptions.
+ * @par Batched adoptions
+ * In append-heavy bursts, many threads split neighboring pages at the same time, and each of
+ * them then tries to adopt its own foster twins into the same parent, contending on the parent
+ * lock. Instead, this sysxct also picks up other children of the parent that are waiting for
+ * adoption (up to kMaxBatchedAdoptions pages in total) and adopts all of them while it holds
+ * the parent lock. All pages are locked in one sysxct_batch_page_locks() call, so they are
+ * taken in canonical order.
+ * Only children that are not locked as of the scan are picked up, so we rarely wait for
+ * on-going splits. Children whose new pointers can be simply appended are adopted in place.
+ * All the others are adopted by one split of the parent page (see
+ * SplitIntermediate::more_adopt_children_), rather than one split per child.
  * @see SplitIntermediate
  */
 struct Adopt final : public xct::SysxctFunctor {
+  enum Constants {
+    /** Maximal number of children, including old_, one Adopt sysxct adopts. */
+    kMaxBatchedAdoptions = 8,
+  };
   /** Thread context */
   thread::Thread* const           context_;
   /** The parent page that currently points to the old page */
@@ -86,11 +100,35 @@ struct Adopt final : public xct::SysxctFunctor {
   }
   virtual ErrorCode run(xct::SysxctWorkspace* sysxct_workspace) override;
 
-  ErrorCode adopt_case_a(
+  /**
+   * Collects children of the parent page that can be adopted together with old_.
+   * This reads the parent page without lock, so the result is just a hint.
+   * @param[out] olds old_ followed by other moved children
+   * @return number of pages in olds
+   */
+  uint16_t  collect_batched_adoptions(MasstreePage** olds) const;
+
+  /**
+   * Adopts one child without splitting the parent page if possible.
+   * @pre the parent and the child are locked, not moved/retired
+   * @return whether the child is adopted. false if it needs a split of the parent page.
+   */
+  bool      adopt_in_place(MasstreePage* old);
+
+  /**
+   * Adopts the given children by splitting the parent page, all of them in one split.
+   * @pre the parent and the children are locked, not moved/retired
+   */
+  ErrorCode adopt_by_split(MasstreePage** olds, uint16_t count);
+
+  void adopt_case_a(
+    MasstreePage* old,
     uint16_t minipage_index,
     uint16_t pointer_index);
 
-  ErrorCode adopt_case_b(
+  /** @return whether the child is adopted by appending the new pointer */
+  bool adopt_case_b(
+    MasstreePage* old,
     uint16_t minipage_index,
     uint16_t pointer_index);
 };
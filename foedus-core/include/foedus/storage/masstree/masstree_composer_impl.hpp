@@ -61,6 +61,14 @@ namespace masstree {
  * doesn't match occasionally, that's fine. We just use it to loosely guide the choice of page
  * boundaries in snapshot pages.
  *
+ * @par Parallelism
+ * Each reducer calls compose() for its partition on its own thread, and construct_root()
+ * merges one root page per reducer on one thread. Within compose(), only
+ * install_snapshot_pointers() runs on several threads
+ * (see snapshot::SnapshotOptions::composer_parallel_threads_). Building pages stays serial
+ * because the pages of one reducer go to one snapshot file, whose page IDs the SnapshotWriter
+ * assigns in write order.
+ *
  * @note
  * This is a private implementation-details of \ref MASSTREE, thus file name ends with _impl.
  * Do not include this header from a client program. There is no case client program needs to
@@ -602,6 +610,18 @@ class MasstreeComposeContext {
     KeySlice low,
     KeySlice high) const ALWAYS_INLINE;
   ErrorStack install_snapshot_pointers(uint64_t* installed_count) const;
+  /**
+   * Sub-routine of install_snapshot_pointers() to recurse on a contiguous range of the root's
+   * children. This might be invoked on several threads in parallel, each of which has its own
+   * prefixes and installed_count.
+   */
+  ErrorCode install_snapshot_pointers_targets(
+    const memory::GlobalVolatilePageResolver& resolver,
+    bool no_next_layer,
+    const VolatilePagePointer* targets,
+    uint32_t target_count,
+    KeySlice* prefixes,
+    uint64_t* installed_count) const;
   ErrorCode install_snapshot_pointers_recurse(
     const memory::GlobalVolatilePageResolver& resolver,
     uint8_t layer,
@@ -27,9 +27,11 @@
 #include "foedus/compiler.hpp"
 #include "foedus/cxx11.hpp"
 #include "foedus/engine.hpp"
+#include "foedus/epoch.hpp"
 #include "foedus/assorted/endianness.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/page.hpp"
+#include "foedus/storage/record_predicate.hpp"
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/storage/masstree/fwd.hpp"
 #include "foedus/storage/masstree/masstree_id.hpp"
@@ -41,6 +43,180 @@
 namespace foedus {
 namespace storage {
 namespace masstree {
+/**
+ * @brief A read-only view of a key in masstree without copying it.
+ * @ingroup MASSTREE
+ * @details
+ * A key in masstree is not stored contiguously. It consists of big-endian prefix slices of the
+ * upper layers, the native-endian slice in the layer of the border page, and the big-endian
+ * suffix in the page. This object just points to them, so getting it costs nothing.
+ * Comparisons against a big-endian key are done slice by slice without materializing the key.
+ * Only copy_to() and copy_part() copy bytes, and only when the caller needs contiguous bytes.
+ *
+ * This is a POD that points to the cursor (or the batch) and the page.
+ * It is valid until the cursor moves, so don't keep it beyond that.
+ * @code{.cpp}
+ * MasstreeKeyView key = cursor.get_key_view();
+ * if (key.starts_with(prefix, prefix_length)) {
+ *   uint64_t second_column = key.get_slice(1);  // a native-endian uint64 at bytes 8-15
+ * }
+ * @endcode
+ */
+struct MasstreeKeyView {
+  /** Big-endian prefix slices. layer_ * sizeof(KeySlice) bytes are set. */
+  const char*   prefix_be_;
+  /** Big-endian suffix after the in-layer slice. Points to somewhere in the page. */
+  const char*   suffix_;
+  KeySlice      in_layer_slice_;
+  /** Length of the key in and after the layer. */
+  KeyLength     in_layer_remainder_;
+  /** Length of the entire key. */
+  KeyLength     key_length_;
+  Layer         layer_;
+
+  KeyLength     get_length() const ALWAYS_INLINE { return key_length_; }
+  KeyLength     get_prefix_length() const ALWAYS_INLINE { return layer_ * sizeof(KeySlice); }
+  /**
+   * @return the index-th 8 byte slice of the key, native-endian. Zero-padded if the key
+   * ends in the slice, so this is handy to read a big-endian uint64 column in the key.
+   * @pre index * sizeof(KeySlice) < get_length()
+   */
+  KeySlice      get_slice(Layer index) const ALWAYS_INLINE {
+    ASSERT_ND(index * sizeof(KeySlice) < key_length_);
+    if (index < layer_) {
+      return assorted::read_bigendian<KeySlice>(prefix_be_ + index * sizeof(KeySlice));
+    } else if (index == layer_) {
+      return in_layer_slice_;
+    } else {
+      const KeyLength suffix_offset = (index - layer_ - 1U) * sizeof(KeySlice);
+      return slice_key(
+        suffix_ + suffix_offset,
+        in_layer_remainder_ - sizeof(KeySlice) - suffix_offset);
+    }
+  }
+
+  /** Copies the entire big-endian key. buffer must be get_length() or longer. */
+  void          copy_to(char* buffer) const;
+  /** Copies len bytes of the big-endian key from offset. */
+  void          copy_part(KeyLength offset, KeyLength len, char* buffer) const;
+  /**
+   * Compares this key with the given big-endian key in the memcmp order of keys,
+   * shorter keys first when one is a prefix of the other.
+   * @return negative, zero, or positive if this key is smaller, equal, or larger
+   */
+  int           compare(const char* key, KeyLength key_length) const;
+  /** @return whether the first prefix_length bytes of this key are the given prefix */
+  bool          starts_with(const char* prefix, KeyLength prefix_length) const;
+  /** @return whether this key is exactly the given key */
+  bool          equals(const char* key, KeyLength key_length) const ALWAYS_INLINE {
+    return key_length == key_length_ && compare(key, key_length) == 0;
+  }
+  /** Materializes the key. It's SLOOOW. So use it as such. */
+  std::string   to_string() const;
+};
+
+/**
+ * @brief Records in one border page returned by MasstreeCursor::next_batch().
+ * @ingroup MASSTREE
+ * @details
+ * Each entry points to the key suffix and payload in the data page just like
+ * MasstreeCursor::get_key_suffix() and MasstreeCursor::get_payload().
+ * The entries are in the order of the cursor, and they all share the same layer and
+ * prefix slices. This object is large (a few KB), so don't place it in a hot stack frame
+ * more than once.
+ */
+struct MasstreeRecordBatch {
+  struct Entry {
+    /** The owner ID of the record in the page. */
+    xct::RwLockableXctId* owner_id_address_;
+    /** The TID we observed before reading the record, possibly added to the read-set. */
+    xct::XctId        observed_;
+    /** The slice of the key in the layer of the page. */
+    KeySlice          in_layer_slice_;
+    /** Length of the key in and after the layer of the page. */
+    KeyLength         in_layer_remainder_;
+    /** Length of the entire key. */
+    KeyLength         key_length_;
+    PayloadLength     payload_length_;
+    /** Big-endian suffix of the key, which points to somewhere in the page. */
+    const char*       suffix_;
+    /** Payload of the record, which points to somewhere in the page. */
+    const char*       payload_;
+  };
+
+  /** Number of valid entries in entries_. */
+  uint16_t    count_;
+  /** Layer of the border page all entries are in. */
+  Layer       layer_;
+  /** Big-endian prefix slices of all entries. layer_ * sizeof(KeySlice) bytes are set. */
+  char        prefix_be_[kMaxKeyLength];
+  Entry       entries_[kBorderPageMaxSlots];
+
+  uint16_t      get_count() const { return count_; }
+  bool          is_empty() const { return count_ == 0; }
+  const Entry&  get_entry(uint16_t index) const ALWAYS_INLINE {
+    ASSERT_ND(index < count_);
+    return entries_[index];
+  }
+  /** Same as MasstreeCursor::get_key_view() */
+  MasstreeKeyView get_key_view(uint16_t index) const ALWAYS_INLINE {
+    const Entry& entry = get_entry(index);
+    MasstreeKeyView view;
+    view.prefix_be_ = prefix_be_;
+    view.suffix_ = entry.suffix_;
+    view.in_layer_slice_ = entry.in_layer_slice_;
+    view.in_layer_remainder_ = entry.in_layer_remainder_;
+    view.key_length_ = entry.key_length_;
+    view.layer_ = layer_;
+    return view;
+  }
+  /** Same as MasstreeCursor::copy_combined_key() */
+  void          copy_combined_key(uint16_t index, char* buffer) const {
+    get_key_view(index).copy_to(buffer);
+  }
+  /** This method assumes the key length is at most 8 bytes. */
+  KeySlice      get_normalized_key(uint16_t index) const ALWAYS_INLINE {
+    ASSERT_ND(get_entry(index).key_length_ <= sizeof(KeySlice));
+    return get_entry(index).in_layer_slice_;
+  }
+};
+
+/**
+ * @brief A position of MasstreeCursor that a later transaction can resume from.
+ * @ingroup MASSTREE
+ * @details
+ * MasstreeCursor::export_token() writes the key the cursor currently points to, and
+ * MasstreeCursor::resume() opens a cursor from the key, inclusive. This is for pagination and
+ * incremental exports that read a range in many short transactions.
+ *
+ * The token also remembers the volatile border page in the first layer that contained the key.
+ * If the page still covers the key when we resume, the cursor starts from the page without
+ * descending from the root, and descends only when it leaves the page.
+ * The page is validated in the same way as MasstreeDescentPath: its immutable fences,
+ * the moved/retired bits, and the current/snapshot epochs as of export_token() so that we never
+ * touch a page that might have been returned to the page pool. Otherwise resume() is open().
+ *
+ * The token is just a position. The resuming transaction takes its own read-sets from the
+ * key, and nothing the previous transaction read is protected any longer.
+ * This is a POD. To persist it somewhere, the first key_length_ bytes of key_ are enough.
+ */
+struct MasstreeCursorToken {
+  /** The storage the cursor was on. */
+  StorageId           storage_id_;
+  /** Whether the cursor had no more records. resume() then returns an exhausted cursor. */
+  bool                finished_;
+  bool                forward_cursor_;
+  KeyLength           key_length_;
+  /** Border page in the first layer that contained the key. Null if we don't have a hint. */
+  VolatilePagePointer page_hint_;
+  /** Current global epoch as of export_token(). */
+  Epoch::EpochInteger current_epoch_;
+  /** Snapshot epoch as of export_token(). */
+  Epoch::EpochInteger snapshot_epoch_;
+  /** Big-endian key the cursor pointed to. key_length_ bytes are set. */
+  char                key_[kMaxKeyLength];
+};
+
 /**
  * @brief Represents a cursor object for Masstree storage.
  * @ingroup MASSTREE
@@ -52,7 +228,7 @@ namespace masstree {
  * MasstreeCursor cursor(orderlines, context);
  * CHECK_ERROR_CODE(cursor.open_normalized(low, high, true, true));
  * while (cursor.is_valid_record()) {
- *  const char* key_be = cursor.get_key();
+ *  MasstreeKeyView key = cursor.get_key_view();
  *  const OrderlineData* payload = reinterpret_cast<const OrderlineData*>(cursor.get_payload());
  *  *ol_amount_total += payload->amount_;
  *  ++(*ol_count);
@@ -179,6 +355,8 @@ class MasstreeCursor CXX11_FINAL {
     kMaxRecords = kBorderPageMaxSlots,
     kMaxRoutes = kPageSize / sizeof(Route),
     kKeyLengthExtremum = 0,
+    /** Default of set_max_prefetch_pages() */
+    kDefaultMaxPrefetchPages = 8,
   };
 
   MasstreeCursor(MasstreeStorage storage, thread::Thread* context);
@@ -188,6 +366,64 @@ class MasstreeCursor CXX11_FINAL {
   bool              is_for_writes() const { return for_writes_; }
   bool              is_forward_cursor() const { return forward_cursor_; }
 
+  /**
+   * @brief Makes the cursor skip records that don't match the given predicate.
+   * @param[in] predicate the filter. The cursor just points to it, so it must be alive
+   * while this cursor is used. null to return all records again.
+   * @details
+   * Call this before open(). The cursor evaluates the predicate right after observing each
+   * record in the page loop, and non-matching records are skipped just like deleted records.
+   * A serializable transaction still takes a read-set on each of them because they might
+   * be updated to match before we commit.
+   * The payload is evaluated without copying, so the predicate might see a record being
+   * updated. It's fine because the read-set catches it at commit.
+   */
+  void              set_predicate(const RecordPredicate* predicate) { predicate_ = predicate; }
+  const RecordPredicate* get_predicate() const { return predicate_; }
+
+  /**
+   * @brief Sets how many border pages the cursor prefetches ahead of the current one.
+   * @param[in] pages upto Thread::kMaxFindPagesBatch. 0 disables prefetching.
+   * @details
+   * When the cursor enters a border page, it prefetches the next border pages under the same
+   * parent in the scan direction. Volatile pages are prefetched to CPU cache, and snapshot pages
+   * are brought into the snapshot cache in one batch (Thread::find_or_read_snapshot_pages_batch()).
+   * The latter reads missed pages synchronously, so we prefetch snapshot pages only when the
+   * snapshot cache is enabled. Without the cache, it would just read each page twice.
+   * The number of pages starts from 1 in open() and doubles on each page transition upto this
+   * value, so short scans pay almost nothing. It also stops at pages beyond the end key.
+   * Default is kDefaultMaxPrefetchPages.
+   */
+  void              set_max_prefetch_pages(uint16_t pages);
+  uint16_t          get_max_prefetch_pages() const { return max_prefetch_pages_; }
+
+  /**
+   * @brief Writes the current position of this cursor so that a later transaction can resume().
+   * @details
+   * The position is the record the cursor currently points to. Call this after next() when
+   * the caller has consumed the current record. If the cursor is exhausted, the token says so.
+   */
+  void              export_token(MasstreeCursorToken* out) const;
+  /**
+   * @brief Opens this cursor from the position in the token.
+   * @param[in] token written by export_token() of a cursor on the same storage
+   * @param[in] end_key same as open(). The token doesn't remember it.
+   * @param[in] end_key_length same as open()
+   * @param[in] for_writes same as open()
+   * @param[in] end_inclusive same as open()
+   * @details
+   * Same as open() from the key in the token, inclusive, in the same direction.
+   * If the record was deleted since then, the cursor starts from the next record.
+   * The cursor skips the descent from the root when the page hint in the token is still valid.
+   * @return kErrorCodeInvalidParameter if the token is for another storage
+   */
+  ErrorCode         resume(
+    const MasstreeCursorToken& token,
+    const char* end_key = CXX11_NULLPTR,
+    KeyLength end_key_length = kKeyLengthExtremum,
+    bool for_writes = false,
+    bool end_inclusive = false);
+
   ErrorCode   open(
     const char* begin_key = CXX11_NULLPTR,
     KeyLength begin_key_length = kKeyLengthExtremum,
@@ -220,6 +456,42 @@ class MasstreeCursor CXX11_FINAL {
       end_inclusive);
   }
 
+  /**
+   * @brief Opens this cursor to read all keys that begin with the given prefix.
+   * @param[in] prefix big-endian prefix of keys, eg the leading columns of a composite key
+   * @param[in] prefix_length byte length of prefix. 0 to read all keys.
+   * @param[in] forward_cursor same as open()
+   * @param[in] for_writes same as open()
+   * @details
+   * This is same as open() from the prefix (inclusive) to the smallest key larger than
+   * all keys with the prefix (exclusive), which this method computes for you.
+   */
+  ErrorCode   open_prefix(
+    const char* prefix,
+    KeyLength prefix_length,
+    bool forward_cursor = true,
+    bool for_writes = false);
+
+  /**
+   * @brief Moves the cursor to the first record whose first prefix_length bytes differ from
+   * those of the current record (skip-scan).
+   * @param[in] prefix_length byte length of the prefix that defines distinct groups of keys
+   * @details
+   * In a forward cursor, this moves to the smallest key larger than all keys sharing the
+   * current record's prefix. In a backward cursor, this moves to the largest key smaller than
+   * all of them. For example, calling this after reading each record returns the first key
+   * of each distinct prefix. If the current key is shorter than prefix_length, no other key
+   * shares the prefix, so this is same as next().
+   *
+   * Unlike re-opening the cursor, this doesn't descend from the root when possible.
+   * It looks for the deepest page in the current route whose key range contains the new search
+   * key, and re-locates from the page. Hence, when the next prefix is in the same border page,
+   * this doesn't read any other page. Records between the two positions are not read,
+   * thus not added to the read-set. The page version set still protects the skipped range of
+   * the border pages as it does for open().
+   */
+  ErrorCode   next_distinct_prefix(KeyLength prefix_length);
+
   bool      is_valid_record() const ALWAYS_INLINE {
     return route_count_ > 0 && !reached_end_ && cur_route()->is_valid_record();
   }
@@ -255,6 +527,25 @@ class MasstreeCursor CXX11_FINAL {
     ASSERT_ND(cur_key_length_ <= sizeof(KeySlice));
     return cur_key_in_layer_slice_;
   };
+  /**
+   * @brief Returns a view of the key of the current record without copying it.
+   * @details
+   * This is the cheapest way to look at the whole key. The view compares against other keys
+   * slice by slice and copies bytes only when asked to. It's valid until the cursor moves.
+   */
+  MasstreeKeyView get_key_view() const ALWAYS_INLINE {
+    ASSERT_ND(is_valid_record());
+    ASSERT_ND(cur_key_in_layer_remainder_ != kInitiallyNextLayer);
+    MasstreeKeyView view;
+    view.prefix_be_ = cur_route_prefix_be_;
+    view.suffix_ = cur_key_suffix_;
+    view.in_layer_slice_ = cur_key_in_layer_slice_;
+    view.in_layer_remainder_ = cur_key_in_layer_remainder_;
+    view.key_length_ = cur_key_length_;
+    view.layer_ = cur_route()->layer_;
+    ASSERT_ND(cur_key_length_ == cur_key_in_layer_remainder_ + view.layer_ * sizeof(KeySlice));
+    return view;
+  }
   /**
    * @brief Copies the entire big-endian key of the current record to the given buffer.
    * @param[out] buffer to receive the combined big-endian key. must be get_key_length() or longer.
@@ -272,10 +563,15 @@ class MasstreeCursor CXX11_FINAL {
    * What we can do is only get_key_suffix() in that regard.
    * We removed the get_key() method and instead added this explicit copy-method so that the
    * user can choose when to re-construct the entire key.
+   * If you only need to compare the key or read a few slices of it, use get_key_view().
    */
-  void        copy_combined_key(char* buffer) const;
+  void        copy_combined_key(char* buffer) const ALWAYS_INLINE {
+    get_key_view().copy_to(buffer);
+  }
   /** Another version to get a part of the key, from the offset for len bytes. */
-  void        copy_combined_key_part(KeyLength offset, KeyLength len, char* buffer) const;
+  void        copy_combined_key_part(KeyLength offset, KeyLength len, char* buffer) const {
+    get_key_view().copy_part(offset, len, buffer);
+  }
   /** For even handier use, it returns std::string. It's SLOOOW. So use it as such. */
   std::string get_combined_key() const ALWAYS_INLINE {
     char buf[kMaxKeyLength];
@@ -304,6 +600,22 @@ class MasstreeCursor CXX11_FINAL {
    */
   ErrorCode next();
 
+  /**
+   * @brief Returns the current record and all following records in the same border page,
+   * then moves the cursor to the first record after them.
+   * @param[out] out receives the records. Empty if the cursor already reached the end.
+   * @details
+   * This gives the same records as calling get_xxx() and next() repeatedly, but it does
+   * the route maintenance and end-key checks of next() only once per border page
+   * rather than once per record. Hence, this is much cheaper for long scans.
+   * Records are still observed one by one as in next(), so a serializable transaction still
+   * takes a read-set per record. The page version does not change when a record is
+   * overwritten, so the page version set alone can't protect them.
+   * After this method, overwrite_record() etc apply to the new current record of the cursor,
+   * not to the records in out.
+   */
+  ErrorCode next_batch(MasstreeRecordBatch* out);
+
 
   ErrorCode delete_record();
 
@@ -330,6 +642,24 @@ class MasstreeCursor CXX11_FINAL {
   bool        end_inclusive_;
   bool        reached_end_;
 
+  /** @see set_predicate() */
+  const RecordPredicate* predicate_;
+
+  /** @see set_max_prefetch_pages() */
+  uint16_t    max_prefetch_pages_;
+  /** How many border pages we prefetch ahead now. Doubles on each page transition. */
+  uint16_t    prefetch_window_;
+  /** How many border pages after the current one we have already prefetched. */
+  uint16_t    prefetched_pages_;
+
+  /** Border page resume() starts from instead of the root. Consumed by open(). */
+  MasstreeBorderPage* resume_hint_;
+  /**
+   * Whether routes_[0] is a border page from resume() rather than the root.
+   * When we are done with the page, we descend from the root to the next page.
+   */
+  bool        resumed_from_hint_;
+
   /** If this value is zero, it means supremum. */
   KeyLength   end_key_length_;
   /** If this value is zero, it means supremum. */
@@ -413,6 +743,12 @@ class MasstreeCursor CXX11_FINAL {
    */
   ErrorCode fetch_cur_record_logical(MasstreeBorderPage* page, SlotIndex record);
   void      check_end_key();
+  /**
+   * Whether the current record must be skipped because it's deleted or doesn't match
+   * predicate_. When predicate_ is set, this checks the end key before evaluating it
+   * so that we don't skip over the end. Thus, this might make !is_valid_record().
+   */
+  bool      should_skip_cur_record();
   bool      is_cur_key_next_layer() const { return cur_key_location_.observed_.is_next_layer(); }
   KeyCompareResult compare_cur_key_aginst_search_key(KeySlice slice, uint8_t layer) const;
   KeyCompareResult compare_cur_key_aginst_end_key() const;
@@ -470,6 +806,23 @@ class MasstreeCursor CXX11_FINAL {
    * @post the common conditions above
    */
   ErrorCode locate_layer(uint8_t layer);
+  /** Sets up the slice to search in the layer, also search_key_in_layer_extremum_. */
+  KeySlice  setup_search_slice(uint8_t layer);
+  /** Descends to the page after the border page resume() started from. */
+  ErrorCode locate_after_resume_hint();
+  /**
+   * Locates the search key again from the deepest page in the current route that contains it.
+   * Used by next_distinct_prefix(). Falls back to a descent from the root.
+   */
+  ErrorCode locate_from_route();
+  /**
+   * Called after locating a record in open() etc. Moves on if the located record is
+   * deleted or doesn't match the predicate, or we are at an empty page or a page boundary.
+   * Then checks the end key.
+   */
+  ErrorCode locate_finish();
+  /** @return the border page in the token if we can start from it, or null */
+  MasstreeBorderPage* get_usable_resume_hint(const MasstreeCursorToken& token) const;
   /**
    * [Initial Search] Go down until it locates the border page under the current layer.
    * @pre cur_route()->page_->is_border()
@@ -497,6 +850,13 @@ class MasstreeCursor CXX11_FINAL {
   ErrorCode proceed_deeper_border();
   ErrorCode proceed_deeper_intermediate();
   void      proceed_route_intermediate_rebase_separator();
+  /**
+   * Prefetches border pages after the page we just entered from the given intermediate page.
+   * @param[in] parent the route of the intermediate page. Its index_/index_mini_ point to the
+   * border page we just entered.
+   * @param[in] moved_to_sibling whether we came from the previous sibling in the same parent
+   */
+  ErrorCode prefetch_next_border_pages(const Route* parent, bool moved_to_sibling);
 
   void set_should_skip_cur_route();
 
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_MASSTREE_MASSTREE_HINT_IMPL_HPP_
+#define FOEDUS_STORAGE_MASSTREE_MASSTREE_HINT_IMPL_HPP_
+
+#include <stdint.h>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/compiler.hpp"
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/masstree/fwd.hpp"
+#include "foedus/storage/masstree/masstree_id.hpp"
+
+namespace foedus {
+namespace storage {
+namespace masstree {
+
+/**
+ * @brief Thread-local cache of the last root-to-border descent in the first layer.
+ * @ingroup MASSTREE
+ * @details
+ * Each thread remembers the volatile pages it went through in its last descent,
+ * pages_[0] being the first root and pages_[depth_ - 1] the border page.
+ * The next lookup in the same storage starts from the deepest remembered page whose
+ * fences still cover the key. Consecutive lookups with nearby keys thus skip the descent
+ * entirely, and a lookup that misses the border page restarts from the nearest ancestor
+ * rather than from the root.
+ *
+ * @par Why a remembered page is safe to start from
+ * Fences of a masstree page never change. When a page splits, it is marked as moved and
+ * the new key ranges go to foster twins. Hence, a page that is not moved and whose fences
+ * cover the key is responsible for the key, even without going through its parent.
+ * The remaining concern is that the page might be already returned to the page pool.
+ * Retired pages are returned only after two epochs (see
+ * thread::ThreadPimpl::collect_retired_volatile_page()), and volatile pages are dropped
+ * only in snapshotting. So, we remember the epochs as of the descent and discard the path
+ * when either of them changes. Snapshotting drops volatile pages while transactions are paused,
+ * and it publishes the new snapshot epoch before resuming them, so no transaction observes
+ * the old snapshot epoch after the drop. As a last line of defense, we also check the storage
+ * ID and layer in the page header before starting from a remembered page.
+ * Only volatile pages are remembered because snapshot pages might be evicted from the snapshot
+ * cache at any time.
+ *
+ * @par Recent border pages
+ * When a lookup descends to a different border page, the previous border page is kept in
+ * recent_borders_, so that lookups alternating between a few key ranges in the same storage
+ * still skip the descent.
+ * Each thread has kSlotsPerThread paths. A storage uses the slot of its ID modulo
+ * kSlotsPerThread, so transactions touching a few storages keep a path for each of them.
+ *
+ * This object is just a physical hint. It does not take any read-set nor page-version set.
+ * The caller does the usual logical checks on the border page it gets.
+ */
+struct MasstreeDescentPath {
+  enum Constants {
+    /** Far deeper than any layer we would have. */
+    kMaxDepth = 16,
+    /** Number of border pages kept in recent_borders_ */
+    kRecentBorders = 4,
+    /** Number of MasstreeDescentPath each thread has. Storages are direct-mapped to them. */
+    kSlotsPerThread = 8,
+  };
+
+  /** ID of the storage the pages belong to. 0 if nothing is remembered. */
+  StorageId           storage_id_;
+  /** Current global epoch as of the descent. */
+  Epoch::EpochInteger current_epoch_;
+  /** Snapshot epoch as of the descent. */
+  Epoch::EpochInteger snapshot_epoch_;
+  /** Number of valid pages in pages_. */
+  uint16_t            depth_;
+  /** Number of valid pages in recent_borders_. */
+  uint16_t            recent_border_count_;
+  /** Volatile pages from the first root to the border page. */
+  MasstreePage*       pages_[kMaxDepth];
+  /** Border pages we previously descended to, the most recent first. */
+  MasstreePage*       recent_borders_[kRecentBorders];
+
+  void clear() {
+    storage_id_ = 0;
+    current_epoch_ = Epoch::kEpochInvalid;
+    snapshot_epoch_ = Epoch::kEpochInvalid;
+    depth_ = 0;
+    recent_border_count_ = 0;
+  }
+
+  /** @return whether the remembered pages can be used in the given storage and epochs */
+  bool is_usable(StorageId storage_id, Epoch current_epoch, Epoch snapshot_epoch) const {
+    return depth_ > 0
+      && storage_id_ == storage_id
+      && current_epoch_ == current_epoch.value()
+      && snapshot_epoch_ == snapshot_epoch.value();
+  }
+
+  /** Starts remembering a new descent, keeping the first \b depth pages. */
+  void reset(StorageId storage_id, Epoch current_epoch, Epoch snapshot_epoch, uint16_t depth) {
+    storage_id_ = storage_id;
+    current_epoch_ = current_epoch.value();
+    snapshot_epoch_ = snapshot_epoch.value();
+    depth_ = depth;
+    recent_border_count_ = 0;
+  }
+
+  /**
+   * Truncates the path to the first \b depth pages to descend again from there.
+   * The current border page, if any, is remembered in recent_borders_.
+   */
+  void truncate(uint16_t depth) {
+    ASSERT_ND(depth < depth_);
+    MasstreePage* border = pages_[depth_ - 1U];
+    uint16_t count = recent_border_count_;
+    if (count == kRecentBorders) {
+      --count;
+    }
+    for (uint16_t i = count; i > 0; --i) {
+      recent_borders_[i] = recent_borders_[i - 1U];
+    }
+    recent_borders_[0] = border;
+    recent_border_count_ = count + 1U;
+    depth_ = depth;
+  }
+
+  /**
+   * Makes the given page in recent_borders_ the current border page.
+   * The old border page takes its place in recent_borders_.
+   */
+  void swap_border(uint16_t recent_index, MasstreePage* page) {
+    ASSERT_ND(recent_index < recent_border_count_);
+    ASSERT_ND(depth_ > 0);
+    recent_borders_[recent_index] = pages_[depth_ - 1U];
+    pages_[depth_ - 1U] = page;
+  }
+
+  /** Remembers one more page. Silently ignores too deep pages. */
+  void push(MasstreePage* page) ALWAYS_INLINE {
+    if (LIKELY(depth_ < kMaxDepth)) {
+      pages_[depth_] = page;
+      ++depth_;
+    }
+  }
+};
+
+}  // namespace masstree
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_MASSTREE_MASSTREE_HINT_IMPL_HPP_
@@ -151,11 +151,18 @@ struct SplitBorder final : public xct::SysxctFunctor {
  * if piggyback_adopt_child_ is non-null. We lock target/piggyback_adopt_child_
  * in canonical order.
  *
+ * more_adopt_children_ is used only via split_impl_no_error() from Adopt, which locks
+ * all of them beforehand.
+ *
  * Obviously no chance of deadlocks or even any conditional locks
  * after releasing enclosing user transaction's locks.
  * max_retries=2 should be enough in run_nested_sysxct().
  */
 struct SplitIntermediate final : public xct::SysxctFunctor {
+  enum Constants {
+    /** Maximal number of more_adopt_children_. Adopt::kMaxBatchedAdoptions - 1. */
+    kMaxMoreAdoptChildren = 7,
+  };
   /** Thread context */
   thread::Thread* const       context_;
   /**
@@ -175,15 +182,29 @@ struct SplitIntermediate final : public xct::SysxctFunctor {
    * @pre piggyback_adopt_child_ == nullptr || piggyback_adopt_child_->has_foster_child()
    */
   MasstreePage* const         piggyback_adopt_child_;
+  /**
+   * Other children of target_ whose foster-twins are adopted in this split, too.
+   * Adopt uses this to adopt several children with one split of their parent.
+   * @pre each of them is locked, moved, and not retired.
+   */
+  MasstreePage* const* const  more_adopt_children_;
+  /** Number of pages in more_adopt_children_. Up to kMaxMoreAdoptChildren. */
+  const uint16_t              more_adopt_children_count_;
 
   SplitIntermediate(
     thread::Thread* context,
     MasstreeIntermediatePage* target,
-    MasstreePage* piggyback_adopt_child = nullptr)
+    MasstreePage* piggyback_adopt_child = nullptr,
+    MasstreePage* const* more_adopt_children = nullptr,
+    uint16_t more_adopt_children_count = 0)
     : xct::SysxctFunctor(),
       context_(context),
       target_(target),
-      piggyback_adopt_child_(piggyback_adopt_child) {
+      piggyback_adopt_child_(piggyback_adopt_child),
+      more_adopt_children_(more_adopt_children),
+      more_adopt_children_count_(more_adopt_children_count) {
+    ASSERT_ND(more_adopt_children_count_ == 0 || piggyback_adopt_child_);
+    ASSERT_ND(more_adopt_children_count_ <= kMaxMoreAdoptChildren);
   }
 
   virtual ErrorCode run(xct::SysxctWorkspace* sysxct_workspace) override;
@@ -205,7 +226,8 @@ struct SplitIntermediate final : public xct::SysxctFunctor {
    */
   struct SplitStrategy {
     enum Constants {
-      kMaxSeparators = 170,  // must be larger than kMaxIntermediatePointers
+      // must be larger than kMaxIntermediatePointers + 1 + kMaxMoreAdoptChildren
+      kMaxSeparators = 170,
     };
     /**
     * pointers_[n] points to page that is responsible for keys
@@ -588,6 +588,28 @@ class MasstreeStorage CXX11_FINAL : public Storage<MasstreeStorageControlBlock>
    */
   ErrorCode   peek_volatile_page_boundaries(Engine* engine, const PeekBoundariesArguments& args);
 
+  /**
+   * @brief Estimates an equi-depth histogram of first-layer keys in this storage.
+   * @param[in] engine Engine
+   * @param[in] bucket_count Number of buckets the caller wants.
+   * @param[out] boundaries Receives up to bucket_count - 1 slices in ascending order. Each slice
+   * is the inclusive lower bound of a bucket. The first bucket starts at kInfimumSlice.
+   * @param[out] boundary_count Number of entries written to boundaries
+   * @details
+   * This is built on peek_volatile_page_boundaries(). Border pages hold roughly similar numbers
+   * of records, so picking every N-th border page boundary gives buckets of similar depth.
+   * Just like peeking, this is opportunistic and not transactionally protected.
+   * It only sees volatile pages, so it returns no boundaries when the volatile pages are dropped.
+   * This is an on-demand sampling helper, not part of StorageStatistics, which is what
+   * StorageManager::get_statistics() maintains across snapshots.
+   * Defined in masstree_storage_peek.cpp
+   */
+  ErrorCode   estimate_key_histogram(
+    Engine* engine,
+    uint32_t bucket_count,
+    KeySlice* boundaries,
+    uint32_t* boundary_count);
+
   /**
    * @brief Deliberately causes splits under the volatile root of first layer, or "fatify" it.
    * @param[in] context Thread context
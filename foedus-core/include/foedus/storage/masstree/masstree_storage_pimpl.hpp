@@ -133,6 +133,30 @@ class MasstreeStoragePimpl final : public Attachable<MasstreeStorageControlBlock
     bool      for_writes,
     KeySlice  slice,
     MasstreeBorderPage** border) ALWAYS_INLINE;
+  /**
+   * The descent loop of find_border_physical(). Unlike find_border_physical(), \b start
+   * can be any page in the layer whose fences cover the slice.
+   * @param[in,out] path if not null, volatile pages we go through are appended to it
+   */
+  ErrorCode find_border_descend(
+    thread::Thread* context,
+    MasstreePage* start,
+    uint8_t   current_layer,
+    bool      for_writes,
+    KeySlice  slice,
+    MasstreeBorderPage** border,
+    MasstreeDescentPath* path) ALWAYS_INLINE;
+  /**
+   * find_border_physical() in the first layer that makes use of the thread's last descent.
+   * Starts from the deepest page in MasstreeDescentPath that still covers the slice,
+   * and from the first root if there is no such page.
+   * @note this method is \e physical-only. It doesn't take any long-term lock or readset.
+   */
+  ErrorCode find_border_hinted(
+    thread::Thread* context,
+    bool      for_writes,
+    KeySlice  slice,
+    MasstreeBorderPage** border);
 
   /** Identifies page and record for the key */
   ErrorCode locate_record(
@@ -352,6 +376,9 @@ static_assert(sizeof(MasstreeStoragePimpl) <= kPageSize, "MasstreeStoragePimpl i
 static_assert(
   sizeof(MasstreeStorageControlBlock) <= soc::GlobalMemoryAnchors::kStorageMemorySize,
   "MasstreeStorageControlBlock is too large.");
+static_assert(
+  sizeof(MasstreeStorageControlBlock) <= kStorageStatisticsOffset,
+  "MasstreeStorageControlBlock overlaps with StorageStatistics.");
 }  // namespace masstree
 }  // namespace storage
 }  // namespace foedus
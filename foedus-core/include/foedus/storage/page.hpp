@@ -399,6 +399,25 @@ inline Page* to_page(const void* address) {
     reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(aligned_address)));
 }
 
+/**
+ * @brief Computes CRC32C of a snapshot page image, skipping PageHeader::checksum_ itself.
+ * @ingroup STORAGE
+ * @details
+ * SnapshotWriter stores this in checksum_ right before writing each page out, and readers
+ * optionally verify it (CacheOptions::verify_snapshot_checksum_).
+ * This never returns 0 because checksum_==0 means the page has no checksum,
+ * for example a snapshot file written before we started to checksum pages.
+ */
+Checksum compute_page_checksum(const Page* page);
+
+/**
+ * @brief Returns whether the checksum_ of the snapshot page image matches its content.
+ * @ingroup STORAGE
+ * @details
+ * Pages without checksum (checksum_==0) are always considered valid.
+ */
+bool verify_page_checksum(const Page* page);
+
 inline void assert_aligned_page(const void* page) {
   ASSERT_ND(page);
   ASSERT_ND(reinterpret_cast<uintptr_t>(page) % kPageSize == 0);
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_RECORD_PREDICATE_HPP_
+#define FOEDUS_STORAGE_RECORD_PREDICATE_HPP_
+#include <stdint.h>
+
+#include <cstring>
+
+#include "foedus/compiler.hpp"
+#include "foedus/cxx11.hpp"
+
+namespace foedus {
+namespace storage {
+
+/**
+ * @brief A user-defined filter on record payloads.
+ * @return whether the record should be returned
+ * @ingroup STORAGE
+ */
+typedef bool (*RecordFilterFunction)(
+  const char* payload,
+  uint16_t payload_length,
+  void* user_data);
+
+/**
+ * @brief A filter on record payloads that cursors evaluate before returning records.
+ * @ingroup STORAGE
+ * @details
+ * This consists of an optional typed comparison of one payload field against a constant,
+ * and an optional user-defined filter function. A record matches when it passes both.
+ * Cursors that receive this object skip non-matching records inside their page loop,
+ * so the caller never sees them.
+ *
+ * Note that skipping a record does not mean that the transaction didn't read it.
+ * A record that doesn't match now might be updated to match before we commit.
+ * Hence, cursors still protect non-matching records in the same way as matching ones,
+ * eg a read-set in serializable transactions.
+ *
+ * Records too short to contain the field do not match.
+ * This is a POD. The cursor just points to it, so keep it alive while using the cursor.
+ * @code{.cpp}
+ * RecordPredicate predicate = RecordPredicate::make_field<uint32_t>(
+ *   offsetof(OrderlineData, quantity_), RecordPredicate::kLess, 10U);
+ * cursor.set_predicate(&predicate);
+ * @endcode
+ */
+struct RecordPredicate {
+  enum FieldType {
+    /** No typed comparison. Only filter_function_, if set. */
+    kNoField = 0,
+    kUint16,
+    kInt16,
+    kUint32,
+    kInt32,
+    kUint64,
+    kInt64,
+    kDouble,
+  };
+  enum Comparator {
+    kEqual = 0,
+    kNotEqual,
+    kLess,
+    kLessEqual,
+    kGreater,
+    kGreaterEqual,
+  };
+  union Operand {
+    uint64_t  unsigned_;
+    int64_t   signed_;
+    double    double_;
+  };
+
+  /** Byte offset of the compared field in the payload. */
+  uint16_t              field_offset_;
+  /** Type of the compared field. Native-endian, no alignment required. */
+  FieldType             field_type_;
+  /** field comparator operand_ */
+  Comparator            comparator_;
+  Operand               operand_;
+  /** Optional user-defined filter. Evaluated after the typed comparison. */
+  RecordFilterFunction  filter_function_;
+  /** Passed to filter_function_ as-is. */
+  void*                 filter_user_data_;
+
+  /** Matches every record. */
+  static RecordPredicate make_empty() {
+    RecordPredicate ret;
+    std::memset(&ret, 0, sizeof(ret));
+    ret.field_type_ = kNoField;
+    ret.filter_function_ = CXX11_NULLPTR;
+    ret.filter_user_data_ = CXX11_NULLPTR;
+    return ret;
+  }
+  /** Matches records for which the given function returns true. */
+  static RecordPredicate make_function(RecordFilterFunction function, void* user_data) {
+    RecordPredicate ret = make_empty();
+    ret.filter_function_ = function;
+    ret.filter_user_data_ = user_data;
+    return ret;
+  }
+  /**
+   * Matches records whose field of type T at the offset satisfies the comparison with operand.
+   * T must be one of the types in FieldType.
+   */
+  template <typename T>
+  static RecordPredicate make_field(uint16_t field_offset, Comparator comparator, T operand);
+
+  /** @return whether the record of the given payload matches this predicate */
+  bool evaluate(const char* payload, uint16_t payload_length) const ALWAYS_INLINE {
+    if (field_type_ != kNoField && !evaluate_field(payload, payload_length)) {
+      return false;
+    }
+    if (filter_function_ && !filter_function_(payload, payload_length, filter_user_data_)) {
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  template <typename T>
+  static ALWAYS_INLINE bool compare(T value, T operand, Comparator comparator) {
+    switch (comparator) {
+    case kEqual:        return value == operand;
+    case kNotEqual:     return value != operand;
+    case kLess:         return value < operand;
+    case kLessEqual:    return value <= operand;
+    case kGreater:      return value > operand;
+    case kGreaterEqual: return value >= operand;
+    default:            return false;
+    }
+  }
+  template <typename T>
+  static ALWAYS_INLINE T read_field(const char* payload, uint16_t field_offset) {
+    T value;
+    std::memcpy(&value, payload + field_offset, sizeof(T));
+    return value;
+  }
+  bool evaluate_field(const char* payload, uint16_t payload_length) const ALWAYS_INLINE {
+    switch (field_type_) {
+    case kUint16:
+      return field_offset_ + sizeof(uint16_t) <= payload_length
+        && compare<uint16_t>(
+          read_field<uint16_t>(payload, field_offset_),
+          static_cast<uint16_t>(operand_.unsigned_),
+          comparator_);
+    case kInt16:
+      return field_offset_ + sizeof(int16_t) <= payload_length
+        && compare<int16_t>(
+          read_field<int16_t>(payload, field_offset_),
+          static_cast<int16_t>(operand_.signed_),
+          comparator_);
+    case kUint32:
+      return field_offset_ + sizeof(uint32_t) <= payload_length
+        && compare<uint32_t>(
+          read_field<uint32_t>(payload, field_offset_),
+          static_cast<uint32_t>(operand_.unsigned_),
+          comparator_);
+    case kInt32:
+      return field_offset_ + sizeof(int32_t) <= payload_length
+        && compare<int32_t>(
+          read_field<int32_t>(payload, field_offset_),
+          static_cast<int32_t>(operand_.signed_),
+          comparator_);
+    case kUint64:
+      return field_offset_ + sizeof(uint64_t) <= payload_length
+        && compare<uint64_t>(read_field<uint64_t>(payload, field_offset_), operand_.unsigned_,
+          comparator_);
+    case kInt64:
+      return field_offset_ + sizeof(int64_t) <= payload_length
+        && compare<int64_t>(read_field<int64_t>(payload, field_offset_), operand_.signed_,
+          comparator_);
+    case kDouble:
+      return field_offset_ + sizeof(double) <= payload_length
+        && compare<double>(read_field<double>(payload, field_offset_), operand_.double_,
+          comparator_);
+    default:
+      return true;
+    }
+  }
+};
+
+/** Maps a C++ type to RecordPredicate::FieldType and sets the operand. */
+template <typename T> struct RecordPredicateFieldTraits;
+#define FOEDUS_RECORD_PREDICATE_TRAITS(TYPE, FIELD_TYPE, MEMBER) \
+template <> struct RecordPredicateFieldTraits< TYPE > { \
+  static void set(TYPE operand, RecordPredicate* out) { \
+    out->field_type_ = RecordPredicate::FIELD_TYPE; \
+    out->operand_.MEMBER = operand; \
+  } \
+}
+FOEDUS_RECORD_PREDICATE_TRAITS(uint16_t, kUint16, unsigned_);
+FOEDUS_RECORD_PREDICATE_TRAITS(int16_t, kInt16, signed_);
+FOEDUS_RECORD_PREDICATE_TRAITS(uint32_t, kUint32, unsigned_);
+FOEDUS_RECORD_PREDICATE_TRAITS(int32_t, kInt32, signed_);
+FOEDUS_RECORD_PREDICATE_TRAITS(uint64_t, kUint64, unsigned_);
+FOEDUS_RECORD_PREDICATE_TRAITS(int64_t, kInt64, signed_);
+FOEDUS_RECORD_PREDICATE_TRAITS(double, kDouble, double_);
+#undef FOEDUS_RECORD_PREDICATE_TRAITS
+
+template <typename T>
+inline RecordPredicate RecordPredicate::make_field(
+  uint16_t field_offset,
+  Comparator comparator,
+  T operand) {
+  RecordPredicate ret = make_empty();
+  ret.field_offset_ = field_offset;
+  ret.comparator_ = comparator;
+  RecordPredicateFieldTraits<T>::set(operand, &ret);
+  return ret;
+}
+
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_RECORD_PREDICATE_HPP_
@@ -26,12 +26,16 @@ namespace foedus {
 namespace storage {
 namespace sequential {
 struct  SequentialAppendLogType;
+struct  SequentialConsumerGroupLogType;
 struct  SequentialCreateLogType;
+class   SequentialConsumer;
 class   SequentialCursor;
 struct  SequentialMetadata;
 class   SequentialPage;
+class   SequentialParallelScan;
 class   SequentialPartitioner;
 class   SequentialRootPage;
+struct  SequentialScanPartition;
 struct  SequentialRecordBatch;
 class   SequentialRecordIterator;
 class   SequentialStorage;
@@ -40,17 +40,23 @@ namespace sequential {
  * @ingroup SEQUENTIAL
  * @details
  * Like partitioner, this does a quite simple stuff.
- * We don't need to do any merge-sort as there is no order.
- * We just sequentially add them all.
+ * We don't need any key order. We just merge the sorted runs by epoch, which
+ * SequentialPartitioner::sort_batch() sorted each run by, and sequentially add them all.
  *
  * @par Page allcation in compose()
  * This composer sequentially writes out data pages until the main buffer in snapshot_writer_
- * becomes full. Whenever it does, it writes out all the pages and treat the first page
- * as one head page. So, this compose() can output more than one head pages.
- * By doing this, we don't have to worry about any of the intermediate pages and pointer
- * installations. Sooooo simple.
- * The limit is of course 500 pointers (4kb), but surely it will fit.
- * If it doesn't, we must consider allowing variable-sized root info page.
+ * becomes full. Whenever it does, it writes out all the pages and continues the same linked list
+ * from the next page. By doing this, we don't have to worry about any of the intermediate pages
+ * and pointer installations. Sooooo simple.
+ *
+ * @par Epoch index
+ * Once the current linked list has kPagesPerHead pages, compose() starts a new linked list
+ * (a new head page) at the next page boundary. Because the records are ordered by epoch,
+ * each head pointer covers a narrow range of epochs. SequentialCursor skips
+ * head pointers whose epoch range doesn't overlap with the requested range, so the head
+ * pointers in root pages serve as an epoch index without reading any data page.
+ * One compose() outputs at most kMaxHeadsPerCompose head pointers (one root info page).
+ * If there are more pages, the last linked list just gets longer.
  *
  * @note
  * This is a private implementation-details of \ref SEQUENTIAL, thus file name ends with _impl.
@@ -59,14 +65,23 @@ namespace sequential {
  */
 class SequentialComposer final {
  public:
+  enum Constants {
+    /** compose() starts a new head page once the current linked list has this many pages. */
+    kPagesPerHead = 64,
+    /** Maximum number of head pointers in one RootInfoPage. */
+    kMaxHeadsPerCompose = (kPageSize - sizeof(PageHeader) - 8) / sizeof(HeadPagePointer),
+  };
+
   /**
    * Output of one compose() call, which are then combined in construct_root().
-   * Each compose() returns just one pointer to a head page.
+   * Each compose() returns pointers to the head pages it wrote, in epoch order.
    */
   struct RootInfoPage final {
-    PageHeader      header_;
-    HeadPagePointer pointer_;
-    char            filler_[kPageSize - sizeof(PageHeader) - sizeof(HeadPagePointer)];
+    PageHeader      header_;                    // +40 -> 40
+    uint64_t        pointer_count_;             // +8 -> 48
+    HeadPagePointer pointers_[kMaxHeadsPerCompose];
+    char            filler_[
+      kPageSize - sizeof(PageHeader) - 8 - sizeof(HeadPagePointer) * kMaxHeadsPerCompose];
   };
 
   explicit SequentialComposer(Composer *parent);
@@ -81,7 +96,7 @@ class SequentialComposer final {
   SequentialPage*     compose_new_head(snapshot::SnapshotWriter* snapshot_writer);
   ErrorStack          dump_pages(
     snapshot::SnapshotWriter* snapshot_writer,
-    bool last_dump,
+    bool end_of_head,
     uint32_t allocated_pages,
     uint64_t* total_pages);
 
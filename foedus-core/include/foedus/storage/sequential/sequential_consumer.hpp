@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_SEQUENTIAL_SEQUENTIAL_CONSUMER_HPP_
+#define FOEDUS_STORAGE_SEQUENTIAL_SEQUENTIAL_CONSUMER_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_code.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/storage/sequential/fwd.hpp"
+#include "foedus/storage/sequential/sequential_storage.hpp"
+#include "foedus/thread/fwd.hpp"
+
+namespace foedus {
+namespace storage {
+namespace sequential {
+/**
+ * @brief Reads a sequential storage as a work queue on behalf of a consumer group.
+ * @ingroup SEQUENTIAL
+ * @details
+ * Each poll() resumes from where the group left off, so consumers don't have to scan from
+ * the beginning and filter by application state.
+ * @code{.cpp}
+ * memory::AlignedMemory buffer(1 << 16, 1 << 12, kNumaAllocOnnode, 0);
+ * SequentialConsumer consumer(context, storage, kMyGroup, buffer.get_block(), 1 << 16);
+ * CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+ * CHECK_ERROR(consumer.poll(1000));
+ * for (uint32_t i = 0; i < consumer.get_record_count(); ++i) {
+ *   process(consumer.get_record(i), consumer.get_record_length(i));
+ * }
+ * CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+ * CHECK_ERROR(consumer.ack(&ack_epoch));
+ * @endcode
+ *
+ * @par Position
+ * The position of a group is an epoch, persisted as SequentialMetadata::consumer_epochs_.
+ * Records in this storage are stored in per-core page lists that the snapshot rewrites,
+ * so a finer position such as a page offset would not survive snapshots.
+ * Instead, poll() never splits an epoch: it returns all records of one or more epochs.
+ * A consumer that crashes before ack() receives the same epochs again (at-least-once).
+ *
+ * @par Cost
+ * poll() reads only the epochs after the position, and ack() truncates the storage up to
+ * the slowest group. poll() reads the pending epochs twice: once to decide how many epochs
+ * fit in max_records and once to copy the records. The first read stops reading each core's
+ * records once it has seen enough records to decide, and snapshot pages outside of the
+ * epochs are skipped by their epoch ranges. Hence, one poll() costs roughly max_records plus
+ * the number of pages before the position, not the total number of pending records.
+ * The copied records are reserved at once, so poll() doesn't grow memory record by record.
+ * ack() writes one metadata log that both moves the position and truncates.
+ *
+ * One group should have one consumer at a time. Use separate groups for independent
+ * consumers. This object is not thread-safe.
+ */
+class SequentialConsumer CXX11_FINAL {
+ public:
+  /**
+   * @param[in] context Thread context of the transaction
+   * @param[in] storage The sequential storage to read from
+   * @param[in] group A consumer group added by SequentialStorage::add_consumer_group()
+   * @param[in,out] buffer Same as the buffer of SequentialCursor
+   * @param[in] buffer_size Byte size of buffer. Must be at least 4kb.
+   */
+  SequentialConsumer(
+    thread::Thread* context,
+    const SequentialStorage& storage,
+    uint16_t group,
+    void* buffer,
+    uint64_t buffer_size);
+
+  /**
+   * @brief Reads records of the next epochs of the group in the current transaction.
+   * @param[in] max_records Returns epochs as far as the total number of records is at most this.
+   * If the first epoch has more records, returns all records of the epoch anyway.
+   * @return kErrorCodeInvalidParameter if the group is not used
+   * @details
+   * This reads only safe epochs, so it doesn't add anything to the read-set except the
+   * truncate-epoch. The records are copied, so they are valid until the next poll().
+   * Records are ordered by epochs. Calling poll() again without ack() returns the epochs
+   * after the previous poll().
+   */
+  ErrorCode   poll(uint32_t max_records);
+
+  /**
+   * @brief Advances the position of the group to the end of the epochs polled so far.
+   * @param[out] commit_epoch The epoch when the change has happened, or invalid if nothing
+   * to acknowledge.
+   * @details
+   * Call this after processing the records. This is a metadata operation, so it does not
+   * need to be in a transaction.
+   * @see SequentialStorage::ack_consumer_group()
+   */
+  ErrorStack  ack(Epoch* commit_epoch);
+
+  uint16_t    get_group() const { return group_; }
+  /** Exclusive end of the epochs polled so far. Invalid if nothing was polled. */
+  Epoch       get_polled_epoch() const { return polled_epoch_; }
+
+  /** Number of records returned by the last poll(). */
+  uint32_t    get_record_count() const { return records_.size(); }
+  const char* get_record(uint32_t index) const {
+    ASSERT_ND(index < records_.size());
+    return &data_[records_[index].offset_];
+  }
+  uint16_t    get_record_length(uint32_t index) const {
+    ASSERT_ND(index < records_.size());
+    return records_[index].length_;
+  }
+  Epoch       get_record_epoch(uint32_t index) const {
+    ASSERT_ND(index < records_.size());
+    return records_[index].epoch_;
+  }
+
+ private:
+  struct PolledRecord {
+    uint64_t  offset_;
+    uint16_t  length_;
+    Epoch     epoch_;
+  };
+  struct EpochCount {
+    Epoch     epoch_;
+    uint32_t  count_;
+    /** Total byte length of the records. */
+    uint64_t  bytes_;
+    bool operator<(const EpochCount& other) const { return epoch_ < other.epoch_; }
+  };
+  enum Constants {
+    /** Initial capacity of epoch_counts_. It grows only if more epochs are pending. */
+    kInitialEpochCounts = 64,
+  };
+
+  /** @return exclusive end of epochs poll() can read now */
+  Epoch       get_safe_end_epoch() const;
+  /**
+   * @return the first epoch in epoch_counts_ (sorted) whose records don't fit in max_records
+   * after the previous epochs. Invalid if all of them fit.
+   */
+  Epoch       find_end_epoch(uint32_t max_records) const;
+  /** Counts records per epoch in [from, to) and returns the end that fits in max_records. */
+  ErrorCode   decide_end_epoch(Epoch from, Epoch to, uint32_t max_records, Epoch* out);
+  /** Copies all records in [from, to) to data_ and records_. */
+  ErrorCode   copy_records(Epoch from, Epoch to);
+
+  thread::Thread* const         context_;
+  SequentialStorage             storage_;
+  const uint16_t                group_;
+  void* const                   buffer_;
+  const uint64_t                buffer_size_;
+
+  /** @see get_polled_epoch() */
+  Epoch                         polled_epoch_;
+  /** Payloads of the records returned by the last poll(). */
+  std::vector<char>             data_;
+  std::vector<PolledRecord>     records_;
+  /** Working memory for decide_end_epoch(). */
+  std::vector<EpochCount>       epoch_counts_;
+};
+
+}  // namespace sequential
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_SEQUENTIAL_SEQUENTIAL_CONSUMER_HPP_
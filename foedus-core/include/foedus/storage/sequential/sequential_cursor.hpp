@@ -30,6 +30,7 @@
 #include "foedus/epoch.hpp"
 #include "foedus/memory/fwd.hpp"
 #include "foedus/storage/page.hpp"
+#include "foedus/storage/record_predicate.hpp"
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/storage/sequential/fwd.hpp"
 #include "foedus/storage/sequential/sequential_id.hpp"
@@ -146,6 +147,54 @@ class SequentialCursor {
   Epoch     get_from_epoch() const { return from_epoch_; }
   /** @return Exclusive end of epochs to read. */
   Epoch     get_to_epoch() const { return to_epoch_; }
+  /**
+   * @brief Lowers the exclusive end of epochs to read in the middle of the scan.
+   * @details
+   * Batches returned so far are not affected. Each snapshot head and each volatile page list
+   * is sorted by epoch, so the following batches stop reading a list once they reach the new
+   * end rather than the original one. This does nothing if to_epoch is not smaller.
+   */
+  void      narrow_to_epoch(Epoch to_epoch) {
+    ASSERT_ND(to_epoch.is_valid());
+    if (to_epoch < to_epoch_) {
+      to_epoch_ = to_epoch;
+    }
+  }
+
+  /**
+   * @brief Makes the returned iterators skip records that don't match the given predicate.
+   * @param[in] predicate the filter. The cursor and iterators just point to it, so it must be
+   * alive while they are used. null to return all records again.
+   * @details
+   * Records in sequential storages are immutable, so this doesn't change what we protect
+   * with read-sets. The skipped records are counted in
+   * SequentialRecordIterator::get_stat_filtered_records().
+   */
+  void      set_predicate(const RecordPredicate* predicate) { predicate_ = predicate; }
+  const RecordPredicate* get_predicate() const { return predicate_; }
+
+  /**
+   * @brief Makes this cursor read only one partition of each node's pages.
+   * @param[in] partition the partition to read. 0 <= partition < partition_count.
+   * @param[in] partition_count the number of partitions in each node.
+   * @details
+   * Call this before the first next_batch(). The cursor then reads the volatile page lists
+   * of threads whose in-node ordinal modulo partition_count is partition, and every
+   * partition_count-th snapshot head page (see HeadPagePointer) in each node.
+   * Combined with node_filter, partition_count cursors on one node read disjoint subsets of
+   * the node's records and together read all of them.
+   * When partition_count equals the number of threads per node, each cursor reads the volatile
+   * pages written by the thread of the same ordinal.
+   * @see SequentialParallelScan
+   */
+  void      set_partition(uint16_t partition, uint16_t partition_count) {
+    ASSERT_ND(states_.empty());
+    ASSERT_ND(partition < partition_count);
+    partition_ = partition;
+    partition_count_ = partition_count;
+  }
+  uint16_t  get_partition() const { return partition_; }
+  uint16_t  get_partition_count() const { return partition_count_; }
 
   /**
    * @brief Returns a batch of records as an iterator.
@@ -165,6 +214,12 @@ class SequentialCursor {
     return !(finished_snapshots_ && finished_safe_volatiles_ && finished_unsafe_volatiles_);
   }
 
+  /**
+   * @returns the number of snapshot pages this cursor skipped without returning them
+   * because all of their records are out of [from_epoch, to_epoch).
+   */
+  uint64_t  get_stat_skipped_pages() const { return stat_skipped_pages_; }
+
   /// Followings are rather implementation details. Used only from testcases.
   bool      is_finished_snapshots() const { return finished_snapshots_; }
   bool      is_finished_safe_volatiles() const { return finished_safe_volatiles_; }
@@ -266,10 +321,10 @@ class SequentialCursor {
    */
   Epoch                         from_epoch_;
   /**
-   * Exclusive end of epochs to read.
+   * Exclusive end of epochs to read. Only narrow_to_epoch() changes it.
    * @invariant !to_epoch_.is_valid()
    */
-  const Epoch                   to_epoch_;
+  Epoch                         to_epoch_;
 
   const Epoch                   latest_snapshot_epoch_;
 
@@ -289,6 +344,12 @@ class SequentialCursor {
   const int32_t                 node_filter_;
   const uint16_t                node_count_;
   const OrderMode               order_mode_;
+  /** @see set_predicate() */
+  const RecordPredicate*        predicate_;
+  /** @see set_partition() */
+  uint16_t                      partition_;
+  /** @see set_partition() */
+  uint16_t                      partition_count_;
   /**
    * True when either the isolation level is SI, or to_epoch_ is up to the previous snapshot epoch.
    * When this is true, we just read snapshot pages without any concern on concurrency control.
@@ -305,11 +366,21 @@ class SequentialCursor {
   /** buffer_pages_ = buffer_size_ / kPageSize */
   const uint32_t                buffer_pages_;
 
+  /**
+   * Where the currently buffered snapshot pages are. Usually same as buffer_, but it directly
+   * points to the read-only mapping of the snapshot file when CacheOptions::snapshot_file_mmap_
+   * is ON, in which case we skip copying pages into buffer_.
+   */
+  const SequentialRecordBatch*  snapshot_pages_;
+
   /// Everything above is const. Some of them doesn't have const qual due to init() method.
   /// Everything below is mutable. in other words, they are the state of this cursor.
 
   uint16_t                      current_node_;
 
+  /** @see get_stat_skipped_pages() */
+  uint64_t                      stat_skipped_pages_;
+
   /** whether this cursor has read all snapshot pages it should read. */
   bool                          finished_snapshots_;
   /** whether this cursor has read all volatile pages in safe epochs it should read. */
@@ -337,17 +408,19 @@ class SequentialCursor {
  * We keep them separate as the internal page representation might change in future.
  */
 struct SequentialRecordBatch CXX11_FINAL {
-  PageHeader            header_;            // +32 -> 32
+  PageHeader            header_;            // +40 -> 40
 
-  uint16_t              record_count_;      // +2 -> 34
-  uint16_t              used_data_bytes_;   // +2 -> 36
-  uint32_t              filler_;            // +4 -> 40
+  uint16_t              record_count_;      // +2 -> 42
+  uint16_t              used_data_bytes_;   // +2 -> 44
+  Epoch                 min_epoch_;         // +4 -> 48
+  Epoch                 max_epoch_;         // +4 -> 52
+  uint32_t              filler_;            // +4 -> 56
 
   /**
    * Pointer to next page.
    * Once it is set, the pointer and the pointed page will never be changed.
    */
-  DualPagePointer       next_page_;         // +16 -> 56
+  DualPagePointer       next_page_;         // +16 -> 72
 
   /**
    * Dynamic data part in this page, which consist of 1) record part growing forward,
@@ -383,7 +456,11 @@ struct SequentialRecordBatch CXX11_FINAL {
 class SequentialRecordIterator CXX11_FINAL {
  public:
   SequentialRecordIterator();
-  SequentialRecordIterator(const SequentialRecordBatch* batch, Epoch from_epoch, Epoch to_epoch);
+  SequentialRecordIterator(
+    const SequentialRecordBatch* batch,
+    Epoch from_epoch,
+    Epoch to_epoch,
+    const RecordPredicate* predicate = CXX11_NULLPTR);
 
   void        reset() {
     std::memset(this, 0, sizeof(SequentialRecordIterator));
@@ -403,7 +480,11 @@ class SequentialRecordIterator CXX11_FINAL {
       cur_record_epoch_ = batch_->get_epoch_from_offset(cur_offset_);
       ASSERT_ND(cur_record_epoch_.is_valid());
       if (LIKELY(in_epoch_range(cur_record_epoch_))) {
-        break;
+        if (LIKELY(matches_predicate())) {
+          break;
+        }
+        ++stat_filtered_records_;
+        continue;
       }
       // we have to skip this record
       ++stat_skipped_records_;
@@ -447,12 +528,20 @@ class SequentialRecordIterator CXX11_FINAL {
 
   /** @returns number of records we skipped so far due to from/to epoch */
   uint16_t    get_stat_skipped_records() const { return stat_skipped_records_; }
+  /** @returns number of records we skipped so far due to the predicate */
+  uint16_t    get_stat_filtered_records() const { return stat_filtered_records_; }
   /** @returns total number of records in this batch */
   uint16_t    get_record_count() const { return record_count_; }
 
   const SequentialRecordBatch* get_raw_batch() const { return batch_; }
 
  private:
+  /** Evaluates predicate_ on the record at cur_offset_, regardless of epoch. */
+  bool        matches_predicate() const ALWAYS_INLINE {
+    return predicate_ == CXX11_NULLPTR
+      || predicate_->evaluate(batch_->get_payload_from_offset(cur_offset_), cur_record_length_);
+  }
+
   const SequentialRecordBatch* batch_;  // +8 -> 8
   Epoch     from_epoch_;                // +4 -> 12
   Epoch     to_epoch_;                  // +4 -> 16
@@ -462,7 +551,8 @@ class SequentialRecordIterator CXX11_FINAL {
   uint16_t  cur_record_length_;         // +2 -> 26
   uint16_t  cur_offset_;                // +2 -> 28
   uint16_t  stat_skipped_records_;      // +2 -> 30
-  uint16_t  filler_;                    // +2 -> 32
+  uint16_t  stat_filtered_records_;     // +2 -> 32
+  const RecordPredicate* predicate_;    // +8 -> 40
 };
 
 STATIC_SIZE_CHECK(sizeof(SequentialRecordBatch), kPageSize)
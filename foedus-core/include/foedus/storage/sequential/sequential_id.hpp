@@ -39,8 +39,10 @@ const uint16_t kMaxSlots = 1 << 15;
 /**
  * Byte size of header in each data page of sequential storage.
  * @ingroup SEQUENTIAL
+ * @details
+ * This is part of the snapshot page layout. Changing it requires bumping kSequentialPageFormat.
  */
-const uint16_t kHeaderSize = 64;
+const uint16_t kHeaderSize = 72;
 /**
  * Byte size of data region in each data page of sequential storage.
  * @ingroup SEQUENTIAL
@@ -104,6 +106,26 @@ const uint16_t kRootPageDataSize = foedus::storage::kPageSize - kRootPageHeaderS
 const uint16_t kPointerPageCount = 1U << 6;
 const uint16_t kPointersPerPage = 1U << 10;
 
+/**
+ * Maximum number of consumer groups in one sequential storage.
+ * @ingroup SEQUENTIAL
+ * @see foedus::storage::sequential::SequentialMetadata::consumer_epochs_
+ */
+const uint16_t kMaxConsumerGroups = 8;
+
+/**
+ * Version of the snapshot page layout this build writes and reads.
+ * @ingroup SEQUENTIAL
+ * @details
+ * Version 0 was the original 64-byte data page header. Version 1 added the min/max epoch of
+ * records to the header (72 bytes), so the record region starts at a different offset and the
+ * two versions can not read each other's snapshot pages. Snapshots written by an older build
+ * have no page_format_ in their metadata, which reads as 0, and loading such a storage with
+ * snapshot pages fails with kErrorCodeStrSequentialIncompatibleFormat.
+ * @see foedus::storage::sequential::SequentialMetadata::page_format_
+ */
+const uint32_t kSequentialPageFormat = 1;
+
 /** Calculate the page/index of the thread-private head/tail pointer. */
 inline void get_pointer_page_and_index(uint16_t thread_id, uint16_t *page, uint16_t *index) {
   *page = thread_id / kPointersPerPage;
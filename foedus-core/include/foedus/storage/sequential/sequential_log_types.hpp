@@ -86,6 +86,33 @@ struct SequentialTruncateLogType : public log::StorageLogType {
   friend std::ostream& operator<<(std::ostream& o, const SequentialTruncateLogType& v);
 };
 
+/**
+ * @brief Log type of changing the position of a consumer group in a sequential storage.
+ * @ingroup SEQUENTIAL LOGTYPE
+ * @details
+ * This log corresponds to SequentialStorage::add_consumer_group(), remove_consumer_group(),
+ * and ack_consumer_group(). Like SequentialTruncateLogType, this is a metadata operation.
+ *
+ * This log type is infrequently triggered, so no optimization. All methods defined in cpp.
+ */
+struct SequentialConsumerGroupLogType : public log::StorageLogType {
+  LOG_TYPE_NO_CONSTRUCT(SequentialConsumerGroupLogType)
+  uint16_t  group_;           // +2 => 18
+  uint16_t  padding1_;        // +2 => 20
+  /** New value of SequentialMetadata::consumer_epochs_. Invalid when the group is removed. */
+  Epoch     new_epoch_;       // +4 => 24
+  /**
+   * New truncate-epoch if the change advances the minimum position of used groups.
+   * Invalid if this doesn't truncate. This saves a separate SequentialTruncateLogType.
+   */
+  Epoch     new_truncate_epoch_;  // +4 => 28
+  uint32_t  padding2_;        // +4 => 32
+
+  void apply_storage(Engine* engine, StorageId storage_id);
+  void assert_valid();
+  friend std::ostream& operator<<(std::ostream& o, const SequentialConsumerGroupLogType& v);
+};
+
 /**
  * @brief Log type of sequential-storage's append operation.
  * @ingroup ARRAY LOGTYPE
@@ -19,6 +19,7 @@
 #define FOEDUS_STORAGE_SEQUENTIAL_SEQUENTIAL_METADATA_HPP_
 #include <stdint.h>
 
+#include <cstring>
 #include <iosfwd>
 #include <string>
 
@@ -52,20 +53,27 @@ namespace sequential {
  */
 struct SequentialMetadata CXX11_FINAL : public Metadata {
   SequentialMetadata()
-    : Metadata(0, kSequentialStorage, ""), truncate_epoch_(Epoch::kEpochInvalid), padding_(0) {}
+    : Metadata(0, kSequentialStorage, ""), truncate_epoch_(Epoch::kEpochInvalid),
+      page_format_(kSequentialPageFormat) {
+    clear_consumer_groups();
+  }
   SequentialMetadata(StorageId id, const StorageName& name)
-    : Metadata(id, kSequentialStorage, name), truncate_epoch_(Epoch::kEpochInvalid), padding_(0) {
+    : Metadata(id, kSequentialStorage, name), truncate_epoch_(Epoch::kEpochInvalid),
+      page_format_(kSequentialPageFormat) {
+    clear_consumer_groups();
   }
   /** This one is for newly creating a storage. */
   explicit SequentialMetadata(const StorageName& name)
-    : Metadata(0, kSequentialStorage, name), truncate_epoch_(Epoch::kEpochInvalid), padding_(0) {
+    : Metadata(0, kSequentialStorage, name), truncate_epoch_(Epoch::kEpochInvalid),
+      page_format_(kSequentialPageFormat) {
+    clear_consumer_groups();
   }
 
+  void clear_consumer_groups() { std::memset(consumer_epochs_, 0, sizeof(consumer_epochs_)); }
+
   std::string describe() const;
   friend std::ostream& operator<<(std::ostream& o, const SequentialMetadata& v);
 
-  uint32_t unused_dummy_func_padding() const { return padding_; }
-
   /**
    * The min epoch value (\e truncate-epoch) for all valid records in this storage.
    * When a physical record or a page has an epoch value less than a truncate-epoch,
@@ -74,7 +82,20 @@ struct SequentialMetadata CXX11_FINAL : public Metadata {
    */
   Epoch::EpochInteger truncate_epoch_;
 
-  uint32_t  padding_;
+  /**
+   * Layout version of the snapshot pages this storage points to.
+   * @see foedus::storage::sequential::kSequentialPageFormat
+   */
+  uint32_t  page_format_;
+
+  /**
+   * The position of each consumer group, indexed by the group ID.
+   * When a group is used, all records in epochs \e before this value are acknowledged by the
+   * group. kEpochInvalid means the group is not used.
+   * The truncate-epoch automatically follows the minimum of them.
+   * @see foedus::storage::sequential::SequentialStorage::ack_consumer_group()
+   */
+  Epoch::EpochInteger consumer_epochs_[kMaxConsumerGroups];
 };
 
 struct SequentialMetadataSerializer CXX11_FINAL : public virtual MetadataSerializer {
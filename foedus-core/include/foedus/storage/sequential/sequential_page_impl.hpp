@@ -77,6 +77,16 @@ class SequentialPage final {
    * barrier or atomic CAS when needed.
    */
   uint16_t            get_used_data_bytes() const { return used_data_bytes_; }
+  /**
+   * Returns the smallest epoch of records in this page, invalid if no record.
+   * Cursors use this and get_max_epoch() to skip pages outside of the requested epoch range
+   * without iterating over records.
+   * @note this method might return a stale information on volatile page, which is fine
+   * as far as the caller reads it after the record count.
+   */
+  Epoch               get_min_epoch() const { return min_epoch_; }
+  /** Returns the largest epoch of records in this page, invalid if no record. */
+  Epoch               get_max_epoch() const { return max_epoch_; }
 
   void                assert_consistent() const {
     ASSERT_ND(get_used_data_bytes() + get_record_count() * sizeof(PayloadLength) <= kDataSize);
@@ -135,6 +145,8 @@ class SequentialPage final {
     header_.init_volatile(page_id, storage_id, kSequentialPageType);
     record_count_ = 0;
     used_data_bytes_ = 0;
+    min_epoch_ = INVALID_EPOCH;
+    max_epoch_ = INVALID_EPOCH;
     next_page_.snapshot_pointer_ = 0;
     next_page_.volatile_pointer_.word = 0;
   }
@@ -142,6 +154,8 @@ class SequentialPage final {
     header_.init_snapshot(page_id, storage_id, kSequentialPageType);
     record_count_ = 0;
     used_data_bytes_ = 0;
+    min_epoch_ = INVALID_EPOCH;
+    max_epoch_ = INVALID_EPOCH;
     next_page_.snapshot_pointer_ = 0;
     next_page_.volatile_pointer_.word = 0;
   }
@@ -164,6 +178,8 @@ class SequentialPage final {
     owner_id_addr->xct_id_ = owner_id;
     owner_id_addr->lock_.reset();  // not used...
     std::memcpy(data_ + used_data_bytes_ + kRecordOverhead, payload, payload_length);
+    min_epoch_.store_min(owner_id.get_epoch());
+    max_epoch_.store_max(owner_id.get_epoch());
     ++record_count_;
     used_data_bytes_ += assorted::align8(payload_length) + kRecordOverhead;
     header_.key_count_ = record_count_;
@@ -213,13 +229,17 @@ class SequentialPage final {
 
   uint16_t              record_count_;      // +2 -> 42
   uint16_t              used_data_bytes_;   // +2 -> 44
-  uint32_t              filler_;            // +4 -> 48
+  /** Smallest epoch of records in this page. Invalid if no record. */
+  Epoch                 min_epoch_;         // +4 -> 48
+  /** Largest epoch of records in this page. Invalid if no record. */
+  Epoch                 max_epoch_;         // +4 -> 52
+  uint32_t              filler_;            // +4 -> 56
 
   /**
    * Pointer to next page.
    * Once it is set, the pointer and the pointed page will never be changed.
    */
-  DualPagePointer       next_page_;         // +16 -> 64
+  DualPagePointer       next_page_;         // +16 -> 72
 
   /**
    * Dynamic data part in this page, which consist of 1) record part growing forward,
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_SEQUENTIAL_SEQUENTIAL_PARALLEL_SCAN_HPP_
+#define FOEDUS_STORAGE_SEQUENTIAL_SEQUENTIAL_PARALLEL_SCAN_HPP_
+
+#include <stdint.h>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/error_stack.hpp"
+#include "foedus/fwd.hpp"
+#include "foedus/proc/proc_id.hpp"
+#include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/sequential/fwd.hpp"
+#include "foedus/storage/sequential/sequential_storage.hpp"
+
+namespace foedus {
+namespace storage {
+namespace sequential {
+/**
+ * @brief The task input that SequentialParallelScan gives to each worker.
+ * @ingroup SEQUENTIAL
+ * @details
+ * The user input given to SequentialParallelScan::run() follows this header.
+ * The worker procedure should read only this partition as follows.
+ * @code{.cpp}
+ * ErrorStack my_scan_task(const proc::ProcArguments& args) {
+ *   const SequentialScanPartition* partition = SequentialScanPartition::from_args(args);
+ *   SequentialStorage storage(args.engine_, partition->storage_id_);
+ *   ... begin_xct
+ *   SequentialCursor cursor(args.context_, storage, buffer, buffer_size,
+ *     SequentialCursor::kNodeFirstMode, partition->from_epoch_, partition->to_epoch_,
+ *     partition->node_);
+ *   cursor.set_partition(partition->partition_, partition->partition_count_);
+ *   ... aggregate records into args.output_buffer_ and set *args.output_used_
+ * }
+ * @endcode
+ */
+struct SequentialScanPartition {
+  StorageId storage_id_;        // +4 -> 4
+  /** The node this worker runs on and reads. */
+  uint16_t  node_;              // +2 -> 6
+  /** The partition this worker reads. @see SequentialCursor::set_partition() */
+  uint16_t  partition_;         // +2 -> 8
+  /** The number of partitions in each node. */
+  uint16_t  partition_count_;   // +2 -> 10
+  uint16_t  padding_;           // +2 -> 12
+  /** Inclusive beginning of epochs to read. Invalid to read all epochs. */
+  Epoch     from_epoch_;        // +4 -> 16
+  /** Exclusive end of epochs to read. Invalid to read all safe epochs. */
+  Epoch     to_epoch_;          // +4 -> 20
+  /** Byte length of the user input that follows this header. */
+  uint32_t  user_input_len_;    // +4 -> 24
+
+  const void* get_user_input() const { return this + 1; }
+
+  static const SequentialScanPartition* from_args(const proc::ProcArguments& args) {
+    ASSERT_ND(args.input_len_ >= sizeof(SequentialScanPartition));
+    const SequentialScanPartition* partition
+      = reinterpret_cast<const SequentialScanPartition*>(args.input_buffer_);
+    ASSERT_ND(args.input_len_ == sizeof(SequentialScanPartition) + partition->user_input_len_);
+    return partition;
+  }
+};
+
+/**
+ * @brief Runs a scan over a sequential storage on many worker threads in parallel.
+ * @ingroup SEQUENTIAL
+ * @details
+ * Sequential storages are already partitioned by nodes and threads: each thread appends
+ * to its own volatile page list, and each node has its own snapshot head pages.
+ * This class runs the given procedure on partition_count threads in each node.
+ * Each of them reads only its own node-local subset via SequentialCursor::set_partition(),
+ * so the scan scales with cores and never reads pages on other nodes.
+ * The i-th partition of a node runs on the i-th thread of the node when it is idle,
+ * so that the thread reads the volatile pages it wrote.
+ *
+ * Each worker returns its partial aggregate as the procedure output.
+ * run() waits for all workers and passes their outputs to the merge function on the calling
+ * thread, in the order of nodes and partitions.
+ * @code{.cpp}
+ * SequentialParallelScan scan(engine, storage, "my_scan_task");
+ * uint64_t total = 0;
+ * CHECK_ERROR(scan.run(nullptr, 0, merge_sum, &total));
+ * @endcode
+ *
+ * The procedure must be registered via proc::ProcManager.
+ * run() needs partition_count idle worker threads in every node, and returns
+ * kErrorCodeThrNoThreadAvailable otherwise. By default, partition_count is the number of
+ * threads per node, so each partition reads exactly one thread's volatile pages. Hence, call
+ * run() from a client thread, not from a worker thread which would occupy one of them.
+ * A smaller partition_count leaves threads idle for other work. The volatile page lists are
+ * then assigned in round-robin, so partitions get the same number of lists only when
+ * partition_count divides the number of threads per node.
+ */
+class SequentialParallelScan CXX11_FINAL {
+ public:
+  /**
+   * @brief Merges the output of one worker into the final result.
+   * @param[in] partition the partition the worker read
+   * @param[in] output the output of the worker procedure
+   * @param[in] output_size byte length of output
+   * @param[in,out] user_data given to run()
+   */
+  typedef void (*MergeFunction)(
+    const SequentialScanPartition& partition,
+    const void* output,
+    uint64_t output_size,
+    void* user_data);
+
+  /**
+   * @param[in] engine Database Engine
+   * @param[in] storage The sequential storage to read from
+   * @param[in] proc_name The procedure each worker runs
+   * @details
+   * By default, this reads all safe epochs with one partition per thread in each node.
+   */
+  SequentialParallelScan(
+    Engine* engine,
+    const SequentialStorage& storage,
+    const proc::ProcName& proc_name);
+
+  /** Inclusive beginning and exclusive end of epochs to read. Same as SequentialCursor. */
+  void      set_epoch_range(Epoch from_epoch, Epoch to_epoch) {
+    from_epoch_ = from_epoch;
+    to_epoch_ = to_epoch;
+  }
+  /** The number of partitions (workers) in each node. 1 to the number of threads per node. */
+  void      set_partition_count(uint16_t partition_count) { partition_count_ = partition_count; }
+  uint16_t  get_partition_count() const { return partition_count_; }
+
+  /**
+   * @brief Runs the procedure on all partitions and merges their outputs.
+   * @param[in] user_input Arbitrary input passed to all workers after SequentialScanPartition
+   * @param[in] user_input_len Byte length of user_input
+   * @param[in] merge Called for each worker's output. Can be null.
+   * @param[in,out] merge_user_data Passed to merge
+   * @return kErrorCodeThrNoThreadAvailable if some node doesn't have enough idle threads,
+   * or the first error of the workers. Even on errors, this waits for all launched workers.
+   */
+  ErrorStack  run(
+    const void* user_input,
+    uint32_t user_input_len,
+    MergeFunction merge,
+    void* merge_user_data);
+
+ private:
+  Engine* const           engine_;
+  const SequentialStorage storage_;
+  const proc::ProcName    proc_name_;
+  Epoch                   from_epoch_;
+  Epoch                   to_epoch_;
+  uint16_t                partition_count_;
+};
+
+}  // namespace sequential
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_SEQUENTIAL_SEQUENTIAL_PARALLEL_SCAN_HPP_
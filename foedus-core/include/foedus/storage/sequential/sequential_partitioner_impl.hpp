@@ -36,11 +36,12 @@ namespace sequential {
  * @brief Partitioner for an sequential storage.
  * @ingroup SEQUENTIAL
  * @details
- * Partitioning/sorting policy for \ref SEQUENTIAL is super simple; it does nothing.
+ * Partitioning/sorting policy for \ref SEQUENTIAL is super simple.
  * We put all logs in node-x to snapshot of node-x for the best performance.
  * As the only read access pattern is full-scan, we don't care partitioning.
  * We just minimize the communication cost by this policy.
- * No sorting either.
+ * The only sorting we do is by epoch, so that each snapshot page has a narrow epoch range
+ * that cursors can use to skip pages (see SequentialPage::get_min_epoch()).
  *
  * @note
  * This is a private implementation-details of \ref SEQUENTIAL, thus file name ends with _impl.
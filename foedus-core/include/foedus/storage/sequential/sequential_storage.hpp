@@ -23,6 +23,7 @@
 
 #include "foedus/attachable.hpp"
 #include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
 #include "foedus/fwd.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage.hpp"
@@ -115,6 +116,43 @@ class SequentialStorage CXX11_FINAL : public Storage<SequentialStorageControlBlo
   ErrorStack  truncate(Epoch new_truncate_epoch, Epoch* commit_epoch);
   void        apply_truncate(const SequentialTruncateLogType& the_log);
 
+  /**
+   * @brief Starts using a consumer group, which consumes records from the truncate-epoch.
+   * @param[in] group ID of the consumer group, less than kMaxConsumerGroups
+   * @param[out] commit_epoch The epoch when the change has happened.
+   * @details
+   * A consumer group lets this storage work as a work queue. Each group has its own
+   * position, which is persisted as part of the metadata. SequentialConsumer::poll()
+   * returns records after the position, and ack_consumer_group() advances it.
+   * Like truncate(), these methods are metadata operations that run their own
+   * meta-transaction. If the group is already used, this method does nothing.
+   */
+  ErrorStack  add_consumer_group(uint16_t group, Epoch* commit_epoch);
+  /**
+   * Stops using the consumer group so that it no longer holds back the truncate-epoch.
+   * If the group is not used, this method does nothing.
+   */
+  ErrorStack  remove_consumer_group(uint16_t group, Epoch* commit_epoch);
+  /**
+   * @brief Acknowledges that the consumer group has processed all records before the epoch.
+   * @param[in] group ID of a used consumer group
+   * @param[in] acked_epoch Records whose epoch is exclusively smaller than this are done.
+   * @param[out] commit_epoch The epoch when the change has happened.
+   * @details
+   * If acked_epoch is not larger than the current position, this method does nothing.
+   * After advancing the position, this method truncates the storage up to the minimum
+   * position of all used consumer groups, so consumed records are discarded automatically.
+   * Both happen in one metadata log, so this costs one meta-transaction.
+   */
+  ErrorStack  ack_consumer_group(uint16_t group, Epoch acked_epoch, Epoch* commit_epoch);
+  /**
+   * @return the position of the consumer group. Invalid if the group is not used.
+   * This doesn't protect the read in a xct.
+   * @see foedus::storage::sequential::SequentialMetadata::consumer_epochs_
+   */
+  Epoch       get_consumer_group_epoch(uint16_t group) const;
+  void        apply_consumer_group(const SequentialConsumerGroupLogType& the_log);
+
   friend std::ostream& operator<<(std::ostream& o, const SequentialStorage& v);
 };
 }  // namespace sequential
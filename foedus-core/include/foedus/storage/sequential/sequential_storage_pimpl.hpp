@@ -159,8 +159,24 @@ class SequentialStoragePimpl final : public Attachable<SequentialStorageControlB
   ErrorStack  initialize_head_tail_pages();
   ErrorStack  drop();
   ErrorStack  truncate(Epoch new_truncate_epoch, Epoch* commit_epoch);
+  /**
+   * Applies a logged truncation and clears the being_written flag of cur_truncate_epoch_tid_,
+   * which the caller has set before logging.
+   */
+  void        install_truncate_epoch(Epoch new_truncate_epoch, Epoch commit_epoch);
   void        apply_truncate(const SequentialTruncateLogType& the_log);
 
+  ErrorStack  add_consumer_group(uint16_t group, Epoch* commit_epoch);
+  ErrorStack  remove_consumer_group(uint16_t group, Epoch* commit_epoch);
+  ErrorStack  ack_consumer_group(uint16_t group, Epoch acked_epoch, Epoch* commit_epoch);
+  void        apply_consumer_group(const SequentialConsumerGroupLogType& the_log);
+  /**
+   * Logs and applies the new position of the group. If the minimum position of used groups
+   * advances, this also truncates up to it in the same metadata log.
+   * Caller must hold status_mutex_.
+   */
+  void        set_consumer_group_epoch(uint16_t group, Epoch new_epoch, Epoch* commit_epoch);
+
   SequentialPage* get_head(
     const memory::LocalPageResolver& resolver,
     thread::ThreadId thread_id) const;
@@ -223,6 +239,9 @@ static_assert(sizeof(SequentialStoragePimpl) <= kPageSize, "SequentialStoragePim
 static_assert(
   sizeof(SequentialStorageControlBlock) <= soc::GlobalMemoryAnchors::kStorageMemorySize,
   "SequentialStorageControlBlock is too large.");
+static_assert(
+  sizeof(SequentialStorageControlBlock) <= kStorageStatisticsOffset,
+  "SequentialStorageControlBlock overlaps with StorageStatistics.");
 }  // namespace sequential
 }  // namespace storage
 }  // namespace foedus
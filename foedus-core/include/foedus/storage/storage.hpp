@@ -31,6 +31,7 @@
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/metadata.hpp"
 #include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 #include "foedus/thread/fwd.hpp"
 #include "foedus/xct/fwd.hpp"
 
@@ -65,6 +66,7 @@ struct StorageControlBlock CXX11_FINAL {
     status_ = kNotExists;
     root_page_pointer_.snapshot_pointer_ = 0;
     root_page_pointer_.volatile_pointer_.word = 0;
+    stats_.initialize();
   }
   void uninitialize() {
     status_mutex_.uninitialize();
@@ -85,7 +87,15 @@ struct StorageControlBlock CXX11_FINAL {
 
   /** Just to make this exactly 4kb. Individual control block doesn't have this. */
   char              padding_[
-    4096 - sizeof(soc::SharedMutex) - 8 - sizeof(DualPagePointer) - sizeof(Metadata)];
+    4096 - sizeof(soc::SharedMutex) - 8 - sizeof(DualPagePointer) - sizeof(Metadata)
+    - sizeof(StorageStatistics)];
+
+  /**
+   * Statistics of this storage. This is placed at the tail of the 4kb so that it is at the
+   * same offset in all individual control blocks, which must not reach here.
+   * @see kStorageStatisticsOffset
+   */
+  StorageStatistics stats_;
 };
 
 /**
@@ -194,6 +204,12 @@ class Storage : public Attachable<CONTROL_BLOCK> {
 
 
 CXX11_STATIC_ASSERT(sizeof(StorageControlBlock) == 1 << 12, "StorageControlBlock is not 4kb");
+
+/**
+ * Byte offset of StorageControlBlock::stats_. Individual control blocks must be smaller than this.
+ * @ingroup STORAGE
+ */
+const uint32_t kStorageStatisticsOffset = (1U << 12) - sizeof(StorageStatistics);
 }  // namespace storage
 }  // namespace foedus
 #endif  // FOEDUS_STORAGE_STORAGE_HPP_
@@ -86,6 +86,19 @@ class StorageManager CXX11_FINAL : public virtual Initializable {
    */
   StorageControlBlock* get_storage(StorageId id);
 
+  /**
+   * @brief Returns online statistics of the given storage.
+   * @param[in] id Storage ID
+   * @details
+   * Statistics are incrementally maintained, so this is as cheap as get_storage().
+   * Record counts as of the latest snapshot are always maintained. Records committed since
+   * then are counted only when StorageOptions::record_statistics_ is on.
+   * Key/bin distributions are not part of the statistics. MasstreeStorage::estimate_key_histogram()
+   * and HashStorage::estimate_bin_histogram() sample volatile pages on demand.
+   * @see StorageStatistics
+   */
+  const StorageStatistics& get_statistics(StorageId id);
+
   /**
    * Returns the array storage of given ID.
    * @param[in] id Storage ID
@@ -55,6 +55,28 @@ struct StorageOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   uint64_t                hot_threshold_;
 
+  /**
+   * Whether each thread remembers its last descent in masstree storages and starts the next
+   * lookup from the deepest remembered page that still covers the key.
+   * @see foedus::storage::masstree::MasstreeDescentPath
+   */
+  bool                    masstree_descent_hint_;
+
+  /**
+   * Whether each thread caches volatile bin-head pages of hash storages it recently visited.
+   * @see foedus::storage::hash::HashBinHints
+   */
+  bool                    hash_bin_hint_;
+
+  /**
+   * Whether transactions count the records they insert/delete in StorageStatistics.
+   * This costs a shared counter update per inserted/deleted record at commit, so it is off
+   * by default. When off, StorageStatistics::get_record_count_estimate() is the count
+   * as of the latest snapshot, which log mappers maintain regardless of this option.
+   * @see foedus::storage::StorageStatistics
+   */
+  bool                    record_statistics_;
+
   EXTERNALIZABLE(StorageOptions);
 };
 }  // namespace storage
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_STORAGE_STORAGE_STATISTICS_HPP_
+#define FOEDUS_STORAGE_STORAGE_STATISTICS_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <iosfwd>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/assorted/cacheline.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/snapshot/snapshot_id.hpp"
+#include "foedus/storage/storage_id.hpp"
+
+namespace foedus {
+namespace storage {
+
+/**
+ * @brief Online, approximate statistics of one storage.
+ * @ingroup STORAGE
+ * @details
+ * This object is placed at the tail of each storage's 4kb control block in shared memory
+ * (see StorageControlBlock), so it's available regardless of storage type.
+ * It's incrementally maintained so that the user never has to walk the storage
+ * (eg verify_single_thread()) to know its size.
+ *
+ * @par Record counts
+ * Log mappers count the records each snapshot inserted/deleted while they glean the logs,
+ * so the record count as of the latest snapshot (get_snapshot_record_count()) is always
+ * maintained and costs nothing to transactions. The snapshot metadata file remembers it,
+ * and we restart from there at next restart.
+ * When StorageOptions::record_statistics_ is on, transactions additionally count
+ * inserted/deleted records when they apply their logs at commit, and
+ * get_record_count_estimate() adds the records committed since the latest snapshot.
+ * This is an atomic increment on a counter shared with other threads, so it's off by default.
+ * To mitigate contention, the counters are striped by thread.
+ * The online part is approximate. It might include records of non-durable epochs lost in
+ * a crash, and it misses records committed between the snapshot epoch and the beginning
+ * of the snapshot.
+ * Truncation of sequential storages is not counted.
+ * Array storages always have all records, so record counts are meaningless for them.
+ * Use ArrayMetadata::array_size_ instead.
+ *
+ * @par Snapshot pages
+ * Composers count the pages they write for this storage in each snapshot.
+ * This is the I/O volume of snapshotting, not the size of the latest snapshot,
+ * because unchanged pages are not rewritten.
+ *
+ * @par No heap-allocation
+ * Just like control blocks, this object is placed in shared memory. Only POD and atomics.
+ */
+struct StorageStatistics CXX11_FINAL {
+  enum Constants {
+    /** Number of stripes of record counters. Each stripe occupies one cacheline. */
+    kCounterStripes = 8,
+  };
+
+  /** Record counters in one cacheline. */
+  struct CounterStripe {
+    std::atomic<int64_t>  inserted_records_;
+    std::atomic<int64_t>  deleted_records_;
+    char                  padding_[assorted::kCachelineSize - 16];
+  };
+
+  // this is backed by shared memory. not instantiation. just reinterpret_cast.
+  StorageStatistics() CXX11_FUNC_DELETE;
+  ~StorageStatistics() CXX11_FUNC_DELETE;
+
+  void initialize() {
+    for (uint16_t i = 0; i < kCounterStripes; ++i) {
+      stripes_[i].inserted_records_.store(0);
+      stripes_[i].deleted_records_.store(0);
+    }
+    snapshot_record_count_ = 0;
+    gleaned_records_.store(0);
+    online_net_at_snapshot_ = 0;
+    pending_online_net_ = 0;
+    snapshot_pages_.store(0);
+    last_snapshot_id_.store(snapshot::kNullSnapshotId);
+  }
+
+  /** Invoked when a transaction inserted a record. */
+  void on_insert(uint16_t thread_ordinal) {
+    stripes_[thread_ordinal % kCounterStripes].inserted_records_.fetch_add(
+      1,
+      std::memory_order_relaxed);
+  }
+  /** Invoked when a transaction deleted a record. */
+  void on_delete(uint16_t thread_ordinal) {
+    stripes_[thread_ordinal % kCounterStripes].deleted_records_.fetch_add(
+      1,
+      std::memory_order_relaxed);
+  }
+  /**
+   * Invoked by the snapshot manager before it starts gleaning logs.
+   * Also remembers where the online counters are at this point, which becomes the base of
+   * get_record_count_estimate() once this snapshot completes.
+   */
+  void on_snapshot_begin() {
+    gleaned_records_.store(0, std::memory_order_relaxed);
+    pending_online_net_ = get_inserted_records() - get_deleted_records();
+  }
+  /** Invoked when a log mapper processed logs that inserted/deleted records of this storage. */
+  void on_gleaned_records(int64_t delta) {
+    gleaned_records_.fetch_add(delta, std::memory_order_relaxed);
+  }
+  /**
+   * Invoked by the snapshot manager after the new snapshot became durable (savepoint).
+   * If the snapshot failed before that, this is not called and on_snapshot_begin() of the
+   * next snapshot discards what the mappers counted.
+   */
+  void on_snapshot_end() {
+    snapshot_record_count_ = get_gleaned_record_count();
+    gleaned_records_.store(0, std::memory_order_relaxed);
+    online_net_at_snapshot_ = pending_online_net_;
+  }
+  /** Invoked when a composer wrote out pages of this storage. */
+  void on_snapshot_pages(snapshot::SnapshotId snapshot_id, uint64_t pages) {
+    snapshot_pages_.fetch_add(pages, std::memory_order_relaxed);
+    last_snapshot_id_.store(snapshot_id, std::memory_order_relaxed);
+  }
+
+  /** @return number of records inserted since the engine started */
+  int64_t get_inserted_records() const {
+    int64_t total = 0;
+    for (uint16_t i = 0; i < kCounterStripes; ++i) {
+      total += stripes_[i].inserted_records_.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+  /** @return number of records deleted since the engine started */
+  int64_t get_deleted_records() const {
+    int64_t total = 0;
+    for (uint16_t i = 0; i < kCounterStripes; ++i) {
+      total += stripes_[i].deleted_records_.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+  /** @return number of (logically existing) records as of the latest snapshot */
+  int64_t get_snapshot_record_count() const { return snapshot_record_count_; }
+  /**
+   * @return number of records as of the snapshot being taken, which is what the snapshot
+   * metadata file remembers. Same as get_snapshot_record_count() unless gleaning.
+   */
+  int64_t get_gleaned_record_count() const {
+    return snapshot_record_count_ + gleaned_records_.load(std::memory_order_relaxed);
+  }
+  /**
+   * @return approximate number of (logically existing) records in this storage.
+   * Same as get_snapshot_record_count() unless StorageOptions::record_statistics_ is on.
+   */
+  int64_t get_record_count_estimate() const {
+    int64_t online_net = get_inserted_records() - get_deleted_records();
+    int64_t count = snapshot_record_count_ + online_net - online_net_at_snapshot_;
+    return count < 0 ? 0 : count;
+  }
+  /** @return number of pages composers wrote for this storage since the engine started */
+  uint64_t get_snapshot_pages() const { return snapshot_pages_.load(std::memory_order_relaxed); }
+  /** @return byte size of get_snapshot_pages() */
+  uint64_t get_snapshot_bytes() const { return get_snapshot_pages() * kPageSize; }
+  /** @return the latest snapshot that wrote out pages of this storage */
+  snapshot::SnapshotId get_last_snapshot_id() const {
+    return last_snapshot_id_.load(std::memory_order_relaxed);
+  }
+
+  /** Striped counters, updated by transactions. */
+  CounterStripe                       stripes_[kCounterStripes];
+  /** @see get_snapshot_record_count(). Only the snapshot thread modifies it. */
+  int64_t                             snapshot_record_count_;
+  /** Net number of records the mappers counted in the snapshot being taken. */
+  std::atomic<int64_t>                gleaned_records_;
+  /** Online net count (inserted - deleted) when the latest snapshot began. */
+  int64_t                             online_net_at_snapshot_;
+  /** Online net count when the snapshot being taken began. */
+  int64_t                             pending_online_net_;
+  /** @see get_snapshot_pages() */
+  std::atomic<uint64_t>               snapshot_pages_;
+  /** @see get_last_snapshot_id() */
+  std::atomic<snapshot::SnapshotId>   last_snapshot_id_;
+  char                                padding_[
+    assorted::kCachelineSize - sizeof(int64_t) * 4 - sizeof(uint64_t)
+    - sizeof(snapshot::SnapshotId)];
+
+  friend std::ostream& operator<<(std::ostream& o, const StorageStatistics& v);
+};
+
+/**
+ * @return how many records a log of the given type adds to the storage: 1 for inserts/appends,
+ * -1 for deletes, 0 otherwise.
+ * @ingroup STORAGE
+ */
+inline int64_t to_record_count_delta(log::LogCode log_type) {
+  switch (log_type) {
+  case log::kLogCodeHashInsert:
+  case log::kLogCodeMasstreeInsert:
+  case log::kLogCodeSequentialAppend:
+    return 1;
+  case log::kLogCodeHashDelete:
+  case log::kLogCodeMasstreeDelete:
+    return -1;
+  default:
+    return 0;
+  }
+}
+
+}  // namespace storage
+}  // namespace foedus
+#endif  // FOEDUS_STORAGE_STORAGE_STATISTICS_HPP_
@@ -27,6 +27,8 @@
 #include "foedus/memory/page_resolver.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/hash/fwd.hpp"
+#include "foedus/storage/masstree/fwd.hpp"
 #include "foedus/thread/fwd.hpp"
 #include "foedus/thread/thread_id.hpp"
 #include "foedus/xct/fwd.hpp"
@@ -91,6 +93,23 @@ class Thread CXX11_FINAL : public virtual Initializable {
   /** Returns page resolver to convert only local page ID to page pointer. */
   const memory::LocalPageResolver& get_local_volatile_page_resolver() const;
 
+  /**
+   * Returns the slot for the given storage that remembers the last descent this thread made.
+   * The slot might be currently used for another storage.
+   * nullptr if StorageOptions::masstree_descent_hint_ is off.
+   */
+  storage::masstree::MasstreeDescentPath* get_masstree_descent_path(storage::StorageId id);
+  /**
+   * Returns the volatile bin-head pages of hash storages this thread recently visited.
+   * nullptr if StorageOptions::hash_bin_hint_ is off.
+   */
+  storage::hash::HashBinHints* get_hash_bin_hints();
+  /**
+   * Returns the previous-version table of the given NUMA node.
+   * It is disabled if XctOptions::previous_version_entries_per_node_ is 0.
+   */
+  xct::PreviousVersionTable* get_previous_version_table(ThreadGroupId node);
+
   /** [statistics] count of cache hits in snapshot caches */
   uint64_t      get_snapshot_cache_hits() const;
   /** [statistics] count of cache misses in snapshot caches */
@@ -155,6 +174,22 @@ class Thread CXX11_FINAL : public virtual Initializable {
     uint32_t page_count,
     storage::Page* buffer);
 
+  /**
+   * @brief Returns contiguous snapshot pages directly from a read-only mapping of the file.
+   * @param[in] page_id_begin first page to retrieve
+   * @param[in] page_count number of contiguous pages to retrieve
+   * @param[in] sequential whether the caller will scan the pages sequentially (madvise hint)
+   * @param[out] out the first page. nullptr if CacheOptions::snapshot_file_mmap_ is OFF or the
+   * pages are not mapped, in which case use read_snapshot_pages() instead.
+   * @details
+   * No copy is made. The pages must not be modified.
+   */
+  ErrorCode     get_mapped_snapshot_pages(
+    storage::SnapshotPagePointer page_id_begin,
+    uint32_t page_count,
+    bool sequential,
+    const storage::Page** out);
+
   /**
    * @brief Installs a volatile page to the given dual pointer as a copy of the snapshot page.
    * @param[in,out] pointer dual pointer. volatile pointer will be modified.
@@ -33,10 +33,13 @@
 #include "foedus/soc/shared_polling.hpp"
 #include "foedus/storage/fwd.hpp"
 #include "foedus/storage/storage_id.hpp"
+#include "foedus/storage/hash/hash_hint_impl.hpp"
+#include "foedus/storage/masstree/masstree_hint_impl.hpp"
 #include "foedus/thread/fwd.hpp"
 #include "foedus/thread/thread_id.hpp"
 #include "foedus/thread/thread_ref.hpp"
 #include "foedus/xct/fwd.hpp"
+#include "foedus/xct/previous_version_table.hpp"
 #include "foedus/xct/retrospective_lock_list.hpp"
 #include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_id.hpp"
@@ -55,6 +58,11 @@ struct ThreadControlBlock {
     mcs_block_current_ = 0;
     mcs_rw_async_mapping_current_ = 0;
     mcs_waiting_.store(false);
+    mcs_cohort_bypassed_ = 0;
+    xct_timestamp_ = 0;
+    for (uint32_t i = 0; i < xct::kMcsMaxBiasedReadLocks; ++i) {
+      mcs_biased_read_locks_[i] = xct::kNullUniversalLockId;
+    }
     current_ticket_ = 0;
     proc_name_.clear();
     input_len_ = 0;
@@ -96,6 +104,29 @@ struct ThreadControlBlock {
    */
   std::atomic<bool>   mcs_waiting_;
 
+  /**
+   * How many times this thread has been bypassed by NUMA-cohort handoffs while it waits for
+   * the current MCS lock. As a thread waits for at most one lock, this is per-thread, too.
+   * Only the current owner of the lock (the one that will hand it over) modifies this, and
+   * it resets this to zero when it grants the lock.
+   */
+  uint32_t            mcs_cohort_bypassed_;
+
+  /**
+   * Read-locks this thread currently holds in the reader-biased mode.
+   * kNullUniversalLockId means an empty slot. Only this thread modifies the slots.
+   * Writers on other threads read them to wait for the readers of their lock.
+   */
+  xct::UniversalLockId  mcs_biased_read_locks_[xct::kMcsMaxBiasedReadLocks];
+
+  /**
+   * Timestamp of the transaction this thread is running, or ran most recently.
+   * A retry of an aborted transaction inherits the timestamp, so it eventually becomes the
+   * oldest. Other threads read this to decide who waits in the wait-die policy.
+   * @see XctOptions::enable_non_canonical_wait_die_
+   */
+  uint64_t              xct_timestamp_;
+
   /**
    * The thread sleeps on this conditional when it has no task.
    * When someone else (whether in same SOC or other SOC) wants to wake up this logger,
@@ -334,8 +365,30 @@ class ThreadPimpl final : public DefaultInitializable {
 
   /** globally and contiguously numbered ID of thread */
   const ThreadGlobalOrdinal global_ordinal_;
-  /** shortcut for engine_->get_options().xct_.mcs_implementation_type_ == simple */
+  /** shortcut for engine_->get_options().xct_.mcs_implementation_type_ != extended */
   bool                    simple_mcs_rw_;
+  /**
+   * xct_.mcs_cohort_bypass_bound_ if mcs_implementation_type_ is simple-cohort, 0 otherwise.
+   * 0 means NUMA-cohort handoffs are disabled.
+   */
+  uint16_t                mcs_cohort_bypass_bound_;
+  /**
+   * xct_.hot_threshold_for_reader_biased_locks_ if we use simple MCS-RW locks, 256 otherwise.
+   * 256 means reader-biased read-locks are disabled.
+   */
+  uint16_t                mcs_reader_bias_threshold_;
+  /** shortcut for engine_->get_options().storage_.masstree_descent_hint_ */
+  bool                    masstree_descent_hint_;
+  /** shortcut for engine_->get_options().storage_.hash_bin_hint_ */
+  bool                    hash_bin_hint_;
+  /** shortcut for engine_->get_options().thread_.group_count_ */
+  uint16_t                numa_node_count_;
+  /** shortcut for engine_->get_options().thread_.thread_count_per_group_ */
+  ThreadLocalOrdinal      threads_per_node_;
+  /** Reader indicators of each node. Index is the NUMA node. */
+  uint32_t*               mcs_reader_indicators_[kMaxThreadGroupId + 1U];
+  /** Previous-version tables of each node. Index is the NUMA node. */
+  xct::PreviousVersionTable previous_version_tables_[kMaxThreadGroupId + 1U];
 
   /**
    * Private memory repository of this thread.
@@ -374,6 +427,12 @@ class ThreadPimpl final : public DefaultInitializable {
    */
   xct::Xct                current_xct_;
 
+  /** The last descent this thread made in each masstree storage. Used only as hints. */
+  storage::masstree::MasstreeDescentPath
+    masstree_descent_paths_[storage::masstree::MasstreeDescentPath::kSlotsPerThread];
+  /** Bin-head pages this thread recently visited in hash storages. Used only as hints. */
+  storage::hash::HashBinHints hash_bin_hints_;
+
   /**
    * Each threads maintains a private set of snapshot file descriptors.
    */
@@ -442,6 +501,28 @@ class ThreadPimplMcsAdaptor {
     ThreadRef other = pimpl_->get_thread_ref(id);
     return &(other.get_control_block()->mcs_waiting_);
   }
+  uint16_t get_cohort_bypass_bound() const { return pimpl_->mcs_cohort_bypass_bound_; }
+  uint16_t get_reader_bias_threshold() const { return pimpl_->mcs_reader_bias_threshold_; }
+  uint16_t get_numa_node_count() const { return pimpl_->numa_node_count_; }
+  ThreadLocalOrdinal get_threads_per_node() const { return pimpl_->threads_per_node_; }
+  xct::UniversalLockId to_universal_lock_id(xct::McsRwLock* lock) const {
+    return xct::rw_lock_to_universal_lock_id(pimpl_->global_volatile_page_resolver_, lock);
+  }
+  uint32_t* get_reader_indicators(ThreadGroupId node) {
+    return pimpl_->mcs_reader_indicators_[node];
+  }
+  xct::UniversalLockId* get_biased_read_locks(ThreadId id) {
+    ThreadRef other = pimpl_->get_thread_ref(id);
+    return other.get_control_block()->mcs_biased_read_locks_;
+  }
+  uint64_t get_xct_timestamp(ThreadId id) {
+    ThreadRef other = pimpl_->get_thread_ref(id);
+    return assorted::atomic_load_acquire<uint64_t>(&other.get_control_block()->xct_timestamp_);
+  }
+  uint32_t* other_cohort_bypassed(ThreadId id) {
+    ThreadRef other = pimpl_->get_thread_ref(id);
+    return &(other.get_control_block()->mcs_cohort_bypassed_);
+  }
   xct::McsBlockIndex get_other_cur_block(ThreadId id) {
     ThreadRef other = pimpl_->get_thread_ref(id);
     return other.get_control_block()->mcs_block_current_;
@@ -26,6 +26,8 @@ namespace foedus {
 namespace xct {
 class   CurrentLockList;
 struct  InCommitEpochGuard;
+struct  LearnedLockEntry;
+class   LearnedLockListCache;
 struct  LockableXctId;
 struct  LockEntry;
 struct  LockFreeReadXctAccess;
@@ -38,6 +40,8 @@ struct  McsRwAsyncMapping;
 struct  McsWwLock;
 struct  McsWwBlock;
 struct  PointerAccess;
+struct  PreviousVersion;
+class   PreviousVersionTable;
 struct  ReadXctAccess;
 class   RetrospectiveLockList;
 struct  RwLockableXctId;
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#ifndef FOEDUS_XCT_PREVIOUS_VERSION_TABLE_HPP_
+#define FOEDUS_XCT_PREVIOUS_VERSION_TABLE_HPP_
+
+#include <stdint.h>
+
+#include "foedus/cxx11.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/xct/fwd.hpp"
+#include "foedus/xct/xct_id.hpp"
+
+namespace foedus {
+namespace xct {
+
+/**
+ * @brief An image of a record right before the first write to it in an epoch.
+ * @ingroup XCT
+ * @details
+ * This is a POD placed in shared memory. Always 256 bytes.
+ * seq_ is a sequence lock. It is odd while a writer is filling the entry.
+ */
+struct PreviousVersion {
+  enum Constants {
+    kSize = 256,
+    kHeaderSize = 32,
+    /** Only this many bytes from the beginning of the payload are kept. */
+    kPayloadSize = kSize - kHeaderSize,
+  };
+  uint64_t            seq_;
+  /** The record. 0 if this entry is not used yet. */
+  UniversalLockId     lock_id_;
+  /** TID of the record before the write. */
+  XctId               old_id_;
+  /** Epoch of the write that overwrote the image. */
+  Epoch::EpochInteger new_epoch_;
+  /** Number of valid bytes in payload_. */
+  uint16_t            payload_size_;
+  uint16_t            padding_;
+  /** Payload of the record before the write. */
+  char                payload_[kPayloadSize];
+};
+
+/**
+ * @brief Previous-version hints for epoch-consistent reads.
+ * @ingroup XCT
+ * @details
+ * A kEpochConsistent transaction reads the database as of a closed epoch, E.
+ * A record whose TID epoch is E or older can be read as it is. A record that was written
+ * after E needs the image before that write, which this table provides.
+ *
+ * When precommit_xct_apply() writes a record for the first time in the commit epoch,
+ * it marks the record as being written, then saves the TID and payload of the record in this
+ * table before it applies the write. An entry whose old TID is E or older and whose new epoch
+ * is newer than E is exactly the image as of E.
+ * Split increments of array storage don't move the TID, but they only commit in the epoch of
+ * the TID, and the writer waits for those of the previous epoch before it saves the image
+ * (see XctManagerPimpl::wait_for_split_increments()).
+ *
+ * Each NUMA node has one table in shared memory, and a record goes to the table of the node
+ * of its page. The table is a set-associative cache with kWays entries per bucket, so
+ * a record written in two consecutive epochs keeps both images.
+ * It is just a cache. Writers silently skip saving when an entry is being written by another
+ * writer, and old images are overwritten. Readers that miss the image abort.
+ *
+ * So far only ArrayStorage saves previous versions because its payload size is fixed.
+ * Payloads longer than PreviousVersion::kPayloadSize are partially kept.
+ */
+class PreviousVersionTable CXX11_FINAL {
+ public:
+  enum Constants {
+    kWays = 2,
+  };
+
+  PreviousVersionTable() : entries_(CXX11_NULLPTR), bucket_count_(0) {}
+
+  /** @param[in] entries the table in shared memory. nullptr to disable. */
+  void init(PreviousVersion* entries, uint32_t entry_count);
+  bool is_enabled() const { return bucket_count_ > 0; }
+
+  static uint64_t calculate_memory_size(uint32_t entry_count);
+
+  /**
+   * Saves the image of the record right before the write in new_epoch.
+   * @pre the caller holds the lock of the record
+   */
+  void save(
+    UniversalLockId lock_id,
+    XctId old_id,
+    Epoch new_epoch,
+    const char* payload,
+    uint16_t payload_size);
+
+  /**
+   * Retrieves the image of the record as of the given epoch.
+   * @param[out] old_id TID of the record as of the epoch
+   * @return whether we found the image in this table
+   */
+  bool load(
+    UniversalLockId lock_id,
+    Epoch consistent_epoch,
+    uint16_t payload_offset,
+    uint16_t payload_count,
+    void* payload,
+    XctId* old_id) const;
+
+ private:
+  PreviousVersion*  entries_;
+  uint32_t          bucket_count_;
+
+  PreviousVersion*  get_bucket(UniversalLockId lock_id) const;
+};
+
+}  // namespace xct
+}  // namespace foedus
+#endif  // FOEDUS_XCT_PREVIOUS_VERSION_TABLE_HPP_
@@ -25,6 +25,7 @@
 
 #include "foedus/assert_nd.hpp"
 #include "foedus/compiler.hpp"
+#include "foedus/epoch.hpp"
 #include "foedus/error_code.hpp"
 #include "foedus/memory/page_resolver.hpp"
 #include "foedus/thread/fwd.hpp"
@@ -231,6 +232,21 @@ class RetrospectiveLockList {
    */
   void construct(thread::Thread* context, uint32_t read_lock_threshold);
 
+  /**
+   * @brief Fill out this retrospetive lock list from a learned profile.
+   * @param[in] entries sorted and distinct entries of the profile. Their lock IDs are resolved
+   * to the lock addresses with our volatile page resolver
+   * @param[in] count number of entries
+   * @param[in] min_confidence we skip entries whose confidence_ is less than this value
+   * @param[in] min_epoch we skip entries whose learned_epoch_ is older than this epoch
+   * @see LearnedLockListCache
+   */
+  void construct_from_learned(
+    const LearnedLockEntry* entries,
+    uint32_t count,
+    uint16_t min_confidence,
+    Epoch min_epoch);
+
   const LockEntry* get_array() const { return array_; }
   LockEntry* get_entry(LockListPosition pos) {
     ASSERT_ND(is_valid_entry(pos));
@@ -291,6 +307,169 @@ class RetrospectiveLockList {
   }
 };
 
+/**
+ * @brief An entry in a learned lock list profile.
+ * @ingroup RLL
+ * @details
+ * Similar to LockEntry, but this one survives across transactions, so it has a confidence
+ * instead of the states of the current run. It has no pointer to the lock. We resolve
+ * universal_lock_id_ again each time we apply the profile. POD.
+ */
+struct LearnedLockEntry {
+  UniversalLockId universal_lock_id_;
+  /**
+   * Begin epoch of the latest transaction that accessed the record.
+   * The page of the record might be recycled once the global epoch passes this epoch + 1.
+   */
+  Epoch::EpochInteger learned_epoch_;
+  LockMode preferred_mode_;
+  /**
+   * Saturating counter. Incremented when an aborted run needed the lock,
+   * decremented when a committed run didn't access the record.
+   * The entry is removed when this becomes 0.
+   */
+  uint16_t confidence_;
+
+  bool operator<(const LearnedLockEntry& rhs) const {
+    return universal_lock_id_ < rhs.universal_lock_id_;
+  }
+
+  /** for std::lower_bound() etc without creating the object */
+  struct LessThan {
+    bool operator()(const LearnedLockEntry& lhs, UniversalLockId rhs) const {
+      return lhs.universal_lock_id_ < rhs;
+    }
+  };
+};
+
+/**
+ * @brief A thread-private cache of RLLs learned across transactions, one per \e profile.
+ * @ingroup RLL
+ * @details
+ * RLL is constructed only from the immediately previous aborted run, and discarded on commit.
+ * Hence, a new transaction always starts blind and needs at least one abort to learn.
+ * This cache remembers the RLLs of aborted runs per profile and aggregates them so that
+ * the first run of a transaction of the same type can take the locks in canonical mode.
+ *
+ * @par Profile
+ * A profile is an arbitrary non-zero 64-bit key set by Xct::set_rll_profile().
+ * By default, the key is a hash of the name of the procedure the thread is running, but
+ * the user can mix parameters in it, for example the storage and the class of key ranges
+ * the transaction will access, to learn access patterns in a finer granularity.
+ *
+ * @par Aging
+ * Entries added by aborted runs get higher confidence. Committed runs of the same profile
+ * decrement the confidence of entries whose records they didn't access, eventually removing
+ * them. When the cache is full, the least recently used profile is recycled.
+ *
+ * @par Invalidation
+ * As profiles outlive the transactions, they keep only UniversalLockId, which we resolve to
+ * the lock address again when we apply them. The address must still be a lock of the same
+ * record, though. Retired volatile pages, for example Masstree pages after splits, go back to
+ * the page pool two epochs after the retirement, and a lock in a recycled page would lock some
+ * other record or even overwrite its payload. Hence, each entry remembers the begin epoch of
+ * the latest transaction that accessed the record, and we apply only entries learned in the
+ * grace epoch (current global epoch - 1) or later, whose pages can't be recycled yet.
+ * Further, volatile pages are dropped only while XctManager pauses new transactions.
+ * Each profile remembers XctManager's pause generation as of learning, and we discard the
+ * profile when the generation changes.
+ *
+ * @note This object itself is thread-private. No concurrency control needed.
+ */
+class LearnedLockListCache {
+ public:
+  enum Constants {
+    /** Confidence added to an entry each time an aborted run needed the lock */
+    kConfidenceIncrement = 2,
+    /** Confidence never exceeds this value */
+    kMaxConfidence = 8,
+    /** We use entries with this or more confidence */
+    kMinConfidenceToApply = 2,
+  };
+
+  LearnedLockListCache();
+
+  /** @return a non-zero profile key for the given name, such as a procedure name */
+  static uint64_t to_profile(const void* name, uint16_t length);
+
+  /** @return bytes needed for the given numbers of profiles and entries per profile */
+  static uint64_t calculate_memory_size(uint16_t profiles, uint16_t entries_per_profile);
+
+  void init(void* memory, uint16_t profiles, uint16_t entries_per_profile);
+  void clear();
+
+  bool is_enabled() const { return profile_count_ > 0; }
+
+  /**
+   * @brief Fill out the RLL for the first run of a transaction of the given profile.
+   * @param[in] key the profile. Must not be 0
+   * @param[in] pause_generation current XctManagerControlBlock::pause_generation_
+   * @param[in] current_epoch current global epoch. Entries learned before the grace epoch
+   * are skipped
+   * @param[in,out] rll must be empty
+   * @return whether we had a profile to fill out the RLL
+   */
+  bool apply(
+    uint64_t key,
+    uint64_t pause_generation,
+    Epoch current_epoch,
+    RetrospectiveLockList* rll);
+
+  /**
+   * @brief Merges the RLL constructed after an abort into the profile.
+   * @param[in] key the profile. Must not be 0
+   * @param[in] pause_generation current XctManagerControlBlock::pause_generation_
+   * @param[in] begin_epoch Xct::get_begin_epoch() of the aborted transaction. Entries that
+   * expired as of this epoch are removed
+   * @param[in] rll the RLL constructed for the next run
+   */
+  void learn_from_abort(
+    uint64_t key,
+    uint64_t pause_generation,
+    Epoch begin_epoch,
+    const RetrospectiveLockList& rll);
+
+  /**
+   * @brief Ages the entries of the profile that the committing transaction didn't access.
+   * @details
+   * Entries it accessed are renewed with its Xct::get_begin_epoch().
+   * @param[in] key the profile. Must not be 0
+   * @param[in] xct the transaction being committed, whose read/write-sets are still intact
+   */
+  void learn_from_commit(uint64_t key, Xct* xct);
+
+  uint16_t get_profile_count() const { return profile_count_; }
+  uint16_t get_entries_per_profile() const { return entries_per_profile_; }
+  /** @return number of entries in the given profile, 0 if no such profile */
+  uint32_t get_entry_count(uint64_t key) const;
+
+ private:
+  struct Profile {
+    /** 0 means unused */
+    uint64_t  key_;
+    /** Last time (in use_clock_) this profile was used. For LRU replacement. */
+    uint64_t  last_used_;
+    /** XctManagerControlBlock::pause_generation_ when this profile was learned */
+    uint64_t  pause_generation_;
+    uint32_t  entry_count_;
+    /** Sorted by universal_lock_id_ and distinct */
+    LearnedLockEntry* entries_;
+  };
+
+  Profile*  profiles_;
+  uint16_t  profile_count_;
+  uint16_t  entries_per_profile_;
+  uint64_t  use_clock_;
+
+  Profile*  find(uint64_t key) const;
+  /** @return the entry of the lock in the sorted entries, nullptr if not found */
+  static LearnedLockEntry* search(
+    LearnedLockEntry* entries,
+    uint32_t count,
+    UniversalLockId id);
+  Profile*  find_or_recycle(uint64_t key, uint64_t pause_generation);
+};
+
 /**
  * @brief Sorted list of all locks, either read-lock or write-lock, taken in the current run.
  * @ingroup RLL
@@ -437,12 +616,24 @@ class CurrentLockList {
   ///
   ////////////////////////////////////////////////////////////////////////
 
+  /** @see XctOptions::enable_non_canonical_wait_die_ */
+  bool is_wait_die() const { return wait_die_; }
+  void set_wait_die(bool value) { wait_die_ = value; }
+
   /**
    * @brief Acquire one lock in this CLL.
    * @details
    * This method automatically checks if we are following canonical mode,
    * and acquire the lock unconditionally when in canonical mode (never returns until acquire),
    * and try the lock instanteneously when not in canonical mode (returns RaceAbort immediately).
+   *
+   * @par Wait-die
+   * When is_wait_die() and the try fails, we compare the age of our transaction with the
+   * one at the tail of the lock queue. If we are younger, we \e die (return LockAbort)
+   * as usual. If we are older, we \e wait: we release all locks after this one to restore
+   * canonical mode, then take this lock unconditionally. As the wait happens in canonical mode,
+   * it never causes a deadlock. Released locks are taken again later in canonical order
+   * if needed. A retry inherits the age of the aborted run, so it eventually gets to wait.
    */
   template<typename MCS_RW_IMPL>
   ErrorCode try_or_acquire_single_lock(LockListPosition pos, MCS_RW_IMPL* mcs_rw_impl);
@@ -521,6 +712,8 @@ class CurrentLockList {
    * kLockListPositionInvalid if no entry is locked.
    */
   LockListPosition last_locked_entry_;
+  /** Whether to apply the wait-die policy on non-canonical locks. */
+  bool wait_die_;
 
   LockListPosition issue_new_position() {
     assert_last_locked_entry();
@@ -622,7 +815,18 @@ inline ErrorCode CurrentLockList::try_or_acquire_single_lock(
       lock_entry->mcs_block_ = mcs_rw_impl->acquire_try_rw_reader(lock_addr);
     }
     if (lock_entry->mcs_block_ == 0) {
-      return kErrorCodeXctLockAbort;
+      if (!wait_die_ || !mcs_rw_impl->is_older_than_tail_waiter(lock_addr)) {
+        return kErrorCodeXctLockAbort;  // die
+      }
+      // wait, but after restoring canonical mode
+      release_all_after(lock_entry->universal_lock_id_, mcs_rw_impl);
+      ASSERT_ND(last_locked_entry_ == kLockListPositionInvalid || last_locked_entry_ < pos);
+      if (lock_entry->preferred_mode_ == kWriteLock) {
+        lock_entry->mcs_block_ = mcs_rw_impl->acquire_unconditional_rw_writer(lock_addr);
+      } else {
+        lock_entry->mcs_block_ = mcs_rw_impl->acquire_unconditional_rw_reader(lock_addr);
+      }
+      last_locked_entry_ = pos;
     }
     lock_entry->taken_mode_ = lock_entry->preferred_mode_;
   }
@@ -26,6 +26,8 @@
 #include "foedus/epoch.hpp"
 #include "foedus/error_code.hpp"
 #include "foedus/fwd.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/debugging/rdtsc.hpp"
 #include "foedus/log/common_log_types.hpp"
 
 // For log verification. Only in debug mode
@@ -71,7 +73,8 @@ class Xct {
   void initialize(
     memory::NumaCoreMemory* core_memory,
     uint32_t* mcs_block_current,
-    uint32_t* mcs_rw_async_mapping_current);
+    uint32_t* mcs_rw_async_mapping_current,
+    uint64_t* xct_timestamp);
 
   /**
    * Begins the transaction.
@@ -83,14 +86,21 @@ class Xct {
     hot_threshold_for_this_xct_ = default_hot_threshold_for_this_xct_;
     rll_threshold_for_this_xct_ = default_rll_threshold_for_this_xct_;
     isolation_level_ = isolation_level;
+    consistent_epoch_ = Epoch();
+    begin_epoch_ = Epoch();
     pointer_set_size_ = 0;
     page_version_set_size_ = 0;
     read_set_size_ = 0;
+    early_validated_read_set_size_ = 0;
     write_set_size_ = 0;
     lock_free_read_set_size_ = 0;
     lock_free_write_set_size_ = 0;
     *mcs_block_current_ = 0;
     *mcs_rw_async_mapping_current_ = 0;
+    if (!retrying_) {
+      *xct_timestamp_ = debugging::get_rdtsc();
+    }
+    retrying_ = false;
     local_work_memory_cur_ = 0;
     current_lock_list_.clear_entries();
     if (!retrospective_lock_list_.is_empty()) {
@@ -113,6 +123,14 @@ class Xct {
     *mcs_rw_async_mapping_current_ = 0;
   }
 
+  /**
+   * Called when the transaction aborts. The next transaction on this thread is deemed as
+   * its retry, and inherits the timestamp for the wait-die policy.
+   * @see CurrentLockList::try_or_acquire_single_lock()
+   */
+  void                on_abort() { retrying_ = true; }
+  uint64_t            get_xct_timestamp() const { return *xct_timestamp_; }
+
   uint32_t            get_mcs_block_current() const { return *mcs_block_current_; }
   uint32_t            increment_mcs_block_current() { return ++(*mcs_block_current_); }
   void                decrement_mcs_block_current() { --(*mcs_block_current_); }
@@ -139,6 +157,16 @@ class Xct {
   void  set_default_rll_threshold_for_this_xct(uint16_t value) {
     default_rll_threshold_for_this_xct_ = value; }
 
+  /**
+   * The profile of the transactions this thread runs, which is the key of the learned lock
+   * lists (see LearnedLockListCache). 0 means no profile. Unlike other per-xct values,
+   * this is kept across transactions until changed, and reset to a hash of the procedure name
+   * for every impersonation. Set it \e before begin_xct() to take effect.
+   */
+  uint64_t  get_rll_profile() const { return rll_profile_; }
+  void  set_rll_profile(uint64_t value) { rll_profile_ = value; }
+  LearnedLockListCache* get_learned_lock_lists() { return &learned_lock_lists_; }
+
   SysxctWorkspace* get_sysxct_workspace() const { return sysxct_workspace_; }
 
   /** Returns if this transaction makes no writes. */
@@ -147,6 +175,24 @@ class Xct {
   }
   /** Returns the level of isolation for this transaction. */
   IsolationLevel      get_isolation_level() const { return isolation_level_; }
+  /**
+   * Returns the epoch as of which a kEpochConsistent transaction reads the database.
+   * Invalid in other isolation levels.
+   */
+  Epoch               get_consistent_epoch() const { return consistent_epoch_; }
+  void                set_consistent_epoch(Epoch value) { consistent_epoch_ = value; }
+  /**
+   * Returns the current global epoch when this transaction began. Volatile pages this
+   * transaction has seen are not recycled until the global epoch passes this epoch + 1.
+   */
+  Epoch               get_begin_epoch() const { return begin_epoch_; }
+  void                set_begin_epoch(Epoch value) { begin_epoch_ = value; }
+  /** @return whether the record with the given TID is as of get_consistent_epoch() */
+  bool                is_epoch_consistent(XctId observed) const {
+    ASSERT_ND(consistent_epoch_.is_valid());
+    Epoch epoch = observed.get_epoch();
+    return !epoch.is_valid() || epoch <= consistent_epoch_;
+  }
   /** Returns the ID of this transaction, but note that it is not issued until commit time! */
   const XctId&        get_id() const { return id_; }
   thread::Thread*     get_thread_context() { return context_; }
@@ -298,6 +344,56 @@ class Xct {
       no_readset_if_moved ,
       no_readset_if_next_layer);
   }
+  /**
+   * @brief Confirms that the record has not changed while a kEpochConsistent transaction
+   * copied its payload.
+   * @details
+   * A kEpochConsistent transaction does not verify anything at commit time. Hence, after
+   * copying a payload observed in on_record_read(), it must make sure that the TID still is the
+   * observed one. Does nothing in other isolation levels, which verify reads in precommit or
+   * do not care.
+   * @return kErrorCodeXctRaceAbort if the TID has changed
+   */
+  ErrorCode           on_record_read_done(
+    const RwLockableXctId* tid_address,
+    XctId observed_xid) const {
+    if (isolation_level_ == kEpochConsistent) {
+      assorted::memory_fence_acquire();
+      if (UNLIKELY(tid_address->xct_id_ != observed_xid)) {
+        return kErrorCodeXctRaceAbort;
+      }
+    }
+    return kErrorCodeOk;
+  }
+  /**
+   * @brief Verifies the read-set before precommit.
+   * @details
+   * Long transactions call this (or let on_record_read() and MasstreeCursor call this,
+   * see XctOptions::early_validation_interval_) to find out that they are doomed to abort
+   * without doing the rest of their work. Entries that need to track moved records
+   * are left to precommit. Passing this check does \e not spare any verification in
+   * precommit, which must verify all read-sets after taking locks.
+   * @return kErrorCodeXctRaceAbort if any of the entries has changed
+   */
+  ErrorCode           validate_read_set_early();
+  /**
+   * @brief Returns whether it's time to call validate_read_set_early().
+   * @param[in] min_growth how many reads should have been added since the previous check
+   * @details
+   * We also wait until the read-set doubles since the previous check so that the
+   * checks in total cost at most two passes over the final read-set.
+   */
+  bool                should_validate_early(uint32_t min_growth) const {
+    if (early_validation_interval_ == 0 || isolation_level_ != kSerializable) {
+      return false;
+    }
+    ASSERT_ND(early_validated_read_set_size_ <= read_set_size_);
+    const uint32_t growth = read_set_size_ - early_validated_read_set_size_;
+    return growth > 0 && growth >= min_growth && growth >= early_validated_read_set_size_;
+  }
+  uint32_t            get_early_validation_interval() const { return early_validation_interval_; }
+  void  set_early_validation_interval(uint32_t value) { early_validation_interval_ = value; }
+
   /**
    * subroutine of on_record_read() to take lock(s).
    */
@@ -378,10 +474,17 @@ class Xct {
 
   /**
    * @brief Add the given log to the lock-free write set of this transaction.
+   * @param[in] storage_id the storage the log applies to
+   * @param[in] log_entry the log to apply at commit
+   * @param[in] payload_address the record payload the log applies to, if any.
+   * Sequential storage doesn't need it. Split increments in array storage do.
+   * @param[in] owner_id_address TID of the record, only for split increments in array storage.
    */
   ErrorCode           add_to_lock_free_write_set(
     storage::StorageId storage_id,
-    log::RecordLogType* log_entry);
+    log::RecordLogType* log_entry,
+    char* payload_address = CXX11_NULLPTR,
+    RwLockableXctId* owner_id_address = CXX11_NULLPTR);
 
   void                remember_previous_xct_id(XctId new_id) {
     ASSERT_ND(id_.before(new_id));
@@ -443,6 +546,10 @@ class Xct {
 
   /** Level of isolation for this transaction. */
   IsolationLevel      isolation_level_;
+  /** @see get_consistent_epoch() */
+  Epoch               consistent_epoch_;
+  /** @see get_begin_epoch() */
+  Epoch               begin_epoch_;
 
   /** Whether the object is an active transaction. */
   bool                active_;
@@ -495,9 +602,24 @@ class Xct {
 
   uint32_t*           mcs_rw_async_mapping_current_;
 
+  /**
+   * Timestamp of this transaction for the wait-die policy.
+   * This points to ThreadControlBlock because other threads compare it with theirs.
+   */
+  uint64_t*           xct_timestamp_;
+  /** Whether the previous transaction aborted, thus this one is its retry. */
+  bool                retrying_;
+
   ReadXctAccess*      read_set_;
   uint32_t            read_set_size_;
   uint32_t            max_read_set_size_;
+  /** read_set_size_ as of the previous validate_read_set_early(). */
+  uint32_t            early_validated_read_set_size_;
+  /**
+   * Copy of XctOptions::early_validation_interval_, which sticks until changed
+   * like rll_profile_.
+   */
+  uint32_t            early_validation_interval_;
 
   WriteXctAccess*     write_set_;
   uint32_t            write_set_size_;
@@ -529,6 +651,15 @@ class Xct {
    */
   xct::RetrospectiveLockList  retrospective_lock_list_;
 
+  /** @see get_rll_profile() */
+  uint64_t                    rll_profile_;
+
+  /**
+   * RLLs learned across transactions of this thread.
+   * @see foedus::xct::LearnedLockListCache
+   */
+  xct::LearnedLockListCache   learned_lock_lists_;
+
   void*               local_work_memory_;
   uint64_t            local_work_memory_size_;
   /** This value is reset to zero for each transaction, and always <= local_work_memory_size_ */
@@ -218,7 +218,8 @@ struct LockFreeReadXctAccess {
  * without any need for locking.
  * @ingroup XCT
  * @details
- * Some storage type doesn't need locking for serializability (so far \ref SEQUENTIAL only)
+ * Some storage type doesn't need locking for serializability (so far \ref SEQUENTIAL and
+ * split increments of \ref ARRAY).
  * For them, we maintain this write-set objects separated from WriteXctAccess.
  * We don't lock/unlock for these records, and we don't even have to remember what
  * we observed (actually, we don't even observe anything when we create this).
@@ -234,7 +235,17 @@ struct LockFreeWriteXctAccess {
   /** Pointer to the log entry in private log buffer for this write opereation. */
   log::RecordLogType*   log_entry_;
 
-  // no need for compare method or storing version/record/etc. it's lock-free!
+  /** Pointer to the payload of the record to apply the log on. null if not applicable. */
+  char*                 payload_address_;
+
+  /**
+   * TID of the record, only for split increments of \ref ARRAY. null otherwise.
+   * We never lock it, but precommit checks that it was written in the commit epoch.
+   * @see foedus::storage::array::ArrayStorage::increment_record_split()
+   */
+  RwLockableXctId*      owner_id_address_;
+
+  // no need for compare method or storing version etc. it's lock-free!
 };
 
 inline bool RecordXctAccess::compare(
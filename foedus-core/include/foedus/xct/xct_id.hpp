@@ -84,6 +84,24 @@ enum IsolationLevel {
    * Choose this level if you want full correctness.
    */
   kSerializable,
+
+  /**
+   * @brief Read-only transactions that read a consistent image of the database as of
+   * a recently closed epoch.
+   * @details
+   * The transaction reads the database as of the epoch two epochs before the current global
+   * epoch as of begin_xct(), which is closed, meaning no transaction commits in it any more.
+   * Records updated after the epoch are read from the previous-version table
+   * (see PreviousVersionTable), which update transactions fill in their apply phase.
+   * Hence, the staleness is a couple of epochs (tens of milliseconds) rather than a snapshot
+   * interval in kSnapshot. Like kDirtyRead and kSnapshot, no read-set is taken and
+   * nothing is verified in precommit.
+   * The transaction aborts only when it misses a previous version, which happens when
+   * the table is disabled, full, or the storage type does not save previous versions
+   * (so far only array storage does).
+   * Writes are not allowed in this level. precommit returns kErrorCodeXctReadOnlyIsolation.
+   */
+  kEpochConsistent,
 };
 
 /**
@@ -151,6 +169,26 @@ const LockListPosition kLockListPositionInvalid = 0;
 
 /** Index in thread-local MCS block. 0 means not locked. */
 typedef uint32_t McsBlockIndex;
+/**
+ * Block indexes at or above this value do not point to MCS blocks.
+ * They denote read-locks taken in the reader-biased mode (see XctOptions), and
+ * the value minus this base is the slot in ThreadControlBlock::mcs_biased_read_locks_.
+ * Real block indexes never exceed 0xFFFF.
+ */
+const McsBlockIndex kMcsBiasedReadBlockBase = 1U << 16;
+/** Number of read-locks one thread can hold at the same time in the reader-biased mode. */
+const uint32_t kMcsMaxBiasedReadLocks = 32;
+/** Number of per-node reader indicators. Each lock is hashed to one of them. */
+const uint32_t kMcsReaderIndicatorCount = 1U << 14;
+inline bool is_biased_read_block(McsBlockIndex index) { return index >= kMcsBiasedReadBlockBase; }
+
+/**
+ * Returns the index of the per-node reader indicator for the given lock.
+ * Adjacent records (16 bytes each) go to adjacent indicators.
+ */
+inline uint32_t to_reader_indicator_index(UniversalLockId lock_id) {
+  return static_cast<uint32_t>((lock_id >> 4) % kMcsReaderIndicatorCount);
+}
 /**
  * A special value meaning the lock is held by a non-regular guest
  * that doesn't have a context. See the MCSg paper for more details.
@@ -45,6 +45,7 @@ struct XctManagerControlBlock {
     current_global_epoch_advanced_.initialize();
     epoch_chime_wakeup_.initialize();
     new_transaction_paused_ = false;
+    pause_generation_ = 0;
   }
   void uninitialize() {
   }
@@ -88,6 +89,12 @@ struct XctManagerControlBlock {
    * This is used only once per several minutes, so no need for optimization. Keep it simple!
    */
   std::atomic<bool>                 new_transaction_paused_;
+  /**
+   * Incremented when new_transaction_paused_ becomes true and when it becomes false.
+   * Volatile pages are dropped only while paused, so thread-local objects that outlive
+   * transactions, such as LearnedLockListCache, discard what they learned in other generations.
+   */
+  std::atomic<uint64_t>             pause_generation_;
 };
 
 /**
@@ -134,6 +141,13 @@ class XctManagerPimpl final : public DefaultInitializable {
    * number in the read set. We don't have to take two memory fences in this case.
    */
   ErrorCode   precommit_xct_readonly(thread::Thread* context, Epoch *commit_epoch);
+  /**
+   * @brief precommit_xct() if the transaction is kEpochConsistent
+   * @details
+   * The transaction must be read-only, and it is serialized at its consistent epoch.
+   * Its reads have been already confirmed, so there is nothing to verify.
+   */
+  ErrorCode   precommit_xct_epoch_consistent(thread::Thread* context, Epoch *commit_epoch);
   /**
    * @brief precommit_xct() if the transaction is read-write
    * @details
@@ -187,6 +201,14 @@ class XctManagerPimpl final : public DefaultInitializable {
   bool        precommit_xct_verify_pointer_set(thread::Thread* context);
   /** Returns false if there is any page version conflict */
   bool        precommit_xct_verify_page_version_set(thread::Thread* context);
+  /**
+   * Returns false if a split increment in the lock-free write set is on a record whose TID
+   * is not in the commit epoch or is being written.
+   * @see foedus::storage::array::ArrayStorage::increment_record_split()
+   */
+  bool        precommit_xct_verify_split_increments(
+    thread::Thread* context,
+    Epoch commit_epoch);
   /**
    * @brief Phase 3 of precommit_xct()
    * @param[in] context thread context
@@ -197,6 +219,21 @@ class XctManagerPimpl final : public DefaultInitializable {
    * This method does NOT release locks yet. This is one difference from SILO.
    */
   void        precommit_xct_apply(thread::Thread* context, XctId max_xct_id, Epoch *commit_epoch);
+  /**
+   * Subroutine of precommit_xct_apply() to save the image of the record before the write
+   * in the previous-version table if needed.
+   * @see PreviousVersionTable
+   */
+  void        save_previous_version(
+    thread::Thread* context,
+    const WriteXctAccess& write,
+    XctId old_id,
+    Epoch commit_epoch);
+  /**
+   * Subroutine of save_previous_version() to wait until split increments committed in
+   * the given epoch are applied, so that the image we save contains all of them.
+   */
+  void        wait_for_split_increments(thread::Thread* context, Epoch epoch, Epoch commit_epoch);
   /** unlocking all acquired locks, used when commit/abort. */
   void        release_and_clear_all_current_locks(thread::Thread* context);
   bool        precommit_xct_acquire_writer_lock(thread::Thread* context, WriteXctAccess *write);
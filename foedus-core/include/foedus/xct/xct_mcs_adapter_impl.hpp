@@ -19,6 +19,7 @@
 #define FOEDUS_XCT_XCT_MCS_ADAPTER_IMPL_HPP_
 
 #include <atomic>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -30,6 +31,7 @@
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/thread/thread_id.hpp"
 #include "foedus/xct/xct_id.hpp"
+#include "foedus/xct/xct_options.hpp"
 
 namespace foedus {
 namespace xct {
@@ -87,6 +89,34 @@ class McsAdaptorConcept {
   /** Returns the bool var on whether other thread is waiting for some lock */
   std::atomic<bool>* other_waiting(thread::ThreadId id);
 
+  /**
+   * Returns how many times a NUMA-cohort handoff can bypass one waiter.
+   * 0 means NUMA-cohort handoffs are disabled.
+   */
+  uint16_t get_cohort_bypass_bound() const;
+  /** Returns the counter of how many times the other thread was bypassed while it waits */
+  uint32_t* other_cohort_bypassed(thread::ThreadId id);
+
+  /**
+   * Returns the page hotness from which read-locks are taken in the reader-biased mode.
+   * 256 means the reader-biased mode is disabled.
+   */
+  uint16_t get_reader_bias_threshold() const;
+  uint16_t get_numa_node_count() const;
+  thread::ThreadLocalOrdinal get_threads_per_node() const;
+  /** Converts the lock to UniversalLockId, which is what we publish for reader-biased locks */
+  UniversalLockId to_universal_lock_id(McsRwLock* lock) const;
+  /** Returns the reader indicators of the given node */
+  uint32_t* get_reader_indicators(thread::ThreadGroupId node);
+  /** Returns the slots of reader-biased read-locks held by the given thread */
+  UniversalLockId* get_biased_read_locks(thread::ThreadId id);
+
+  /**
+   * Returns the timestamp of the transaction the given thread is running, which is used to
+   * decide which transaction waits in the wait-die policy. Smaller is older.
+   */
+  uint64_t get_xct_timestamp(thread::ThreadId id);
+
   /** Dereference my block index for exclusive locks */
   McsWwBlock* get_ww_my_block(McsBlockIndex index);
   /** Dereference my block index for reader-writer locks */
@@ -135,6 +165,9 @@ struct McsMockThread {
     mcs_rw_async_mappings_ = std::move(rhs.mcs_rw_async_mappings_);
     mcs_block_current_ = rhs.mcs_block_current_;
     mcs_waiting_.store(rhs.mcs_waiting_.load());  // mainly due to this guy, this is NOT a move
+    mcs_cohort_bypassed_ = rhs.mcs_cohort_bypassed_;
+    xct_timestamp_ = rhs.xct_timestamp_;
+    std::memcpy(mcs_biased_read_locks_, rhs.mcs_biased_read_locks_, sizeof(mcs_biased_read_locks_));
   }
   void init(uint32_t max_block_count) {
     mcs_ww_blocks_.resize(max_block_count);
@@ -143,6 +176,9 @@ struct McsMockThread {
     mcs_rw_async_mapping_current_ = 0;
     mcs_block_current_ = 0;
     mcs_waiting_ = false;
+    mcs_cohort_bypassed_ = 0;
+    xct_timestamp_ = 0;
+    std::memset(mcs_biased_read_locks_, 0, sizeof(mcs_biased_read_locks_));
   }
   xct::McsBlockIndex get_mcs_rw_async_block_index(
     const memory::GlobalVolatilePageResolver& resolver,
@@ -162,6 +198,9 @@ struct McsMockThread {
   uint32_t                mcs_rw_async_mapping_current_;
   uint32_t                mcs_block_current_;
   std::atomic<bool>       mcs_waiting_;
+  uint32_t                mcs_cohort_bypassed_;
+  uint64_t                xct_timestamp_;
+  UniversalLockId         mcs_biased_read_locks_[kMcsMaxBiasedReadLocks];
   // add more if we need more context
 };
 
@@ -212,6 +251,7 @@ struct McsMockNode {
     uint32_t pages_per_node) {
     node_id_ = node_id;
     max_block_count_ = max_block_count;
+    reader_indicators_.resize(kMcsReaderIndicatorCount, 0);
     threads_.resize(threads_per_node);
     for (uint32_t t = 0; t < threads_per_node; ++t) {
       threads_[t].init(max_block_count);
@@ -231,6 +271,7 @@ struct McsMockNode {
   uint16_t node_id_;
   uint32_t max_block_count_;
   std::vector< McsMockThread<RW_BLOCK> >  threads_;
+  std::vector<uint32_t>   reader_indicators_;
 
   /**
    * Locks assigned to this node are stored in these memory.
@@ -253,6 +294,9 @@ struct McsMockContext {
     uint32_t max_lock_count) {
     max_block_count_ = max_block_count;
     max_lock_count_ = max_lock_count;
+    cohort_bypass_bound_ = 0;
+    reader_bias_threshold_ = XctOptions::kDefaultHotThresholdForReaderBiasedLocks;
+    threads_per_node_ = threads_per_node;
     // + 1U for index-0 (which is not used), and +1U for ceiling
     pages_per_node_ = (max_lock_count_ / kMcsMockDataPageLocksPerPage) + 1U + 1U;
     nodes_.resize(nodes);
@@ -288,6 +332,11 @@ struct McsMockContext {
   uint32_t max_block_count_;
   uint32_t max_lock_count_;
   uint32_t pages_per_node_;
+  /** Set a positive value to test NUMA-cohort handoffs. 0 (default) disables them. */
+  uint16_t cohort_bypass_bound_;
+  /** Set a value less than 256 to test reader-biased read-locks. */
+  uint16_t reader_bias_threshold_;
+  uint32_t threads_per_node_;
   std::vector< McsMockNode<RW_BLOCK> >    nodes_;
   /**
    * All locks managed by this objects are placed in these memory regions.
@@ -348,6 +397,28 @@ class McsMockAdaptor {
     McsMockThread<RW_BLOCK>* other = get_other_thread(id);
     return &(other->mcs_waiting_);
   }
+  uint16_t get_cohort_bypass_bound() const { return context_->cohort_bypass_bound_; }
+  uint16_t get_reader_bias_threshold() const { return context_->reader_bias_threshold_; }
+  uint16_t get_numa_node_count() const { return context_->nodes_.size(); }
+  thread::ThreadLocalOrdinal get_threads_per_node() const { return context_->threads_per_node_; }
+  UniversalLockId to_universal_lock_id(McsRwLock* lock) const {
+    return xct::rw_lock_to_universal_lock_id(context_->page_memory_resolver_, lock);
+  }
+  uint32_t* get_reader_indicators(thread::ThreadGroupId node) {
+    ASSERT_ND(node < context_->nodes_.size());
+    return context_->nodes_[node].reader_indicators_.data();
+  }
+  UniversalLockId* get_biased_read_locks(thread::ThreadId id) {
+    McsMockThread<RW_BLOCK>* other = get_other_thread(id);
+    return other->mcs_biased_read_locks_;
+  }
+  uint64_t get_xct_timestamp(thread::ThreadId id) {
+    return get_other_thread(id)->xct_timestamp_;
+  }
+  uint32_t* other_cohort_bypassed(thread::ThreadId id) {
+    McsMockThread<RW_BLOCK>* other = get_other_thread(id);
+    return &(other->mcs_cohort_bypassed_);
+  }
   McsBlockIndex get_other_cur_block(thread::ThreadId id) {
     McsMockThread<RW_BLOCK>* other = get_other_thread(id);
     return other->mcs_block_current_;
@@ -163,6 +163,14 @@ class McsImpl {  // TODO(Hideaki) should be renamed to McsRwImpl
    * @pre the lock must be now in writer mode.
    */
   void release_rw_writer(McsRwLock* lock, McsBlockIndex block_index);
+
+  /**
+   * [RW] Used for the wait-die policy of non-canonical locks.
+   * @return whether the transaction of this thread is older than that of the thread
+   * at the tail of the lock queue.
+   * @note this is an instantenous check. The queue might change right after this.
+   */
+  bool is_older_than_tail_waiter(McsRwLock* lock);
   /// RW-lock methods: END
   //////////////////////////////////////////////////////////////////////////////////
 
@@ -203,6 +211,14 @@ class McsWwImpl {
   void           release(McsWwLock* lock, McsBlockIndex block_index);
 
  private:
+  /**
+   * Used in release() when NUMA-cohort handoffs are enabled (see XctOptions).
+   * If the successor is on another node, moves a waiter on this node to the head of the queue
+   * unless it would bypass a waiter more than the bound.
+   * @return ID of the thread to hand over the lock
+   */
+  thread::ThreadId pick_cohort_successor(McsWwBlock* block);
+
   ADAPTOR adaptor_;
 };
 
@@ -49,6 +49,18 @@ struct XctOptions CXX11_FINAL : public virtual externalize::Externalizable {
     kDefaultEpochAdvanceIntervalMs = 20,
     kMcsImplementationTypeSimple = 0,
     kMcsImplementationTypeExtended = 1,
+    /** Simple MCS-RW locks plus NUMA-cohort handoffs. See mcs_cohort_bypass_bound_. */
+    kMcsImplementationTypeSimpleCohort = 2,
+    /** Default value for mcs_cohort_bypass_bound_. */
+    kDefaultMcsCohortBypassBound = 8,
+    /** Default value for hot_threshold_for_reader_biased_locks_. Disabled by default. */
+    kDefaultHotThresholdForReaderBiasedLocks = 256,
+    /** Default value for learned_lock_list_profiles_. */
+    kDefaultLearnedLockListProfiles = 8,
+    /** Default value for learned_lock_list_entries_. */
+    kDefaultLearnedLockListEntries = 64,
+    /** Default value for previous_version_entries_per_node_. 4MB per node. */
+    kDefaultPreviousVersionEntriesPerNode = 1 << 14,
     kDefaultHotThreshold = 256,  // OCC by default (for test cases and benchamrks that don't set it)
   };
 
@@ -134,6 +146,27 @@ struct XctOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   uint16_t    hot_threshold_for_retrospective_lock_list_;
 
+  /**
+   * @brief Number of profiles in each thread's cache of learned lock lists.
+   * @details
+   * Used only when RLL is enabled for the transaction.
+   * Each thread remembers the RLLs of aborted transactions per profile
+   * (see Xct::set_rll_profile()), and uses them as the RLL of the first run of following
+   * transactions of the same profile. 0 disables it.
+   * @see foedus::xct::LearnedLockListCache
+   * @ref RLL
+   */
+  uint16_t    learned_lock_list_profiles_;
+
+  /**
+   * @brief Maximum number of locks each learned lock list profile remembers.
+   * @details
+   * We pre-allocate learned_lock_list_profiles_ times this many entries for each
+   * NumaCoreMemory. Transactions of one type that conflict on more records than this
+   * still learn the first ones.
+   */
+  uint16_t    learned_lock_list_entries_;
+
   /**
    * @brief Whether precommit always releases all locks that violate canonical mode before
    * taking X-locks.
@@ -154,14 +187,92 @@ struct XctOptions CXX11_FINAL : public virtual externalize::Externalizable {
    */
   bool        force_canonical_xlocks_in_precommit_;
 
+  /**
+   * @brief Whether to apply the wait-die policy when a lock in non-canonical mode is contended.
+   * @details
+   * Default is false, in which case such a lock is just tried, and the transaction aborts
+   * (or gives up the lock) if it can't immediately acquire it.
+   * When true, a transaction older than the one at the tail of the lock queue waits instead.
+   * It first releases the locks it holds after the lock, so the wait is in canonical mode
+   * and deadlock-free. A younger transaction aborts as usual. The retry keeps the age,
+   * so each transaction eventually gets to wait. This reduces abort storms under heavy
+   * contention at the cost of re-taking the released locks.
+   * @see foedus::xct::CurrentLockList::try_or_acquire_single_lock()
+   * @ref RLL
+   */
+  bool        enable_non_canonical_wait_die_;
+
   /**
    * @brief Defines which implementation of MCS locks to use for RW locks.
    * @details
-   * So far we allow "kMcsImplementationTypeSimple" and "kMcsImplementationTypeExtended".
+   * So far we allow "kMcsImplementationTypeSimple", "kMcsImplementationTypeExtended",
+   * and "kMcsImplementationTypeSimpleCohort".
    * For WW locks, we always use our MCSg lock.
+   *
+   * "kMcsImplementationTypeSimpleCohort" uses the simple RW lock, but the releasing writer
+   * (and the releasing owner of WW locks) prefers to pass the lock to a waiting writer on its own
+   * NUMA node, even if a waiter on another node is ahead of it in the queue. This saves
+   * cross-socket cache-line transfers of hot locks. Only the order of \e waiters in one queue
+   * changes, so the canonical order of UniversalLockId and its deadlock-freedom are kept.
    * @see foedus::xct::McsImpl
    */
   uint16_t    mcs_implementation_type_;
+
+  /**
+   * @brief How many times a waiter can be bypassed by NUMA-cohort handoffs.
+   * @details
+   * Used only with kMcsImplementationTypeSimpleCohort. Once a waiting thread is passed over
+   * this many times, it receives the lock in usual FIFO order. This bounds the unfairness
+   * against threads on remote nodes. Must be positive.
+   */
+  uint16_t    mcs_cohort_bypass_bound_;
+
+  /**
+   * @brief Read-locks on records in pages whose hotness is this value or more are taken in the
+   * reader-biased mode.
+   * @details
+   * Used only with the simple MCS-RW locks (kMcsImplementationTypeSimple and
+   * kMcsImplementationTypeSimpleCohort). A reader in this mode does not touch the lock word
+   * as far as no one is in the MCS queue. Instead, it publishes the lock in its own slot and
+   * increments a reader indicator of its NUMA node. Writers then check the indicators of all
+   * nodes and wait for such readers of the lock (revocation) after taking the MCS lock.
+   * This avoids cache-line ping-pongs among readers of hot, read-mostly records at the cost
+   * of a little more work for writers.
+   * Hotness is 0-255, so the default value 256 disables it.
+   */
+  uint16_t    hot_threshold_for_reader_biased_locks_;
+
+  /**
+   * @brief Number of entries in the previous-version table of each NUMA node.
+   * @details
+   * Transactions that update records save the images before the update in this table,
+   * which kEpochConsistent transactions read to see records as of a closed epoch.
+   * Each entry is 256 bytes of shared memory. The default is kDefaultPreviousVersionEntriesPerNode.
+   * 0 disables the table, in which case kEpochConsistent transactions abort whenever they see
+   * a record updated after the epoch, which, for hot records, is almost always.
+   * @see foedus::xct::PreviousVersionTable
+   */
+  uint32_t    previous_version_entries_per_node_;
+
+  /**
+   * @brief Minimal number of new reads before a serializable transaction re-verifies its
+   * whole read-set before going on.
+   * @details
+   * Default is 0, which disables it. OCC detects conflicts only in precommit, so a long
+   * transaction might do all its work just to abort there. When this is positive, a read
+   * triggers the check once at least this many entries were added to the read-set since the
+   * previous check \e and the read-set has at least doubled since then. MasstreeCursor also
+   * tries the check when it moves on to the next border page, where any number of new reads
+   * suffices as long as the read-set has doubled.
+   * Each check verifies all entries of the read-set, not only the new ones, and we return
+   * kErrorCodeXctRaceAbort as soon as we find a changed record. Because the read-set must
+   * double between checks, the checks in total cost at most two passes over the final
+   * read-set. This does not replace the verification in precommit, which still checks all
+   * read-sets after taking locks.
+   * @see foedus::xct::Xct::validate_read_set_early()
+   * @see foedus::xct::Xct::should_validate_early()
+   */
+  uint32_t    early_validation_interval_;
 };
 }  // namespace xct
 }  // namespace foedus
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/assorted/crc32c.hpp"
+
+#include <cstring>
+
+namespace foedus {
+namespace assorted {
+
+namespace {
+/** Reflected Castagnoli polynomial. */
+const uint32_t kCrc32cPolynomial = 0x82F63B78U;
+
+struct Crc32cTable {
+  uint32_t entries_[256];
+  Crc32cTable() {
+    for (uint32_t i = 0; i < 256U; ++i) {
+      uint32_t value = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        value = (value & 1U) ? (value >> 1) ^ kCrc32cPolynomial : (value >> 1);
+      }
+      entries_[i] = value;
+    }
+  }
+};
+
+uint32_t crc32c_software(const char* data, uint64_t length, uint32_t crc) {
+  static const Crc32cTable kTable;
+  for (uint64_t i = 0; i < length; ++i) {
+    crc = kTable.entries_[(crc ^ static_cast<uint8_t>(data[i])) & 0xFFU] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("sse4.2")))
+uint32_t crc32c_hardware(const char* data, uint64_t length, uint32_t crc) {
+  uint64_t crc64 = crc;
+  uint64_t i = 0;
+  for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    crc64 = __builtin_ia32_crc32di(crc64, word);
+  }
+  uint32_t crc32 = static_cast<uint32_t>(crc64);
+  for (; i < length; ++i) {
+    crc32 = __builtin_ia32_crc32qi(crc32, static_cast<uint8_t>(data[i]));
+  }
+  return crc32;
+}
+
+bool is_hardware_crc32c_supported() {
+  static const bool kSupported = __builtin_cpu_supports("sse4.2");
+  return kSupported;
+}
+#endif  // defined(__x86_64__) && defined(__GNUC__)
+}  // namespace
+
+uint32_t crc32c(const void* data, uint64_t length, uint32_t crc) {
+  const char* bytes = reinterpret_cast<const char*>(data);
+  crc = ~crc;
+#if defined(__x86_64__) && defined(__GNUC__)
+  if (is_hardware_crc32c_supported()) {
+    return ~crc32c_hardware(bytes, length, crc);
+  }
+#endif  // defined(__x86_64__) && defined(__GNUC__)
+  return ~crc32c_software(bytes, length, crc);
+}
+
+}  // namespace assorted
+}  // namespace foedus
@@ -27,6 +27,8 @@ CacheOptions::CacheOptions() {
   private_snapshot_cache_initial_grab_ = memory::PagePoolOffsetChunk::kMaxSize / 2;
   snapshot_cache_eviction_threshold_ = 0.75;
   snapshot_cache_urgent_threshold_ = 0.9;
+  snapshot_file_mmap_ = false;
+  verify_snapshot_checksum_ = false;
 }
 ErrorStack CacheOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_enabled_);
@@ -38,6 +40,8 @@ ErrorStack CacheOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_cache_urgent_threshold_);
   ASSERT_ND(snapshot_cache_urgent_threshold_ >= snapshot_cache_eviction_threshold_);
   ASSERT_ND(snapshot_cache_urgent_threshold_ <= 1);
+  EXTERNALIZE_LOAD_ELEMENT(element, snapshot_file_mmap_);
+  EXTERNALIZE_LOAD_ELEMENT(element, verify_snapshot_checksum_);
   return kRetOk;
 }
 ErrorStack CacheOptions::save(tinyxml2::XMLElement* element) const {
@@ -62,6 +66,10 @@ ErrorStack CacheOptions::save(tinyxml2::XMLElement* element) const {
     snapshot_cache_urgent_threshold_,
     "When the cache eviction performs in an urgent mode, which immediately advances"
     " the current epoch to release pages");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_file_mmap_,
+    "Whether to read snapshot files through read-only memory mappings");
+  EXTERNALIZE_SAVE_ELEMENT(element, verify_snapshot_checksum_,
+    "Whether to verify the CRC32C checksum of each snapshot page read from snapshot files");
   return kRetOk;
 }
 
@@ -17,21 +17,31 @@
  */
 #include "foedus/cache/snapshot_file_set.hpp"
 
+#include <glog/logging.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
 #include <map>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/error_stack_batch.hpp"
 #include "foedus/fs/direct_io_file.hpp"
+#include "foedus/fs/filesystem.hpp"
 #include "foedus/fs/path.hpp"
 #include "foedus/storage/page.hpp"
 
 namespace foedus {
 namespace cache {
 
-SnapshotFileSet::SnapshotFileSet(Engine* engine) : engine_(engine) {
+SnapshotFileSet::SnapshotFileSet(Engine* engine)
+  : engine_(engine),
+    mmap_enabled_(engine->get_options().cache_.snapshot_file_mmap_),
+    verify_checksum_(engine->get_options().cache_.verify_snapshot_checksum_) {
 }
 
 ErrorStack SnapshotFileSet::initialize_once() {
@@ -45,6 +55,16 @@ ErrorStack SnapshotFileSet::uninitialize_once() {
 }
 
 void SnapshotFileSet::close_all() {
+  for (auto& mappings_in_a_snapshot : mappings_) {
+    for (auto& mapping : mappings_in_a_snapshot.second) {
+      ::munmap(const_cast<char*>(mapping.second.address_), mapping.second.size_);
+    }
+  }
+  mappings_.clear();
+  for (const MappedFile& mapping : retired_mappings_) {
+    ::munmap(const_cast<char*>(mapping.address_), mapping.size_);
+  }
+  retired_mappings_.clear();
   for (auto& files_in_a_snapshot : files_) {
     auto& values = files_in_a_snapshot.second;
     for (auto& file : values) {
@@ -87,21 +107,143 @@ ErrorCode SnapshotFileSet::get_or_open_file(
     }
     std::pair< thread::ThreadGroupId, fs::DirectIoFile* > entry(node_id, file);
     the_map.insert(entry);
+    if (mmap_enabled_) {
+      map_file(snapshot_id, node_id, file);
+    }
     *out = file;
     return kErrorCodeOk;
   }
 }
 
+void SnapshotFileSet::map_file(
+  snapshot::SnapshotId snapshot_id,
+  thread::ThreadGroupId node_id,
+  fs::DirectIoFile* file) {
+  ASSERT_ND(mmap_enabled_);
+  uint64_t size = fs::file_size(file->get_path());
+  if (size == 0 || size == static_cast<uint64_t>(-1)) {
+    return;
+  }
+  // Private and writable. Callers get snapshot pages as non-const Page*, just like pages in the
+  // snapshot cache, so a write must not fault. It goes to a private copy and never to the file.
+  void* address = ::mmap(
+    nullptr,
+    size,
+    PROT_READ | PROT_WRITE,
+    MAP_PRIVATE,
+    file->get_descriptor(),
+    0);
+  if (address == MAP_FAILED) {
+    // not a fatal issue. we just fall back to usual reads.
+    LOG(WARNING) << "Failed to mmap a snapshot file " << file->get_path() << ". errno=" << errno
+      << ". Falling back to read()";
+    return;
+  }
+  MappedFile mapped = { reinterpret_cast<const char*>(address), size };
+  mappings_[snapshot_id][node_id] = mapped;
+}
+
+const char* SnapshotFileSet::find_mapped(
+  storage::SnapshotPagePointer page_id_begin,
+  uint32_t page_count) {
+  ASSERT_ND(mmap_enabled_);
+  snapshot::SnapshotId snapshot_id
+    = storage::extract_snapshot_id_from_snapshot_pointer(page_id_begin);
+  thread::ThreadGroupId node_id = storage::extract_numa_node_from_snapshot_pointer(page_id_begin);
+  auto snapshot = mappings_.find(snapshot_id);
+  if (snapshot == mappings_.end()) {
+    return nullptr;
+  }
+  auto node = snapshot->second.find(node_id);
+  if (node == snapshot->second.end()) {
+    return nullptr;
+  }
+  uint64_t offset = storage::extract_local_page_id_from_snapshot_pointer(page_id_begin)
+    * sizeof(storage::Page);
+  uint64_t bytes = static_cast<uint64_t>(page_count) * sizeof(storage::Page);
+  if (offset + bytes > node->second.size_) {
+    // the file was appended after we mapped it. happens only for the node-0 file of the latest
+    // snapshot, to which the gleaner appends root pages. re-map it with the current size.
+    // We might have handed out pointers into the old mapping, so keep it until close_all().
+    retired_mappings_.push_back(node->second);
+    snapshot->second.erase(node);
+    fs::DirectIoFile* file;
+    if (get_or_open_file(snapshot_id, node_id, &file) != kErrorCodeOk) {
+      return nullptr;
+    }
+    map_file(snapshot_id, node_id, file);
+    node = snapshot->second.find(node_id);
+    if (node == snapshot->second.end() || offset + bytes > node->second.size_) {
+      return nullptr;
+    }
+  }
+  return node->second.address_ + offset;
+}
+
+ErrorCode SnapshotFileSet::get_mapped_pages(
+  storage::SnapshotPagePointer page_id_begin,
+  uint32_t page_count,
+  bool sequential,
+  const storage::Page** out) {
+  *out = nullptr;
+  if (!mmap_enabled_) {
+    return kErrorCodeOk;
+  }
+  fs::DirectIoFile* file;
+  CHECK_ERROR_CODE(get_or_open_file(page_id_begin, &file));  // this also maps the file
+  const char* address = find_mapped(page_id_begin, page_count);
+  if (address == nullptr) {
+    return kErrorCodeOk;
+  }
+  if (sequential) {
+    // madvise requires a page-aligned address. Our pages are 4kb aligned in the file.
+    uint64_t bytes = static_cast<uint64_t>(page_count) * sizeof(storage::Page);
+    void* aligned = const_cast<char*>(address);
+    ::madvise(aligned, bytes, MADV_SEQUENTIAL);
+    ::madvise(aligned, bytes, MADV_WILLNEED);
+  }
+  const storage::Page* pages = reinterpret_cast<const storage::Page*>(address);
+  ASSERT_ND(pages->get_header().page_id_ == page_id_begin);
+  CHECK_ERROR_CODE(verify_checksums(pages, page_count));
+  *out = pages;
+  return kErrorCodeOk;
+}
+
+ErrorCode SnapshotFileSet::verify_checksums(
+  const storage::Page* pages,
+  uint32_t page_count) const {
+  if (!verify_checksum_) {
+    return kErrorCodeOk;
+  }
+  for (uint32_t i = 0; i < page_count; ++i) {
+    if (UNLIKELY(!storage::verify_page_checksum(pages + i))) {
+      LOG(ERROR) << "Checksum mismatch in snapshot page " << pages[i].get_header().page_id_
+        << ". stored=" << pages[i].get_header().checksum_
+        << ", computed=" << storage::compute_page_checksum(pages + i);
+      return kErrorCodeCacheChecksumMismatch;
+    }
+  }
+  return kErrorCodeOk;
+}
+
 ErrorCode SnapshotFileSet::read_page(storage::SnapshotPagePointer page_id, void* out) {
   fs::DirectIoFile* file;
   CHECK_ERROR_CODE(get_or_open_file(page_id, &file));
+  if (mmap_enabled_) {
+    const char* address = find_mapped(page_id, 1);
+    if (address) {
+      std::memcpy(out, address, sizeof(storage::Page));
+      ASSERT_ND(reinterpret_cast<storage::Page*>(out)->get_header().page_id_ == page_id);
+      return verify_checksums(reinterpret_cast<storage::Page*>(out), 1);
+    }
+  }
   storage::SnapshotLocalPageId local_page_id
     = storage::extract_local_page_id_from_snapshot_pointer(page_id);
   CHECK_ERROR_CODE(
     file->seek(local_page_id * sizeof(storage::Page), fs::DirectIoFile::kDirectIoSeekSet));
   CHECK_ERROR_CODE(file->read_raw(sizeof(storage::Page), out));
   ASSERT_ND(reinterpret_cast<storage::Page*>(out)->get_header().page_id_ == page_id);
-  return kErrorCodeOk;
+  return verify_checksums(reinterpret_cast<storage::Page*>(out), 1);
 }
 
 ErrorCode SnapshotFileSet::read_pages(
@@ -110,18 +252,24 @@ ErrorCode SnapshotFileSet::read_pages(
   void* out) {
   fs::DirectIoFile* file;
   CHECK_ERROR_CODE(get_or_open_file(page_id_begin, &file));
-  storage::SnapshotLocalPageId local_page_id_begin
-    = storage::extract_local_page_id_from_snapshot_pointer(page_id_begin);
-  CHECK_ERROR_CODE(
-    file->seek(local_page_id_begin * sizeof(storage::Page), fs::DirectIoFile::kDirectIoSeekSet));
-  CHECK_ERROR_CODE(file->read_raw(sizeof(storage::Page) * page_count, out));
+  const char* address = mmap_enabled_ ? find_mapped(page_id_begin, page_count) : nullptr;
+  if (address) {
+    std::memcpy(out, address, sizeof(storage::Page) * page_count);
+  } else {
+    storage::SnapshotLocalPageId local_page_id_begin
+      = storage::extract_local_page_id_from_snapshot_pointer(page_id_begin);
+    CHECK_ERROR_CODE(file->seek(
+      local_page_id_begin * sizeof(storage::Page),
+      fs::DirectIoFile::kDirectIoSeekSet));
+    CHECK_ERROR_CODE(file->read_raw(sizeof(storage::Page) * page_count, out));
+  }
 #ifndef NDEBUG
   storage::Page* pages = reinterpret_cast<storage::Page*>(out);
   for (uint32_t i = 0; i < page_count; ++i) {
     ASSERT_ND(pages[i].get_header().page_id_ == page_id_begin + i);
   }
 #endif  // NDEBUG
-  return kErrorCodeOk;
+  return verify_checksums(reinterpret_cast<storage::Page*>(out), page_count);
 }
 
 std::ostream& operator<<(std::ostream& o, const SnapshotFileSet& v) {
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/log/log_subscriber.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/fs/direct_io_file.hpp"
+#include "foedus/fs/filesystem.hpp"
+#include "foedus/fs/path.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/log/logger_ref.hpp"
+#include "foedus/savepoint/savepoint.hpp"
+#include "foedus/savepoint/savepoint_manager.hpp"
+
+namespace foedus {
+namespace log {
+
+const uint64_t kIoAlignment = 0x1000;
+inline uint64_t align_io_floor(uint64_t offset) { return (offset / kIoAlignment) * kIoAlignment; }
+inline uint64_t align_io_ceil(uint64_t offset) {
+  return align_io_floor(offset + kIoAlignment - 1U);
+}
+
+/** Sorts offsets of logs in a buffer by their XctId. Stable sort keeps in-xct order. */
+struct CompareLogsByXctId {
+  explicit CompareLogsByXctId(const char* buffer) : buffer_(buffer) {}
+  bool operator()(uint64_t left, uint64_t right) const {
+    const LogHeader* left_header = reinterpret_cast<const LogHeader*>(buffer_ + left);
+    const LogHeader* right_header = reinterpret_cast<const LogHeader*>(buffer_ + right);
+    return left_header->xct_id_.before(right_header->xct_id_);
+  }
+  const char* const buffer_;
+};
+
+LogSubscriber::LogSubscriber(Engine* engine, Epoch consumed_epoch, uint64_t buffer_size)
+  : engine_(engine),
+    buffer_size_(buffer_size),
+    consumed_epoch_(consumed_epoch),
+    epoch_(INVALID_EPOCH),
+    restart_epoch_(INVALID_EPOCH),
+    buffer_used_(0) {
+}
+
+ErrorStack LogSubscriber::initialize_once() {
+  io_buffer_.alloc(kIoBufferSize, kIoAlignment, memory::AlignedMemory::kNumaAllocOnnode, 0);
+  buffer_.alloc(
+    align_io_ceil(buffer_size_),
+    kIoAlignment,
+    memory::AlignedMemory::kNumaAllocOnnode,
+    0);
+  if (io_buffer_.is_null() || buffer_.is_null()) {
+    return ERROR_STACK(kErrorCodeOutofmemory);
+  }
+  buffer_used_ = 0;
+  log_offsets_.clear();
+  epoch_ = INVALID_EPOCH;
+
+  // Loggers have no epoch histories before restart. If we need logs before restart,
+  // rebuild them from the log files.
+  restart_epoch_ = engine_->get_savepoint_manager()->get_initial_durable_epoch();
+  restart_histories_.clear();
+  restart_markers_.clear();
+  if (!consumed_epoch_.is_valid() || consumed_epoch_ < restart_epoch_) {
+    const EngineOptions& options = engine_->get_options();
+    const LoggerId total_loggers = options.log_.loggers_per_node_ * options.thread_.group_count_;
+    for (LoggerId id = 0; id < total_loggers; ++id) {
+      CHECK_ERROR(restore_restart_history(id));
+    }
+  }
+  return kRetOk;
+}
+
+ErrorStack LogSubscriber::restore_restart_history(LoggerId logger_id) {
+  const EpochHistory marker = engine_->get_log_manager()->get_logger(logger_id)
+    .get_oldest_epoch_history();
+  ASSERT_ND(marker.new_epoch_ == restart_epoch_);
+  restart_markers_.push_back(marker);
+  restart_histories_.push_back(std::vector<EpochHistory>());
+  std::vector<EpochHistory>* markers = &restart_histories_.back();
+
+  // Log files are kept from the oldest position in the savepoint.
+  const savepoint::LoggerSavepointInfo info
+    = engine_->get_savepoint_manager()->get_logger_savepoint(logger_id);
+  LogRange range;
+  range.begin_file_ordinal = info.oldest_log_file_;
+  range.begin_offset = info.oldest_log_file_offset_begin_;
+  range.end_file_ordinal = marker.log_file_ordinal_;
+  range.end_offset = marker.log_file_offset_;
+  if (!range.is_empty()) {
+    WRAP_ERROR_CODE(read_range(logger_id, range, INVALID_EPOCH, markers));
+  }
+  LOG(INFO) << "Logger-" << logger_id << " had " << markers->size() << " epoch markers before"
+    << " restart at " << restart_epoch_;
+
+  // Logs upto the old epoch of the first marker are not in the files any more.
+  const Epoch earliest = markers->empty() ? marker.new_epoch_ : markers->front().old_epoch_;
+  if (consumed_epoch_.is_valid() && consumed_epoch_ < earliest) {
+    LOG(ERROR) << "Logger-" << logger_id << " no longer has logs after the consumed epoch "
+      << consumed_epoch_ << ". The oldest log is after epoch " << earliest;
+    return ERROR_STACK(kErrorCodeLogSubscriberEpochUnavailable);
+  }
+  return kRetOk;
+}
+
+LogRange LogSubscriber::get_restart_range(LoggerId logger_id, Epoch epoch) const {
+  ASSERT_ND(epoch <= restart_epoch_);
+  const std::vector<EpochHistory>& markers = restart_histories_[logger_id];
+  const EpochHistory& restart_marker = restart_markers_[logger_id];
+  const Epoch prev_epoch = epoch.one_less();
+  LogRange result;
+  result.end_file_ordinal = restart_marker.log_file_ordinal_;
+  result.end_offset = restart_marker.log_file_offset_;
+  uint32_t pos = 0;
+  for (; pos < markers.size() && markers[pos].new_epoch_ <= prev_epoch; ++pos) {
+    continue;
+  }
+  if (pos == markers.size()) {
+    // No logs of the epoch before restart.
+    result.begin_file_ordinal = result.end_file_ordinal;
+    result.begin_offset = result.end_offset;
+    return result;
+  }
+  result.begin_file_ordinal = markers[pos].log_file_ordinal_;
+  result.begin_offset = markers[pos].log_file_offset_;
+  for (; pos < markers.size(); ++pos) {
+    if (markers[pos].new_epoch_ > epoch) {
+      result.end_file_ordinal = markers[pos].log_file_ordinal_;
+      result.end_offset = markers[pos].log_file_offset_;
+      break;
+    }
+  }
+  return result;
+}
+
+ErrorStack LogSubscriber::uninitialize_once() {
+  log_offsets_.clear();
+  io_buffer_.release_block();
+  buffer_.release_block();
+  return kRetOk;
+}
+
+void LogSubscriber::add_storage(storage::StorageId storage_id) {
+  if (std::find(storages_.begin(), storages_.end(), storage_id) == storages_.end()) {
+    storages_.push_back(storage_id);
+  }
+}
+
+bool LogSubscriber::is_subscribed(storage::StorageId storage_id) const {
+  if (storages_.empty()) {
+    return true;
+  }
+  return std::find(storages_.begin(), storages_.end(), storage_id) != storages_.end();
+}
+
+ErrorCode LogSubscriber::next_epoch(int64_t wait_microseconds) {
+  ASSERT_ND(is_initialized());
+  LogManager* log_manager = engine_->get_log_manager();
+  log_offsets_.clear();
+  buffer_used_ = 0;
+  epoch_ = INVALID_EPOCH;
+  while (true) {
+    const Epoch durable_epoch = log_manager->get_durable_global_epoch();
+    while (!consumed_epoch_.is_valid() || consumed_epoch_ < durable_epoch) {
+      const Epoch epoch = find_next_epoch(durable_epoch);
+      if (!epoch.is_valid()) {
+        // No logger wrote anything after consumed_epoch_. Skip them all.
+        consumed_epoch_ = durable_epoch;
+        break;
+      }
+      // If this fails, consumed_epoch_ stays so that the caller can retry the epoch.
+      CHECK_ERROR_CODE(read_epoch(epoch));
+      consumed_epoch_ = epoch;
+      if (!log_offsets_.empty()) {
+        epoch_ = epoch;
+        return kErrorCodeOk;
+      }
+      DVLOG(1) << "Epoch " << epoch << " had no logs of the subscribed storages";
+    }
+
+    // We have consumed all durable epochs. Wait for the next one.
+    CHECK_ERROR_CODE(log_manager->wait_until_durable(durable_epoch.one_more(), wait_microseconds));
+  }
+}
+
+Epoch LogSubscriber::find_next_epoch(Epoch durable_epoch) const {
+  const EngineOptions& options = engine_->get_options();
+  const LoggerId total_loggers = options.log_.loggers_per_node_ * options.thread_.group_count_;
+  Epoch ret = INVALID_EPOCH;
+  for (LoggerId id = 0; id < total_loggers; ++id) {
+    Epoch marked = engine_->get_log_manager()->get_logger(id).get_next_marked_epoch(
+      consumed_epoch_);
+    if (marked.is_valid() && marked <= durable_epoch) {
+      ret.store_min(marked);
+    }
+  }
+  // Epoch markers before restart are only in restart_histories_.
+  const bool before_restart = !consumed_epoch_.is_valid() || consumed_epoch_ < restart_epoch_;
+  if (!restart_histories_.empty() && before_restart) {
+    for (LoggerId id = 0; id < total_loggers; ++id) {
+      const std::vector<EpochHistory>& markers = restart_histories_[id];
+      for (uint32_t pos = 0; pos < markers.size(); ++pos) {
+        if (!consumed_epoch_.is_valid() || markers[pos].new_epoch_ > consumed_epoch_) {
+          ret.store_min(markers[pos].new_epoch_);
+          break;
+        }
+      }
+    }
+  }
+  return ret;
+}
+
+ErrorCode LogSubscriber::read_epoch(Epoch epoch) {
+  ASSERT_ND(epoch.is_valid());
+  const EngineOptions& options = engine_->get_options();
+  const LoggerId total_loggers = options.log_.loggers_per_node_ * options.thread_.group_count_;
+  log_offsets_.clear();
+  buffer_used_ = 0;
+  for (LoggerId id = 0; id < total_loggers; ++id) {
+    LogRange range;
+    if (!restart_histories_.empty() && epoch <= restart_epoch_) {
+      // Logs written before restart. Loggers don't have epoch histories for them.
+      range = get_restart_range(id, epoch);
+    } else {
+      range = engine_->get_log_manager()->get_logger(id).get_log_range(epoch.one_less(), epoch);
+    }
+    if (!range.is_empty()) {
+      CHECK_ERROR_CODE(read_range(id, range, epoch));
+    }
+  }
+
+  // Each logger has logs of many threads. Sort them into an order of transactions.
+  std::stable_sort(
+    log_offsets_.begin(),
+    log_offsets_.end(),
+    CompareLogsByXctId(reinterpret_cast<const char*>(buffer_.get_block())));
+  return kErrorCodeOk;
+}
+
+ErrorCode LogSubscriber::read_range(
+  LoggerId logger_id,
+  const LogRange& range,
+  Epoch epoch,
+  std::vector<EpochHistory>* markers) {
+  // Same as LogMapper::handle_process(), we read 4kb-aligned ranges with direct I/O.
+  const LogOptions& options = engine_->get_options().log_;
+  const uint16_t numa_node = logger_id / options.loggers_per_node_;
+  const char* io_buffer = reinterpret_cast<const char*>(io_buffer_.get_block());
+  for (LogFileOrdinal ordinal = range.begin_file_ordinal;
+        ordinal <= range.end_file_ordinal;
+        ++ordinal) {
+    fs::Path path(options.construct_suffixed_log_path(numa_node, logger_id, ordinal));
+    uint64_t begin_infile = ordinal == range.begin_file_ordinal ? range.begin_offset : 0;
+    uint64_t end_infile;
+    if (ordinal == range.end_file_ordinal) {
+      end_infile = range.end_offset;
+    } else {
+      end_infile = align_io_floor(fs::file_size(path));
+    }
+    if (begin_infile >= end_infile) {
+      continue;
+    }
+
+    fs::DirectIoFile file(path, options.emulation_);
+    CHECK_ERROR_CODE(file.open(true, false, false, false));
+    while (begin_infile < end_infile) {
+      const uint64_t read_infile_aligned = align_io_floor(begin_infile);
+      const uint64_t read_size = std::min<uint64_t>(
+        io_buffer_.get_size(),
+        align_io_ceil(end_infile - read_infile_aligned));
+      CHECK_ERROR_CODE(file.seek(read_infile_aligned, fs::DirectIoFile::kDirectIoSeekSet));
+      CHECK_ERROR_CODE(file.read(read_size, &io_buffer_));
+
+      const uint64_t end_inbuf = std::min<uint64_t>(read_size, end_infile - read_infile_aligned);
+      uint64_t cur_inbuf = begin_infile - read_infile_aligned;
+      while (cur_inbuf < end_inbuf) {
+        const LogHeader* header = reinterpret_cast<const LogHeader*>(io_buffer + cur_inbuf);
+        ASSERT_ND(header->log_length_ > 0);
+        if (UNLIKELY(header->log_length_ == 0
+          || read_infile_aligned + cur_inbuf + header->log_length_ > end_infile)) {
+          LOG(ERROR) << "Inconsistent log entry in " << path << " at "
+            << read_infile_aligned + cur_inbuf << ": " << *header;
+          return kErrorCodeSnapshotInvalidLogEnd;
+        } else if (cur_inbuf + header->log_length_ > read_size) {
+          break;  // this log spans the end of the read. read again from here.
+        }
+        if (markers == CXX11_NULLPTR) {
+          CHECK_ERROR_CODE(add_log(header, epoch));
+        } else if (header->get_type() == kLogCodeEpochMarker) {
+          const EpochMarkerLogType* marker = reinterpret_cast<const EpochMarkerLogType*>(header);
+          // Markers after the durable epoch at restart are remnants of non-durable logs.
+          if (marker->new_epoch_ <= restart_epoch_) {
+            markers->push_back(EpochHistory(*marker));
+          }
+        }
+        cur_inbuf += header->log_length_;
+      }
+      begin_infile = read_infile_aligned + cur_inbuf;
+    }
+    file.close();
+  }
+  return kErrorCodeOk;
+}
+
+inline ErrorCode LogSubscriber::add_log(const LogHeader* header, Epoch epoch) {
+  if (header->get_kind() != kRecordLogs) {
+    return kErrorCodeOk;  // epoch markers, fillers, etc
+  } else if (header->xct_id_.get_epoch() != epoch || !is_subscribed(header->storage_id_)) {
+    return kErrorCodeOk;
+  }
+  if (UNLIKELY(buffer_used_ + header->log_length_ > buffer_.get_size())) {
+    LOG(WARNING) << "Logs of epoch " << epoch << " don't fit in the LogSubscriber buffer of "
+      << buffer_.get_size() << " bytes";
+    log_offsets_.clear();
+    buffer_used_ = 0;
+    return kErrorCodeLogSubscriberBufferTooSmall;
+  }
+  char* buffer = reinterpret_cast<char*>(buffer_.get_block());
+  std::memcpy(buffer + buffer_used_, header, header->log_length_);
+  log_offsets_.push_back(buffer_used_);
+  buffer_used_ += header->log_length_;
+  return kErrorCodeOk;
+}
+
+}  // namespace log
+}  // namespace foedus
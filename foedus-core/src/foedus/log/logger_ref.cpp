@@ -155,5 +155,25 @@ LogRange LoggerRef::get_log_range(Epoch prev_epoch, Epoch until_epoch) {
   return result;
 }
 
+Epoch LoggerRef::get_next_marked_epoch(Epoch prev_epoch) const {
+  soc::SharedMutexScope scope(&control_block_->epoch_history_mutex_);
+  const uint32_t head = control_block_->epoch_history_head_;
+  const uint32_t count = control_block_->epoch_history_count_;
+  for (uint32_t pos = 0; pos < count; ++pos) {
+    uint32_t abs_pos = control_block_->wrap_epoch_history_index(head + pos);
+    const EpochHistory& cur = control_block_->epoch_histories_[abs_pos];
+    if (!prev_epoch.is_valid() || cur.new_epoch_ > prev_epoch) {
+      return cur.new_epoch_;
+    }
+  }
+  return INVALID_EPOCH;
+}
+
+EpochHistory LoggerRef::get_oldest_epoch_history() const {
+  soc::SharedMutexScope scope(&control_block_->epoch_history_mutex_);
+  ASSERT_ND(control_block_->epoch_history_count_ > 0);  // we write a dummy marker at start
+  return control_block_->epoch_histories_[control_block_->epoch_history_head_];
+}
+
 }  // namespace log
 }  // namespace foedus
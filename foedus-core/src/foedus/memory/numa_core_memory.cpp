@@ -52,6 +52,7 @@ NumaCoreMemory::NumaCoreMemory(
     current_lock_list_capacity_(0),
     retrospective_lock_list_memory_(nullptr),
     retrospective_lock_list_capacity_(0),
+    learned_lock_list_memory_(nullptr),
     volatile_pool_(nullptr),
     snapshot_pool_(nullptr) {
   ASSERT_ND(numa_node_ == node_memory->get_numa_node());
@@ -82,6 +83,9 @@ uint64_t NumaCoreMemory::calculate_local_small_memory_size(const EngineOptions&
   const uint64_t total_access_sets = xct_opt.max_read_set_size_ + xct_opt.max_write_set_size_;
   memory_size += sizeof(xct::LockEntry) * total_access_sets;
   memory_size += sizeof(xct::LockEntry) * total_access_sets;
+  memory_size += xct::LearnedLockListCache::calculate_memory_size(
+    xct_opt.learned_lock_list_profiles_,
+    xct_opt.learned_lock_list_entries_);
   return memory_size;
 }
 
@@ -134,6 +138,10 @@ ErrorStack NumaCoreMemory::initialize_once() {
   retrospective_lock_list_memory_ = reinterpret_cast<xct::LockEntry*>(memory);
   retrospective_lock_list_capacity_ = total_access_sets;
   memory += sizeof(xct::LockEntry) * total_access_sets;
+  learned_lock_list_memory_ = memory;
+  memory += xct::LearnedLockListCache::calculate_memory_size(
+    xct_opt.learned_lock_list_profiles_,
+    xct_opt.learned_lock_list_entries_);
 
   memory += static_cast<uint64_t>(thread_per_group - core_local_ordinal_) << 12;
   ASSERT_ND(reinterpret_cast<char*>(small_thread_local_memory_.get_block())
@@ -33,6 +33,7 @@
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/storage_log_types.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/sequential/sequential_log_types.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -169,6 +170,17 @@ ErrorStack RestartManagerPimpl::redo_meta_logs(Epoch durable_epoch, Epoch snapsh
           entry->header_.storage_id_);
         ++processed;
         break;
+      case log::kLogCodeSequentialTruncate:
+        reinterpret_cast<storage::sequential::SequentialTruncateLogType*>(entry)->apply_storage(
+          engine_,
+          entry->header_.storage_id_);
+        ++processed;
+        break;
+      case log::kLogCodeSequentialConsumerGroup:
+        reinterpret_cast<storage::sequential::SequentialConsumerGroupLogType*>(
+          entry)->apply_storage(engine_, entry->header_.storage_id_);
+        ++processed;
+        break;
       default:
         LOG(ERROR) << "Unexpected log type in metadata log:" << entry->header_;
     }
@@ -43,7 +43,9 @@
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/composer.hpp"
 #include "foedus/storage/partitioner.hpp"
+#include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 #include "foedus/thread/stoppable_thread_impl.hpp"
 
 namespace foedus {
@@ -275,7 +277,11 @@ ErrorStack LogGleaner::construct_root_pages() {
       input_count,
       gleaner_resource_,
       &new_root_page_pointer};
+    storage::SnapshotPagePointer next_page_id_before = snapshot_writer.get_next_page_id();
     CHECK_ERROR(composer.construct_root(args));
+    engine_->get_storage_manager()->get_storage(min_storage_id)->stats_.on_snapshot_pages(
+      new_snapshot_.id_,
+      snapshot_writer.get_next_page_id() - next_page_id_before);
     ASSERT_ND(new_root_page_pointer > 0);
     ASSERT_ND(new_root_page_pointers_.find(min_storage_id) == new_root_page_pointers_.end());
     new_root_page_pointers_.insert(std::pair<storage::StorageId, storage::SnapshotPagePointer>(
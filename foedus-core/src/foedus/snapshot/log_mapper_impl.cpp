@@ -41,6 +41,7 @@
 #include "foedus/snapshot/snapshot.hpp"
 #include "foedus/storage/partitioner.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 #include "foedus/storage/hash/hash_log_types.hpp"
 #include "foedus/storage/masstree/masstree_log_types.hpp"
 
@@ -462,12 +463,17 @@ void LogMapper::flush_bucket(const BucketHashList& hashlist) {
   }
 
   uint64_t log_count = 0;  // just for reporting
+  int64_t record_count_delta = 0;  // for StorageStatistics
   debugging::StopWatch stop_watch;
   for (Bucket* bucket = hashlist.head_; bucket != nullptr; bucket = bucket->next_bucket_) {
     ASSERT_ND(bucket->counts_ > 0);
     ASSERT_ND(bucket->counts_ <= kBucketMaxCount);
     ASSERT_ND(bucket->storage_id_ == hashlist.storage_id_);
     log_count += bucket->counts_;
+    for (uint32_t i = 0; i < bucket->counts_; ++i) {
+      const log::LogHeader& header = log_buffer.resolve(bucket->log_positions_[i])->header_;
+      record_count_delta += storage::to_record_count_delta(header.get_type());
+    }
 
     // if there are multiple partitions, we first partition log entries.
     if (multi_partitions) {
@@ -532,6 +538,11 @@ void LogMapper::flush_bucket(const BucketHashList& hashlist) {
     }
   }
 
+  if (record_count_delta != 0) {
+    engine_->get_storage_manager()->get_storage(hashlist.storage_id_)->stats_.on_gleaned_records(
+      record_count_delta);
+  }
+
   stop_watch.stop();
   LOG(INFO) << to_string() << " sent out " << log_count << " log entries for storage-"
     << hashlist.storage_id_ << " in " << stop_watch.elapsed_ms() << " milliseconds";
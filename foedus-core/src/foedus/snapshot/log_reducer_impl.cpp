@@ -45,6 +45,9 @@
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/composer.hpp"
 #include "foedus/storage/partitioner.hpp"
+#include "foedus/storage/storage.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 
 namespace foedus {
 namespace snapshot {
@@ -640,7 +643,11 @@ ErrorStack LogReducer::merge_sort() {
       &composer_work_memory,
       parent_.get_base_epoch(),
       root_info_page};
+    storage::SnapshotPagePointer next_page_id_before = snapshot_writer.get_next_page_id();
     CHECK_ERROR(composer.compose(args));
+    engine_->get_storage_manager()->get_storage(storage_id)->stats_.on_snapshot_pages(
+      parent_.get_snapshot_id(),
+      snapshot_writer.get_next_page_id() - next_page_id_before);
 
     // move on to next blocks
     for (auto& ptr : context.sorted_buffers_) {
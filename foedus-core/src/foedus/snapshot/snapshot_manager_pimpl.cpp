@@ -49,6 +49,7 @@
 #include "foedus/storage/metadata.hpp"
 #include "foedus/storage/partitioner.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 #include "foedus/thread/numa_thread_scope.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
@@ -354,6 +355,12 @@ ErrorStack SnapshotManagerPimpl::handle_snapshot_triggered(Snapshot *new_snapsho
   // this holds the pointer to new root page.
   std::map<storage::StorageId, storage::SnapshotPagePointer> new_root_page_pointers;
 
+  // Mappers count inserted/deleted records of each storage while they glean.
+  storage::StorageManager* storage_manager = engine_->get_storage_manager();
+  for (storage::StorageId id = 1; id <= new_snapshot->max_storage_id_; ++id) {
+    storage_manager->get_storage(id)->stats_.on_snapshot_begin();
+  }
+
   // Log gleaners design partitioning and do scatter-gather to consume the logs.
   // This will create snapshot files at each partition and tell us the new root pages of
   // each storage.
@@ -364,20 +371,23 @@ ErrorStack SnapshotManagerPimpl::handle_snapshot_triggered(Snapshot *new_snapsho
 
   // Invokes savepoint module to make sure this snapshot has "happened".
   CHECK_ERROR(snapshot_savepoint(*new_snapshot));
-
-  // install pointers to snapshot pages and drop volatile pages.
-  CHECK_ERROR(drop_volatile_pages(*new_snapshot, new_root_page_pointers));
+  for (storage::StorageId id = 1; id <= new_snapshot->max_storage_id_; ++id) {
+    storage_manager->get_storage(id)->stats_.on_snapshot_end();
+  }
 
   Epoch new_snapshot_epoch = new_snapshot->valid_until_epoch_;
   ASSERT_ND(new_snapshot_epoch.is_valid() &&
     (!get_snapshot_epoch().is_valid() || new_snapshot_epoch > get_snapshot_epoch()));
+  // The snapshot has "happened". drop_volatile_pages() publishes the new snapshot epoch
+  // before resuming transactions, so the ID must be ready by then.
+  control_block_->previous_snapshot_id_ = snapshot_id;
+
+  // install pointers to snapshot pages and drop volatile pages.
+  CHECK_ERROR(drop_volatile_pages(*new_snapshot, new_root_page_pointers));
+  ASSERT_ND(get_snapshot_epoch() == new_snapshot_epoch);
 
   // done. notify waiters if exist
-  Epoch::EpochInteger epoch_after = new_snapshot_epoch.value();
-  control_block_->previous_snapshot_id_ = snapshot_id;
   previous_snapshot_time_ = std::chrono::system_clock::now();
-
-  control_block_->snapshot_epoch_ = epoch_after;
   assorted::memory_fence_release();
   control_block_->snapshot_taken_.signal();
   return kRetOk;
@@ -580,7 +590,12 @@ ErrorStack SnapshotManagerPimpl::drop_volatile_pages(
     LOG(INFO) << "As a result, we dropped " << dropped_count << " pages from storage-" << id;
   }
 
-
+  // Publish the new snapshot epoch BEFORE resuming transactions. Threads cache pointers to
+  // volatile pages (eg masstree::MasstreeDescentPath) tagged with the snapshot epoch as of
+  // caching. Transactions that start after the resume must see the new value so that they
+  // never follow a cached pointer to a page we have just dropped.
+  control_block_->snapshot_epoch_ = new_snapshot.valid_until_epoch_.value();
+  assorted::memory_fence_release();
   engine_->get_xct_manager()->resume_accepting_xct();
 
   stop_watch.stop();
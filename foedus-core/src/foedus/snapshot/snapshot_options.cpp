@@ -35,6 +35,9 @@ SnapshotOptions::SnapshotOptions() {
   log_reducer_read_io_buffer_kb_ = kDefaultLogReducerReadIoBufferKb;
   snapshot_writer_page_pool_size_mb_ = kDefaultSnapshotWriterPagePoolSizeMb;
   snapshot_writer_intermediate_pool_size_mb_ = kDefaultSnapshotWriterIntermediatePoolSizeMb;
+  composer_parallel_threads_ = kDefaultComposerParallelThreads;
+  snapshot_writer_async_buffers_ = kDefaultSnapshotWriterAsyncBuffers;
+  snapshot_writer_async_buffer_mb_ = kDefaultSnapshotWriterAsyncBufferMb;
 }
 
 std::string SnapshotOptions::convert_folder_path_pattern(int node) const {
@@ -62,6 +65,9 @@ ErrorStack SnapshotOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, log_reducer_read_io_buffer_kb_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_writer_page_pool_size_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, snapshot_writer_intermediate_pool_size_mb_);
+  EXTERNALIZE_LOAD_ELEMENT(element, composer_parallel_threads_);
+  EXTERNALIZE_LOAD_ELEMENT(element, snapshot_writer_async_buffers_);
+  EXTERNALIZE_LOAD_ELEMENT(element, snapshot_writer_async_buffer_mb_);
   CHECK_ERROR(get_child_element(element, "SnapshotDeviceEmulationOptions", &emulation_))
   return kRetOk;
 }
@@ -101,6 +107,15 @@ ErrorStack SnapshotOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ELEMENT(element, snapshot_writer_intermediate_pool_size_mb_,
     "The size in MB of additional page pool for one snapshot writer just for holding"
     " intermediate pages.");
+  EXTERNALIZE_SAVE_ELEMENT(element, composer_parallel_threads_,
+    "Number of threads each reducer uses to install snapshot pointers of a masstree storage"
+    " to its volatile pages. Other steps of composition are not parallelized within a reducer."
+    " 1 means no parallelization.");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_writer_async_buffers_,
+    "Number of staging buffers each snapshot writer keeps for asynchronous writes."
+    " 0 means the snapshot writer synchronously writes from its page pool.");
+  EXTERNALIZE_SAVE_ELEMENT(element, snapshot_writer_async_buffer_mb_,
+    "The size in MB of each staging buffer for asynchronous writes in snapshot writer.");
   CHECK_ERROR(add_child_element(element, "SnapshotDeviceEmulationOptions",
           "[Experiments-only] Settings to emulate slower data device", emulation_));
   return kRetOk;
@@ -20,7 +20,11 @@
 #include <stdint.h>
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
 #include <string>
+#include <utility>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
@@ -30,6 +34,7 @@
 #include "foedus/snapshot/log_gleaner_impl.hpp"
 #include "foedus/snapshot/log_reducer_impl.hpp"
 #include "foedus/snapshot/snapshot.hpp"
+#include "foedus/storage/page.hpp"
 
 namespace foedus {
 namespace snapshot {
@@ -47,12 +52,30 @@ SnapshotWriter::SnapshotWriter(
   pool_memory_(pool_memory),
   intermediate_memory_(intermediate_memory),
   snapshot_file_(nullptr),
-  next_page_id_(0) {
+  next_page_id_(0),
+  async_buffer_count_(engine->get_options().snapshot_.snapshot_writer_async_buffers_),
+  async_buffer_size_(
+    static_cast<uint64_t>(engine->get_options().snapshot_.snapshot_writer_async_buffer_mb_) << 20),
+  async_current_(async_buffer_count_),
+  async_current_bytes_(0),
+  async_writing_(false),
+  async_stop_requested_(false),
+  async_error_(kErrorCodeOk) {
+  ASSERT_ND(async_buffer_size_ % sizeof(storage::Page) == 0);
 }
 
 bool SnapshotWriter::close() {
   if (snapshot_file_) {
     bool success = true;
+    if (async_thread_.joinable()) {
+      ErrorCode flush_error = flush_async_writes();
+      if (flush_error != kErrorCodeOk) {
+        LOG(ERROR) << "Asynchronous writes to a snapshot file failed: " << *this
+          << ", error=" << get_error_message(flush_error);
+        success = false;
+      }
+      stop_async_writes();
+    }
     fs::Path path = snapshot_file_->get_path();
     bool closed = snapshot_file_->close();
     if (!closed) {
@@ -92,7 +115,6 @@ ErrorStack SnapshotWriter::open() {
     storage::PageHeader* first_page_header = reinterpret_cast<storage::PageHeader*>(first_page);
     first_page_header->page_id_ = storage::to_snapshot_page_pointer(snapshot_id_, numa_node_, 0);
     first_page_header->storage_id_ = 0x1BF0ED05;  // something unusual
-    first_page_header->checksum_ = 0x1BF0ED05;  // something unusual
     std::memset(
       first_page + sizeof(storage::PageHeader),
       0,
@@ -101,6 +123,8 @@ ErrorStack SnapshotWriter::open() {
       " The first page is never used as data. It just has the common page header"
       " and these useless sentences. Maybe we put our complaints on our cafeteria here.");
     std::memcpy(first_page + sizeof(storage::PageHeader), duh.data(), duh.size());
+    first_page_header->checksum_ = storage::compute_page_checksum(
+      reinterpret_cast<storage::Page*>(first_page));
 
     WRAP_ERROR_CODE(snapshot_file_->write(sizeof(storage::Page), *pool_memory_));
     next_page_id_ = storage::to_snapshot_page_pointer(snapshot_id_, numa_node_, 1);
@@ -113,9 +137,94 @@ ErrorStack SnapshotWriter::open() {
     uint64_t next_offset = file_size / sizeof(storage::Page);
     next_page_id_ = storage::to_snapshot_page_pointer(snapshot_id_, numa_node_, next_offset);
   }
+  if (async_buffer_count_ > 0 && async_buffer_size_ > 0) {
+    start_async_writes();
+  }
   return kRetOk;
 }
 
+void SnapshotWriter::start_async_writes() {
+  ASSERT_ND(!async_thread_.joinable());
+  if (async_buffers_.is_null()) {
+    async_buffers_.alloc_onnode(
+      async_buffer_size_ * async_buffer_count_,
+      memory::kHugepageSize,
+      numa_node_);
+  }
+  async_queue_.clear();
+  async_free_buffers_.clear();
+  for (uint16_t i = 0; i < async_buffer_count_; ++i) {
+    async_free_buffers_.push_back(i);
+  }
+  async_current_ = async_buffer_count_;
+  async_current_bytes_ = 0;
+  async_writing_ = false;
+  async_stop_requested_ = false;
+  async_error_ = kErrorCodeOk;
+  async_thread_ = std::move(std::thread(&SnapshotWriter::handle_async_writes, this));
+}
+
+void SnapshotWriter::stop_async_writes() {
+  ASSERT_ND(async_thread_.joinable());
+  {
+    std::lock_guard<std::mutex> guard(async_mutex_);
+    async_stop_requested_ = true;
+  }
+  async_cond_.notify_all();
+  async_thread_.join();
+}
+
+void SnapshotWriter::handle_async_writes() {
+  std::unique_lock<std::mutex> lock(async_mutex_);
+  while (true) {
+    async_cond_.wait(lock, [this]{ return async_stop_requested_ || !async_queue_.empty(); });
+    if (async_queue_.empty()) {
+      ASSERT_ND(async_stop_requested_);
+      break;
+    }
+    std::pair<uint16_t, uint64_t> write = async_queue_.front();
+    async_queue_.pop_front();
+    async_writing_ = true;
+    ErrorCode error = async_error_;
+    lock.unlock();
+    if (error == kErrorCodeOk) {
+      // once failed, skip all following writes. the file is broken anyways.
+      uint64_t offset = async_buffer_size_ * write.first;
+      error = snapshot_file_->write(
+        write.second,
+        memory::AlignedMemorySlice(&async_buffers_, offset, write.second));
+    }
+    lock.lock();
+    if (error != kErrorCodeOk && async_error_ == kErrorCodeOk) {
+      async_error_ = error;
+    }
+    async_writing_ = false;
+    async_free_buffers_.push_back(write.first);
+    async_cond_.notify_all();
+  }
+}
+
+void SnapshotWriter::submit_current_buffer() {
+  ASSERT_ND(async_current_ < async_buffer_count_);
+  ASSERT_ND(async_current_bytes_ > 0);
+  async_queue_.emplace_back(async_current_, async_current_bytes_);
+  async_current_ = async_buffer_count_;
+  async_current_bytes_ = 0;
+  async_cond_.notify_all();
+}
+
+ErrorCode SnapshotWriter::flush_async_writes() {
+  if (!async_thread_.joinable()) {
+    return kErrorCodeOk;
+  }
+  std::unique_lock<std::mutex> lock(async_mutex_);
+  if (async_current_bytes_ > 0) {
+    submit_current_buffer();
+  }
+  async_cond_.wait(lock, [this]{ return async_queue_.empty() && !async_writing_; });
+  return async_error_;
+}
+
 ErrorCode SnapshotWriter::dump_general(
   memory::AlignedMemory* buffer,
   memory::PagePoolOffset from_page,
@@ -137,14 +246,49 @@ ErrorCode SnapshotWriter::dump_general(
     ASSERT_ND(snapshot_id == snapshot_id_);
   }
 #endif  // NDEBUG
-  CHECK_ERROR_CODE(snapshot_file_->write(
-    sizeof(storage::Page) * count,
-    memory::AlignedMemorySlice(
-      buffer,
-      sizeof(storage::Page) * from_page,
-      sizeof(storage::Page) * count)));
+  // Pages are final at this point. Stamp their checksums right before writing them out.
+  storage::Page* pages = reinterpret_cast<storage::Page*>(buffer->get_block()) + from_page;
+  for (memory::PagePoolOffset i = 0; i < count; ++i) {
+    pages[i].get_header().checksum_ = storage::compute_page_checksum(pages + i);
+  }
+  if (!async_thread_.joinable()) {
+    CHECK_ERROR_CODE(snapshot_file_->write(
+      sizeof(storage::Page) * count,
+      memory::AlignedMemorySlice(
+        buffer,
+        sizeof(storage::Page) * from_page,
+        sizeof(storage::Page) * count)));
+    next_page_id_ += count;
+    return kErrorCodeOk;
+  }
+
+  // Copy the pages to staging buffers so that the caller can reuse the page pool right away.
+  const char* source = reinterpret_cast<const char*>(pages);
+  uint64_t remaining = sizeof(storage::Page) * count;
+  while (remaining > 0) {
+    if (async_current_ == async_buffer_count_) {
+      std::unique_lock<std::mutex> lock(async_mutex_);
+      async_cond_.wait(lock, [this]{ return !async_free_buffers_.empty(); });
+      async_current_ = async_free_buffers_.back();
+      async_free_buffers_.pop_back();
+      async_current_bytes_ = 0;
+    }
+    uint64_t copy_bytes = std::min<uint64_t>(remaining, async_buffer_size_ - async_current_bytes_);
+    char* staging = reinterpret_cast<char*>(async_buffers_.get_block())
+      + async_buffer_size_ * async_current_ + async_current_bytes_;
+    // No lock needed. The I/O thread never touches the buffer we are filling.
+    std::memcpy(staging, source, copy_bytes);
+    source += copy_bytes;
+    remaining -= copy_bytes;
+    async_current_bytes_ += copy_bytes;
+    if (async_current_bytes_ == async_buffer_size_) {
+      std::lock_guard<std::mutex> guard(async_mutex_);
+      submit_current_buffer();
+    }
+  }
   next_page_id_ += count;
-  return kErrorCodeOk;
+  std::lock_guard<std::mutex> guard(async_mutex_);
+  return async_error_;
 }
 
 ErrorCode SnapshotWriter::expand_pool_memory(uint32_t required_pages, bool retain_content) {
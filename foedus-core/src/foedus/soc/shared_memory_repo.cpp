@@ -30,6 +30,7 @@
 #include "foedus/assorted/assorted_func.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/partitioner.hpp"
+#include "foedus/xct/previous_version_table.hpp"
 
 namespace foedus {
 namespace soc {
@@ -423,6 +424,27 @@ void SharedMemoryRepo::set_node_memory_anchors(
   total += NodeMemoryAnchors::kLogReducerMemorySize;
   put_node_memory_boundary(node, &total, "node_log_reducer_memory_boundary", reset_boundaries);
 
+  anchor.mcs_reader_indicator_memory_ = reinterpret_cast<uint32_t*>(base + total);
+  total += NodeMemoryAnchors::kMcsReaderIndicatorMemorySize;
+  put_node_memory_boundary(
+    node,
+    &total,
+    "node_mcs_reader_indicator_memory_boundary",
+    reset_boundaries);
+
+  if (options.xct_.previous_version_entries_per_node_ > 0) {
+    anchor.previous_version_memory_ = reinterpret_cast<xct::PreviousVersion*>(base + total);
+  } else {
+    anchor.previous_version_memory_ = nullptr;
+  }
+  total += xct::PreviousVersionTable::calculate_memory_size(
+    options.xct_.previous_version_entries_per_node_);
+  put_node_memory_boundary(
+    node,
+    &total,
+    "node_previous_version_memory_boundary",
+    reset_boundaries);
+
   anchor.log_reducer_root_info_pages_ = reinterpret_cast<storage::Page*>(base + total);
   total += options.storage_.max_storages_ * 4096ULL;
   put_node_memory_boundary(
@@ -511,6 +533,9 @@ uint64_t SharedMemoryRepo::calculate_node_memory_size(const EngineOptions& optio
   total += align_4kb(sizeof(proc::ProcAndName) * options.proc_.max_proc_count_) + kBoundarySize;
   total += align_4kb(sizeof(proc::LocalProcId) * options.proc_.max_proc_count_) + kBoundarySize;
   total += NodeMemoryAnchors::kLogReducerMemorySize + kBoundarySize;
+  total += NodeMemoryAnchors::kMcsReaderIndicatorMemorySize + kBoundarySize;
+  total += xct::PreviousVersionTable::calculate_memory_size(
+    options.xct_.previous_version_entries_per_node_) + kBoundarySize;
   total += options.storage_.max_storages_ * 4096ULL + kBoundarySize;
 
   uint64_t loggers_per_node = options.log_.loggers_per_node_;
@@ -1102,6 +1102,8 @@ inline Composer::DropResult ArrayComposer::drop_volatiles_leaf(
   uint16_t records = range.end_ - range.begin_;
   for (uint16_t i = 0; i < records; ++i) {
     Record* record = volatile_page->get_leaf_record(i, payload_size);
+    // Split increments don't move the TID, but they commit only in the TID's epoch.
+    // See ArrayStorage::increment_record_split().
     Epoch epoch = record->owner_id_.xct_id_.get_epoch();
     ASSERT_ND(epoch.is_valid());
     result.on_rec_observed(epoch);
@@ -44,6 +44,7 @@
 #include "foedus/storage/array/array_page_impl.hpp"
 #include "foedus/storage/array/array_storage.hpp"
 #include "foedus/thread/thread.hpp"
+#include "foedus/xct/previous_version_table.hpp"
 #include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 #include "foedus/xct/xct_optimistic_read_impl.hpp"
@@ -163,6 +164,19 @@ ErrorCode ArrayStorage::increment_record_oneshot(
     payload_offset);
 }
 
+template <typename T>
+ErrorCode ArrayStorage::increment_record_split(
+  thread::Thread* context,
+  ArrayOffset offset,
+  T value,
+  uint16_t payload_offset) {
+  return ArrayStoragePimpl(this).increment_record_split<T>(
+    context,
+    offset,
+    value,
+    payload_offset);
+}
+
 /**
  * Calculate leaf/interior pages we need.
  * @return index=level.
@@ -379,6 +393,10 @@ inline ErrorCode ArrayStoragePimpl::get_record(
   Record *record = nullptr;
   bool snapshot_record;
   CHECK_ERROR_CODE(locate_record_for_read(context, offset, &record, &snapshot_record));
+  if (!snapshot_record
+    && context->get_current_xct().get_isolation_level() == xct::kEpochConsistent) {
+    return read_record_epoch_consistent(context, record, payload, payload_offset, payload_count);
+  }
   CHECK_ERROR_CODE(context->get_current_xct().on_record_read(false, &record->owner_id_));
   std::memcpy(payload, record->payload_ + payload_offset, payload_count);
   return kErrorCodeOk;
@@ -394,12 +412,61 @@ ErrorCode ArrayStoragePimpl::get_record_primitive(
   Record *record = nullptr;
   bool snapshot_record;
   CHECK_ERROR_CODE(locate_record_for_read(context, offset, &record, &snapshot_record));
+  if (!snapshot_record
+    && context->get_current_xct().get_isolation_level() == xct::kEpochConsistent) {
+    return read_record_epoch_consistent(context, record, payload, payload_offset, sizeof(T));
+  }
   CHECK_ERROR_CODE(context->get_current_xct().on_record_read(false, &record->owner_id_));
   char* ptr = record->payload_ + payload_offset;
   *payload = *reinterpret_cast<const T*>(ptr);
   return kErrorCodeOk;
 }
 
+ErrorCode ArrayStoragePimpl::read_record_epoch_consistent(
+  thread::Thread* context,
+  Record* record,
+  void* payload,
+  uint16_t payload_offset,
+  uint16_t payload_count) {
+  const xct::Xct& current_xct = context->get_current_xct();
+  ASSERT_ND(current_xct.get_isolation_level() == xct::kEpochConsistent);
+  while (true) {
+    xct::XctId observed = record->owner_id_.xct_id_.spin_while_being_written();
+    if (!current_xct.is_epoch_consistent(observed)) {
+      break;
+    }
+    assorted::memory_fence_acquire();
+    std::memcpy(payload, record->payload_ + payload_offset, payload_count);
+    if (current_xct.on_record_read_done(&record->owner_id_, observed) == kErrorCodeOk) {
+      return kErrorCodeOk;
+    }
+    // someone has just overwritten it. the image as of the epoch is now in the table.
+  }
+
+  // The record was overwritten after the consistent epoch. The writer has saved the image
+  // before the write in the table of the node of the page, if enabled.
+  const Page* page = to_page(record);
+  xct::PreviousVersionTable* table
+    = context->get_previous_version_table(page->get_volatile_page_id().get_numa_node());
+  if (table->is_enabled()) {
+    xct::UniversalLockId lock_id = xct::xct_id_to_universal_lock_id(
+      context->get_global_volatile_page_resolver(),
+      &record->owner_id_);
+    xct::XctId old_id;
+    if (table->load(
+      lock_id,
+      current_xct.get_consistent_epoch(),
+      payload_offset,
+      payload_count,
+      payload,
+      &old_id)) {
+      return kErrorCodeOk;
+    }
+  }
+  DVLOG(1) << "Missed the previous version of an array record. It was overwritten or too long";
+  return kErrorCodeXctRaceAbort;
+}
+
 inline ErrorCode ArrayStoragePimpl::get_record_payload(
   thread::Thread* context,
   ArrayOffset offset,
@@ -532,6 +599,37 @@ ErrorCode ArrayStoragePimpl::increment_record_oneshot(
     log_entry);
 }
 
+template <typename T>
+ErrorCode ArrayStoragePimpl::increment_record_split(
+  thread::Thread* context,
+  ArrayOffset offset,
+  T value,
+  uint16_t payload_offset) {
+  ASSERT_ND(payload_offset + sizeof(T) <= get_payload_size());
+  ASSERT_ND(payload_offset % sizeof(T) == 0);
+  Record *record = nullptr;
+  CHECK_ERROR_CODE(locate_record_for_write(context, offset, &record));
+  Epoch current_epoch = context->get_engine()->get_xct_manager()->get_current_global_epoch_weak();
+  if (record->owner_id_.xct_id_.get_epoch() != current_epoch) {
+    // The first increment in this epoch must move the TID for snapshots and
+    // epoch-consistent reads. Take the usual locked path.
+    return increment_record_oneshot<T>(context, offset, value, payload_offset);
+  }
+  // Same log as oneshot, but in the lock-free write set. We neither lock the record nor
+  // change its TID. The log is atomically applied at commit, and the snapshot composer
+  // sums it up just like other increment logs.
+  ValueType type = to_value_type<T>();
+  uint16_t log_length = ArrayIncrementLogType::calculate_log_length(type);
+  ArrayIncrementLogType* log_entry = reinterpret_cast<ArrayIncrementLogType*>(
+    context->get_thread_log_buffer().reserve_new_log(log_length));
+  log_entry->populate<T>(get_id(), offset, value, payload_offset);
+  return context->get_current_xct().add_to_lock_free_write_set(
+    get_id(),
+    log_entry,
+    record->payload_,
+    &record->owner_id_);
+}
+
 inline ErrorCode ArrayStoragePimpl::lookup_for_read(
   thread::Thread* context,
   ArrayOffset offset,
@@ -682,6 +780,17 @@ inline ErrorCode ArrayStoragePimpl::get_record_primitive_batch(
   const ArrayOffset* offset_batch,
   T* payload_batch) {
   ASSERT_ND(batch_size <= kBatchMax);
+  if (UNLIKELY(context->get_current_xct().get_isolation_level() == xct::kEpochConsistent)) {
+    // Each record might need its previous version. No point to batch.
+    for (uint8_t i = 0; i < batch_size; ++i) {
+      CHECK_ERROR_CODE(get_record_primitive<T>(
+        context,
+        offset_batch[i],
+        payload_batch + i,
+        payload_offset));
+    }
+    return kErrorCodeOk;
+  }
   Record* record_batch[kBatchMax];
   bool snapshot_record_batch[kBatchMax];
   CHECK_ERROR_CODE(locate_record_for_read_batch(
@@ -1174,6 +1283,14 @@ INSTANTIATE_ALL_NUMERIC_TYPES(EX_INC1S);
 #define EX_INC1S_IMPL(x) template ErrorCode ArrayStoragePimpl::increment_record_oneshot< x > \
   (thread::Thread* context, ArrayOffset offset, x value, uint16_t payload_offset)
 INSTANTIATE_ALL_NUMERIC_TYPES(EX_INC1S_IMPL);
+
+#define EX_INCSPLIT(x) template ErrorCode ArrayStorage::increment_record_split< x > \
+  (thread::Thread* context, ArrayOffset offset, x value, uint16_t payload_offset)
+INSTANTIATE_ALL_NUMERIC_TYPES(EX_INCSPLIT);
+
+#define EX_INCSPLIT_IMPL(x) template ErrorCode ArrayStoragePimpl::increment_record_split< x > \
+  (thread::Thread* context, ArrayOffset offset, x value, uint16_t payload_offset)
+INSTANTIATE_ALL_NUMERIC_TYPES(EX_INCSPLIT_IMPL);
 // @endcond
 
 }  // namespace array
@@ -275,6 +275,11 @@ ErrorStack HashStorage::hcc_reset_all_temperature_stat() {
   return pimpl.hcc_reset_all_temperature_stat();
 }
 
+ErrorStack HashStorage::estimate_bin_histogram(uint32_t sample_bins, BinHistogram* out) {
+  HashStoragePimpl pimpl(this);
+  return pimpl.estimate_bin_histogram(sample_bins, out);
+}
+
 
 ErrorStack HashStorage::debugout_single_thread(
   Engine* engine,
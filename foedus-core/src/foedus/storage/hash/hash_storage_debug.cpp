@@ -19,10 +19,14 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include "foedus/engine.hpp"
 #include "foedus/cache/snapshot_file_set.hpp"
 #include "foedus/memory/aligned_memory.hpp"
 #include "foedus/memory/engine_memory.hpp"
+#include "foedus/storage/hash/hash_hashinate.hpp"
 #include "foedus/storage/hash/hash_id.hpp"
 #include "foedus/storage/hash/hash_metadata.hpp"
 #include "foedus/storage/hash/hash_page_impl.hpp"
@@ -264,6 +268,61 @@ ErrorStack HashStoragePimpl::hcc_reset_all_temperature_stat_data(VolatilePagePoi
   return kRetOk;
 }
 
+ErrorStack HashStoragePimpl::estimate_bin_histogram(
+  uint32_t sample_bins,
+  HashStorage::BinHistogram* out) {
+  std::memset(out, 0, sizeof(HashStorage::BinHistogram));
+  const HashBin bin_count = get_bin_count();
+  if (sample_bins == 0) {
+    return kRetOk;
+  }
+  const HashBin stride = std::max<HashBin>(1U, bin_count / sample_bins);
+  for (HashBin bin = 0; bin < bin_count && out->sampled_bins_ < sample_bins; bin += stride) {
+    uint32_t records = count_volatile_bin_records(bin);
+    out->sampled_records_ += records;
+    ++out->bins_[std::min<uint32_t>(records, HashStorage::BinHistogram::kMaxRecordCount)];
+    ++out->sampled_bins_;
+  }
+  return kRetOk;
+}
+
+uint32_t HashStoragePimpl::count_volatile_bin_records(HashBin bin) {
+  // This is not protected from concurrent transactions at all, but volatile pages are never
+  // freed while the engine is running except by snapshots, and we only read page headers.
+  const auto& resolver = engine_->get_memory_manager()->get_global_volatile_page_resolver();
+  const IntermediateRoute route = IntermediateRoute::construct(bin);
+  VolatilePagePointer pointer = control_block_->root_page_pointer_.volatile_pointer_;
+  if (pointer.is_null()) {
+    return 0;
+  }
+  const HashIntermediatePage* page
+    = reinterpret_cast<const HashIntermediatePage*>(resolver.resolve_offset(pointer));
+  while (true) {
+    const uint8_t level = page->get_level();
+    pointer = page->get_pointer(route.route[level]).volatile_pointer_;
+    if (pointer.is_null()) {
+      return 0;
+    }
+    if (level == 0) {
+      break;
+    }
+    page = reinterpret_cast<const HashIntermediatePage*>(resolver.resolve_offset(pointer));
+  }
+
+  uint32_t records = 0;
+  for (const HashDataPage* cur
+        = reinterpret_cast<const HashDataPage*>(resolver.resolve_offset(pointer));
+      cur;) {
+    records += cur->get_record_count();
+    VolatilePagePointer next_id = cur->next_page().volatile_pointer_;
+    cur = nullptr;
+    if (!next_id.is_null()) {
+      cur = reinterpret_cast<const HashDataPage*>(resolver.resolve_offset(next_id));
+    }
+  }
+  return records;
+}
+
 }  // namespace hash
 }  // namespace storage
 }  // namespace foedus
@@ -36,11 +36,13 @@
 #include "foedus/memory/numa_core_memory.hpp"
 #include "foedus/memory/numa_node_memory.hpp"
 #include "foedus/memory/page_pool.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/storage_manager_pimpl.hpp"
 #include "foedus/storage/hash/hash_combo.hpp"
 #include "foedus/storage/hash/hash_hashinate.hpp"
+#include "foedus/storage/hash/hash_hint_impl.hpp"
 #include "foedus/storage/hash/hash_id.hpp"
 #include "foedus/storage/hash/hash_log_types.hpp"
 #include "foedus/storage/hash/hash_metadata.hpp"
@@ -204,7 +206,9 @@ ErrorCode HashStoragePimpl::get_record(
   *payload_capacity = payload_length;
   uint16_t key_offset = location.get_aligned_key_length();
   std::memcpy(payload, location.record_ + key_offset, payload_length);
-  return kErrorCodeOk;
+  return context->get_current_xct().on_record_read_done(
+    &location.page_->get_slot_address(location.index_)->tid_,
+    location.observed_);
 }
 
 ErrorCode HashStoragePimpl::get_record_part(
@@ -244,7 +248,9 @@ ErrorCode HashStoragePimpl::get_record_part(
 
   uint16_t key_offset = location.get_aligned_key_length();
   std::memcpy(payload, location.record_ + key_offset + payload_offset, payload_count);
-  return kErrorCodeOk;
+  return context->get_current_xct().on_record_read_done(
+    &location.page_->get_slot_address(location.index_)->tid_,
+    location.observed_);
 }
 
 uint16_t adjust_payload_hint(uint16_t payload_count, uint16_t physical_payload_hint) {
@@ -844,11 +850,33 @@ ErrorCode HashStoragePimpl::locate_bin(
   bool for_write,
   const HashCombo& combo,
   HashDataPage** bin_head) {
+  xct::Xct& current_xct = context->get_current_xct();
+  HashBinHints* hints = context->get_hash_bin_hints();
+  if (hints && UNLIKELY(current_xct.get_isolation_level() == xct::kSnapshot)) {
+    // The hints have only volatile pages. Snapshot transactions must not see them.
+    hints = nullptr;
+  }
+  Epoch current_epoch;
+  Epoch snapshot_epoch;
+  if (hints) {
+    current_epoch = engine_->get_xct_manager()->get_current_global_epoch_weak();
+    snapshot_epoch = engine_->get_snapshot_manager()->get_snapshot_epoch_weak();
+    HashDataPage* hinted = hints->get(get_id(), combo.bin_, current_epoch, snapshot_epoch);
+    // The epoch check in HashBinHints::get() guarantees the page is not yet dropped.
+    // Still, we check what the page claims to be. It is cheap compared to a miss.
+    if (hinted
+      && !hinted->header().snapshot_
+      && hinted->header().storage_id_ == get_id()
+      && hinted->get_bin() == combo.bin_) {
+      *bin_head = hinted;
+      return kErrorCodeOk;
+    }
+  }
+
   HashIntermediatePage* root;
   CHECK_ERROR_CODE(get_root_page(context, for_write, &root));
   ASSERT_ND(root);
   *bin_head = nullptr;
-  xct::Xct& current_xct = context->get_current_xct();
 
   HashIntermediatePage* parent = root;
   while (true) {
@@ -883,6 +911,9 @@ ErrorCode HashStoragePimpl::locate_bin(
 
   ASSERT_ND(*bin_head != nullptr || !for_write);
   ASSERT_ND(*bin_head == nullptr || (*bin_head)->get_bin() == combo.bin_);
+  if (hints && *bin_head && !(*bin_head)->header().snapshot_) {
+    hints->put(get_id(), combo.bin_, current_epoch, snapshot_epoch, *bin_head);
+  }
   return kErrorCodeOk;
 }
 
@@ -34,54 +34,128 @@ ErrorCode Adopt::run(xct::SysxctWorkspace* sysxct_workspace) {
   ASSERT_ND(!old_->header().snapshot_);
   ASSERT_ND(old_->is_moved());  // this is guaranteed because these flag are immutable once set.
 
-  // Lock pages in one shot.
-  Page* pages[2];
+  // Lock pages in one shot, including other children we adopt together.
+  MasstreePage* olds[kMaxBatchedAdoptions];
+  const uint16_t old_count = collect_batched_adoptions(olds);
+  ASSERT_ND(old_count >= 1U && olds[0] == old_);
+  Page* pages[kMaxBatchedAdoptions + 1U];
   pages[0] = reinterpret_cast<Page*>(parent_);
-  pages[1] = reinterpret_cast<Page*>(old_);
-  CHECK_ERROR_CODE(context_->sysxct_batch_page_locks(sysxct_workspace, 2, pages));
+  for (uint16_t i = 0; i < old_count; ++i) {
+    pages[i + 1U] = reinterpret_cast<Page*>(olds[i]);
+  }
+  CHECK_ERROR_CODE(context_->sysxct_batch_page_locks(sysxct_workspace, old_count + 1U, pages));
 
   // After the above lock, we check status of the pages
   if (parent_->is_moved()) {
     VLOG(0) << "Interesting. concurrent thread has already split this node?";
     return kErrorCodeOk;
-  } else if (old_->is_retired()) {
-    VLOG(0) << "Interesting. concurrent thread already adopted.";
-    return kErrorCodeOk;
   }
 
-  const KeySlice searching_slice = old_->get_low_fence();
+  // Adopt whatever we can without changing the parent page much. The rest are adopted
+  // by splitting the parent page at last, all of them in one split.
+  MasstreePage* split_olds[kMaxBatchedAdoptions];
+  uint16_t split_count = 0;
+  for (uint16_t i = 0; i < old_count; ++i) {
+    if (olds[i]->is_retired()) {
+      VLOG(0) << "Interesting. concurrent thread already adopted.";
+      continue;
+    }
+    ASSERT_ND(olds[i]->is_moved());
+    if (!adopt_in_place(olds[i])) {
+      split_olds[split_count] = olds[i];
+      ++split_count;
+    }
+  }
+
+  if (split_count > 0) {
+    CHECK_ERROR_CODE(adopt_by_split(split_olds, split_count));
+  }
+  return kErrorCodeOk;
+}
+
+uint16_t Adopt::collect_batched_adoptions(MasstreePage** olds) const {
+  olds[0] = old_;
+  uint16_t count = 1;
+  const uint8_t key_count = parent_->get_key_count();
+  for (uint8_t i = 0; i <= key_count && i <= kMaxIntermediateSeparators; ++i) {
+    const MasstreeIntermediatePage::MiniPage& minipage = parent_->get_minipage(i);
+    const uint8_t mini_count = minipage.key_count_;
+    for (uint8_t j = 0; j <= mini_count && j <= kMaxIntermediateMiniSeparators; ++j) {
+      VolatilePagePointer pointer = minipage.pointers_[j].volatile_pointer_;
+      if (pointer.is_null() || pointer == old_->get_volatile_page_id()) {
+        continue;
+      }
+      MasstreePage* child = context_->resolve_cast<MasstreePage>(pointer);
+      if (child->has_foster_child() && !child->is_retired() && !child->is_locked()) {
+        olds[count] = child;
+        ++count;
+        if (count == kMaxBatchedAdoptions) {
+          return count;
+        }
+      }
+    }
+  }
+  return count;
+}
+
+bool Adopt::adopt_in_place(MasstreePage* old) {
+  const KeySlice searching_slice = old->get_low_fence();
   const auto minipage_index = parent_->find_minipage(searching_slice);
   auto& minipage = parent_->get_minipage(minipage_index);
   const auto pointer_index = minipage.find_pointer(searching_slice);
   ASSERT_ND(minipage.key_count_ <= kMaxIntermediateMiniSeparators);
-  ASSERT_ND(old_->get_volatile_page_id() == minipage.pointers_[pointer_index].volatile_pointer_);
+  ASSERT_ND(old->get_volatile_page_id() == minipage.pointers_[pointer_index].volatile_pointer_);
 
   // Now, how do we accommodate the new pointer?
-  if (old_->get_foster_fence() == old_->get_low_fence()
-    || old_->get_foster_fence() == old_->get_high_fence()) {
+  bool adopted;
+  if (old->get_foster_fence() == old->get_low_fence()
+    || old->get_foster_fence() == old->get_high_fence()) {
     // Case A. One of the grandchildrens is empty-range
-    CHECK_ERROR_CODE(adopt_case_a(minipage_index, pointer_index));
+    adopt_case_a(old, minipage_index, pointer_index);
+    adopted = true;
   } else {
     // Case B. More complex, normal case
-    CHECK_ERROR_CODE(adopt_case_b(minipage_index, pointer_index));
+    adopted = adopt_case_b(old, minipage_index, pointer_index);
   }
 
   parent_->verify_separators();
+  return adopted;
+}
+
+ErrorCode Adopt::adopt_by_split(MasstreePage** olds, uint16_t count) {
+  ASSERT_ND(count >= 1U && count <= kMaxBatchedAdoptions);
+  // We initially had more complex code to do in-page rebalance and
+  // in-minipage "shifting", but got some bugs. Pulled out too many hairs.
+  // Let's keep it simple. If we really observe bottleneck here, we can reconsider.
+  // Splitting is way more robust because it changes nothing in this existing page.
+  // It just places new foster-twin pointers.
+
+  // Reuse SplitIntermediate. We are directly invoking the sysxct's internal logic
+  // rather than nesting sysxct.
+  memory::PagePoolOffset offsets[2];
+  thread::GrabFreeVolatilePagesScope free_pages_scope(context_, offsets);
+  CHECK_ERROR_CODE(free_pages_scope.grab(2));
+  SplitIntermediate split(context_, parent_, olds[0], olds + 1, count - 1U);
+  split.split_impl_no_error(&free_pages_scope);
+  for (uint16_t i = 0; i < count; ++i) {
+    ASSERT_ND(olds[i]->is_retired());  // the above internally retires old pages
+  }
   return kErrorCodeOk;
 }
 
-ErrorCode Adopt::adopt_case_a(
+void Adopt::adopt_case_a(
+  MasstreePage* old,
   uint16_t minipage_index,
   uint16_t pointer_index) {
   VLOG(0) << "Adopting from a child page that contains an empty-range page. This happens when"
     << " record compaction/expansion created a page without a record.";
 
-  MasstreePage* grandchild_minor = context_->resolve_cast<MasstreePage>(old_->get_foster_minor());
-  ASSERT_ND(grandchild_minor->get_low_fence() == old_->get_low_fence());
-  ASSERT_ND(grandchild_minor->get_high_fence() == old_->get_foster_fence());
-  MasstreePage* grandchild_major = context_->resolve_cast<MasstreePage>(old_->get_foster_major());
-  ASSERT_ND(grandchild_major->get_low_fence() == old_->get_foster_fence());
-  ASSERT_ND(grandchild_major->get_high_fence() == old_->get_high_fence());
+  MasstreePage* grandchild_minor = context_->resolve_cast<MasstreePage>(old->get_foster_minor());
+  ASSERT_ND(grandchild_minor->get_low_fence() == old->get_low_fence());
+  ASSERT_ND(grandchild_minor->get_high_fence() == old->get_foster_fence());
+  MasstreePage* grandchild_major = context_->resolve_cast<MasstreePage>(old->get_foster_major());
+  ASSERT_ND(grandchild_major->get_low_fence() == old->get_foster_fence());
+  ASSERT_ND(grandchild_major->get_high_fence() == old->get_high_fence());
   ASSERT_ND(!grandchild_minor->header().snapshot_);
   ASSERT_ND(!grandchild_major->header().snapshot_);
 
@@ -99,7 +173,7 @@ ErrorCode Adopt::adopt_case_a(
   }
 
   auto& minipage = parent_->get_minipage(minipage_index);
-  ASSERT_ND(old_->get_volatile_page_id() == minipage.pointers_[pointer_index].volatile_pointer_);
+  ASSERT_ND(old->get_volatile_page_id() == minipage.pointers_[pointer_index].volatile_pointer_);
   minipage.pointers_[pointer_index].snapshot_pointer_ = 0;
   minipage.pointers_[pointer_index].volatile_pointer_ = nonempty_grandchild->get_volatile_page_id();
 
@@ -110,20 +184,20 @@ ErrorCode Adopt::adopt_case_a(
   // It's a special retirement path.
   empty_grandchild->get_version_address()->status_.status_ |= PageVersionStatus::kRetiredBit;
   context_->collect_retired_volatile_page(empty_grandchild->get_volatile_page_id());
-  old_->set_retired();
-  context_->collect_retired_volatile_page(old_->get_volatile_page_id());
-  return kErrorCodeOk;
+  old->set_retired();
+  context_->collect_retired_volatile_page(old->get_volatile_page_id());
 }
 
-ErrorCode Adopt::adopt_case_b(
+bool Adopt::adopt_case_b(
+  MasstreePage* old,
   uint16_t minipage_index,
   uint16_t pointer_index) {
   const auto key_count = parent_->get_key_count();
-  const KeySlice new_separator = old_->get_foster_fence();
-  const VolatilePagePointer minor_pointer = old_->get_foster_minor();
-  const VolatilePagePointer major_pointer = old_->get_foster_major();
+  const KeySlice new_separator = old->get_foster_fence();
+  const VolatilePagePointer minor_pointer = old->get_foster_minor();
+  const VolatilePagePointer major_pointer = old->get_foster_major();
   auto& minipage = parent_->get_minipage(minipage_index);
-  ASSERT_ND(old_->get_volatile_page_id() == minipage.pointers_[pointer_index].volatile_pointer_);
+  ASSERT_ND(old->get_volatile_page_id() == minipage.pointers_[pointer_index].volatile_pointer_);
 
   // Can we simply append the new pointer either as a new minipage at the end of this page
   // or as a new separator at the end of a minipage? Then we don't need major change.
@@ -148,9 +222,9 @@ ErrorCode Adopt::adopt_case_b(
       ++minipage.key_count_;
       ASSERT_ND(minipage.key_count_ <= kMaxIntermediateMiniSeparators);
 
-      old_->set_retired();
-      context_->collect_retired_volatile_page(old_->get_volatile_page_id());
-      return kErrorCodeOk;
+      old->set_retired();
+      context_->collect_retired_volatile_page(old->get_volatile_page_id());
+      return true;
     } else if (key_count == minipage_index && key_count < kMaxIntermediateSeparators) {
       // The minipage is full.. and the minipage is the last one!
       // We can add it as a new minipage
@@ -185,30 +259,20 @@ ErrorCode Adopt::adopt_case_b(
       parent_->increment_key_count();
       ASSERT_ND(parent_->get_key_count() == minipage_index + 1);
 
-      old_->set_retired();
-      context_->collect_retired_volatile_page(old_->get_volatile_page_id());
-      return kErrorCodeOk;
+      old->set_retired();
+      context_->collect_retired_volatile_page(old->get_volatile_page_id());
+      return true;
     }
   }
 
-  // In all other cases, we split this page.
-  // We initially had more complex code to do in-page rebalance and
-  // in-minipage "shifting", but got some bugs. Pulled out too many hairs.
-  // Let's keep it simple. If we really observe bottleneck here, we can reconsider.
-  // Splitting is way more robust because it changes nothing in this existing page.
-  // It just places new foster-twin pointers.
-
-  // Reuse SplitIntermediate. We are directly invoking the sysxct's internal logic
-  // rather than nesting sysxct.
-  memory::PagePoolOffset offsets[2];
-  thread::GrabFreeVolatilePagesScope free_pages_scope(context_, offsets);
-  CHECK_ERROR_CODE(free_pages_scope.grab(2));
-  SplitIntermediate split(context_, parent_, old_);
-  split.split_impl_no_error(&free_pages_scope);
-  ASSERT_ND(old_->is_retired());  // the above internally retires old page
-  return kErrorCodeOk;
+  // In all other cases, we split this page. See adopt_by_split().
+  return false;
 }
 
+static_assert(
+  Adopt::kMaxBatchedAdoptions == SplitIntermediate::kMaxMoreAdoptChildren + 1U,
+  "Adopt hands all but one of the batched children to SplitIntermediate");
+
 }  // namespace masstree
 }  // namespace storage
 }  // namespace foedus
@@ -23,9 +23,12 @@
 #include <cstring>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/assorted/assorted_func.hpp"
 #include "foedus/cache/snapshot_file_set.hpp"
 #include "foedus/debugging/stop_watch.hpp"
 #include "foedus/fs/direct_io_file.hpp"
@@ -40,6 +43,7 @@
 #include "foedus/storage/masstree/masstree_page_impl.hpp"
 #include "foedus/storage/masstree/masstree_partitioner_impl.hpp"
 #include "foedus/storage/masstree/masstree_storage_pimpl.hpp"
+#include "foedus/thread/numa_thread_scope.hpp"
 
 namespace foedus {
 namespace storage {
@@ -1256,12 +1260,17 @@ ErrorStack MasstreeComposeContext::open_next_level(
 
   MasstreePage* target = get_page(level->head_);
   MasstreePage* original = get_original(this_level);
+  snapshot::SnapshotId old_snapshot_id = extract_snapshot_id_from_snapshot_pointer(old_page_id);
+  ASSERT_ND(old_snapshot_id != snapshot::kNullSnapshotId);
+  if (UNLIKELY(old_snapshot_id == snapshot_id_)) {
+    // The page might be still in the staging buffers of asynchronous writes.
+    // Make sure it's in the file before reading it.
+    WRAP_ERROR_CODE(get_writer()->flush_async_writes());
+  }
   WRAP_ERROR_CODE(args_.previous_snapshot_files_->read_page(old_page_id, original));
   level->low_fence_ = original->get_low_fence();
   level->high_fence_ = original->get_high_fence();
 
-  snapshot::SnapshotId old_snapshot_id = extract_snapshot_id_from_snapshot_pointer(old_page_id);
-  ASSERT_ND(old_snapshot_id != snapshot::kNullSnapshotId);
   if (UNLIKELY(old_snapshot_id == snapshot_id_)) {
     // if we are re-opening a page we have created in this execution,
     // we have to remove the old entry in page_boundary_info we created when we closed it.
@@ -2381,25 +2390,84 @@ ErrorStack MasstreeComposeContext::install_snapshot_pointers(uint64_t* installed
 
   // The recursion is not transactionally protected. That's fine; even if we skip over
   // something, it's just that we can't drop the page this time.
-  for (VolatilePagePointer pointer : recursion_targets) {
-    MasstreePage* child = reinterpret_cast<MasstreePage*>(resolver.resolve_offset(pointer));
+  // Each recursion target is a disjoint sub-tree, so we split them into contiguous key ranges
+  // and recurse on them in parallel. Each thread has its own prefixes and counter.
+  const uint32_t target_count = recursion_targets.size();
+  const uint32_t thread_count = std::min<uint32_t>(
+    target_count,
+    std::max<uint32_t>(1U, engine_->get_options().snapshot_.composer_parallel_threads_));
+  if (thread_count <= 1U) {
+    WRAP_ERROR_CODE(install_snapshot_pointers_targets(
+      resolver,
+      no_next_layer,
+      recursion_targets.data(),
+      target_count,
+      prefixes,
+      installed_count));
+  } else {
+    std::vector< std::thread > threads;
+    std::vector< ErrorCode > results(thread_count, kErrorCodeOk);
+    std::vector< uint64_t > counts(thread_count, 0);
+    const uint32_t targets_per_thread = assorted::int_div_ceil(target_count, thread_count);
+    for (uint32_t i = 0; i < thread_count; ++i) {
+      const uint32_t from = i * targets_per_thread;
+      const uint32_t to = std::min<uint32_t>(target_count, from + targets_per_thread);
+      if (from >= to) {
+        break;
+      }
+      threads.emplace_back([this, &resolver, no_next_layer, &recursion_targets,
+                            from, to, &results, &counts, i]() {
+        thread::NumaThreadScope scope(numa_node_);
+        KeySlice thread_prefixes[kMaxLayers];
+        std::memset(thread_prefixes, 0, sizeof(thread_prefixes));
+        results[i] = install_snapshot_pointers_targets(
+          resolver,
+          no_next_layer,
+          &recursion_targets[from],
+          to - from,
+          thread_prefixes,
+          &counts[i]);
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    for (uint32_t i = 0; i < threads.size(); ++i) {
+      *installed_count += counts[i];
+    }
+    for (uint32_t i = 0; i < threads.size(); ++i) {
+      WRAP_ERROR_CODE(results[i]);
+    }
+  }
+  watch.stop();
+  LOG(INFO) << "MasstreeStorage-" << id_ << " installed " << *installed_count << " pointers"
+    << " in " << watch.elapsed_ms() << "ms with " << thread_count << " threads";
+  return kRetOk;
+}
+
+ErrorCode MasstreeComposeContext::install_snapshot_pointers_targets(
+  const memory::GlobalVolatilePageResolver& resolver,
+  bool no_next_layer,
+  const VolatilePagePointer* targets,
+  uint32_t target_count,
+  KeySlice* prefixes,
+  uint64_t* installed_count) const {
+  for (uint32_t i = 0; i < target_count; ++i) {
+    MasstreePage* child = reinterpret_cast<MasstreePage*>(resolver.resolve_offset(targets[i]));
     if (no_next_layer && child->is_border()) {
       // unlike install_snapshot_pointers_recurse_intermediate, we check it here.
       // because btree-levels might be unbalanced in first layer's root, we have to follow
       // the pointer to figure this out.
       continue;
     }
-    WRAP_ERROR_CODE(install_snapshot_pointers_recurse(
+    CHECK_ERROR_CODE(install_snapshot_pointers_recurse(
       resolver,
       0,
       prefixes,
       child,
       installed_count));
   }
-  watch.stop();
-  LOG(INFO) << "MasstreeStorage-" << id_ << " installed " << *installed_count << " pointers"
-    << " in " << watch.elapsed_ms() << "ms";
-  return kRetOk;
+  return kErrorCodeOk;
 }
 
 inline ErrorCode MasstreeComposeContext::install_snapshot_pointers_recurse(
@@ -23,15 +23,20 @@
 #include <cstring>
 #include <string>
 
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/memory/numa_core_memory.hpp"
 #include "foedus/memory/page_pool.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/storage/masstree/masstree_page_impl.hpp"
 #include "foedus/storage/masstree/masstree_retry_impl.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
 #include "foedus/storage/masstree/masstree_storage_pimpl.hpp"
+#include "foedus/thread/thread.hpp"
 #include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
 
 
 namespace foedus {
@@ -46,6 +51,14 @@ MasstreeCursor::MasstreeCursor(MasstreeStorage storage, thread::Thread* context)
   for_writes_ = false;
   forward_cursor_ = true;
   reached_end_ = false;
+  predicate_ = nullptr;
+
+  max_prefetch_pages_ = kDefaultMaxPrefetchPages;
+  prefetch_window_ = 0;
+  prefetched_pages_ = 0;
+
+  resume_hint_ = nullptr;
+  resumed_from_hint_ = false;
 
   route_count_ = 0;
   routes_ = nullptr;
@@ -74,71 +87,115 @@ MasstreeCursor::MasstreeCursor(MasstreeStorage storage, thread::Thread* context)
   search_key_slices_ = nullptr;
 }
 
-void MasstreeCursor::copy_combined_key(char* buffer) const {
-  ASSERT_ND(is_valid_record());
-  const Route* route = cur_route();
-  const Layer layer = route->layer_;
-  ASSERT_ND(layer == route->page_->get_layer());
-  ASSERT_ND(cur_key_in_layer_remainder_ != kInitiallyNextLayer);
-  ASSERT_ND(cur_key_length_ == cur_key_in_layer_remainder_ + layer * sizeof(KeySlice));
-
-  std::memcpy(buffer, ASSUME_ALIGNED(cur_route_prefix_be_, 256), layer * sizeof(KeySlice));
-  assorted::write_bigendian<KeySlice>(cur_key_in_layer_slice_, buffer + layer * sizeof(KeySlice));
-  KeyLength suffix_length = calculate_suffix_length(cur_key_in_layer_remainder_);
+void MasstreeKeyView::copy_to(char* buffer) const {
+  ASSERT_ND(key_length_ == in_layer_remainder_ + layer_ * sizeof(KeySlice));
+  std::memcpy(buffer, prefix_be_, layer_ * sizeof(KeySlice));
+  assorted::write_bigendian<KeySlice>(in_layer_slice_, buffer + layer_ * sizeof(KeySlice));
+  KeyLength suffix_length = calculate_suffix_length(in_layer_remainder_);
   if (suffix_length > 0) {
     std::memcpy(
-      buffer + (layer + 1U) * sizeof(KeySlice),
-      ASSUME_ALIGNED(cur_key_suffix_, 8),
+      buffer + (layer_ + 1U) * sizeof(KeySlice),
+      ASSUME_ALIGNED(suffix_, 8),
       suffix_length);
   }
 }
-void MasstreeCursor::copy_combined_key_part(KeyLength offset, KeyLength len, char* buffer) const {
-  ASSERT_ND(is_valid_record());
-  ASSERT_ND(offset + len <= cur_key_length_);
-  const Route* route = cur_route();
-  const Layer layer = route->layer_;
-  ASSERT_ND(layer == route->page_->get_layer());
-  ASSERT_ND(cur_key_in_layer_remainder_ != kInitiallyNextLayer);
-  ASSERT_ND(cur_key_length_ == cur_key_in_layer_remainder_ + layer * sizeof(KeySlice));
-
-  const KeyLength prefix_len = layer * sizeof(KeySlice);
-  KeyLength buffer_pos = 0;
-  KeyLength len_remaining = len;
-  if (offset < prefix_len) {
-    KeyLength prefix_copy_len = std::min<KeyLength>(prefix_len - offset, len_remaining);
-    std::memcpy(buffer, cur_route_prefix_be_ + offset, prefix_copy_len);
-    buffer_pos += prefix_copy_len;
-    len_remaining -= prefix_copy_len;
-  }
-
-  if (len_remaining > 0) {
-    if (offset < prefix_len + sizeof(KeySlice)) {
-      char cur_slice_be[sizeof(KeySlice)];
-      assorted::write_bigendian<KeySlice>(cur_key_in_layer_slice_, cur_slice_be);
-
-      KeyLength cur_slice_offset = offset - prefix_len;
-      KeyLength cur_slice_copy_len
-        = std::min<KeyLength>(sizeof(KeySlice) - cur_slice_offset, len_remaining);
-      std::memcpy(buffer + buffer_pos, cur_slice_be + cur_slice_offset, cur_slice_copy_len);
-      buffer_pos += cur_slice_copy_len;
-      len_remaining -= cur_slice_copy_len;
-    }
-
-    if (len_remaining > 0) {
-      KeyLength suffix_offset = offset - prefix_len - sizeof(KeySlice);
-      KeyLength suffix_length = calculate_suffix_length(cur_key_in_layer_remainder_);
-      KeyLength suffix_copy_len = std::min<KeyLength>(suffix_length - suffix_offset, len_remaining);
-      std::memcpy(
-        buffer + buffer_pos,
-        cur_key_suffix_ + suffix_offset,
-        suffix_copy_len);
-      buffer_pos += suffix_copy_len;
-      len_remaining -= suffix_copy_len;
-    }
-  }
-
-  ASSERT_ND(buffer_pos == len);
-  ASSERT_ND(len_remaining == 0);
+
+void MasstreeKeyView::copy_part(KeyLength offset, KeyLength len, char* buffer) const {
+  ASSERT_ND(offset + len <= key_length_);
+  const KeyLength prefix_len = get_prefix_length();
+  const KeyLength end = offset + len;
+  KeyLength pos = offset;
+  if (pos < prefix_len) {
+    KeyLength copy_len = std::min<KeyLength>(prefix_len, end) - pos;
+    std::memcpy(buffer, prefix_be_ + pos, copy_len);
+    buffer += copy_len;
+    pos += copy_len;
+  }
+  if (pos < end && pos < prefix_len + sizeof(KeySlice)) {
+    char slice_be[sizeof(KeySlice)];
+    assorted::write_bigendian<KeySlice>(in_layer_slice_, slice_be);
+    KeyLength copy_len = std::min<KeyLength>(prefix_len + sizeof(KeySlice), end) - pos;
+    std::memcpy(buffer, slice_be + (pos - prefix_len), copy_len);
+    buffer += copy_len;
+    pos += copy_len;
+  }
+  if (pos < end) {
+    std::memcpy(buffer, suffix_ + (pos - prefix_len - sizeof(KeySlice)), end - pos);
+  }
+}
+
+int MasstreeKeyView::compare(const char* key, KeyLength key_length) const {
+  // 1. prefix slices. they are big-endian, so memcmp is the key order.
+  const KeyLength prefix_len = get_prefix_length();
+  if (prefix_len > 0) {
+    int cmp = std::memcmp(prefix_be_, key, std::min<KeyLength>(prefix_len, key_length));
+    if (cmp != 0) {
+      return cmp;
+    } else if (key_length < prefix_len) {
+      return 1;
+    }
+  }
+
+  // 2. in-layer slice. both are zero-padded, so a tie means either is a prefix of the other
+  // or they have the same 8 bytes.
+  const KeyLength remainder = key_length - prefix_len;
+  KeySlice slice = remainder > 0 ? slice_key(key + prefix_len, remainder) : 0;
+  if (in_layer_slice_ < slice) {
+    return -1;
+  } else if (in_layer_slice_ > slice) {
+    return 1;
+  }
+
+  // 3. suffix
+  if (in_layer_remainder_ > sizeof(KeySlice) && remainder > sizeof(KeySlice)) {
+    KeyLength min_length = std::min<KeyLength>(in_layer_remainder_, remainder);
+    int cmp = std::memcmp(
+      suffix_,
+      key + prefix_len + sizeof(KeySlice),
+      min_length - sizeof(KeySlice));
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
+  if (in_layer_remainder_ < remainder) {
+    return -1;
+  } else if (in_layer_remainder_ > remainder) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+bool MasstreeKeyView::starts_with(const char* prefix, KeyLength prefix_length) const {
+  if (prefix_length > key_length_) {
+    return false;
+  }
+  const KeyLength prefix_len = get_prefix_length();
+  if (prefix_len > 0
+    && std::memcmp(prefix_be_, prefix, std::min<KeyLength>(prefix_len, prefix_length)) != 0) {
+    return false;
+  } else if (prefix_length <= prefix_len) {
+    return true;
+  }
+
+  // compare the first bytes of the in-layer slice. the bytes after them are masked out.
+  const KeyLength remainder = prefix_length - prefix_len;
+  if (remainder < sizeof(KeySlice)) {
+    const KeySlice mask = ~static_cast<KeySlice>(0) << ((sizeof(KeySlice) - remainder) * 8U);
+    return (in_layer_slice_ & mask) == slice_key(prefix + prefix_len, remainder);
+  } else if (in_layer_slice_ != slice_key(prefix + prefix_len, remainder)) {
+    return false;
+  }
+  return std::memcmp(
+    suffix_,
+    prefix + prefix_len + sizeof(KeySlice),
+    remainder - sizeof(KeySlice)) == 0;
+}
+
+std::string MasstreeKeyView::to_string() const {
+  char buf[kMaxKeyLength];
+  copy_to(buf);
+  return std::string(buf, key_length_);
 }
 
 template <typename T>
@@ -157,6 +214,10 @@ inline ErrorCode MasstreeCursor::allocate_if_not_exist(T** pointer) {
   return kErrorCodeOk;
 }
 
+void MasstreeCursor::set_max_prefetch_pages(uint16_t pages) {
+  max_prefetch_pages_ = std::min<uint16_t>(pages, thread::Thread::kMaxFindPagesBatch);
+}
+
 MasstreePage* MasstreeCursor::resolve_volatile(VolatilePagePointer ptr) const {
   ASSERT_ND(!ptr.is_null());
   const auto& resolver = context_->get_global_volatile_page_resolver();
@@ -183,9 +244,8 @@ ErrorCode MasstreeCursor::next() {
 
   // After proceed_route(), it is still possible that we are at a deleted record or empty page.
   // Keep moving on in that case.
-  while (should_skip_cur_route_
-    || (is_valid_record() && cur_key_location_.observed_.is_deleted())) {
-    DVLOG(0) << "Rare. next() needs to move on to find non-deleted records/pages";
+  while (should_skip_cur_route_ || (is_valid_record() && should_skip_cur_record())) {
+    DVLOG(predicate_ ? 2 : 0) << "next() needs to move on to find non-deleted records/pages";
     should_skip_cur_route_ = false;
     CHECK_ERROR_CODE(proceed_route());
     if (route_count_ == 0) {
@@ -203,6 +263,78 @@ ErrorCode MasstreeCursor::next() {
   return kErrorCodeOk;
 }
 
+ErrorCode MasstreeCursor::next_batch(MasstreeRecordBatch* out) {
+  ASSERT_ND(!should_skip_cur_route_);
+  out->count_ = 0;
+  if (!is_valid_record()) {
+    return kErrorCodeOk;
+  }
+
+  assert_route();
+  Route* route = cur_route();
+  ASSERT_ND(route->page_->is_border());
+  MasstreeBorderPage* page = reinterpret_cast<MasstreeBorderPage*>(route->page_);
+  out->layer_ = route->layer_;
+  if (route->layer_ > 0) {
+    std::memcpy(out->prefix_be_, cur_route_prefix_be_, route->layer_ * sizeof(KeySlice));
+  }
+
+  // Collect records in this page as far as we don't have to leave the page.
+  // The current record is always valid, non-deleted, and before the end key here.
+  while (true) {
+    ASSERT_ND(out->count_ < kBorderPageMaxSlots);
+    ASSERT_ND(!cur_key_location_.observed_.is_deleted());
+    ASSERT_ND(!is_cur_key_next_layer());
+    MasstreeRecordBatch::Entry& entry = out->entries_[out->count_];
+    entry.owner_id_address_ = cur_key_owner_id_address;
+    entry.observed_ = cur_key_location_.observed_;
+    entry.in_layer_slice_ = cur_key_in_layer_slice_;
+    entry.in_layer_remainder_ = cur_key_in_layer_remainder_;
+    entry.key_length_ = cur_key_length_;
+    entry.payload_length_ = cur_payload_length_;
+    entry.suffix_ = cur_key_suffix_;
+    entry.payload_ = cur_payload_;
+    ++out->count_;
+
+    bool found = false;
+    while (true) {
+      if (forward_cursor_) {
+        ++route->index_;
+      } else {
+        --route->index_;
+      }
+      if (!route->is_valid_record()) {
+        break;
+      }
+      CHECK_ERROR_CODE(fetch_cur_record_logical(page, route->get_cur_original_index()));
+      if (is_cur_key_next_layer()) {
+        break;
+      } else if (!should_skip_cur_record()) {
+        found = true;
+        break;
+      }
+    }
+
+    if (!found) {
+      // Either we are done with this page or we need to go down to next layer.
+      // Step back to the previous record and let next() take care of it as usual.
+      // It re-observes the next-layer record if there is, but that takes no read-set.
+      if (forward_cursor_) {
+        --route->index_;
+      } else {
+        ++route->index_;
+      }
+      ASSERT_ND(route->is_valid_record());
+      return next();
+    }
+
+    check_end_key();
+    if (!is_valid_record()) {
+      return kErrorCodeOk;
+    }
+  }
+}
+
 inline ErrorCode MasstreeCursor::proceed_route() {
   ASSERT_ND(!should_skip_cur_route_);  // must be controlled in the caller (open/next)
   if (cur_route()->page_->is_border()) {
@@ -239,11 +371,15 @@ ErrorCode MasstreeCursor::proceed_route_border() {
       // If it points to next-layer, we ignore deleted bit. It has no meaning for next-layer rec.
       if (is_cur_key_next_layer()) {
         CHECK_ERROR_CODE(proceed_next_layer());
-      } else if (cur_key_location_.observed_.is_deleted()) {
-        continue;
+      } else if (should_skip_cur_record()) {
+        continue;  // deleted or filtered out by predicate_
       }
       break;
     } else {
+      // Done with this page. A good time to see if we are already doomed before reading more.
+      if (current_xct_->should_validate_early(1U)) {
+        CHECK_ERROR_CODE(current_xct_->validate_read_set_early());
+      }
       CHECK_ERROR_CODE(proceed_pop());
       break;
     }
@@ -385,6 +521,9 @@ ErrorCode MasstreeCursor::proceed_route_intermediate() {
 
     route->latest_separator_ = new_separator;
     CHECK_ERROR_CODE(push_route(next));
+    if (next->is_border()) {
+      CHECK_ERROR_CODE(prefetch_next_border_pages(route, true));
+    }
     return proceed_deeper();
   }
   return kErrorCodeOk;
@@ -394,6 +533,9 @@ inline ErrorCode MasstreeCursor::proceed_pop() {
   while (true) {
     --route_count_;
     if (route_count_ == 0) {
+      if (UNLIKELY(resumed_from_hint_)) {
+        return locate_after_resume_hint();
+      }
       reached_end_ = true;
       return kErrorCodeOk;
     }
@@ -518,9 +660,137 @@ inline ErrorCode MasstreeCursor::proceed_deeper_intermediate() {
 
   route->latest_separator_ = forward_cursor_ ? separator_high : separator_low;
   CHECK_ERROR_CODE(push_route(next));
+  if (next->is_border()) {
+    CHECK_ERROR_CODE(prefetch_next_border_pages(route, false));
+  }
   return proceed_deeper();
 }
 
+ErrorCode MasstreeCursor::prefetch_next_border_pages(const Route* parent, bool moved_to_sibling) {
+  ASSERT_ND(!parent->page_->is_border());
+  if (moved_to_sibling) {
+    // the page we just entered was one of the prefetched pages, if any
+    if (prefetched_pages_ > 0) {
+      --prefetched_pages_;
+    }
+    prefetch_window_ = std::min<uint16_t>(prefetch_window_ * 2U, max_prefetch_pages_);
+  } else {
+    prefetched_pages_ = 0;
+  }
+  if (prefetch_window_ == 0) {
+    return kErrorCodeOk;
+  }
+
+  // We can compare separators with the end key only when the prefix is the same as end key's.
+  // Otherwise, the end key is not in this layer. We prefetch the full window.
+  const Layer layer = parent->layer_;
+  bool check_end_key = false;
+  KeySlice end_slice = 0;
+  if (!is_end_key_supremum() && sizeof(KeySlice) * layer < end_key_length_) {
+    check_end_key = true;
+    for (Layer i = 0; i < layer; ++i) {
+      if (end_key_slices_[i] != cur_route_prefix_slices_[i]) {
+        check_end_key = false;
+        break;
+      }
+    }
+    end_slice = end_key_slices_[layer];
+  }
+
+  // This is just a hint. We read the intermediate page without any verification. Even if it's
+  // concurrently modified, the worst case is to prefetch a wrong page.
+  const MasstreeIntermediatePage* page
+    = reinterpret_cast<const MasstreeIntermediatePage*>(parent->page_);
+  SlotIndex index = parent->index_;
+  SlotIndex index_mini = parent->index_mini_;
+  SlotIndex key_count_mini = parent->key_count_mini_;
+  // for_writes_ cursors always follow volatile pages, so no point to read snapshot pages.
+  // Without snapshot cache, we would read the pages into work memory just to discard them.
+  const bool prefetch_snapshot
+    = !for_writes_ && engine_->get_options().cache_.snapshot_cache_enabled_;
+  SnapshotPagePointer snapshot_page_ids[thread::Thread::kMaxFindPagesBatch];
+  uint16_t snapshot_count = 0;
+  uint16_t distance;
+  for (distance = 1U; distance <= prefetch_window_; ++distance) {
+    if (forward_cursor_) {
+      if (index_mini < key_count_mini) {
+        ++index_mini;
+      } else if (index < parent->key_count_) {
+        ++index;
+        key_count_mini = page->get_minipage(index).key_count_;
+        index_mini = 0;
+      } else {
+        break;  // the rest is under another intermediate page. we will prefetch them there.
+      }
+    } else {
+      if (index_mini > 0) {
+        --index_mini;
+      } else if (index > 0) {
+        --index;
+        key_count_mini = page->get_minipage(index).key_count_;
+        index_mini = key_count_mini;
+      } else {
+        break;
+      }
+    }
+    ASSERT_ND(key_count_mini <= kMaxIntermediateMiniSeparators);
+
+    const MasstreeIntermediatePage::MiniPage& minipage = page->get_minipage(index);
+    if (check_end_key) {
+      if (forward_cursor_) {
+        KeySlice low;
+        if (index_mini > 0) {
+          low = minipage.separators_[index_mini - 1U];
+        } else if (index > 0) {
+          low = page->get_separator(index - 1U);
+        } else {
+          low = page->get_low_fence();
+        }
+        if (low > end_slice) {
+          break;
+        }
+      } else {
+        KeySlice high;
+        if (index_mini < key_count_mini) {
+          high = minipage.separators_[index_mini];
+        } else if (index < parent->key_count_) {
+          high = page->get_separator(index);
+        } else {
+          high = page->get_high_fence();
+        }
+        if (high < end_slice) {
+          break;
+        }
+      }
+    }
+    if (distance <= prefetched_pages_) {
+      continue;
+    }
+
+    const DualPagePointer& pointer = minipage.pointers_[index_mini];
+    VolatilePagePointer volatile_pointer = pointer.volatile_pointer_;
+    if (!volatile_pointer.is_null()) {
+      resolve_volatile(volatile_pointer)->prefetch_general();
+    } else if (prefetch_snapshot && pointer.snapshot_pointer_ != 0) {
+      snapshot_page_ids[snapshot_count] = pointer.snapshot_pointer_;
+      ++snapshot_count;
+    }
+  }
+  prefetched_pages_ = distance - 1U;
+
+  if (snapshot_count > 0) {
+    Page* snapshot_pages[thread::Thread::kMaxFindPagesBatch];
+    CHECK_ERROR_CODE(context_->find_or_read_snapshot_pages_batch(
+      snapshot_count,
+      snapshot_page_ids,
+      snapshot_pages));
+    for (uint16_t i = 0; i < snapshot_count; ++i) {
+      reinterpret_cast<MasstreePage*>(snapshot_pages[i])->prefetch_general();
+    }
+  }
+  return kErrorCodeOk;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 //
 //      common methods
@@ -752,6 +1022,20 @@ inline void MasstreeCursor::check_end_key() {
   }
 }
 
+inline bool MasstreeCursor::should_skip_cur_record() {
+  ASSERT_ND(is_valid_record());
+  if (cur_key_location_.observed_.is_deleted()) {
+    return true;
+  } else if (predicate_ == nullptr) {
+    return false;
+  }
+  check_end_key();
+  if (!is_valid_record()) {
+    return false;  // the caller will see that we reached the end
+  }
+  return !predicate_->evaluate(cur_payload_, cur_payload_length_);
+}
+
 inline MasstreeCursor::KeyCompareResult MasstreeCursor::compare_cur_key_aginst_search_key(
   KeySlice slice,
   uint8_t layer) const {
@@ -798,13 +1082,10 @@ inline MasstreeCursor::KeyCompareResult MasstreeCursor::compare_cur_key_aginst_e
   // Was the last slice a complete one?
   // For example, end-key="123456", layer=1. end_key_slices_[0] was incomplete.
   // We know cur_route_prefix_slices_[0] was "123456  " (space as \0). So it's actually different.
+  // The end-key is a prefix of the current key, so the current key is larger in either direction.
   if (sizeof(KeySlice) * layer > end_key_length_) {
     ASSERT_ND(cur_key_length_ > end_key_length_);
-    if (is_forward_cursor()) {
-      return kCurKeyLarger;
-    } else {
-      return kCurKeySmaller;
-    }
+    return kCurKeyLarger;
   }
 
   // okay, all prefix slices were exactly the same.
@@ -956,6 +1237,8 @@ ErrorCode MasstreeCursor::open(
   end_inclusive_ = end_inclusive;
   end_key_length_ = end_key_length;
   route_count_ = 0;
+  prefetch_window_ = max_prefetch_pages_ > 0 ? 1U : 0;
+  prefetched_pages_ = 0;
   if (!is_end_key_supremum()) {
     copy_input_key(end_key, end_key_length, end_key_, end_key_slices_);
   }
@@ -967,11 +1250,24 @@ ErrorCode MasstreeCursor::open(
     copy_input_key(begin_key, begin_key_length, search_key_, search_key_slices_);
   }
 
-  MasstreeIntermediatePage* root;
-  MasstreeStoragePimpl pimpl(&storage_);
-  CHECK_ERROR_CODE(pimpl.get_first_root(context_, for_writes, &root));
-  CHECK_ERROR_CODE(push_route(root));
+  // resume() might give us the border page to start from, skipping the descent.
+  MasstreeBorderPage* hint = resume_hint_;
+  resume_hint_ = nullptr;
+  resumed_from_hint_ = false;
+  if (hint && hint->within_fences(setup_search_slice(0))) {
+    resumed_from_hint_ = true;
+    CHECK_ERROR_CODE(push_route(hint));
+  } else {
+    MasstreeIntermediatePage* root;
+    MasstreeStoragePimpl pimpl(&storage_);
+    CHECK_ERROR_CODE(pimpl.get_first_root(context_, for_writes, &root));
+    CHECK_ERROR_CODE(push_route(root));
+  }
   CHECK_ERROR_CODE(locate_layer(0));
+  return locate_finish();
+}
+
+ErrorCode MasstreeCursor::locate_finish() {
   ASSERT_ND(route_count_ != 0);
   ASSERT_ND(cur_route()->page_->is_border());
   ASSERT_ND(should_skip_cur_route_ || (!should_skip_cur_route_ && is_valid_record()));
@@ -983,9 +1279,8 @@ ErrorCode MasstreeCursor::open(
   //  Let's go on to next page by proceed_route() and find a next page.
   // Note, it's a while, not if. It's very unlikely but possible that proceed_route again
   // results in the same state.
-  while (should_skip_cur_route_
-      || (is_valid_record() && cur_key_location_.observed_.is_deleted())) {
-    DVLOG(0) << "Rare. open() needs to move on to find non-deleted records/pages";
+  while (should_skip_cur_route_ || (is_valid_record() && should_skip_cur_record())) {
+    DVLOG(predicate_ ? 2 : 0) << "open() needs to move on to find non-deleted records/pages";
     should_skip_cur_route_ = false;
     CHECK_ERROR_CODE(proceed_route());
     if (route_count_ == 0) {
@@ -1003,11 +1298,260 @@ ErrorCode MasstreeCursor::open(
   return kErrorCodeOk;
 }
 
-inline ErrorCode MasstreeCursor::locate_layer(uint8_t layer) {
-  MasstreePage* layer_root = cur_route()->page_;
-  ASSERT_ND(layer_root->is_layer_root());
-  ASSERT_ND(layer_root->get_layer() == layer);
-  // set up the search in this layer. What's the slice we will look for in this layer?
+/**
+ * Makes the given key the smallest key that is larger than all keys beginning with it.
+ * @return false if there is no such key, meaning the key is all 0xFF.
+ */
+bool to_prefix_successor(char* key, KeyLength* length) {
+  while (*length > 0 && static_cast<uint8_t>(key[*length - 1U]) == 0xFFU) {
+    --(*length);
+  }
+  if (*length == 0) {
+    return false;
+  }
+  key[*length - 1U] = static_cast<char>(static_cast<uint8_t>(key[*length - 1U]) + 1U);
+  return true;
+}
+
+ErrorCode MasstreeCursor::open_prefix(
+  const char* prefix,
+  KeyLength prefix_length,
+  bool forward_cursor,
+  bool for_writes) {
+  if (prefix_length == 0) {
+    return open(nullptr, kKeyLengthExtremum, nullptr, kKeyLengthExtremum,
+      forward_cursor, for_writes);
+  }
+  char successor[kMaxKeyLength];
+  std::memcpy(successor, prefix, prefix_length);
+  KeyLength successor_length = prefix_length;
+  if (!to_prefix_successor(successor, &successor_length)) {
+    successor_length = kKeyLengthExtremum;  // no key is larger. supremum.
+  }
+  if (forward_cursor) {
+    return open(prefix, prefix_length, successor, successor_length,
+      true, for_writes, true, false);
+  } else {
+    return open(successor, successor_length, prefix, prefix_length,
+      false, for_writes, false, true);
+  }
+}
+
+ErrorCode MasstreeCursor::next_distinct_prefix(KeyLength prefix_length) {
+  ASSERT_ND(!should_skip_cur_route_);
+  if (!is_valid_record()) {
+    return kErrorCodeOk;
+  }
+  if (cur_key_length_ <= prefix_length) {
+    // the whole key is the prefix, so the next key has a different prefix anyway.
+    // this also saves re-locating (and re-taking page versions) for every record.
+    return next();
+  }
+
+  assert_route();
+  char key[kMaxKeyLength];
+  get_key_view().copy_part(0, prefix_length, key);
+  KeyLength key_length = prefix_length;
+  if (forward_cursor_) {
+    if (!to_prefix_successor(key, &key_length)) {
+      reached_end_ = true;
+      return kErrorCodeOk;
+    }
+    search_type_ = kForwardInclusive;
+  } else {
+    // all keys with the prefix are the prefix itself or larger
+    if (key_length == 0) {
+      reached_end_ = true;
+      return kErrorCodeOk;
+    }
+    search_type_ = kBackwardExclusive;
+  }
+  search_key_length_ = key_length;
+  copy_input_key(key, key_length, search_key_, search_key_slices_);
+
+  CHECK_ERROR_CODE(locate_from_route());
+  return locate_finish();
+}
+
+ErrorCode MasstreeCursor::locate_from_route() {
+  // Find the deepest page in the route that contains the search key, walking up.
+  // The pages before it in the route are still the path to it, and the path's slices
+  // in cur_route_prefix_slices_ are still same as the search key's.
+  for (uint16_t i = route_count_; i > 0; --i) {
+    MasstreePage* page = routes_[i - 1U].page_;
+    const Layer layer = page->get_layer();
+    if (search_key_length_ <= layer * sizeof(KeySlice)) {
+      continue;  // the search key ends in a previous layer
+    }
+    bool same_path = true;
+    for (Layer l = 0; l < layer; ++l) {
+      if (search_key_slices_[l] != cur_route_prefix_slices_[l]) {
+        same_path = false;
+        break;
+      }
+    }
+    if (!same_path) {
+      continue;
+    }
+    KeySlice slice = setup_search_slice(layer);
+    if (!page->within_fences(slice)) {
+      continue;
+    }
+
+    // Re-push the page to take its latest version, and locate in it just like open().
+    DVLOG(2) << "Re-locating from the route-" << (i - 1U) << " in layer-"
+      << static_cast<int>(layer);
+    route_count_ = i - 1U;
+    CHECK_ERROR_CODE(push_route(page));
+    if (!page->is_border()) {
+      CHECK_ERROR_CODE(locate_descend(slice));
+    }
+    ASSERT_ND(cur_route()->page_->is_border());
+    return locate_border(slice);
+  }
+
+  DVLOG(2) << "No page in the route contains the search key. Descending from the root";
+  route_count_ = 0;
+  resumed_from_hint_ = false;
+  MasstreeIntermediatePage* root;
+  MasstreeStoragePimpl pimpl(&storage_);
+  CHECK_ERROR_CODE(pimpl.get_first_root(context_, for_writes_, &root));
+  CHECK_ERROR_CODE(push_route(root));
+  return locate_layer(0);
+}
+
+void MasstreeCursor::export_token(MasstreeCursorToken* out) const {
+  out->storage_id_ = storage_.get_id();
+  out->forward_cursor_ = forward_cursor_;
+  out->page_hint_.word = 0;
+  out->current_epoch_ = engine_->get_xct_manager()->get_current_global_epoch_weak().value();
+  out->snapshot_epoch_ = engine_->get_snapshot_manager()->get_snapshot_epoch_weak().value();
+  if (!is_valid_record()) {
+    out->finished_ = true;
+    out->key_length_ = 0;
+    return;
+  }
+
+  out->finished_ = false;
+  out->key_length_ = cur_key_length_;
+  copy_combined_key(out->key_);
+  // The border page in the first layer is the last one of layer-0 in the route.
+  for (uint16_t i = route_count_; i > 0; --i) {
+    const Route& route = routes_[i - 1U];
+    if (route.layer_ == 0 && route.page_->is_border()) {
+      if (!route.snapshot_ && !route.was_stably_moved()) {
+        out->page_hint_ = route.page_->get_volatile_page_id();
+      }
+      break;
+    }
+  }
+}
+
+MasstreeBorderPage* MasstreeCursor::get_usable_resume_hint(
+  const MasstreeCursorToken& token) const {
+  if (token.page_hint_.is_null() || token.key_length_ == 0) {
+    return nullptr;
+  } else if (current_xct_->get_isolation_level() == xct::kSnapshot) {
+    return nullptr;  // snapshot transactions must not see volatile pages
+  }
+  // Same as MasstreeDescentPath. If the epochs are the same, the page is not reclaimed yet.
+  // Snapshotting publishes the new snapshot epoch before it resumes transactions, so we never
+  // see the old snapshot epoch after the volatile pages are dropped.
+  const Epoch current_epoch = engine_->get_xct_manager()->get_current_global_epoch_weak();
+  const Epoch snapshot_epoch = engine_->get_snapshot_manager()->get_snapshot_epoch_weak();
+  if (token.current_epoch_ != current_epoch.value()
+    || token.snapshot_epoch_ != snapshot_epoch.value()) {
+    return nullptr;
+  }
+  MasstreePage* page = resolve_volatile(token.page_hint_);
+  if (page->header().snapshot_
+    || !page->is_border()
+    || page->get_layer() != 0
+    || page->header().storage_id_ != storage_.get_id()
+    || page->is_moved()
+    || page->is_retired()) {
+    return nullptr;
+  }
+  // open() checks the fences with the search slice.
+  return reinterpret_cast<MasstreeBorderPage*>(page);
+}
+
+ErrorCode MasstreeCursor::resume(
+  const MasstreeCursorToken& token,
+  const char* end_key,
+  KeyLength end_key_length,
+  bool for_writes,
+  bool end_inclusive) {
+  if (UNLIKELY(token.storage_id_ != storage_.get_id())) {
+    return kErrorCodeInvalidParameter;
+  }
+  if (!current_xct_->is_active()) {
+    return kErrorCodeXctNoXct;
+  }
+  if (token.finished_) {
+    // Nothing to read. Just make is_valid_record() false without locating anything.
+    forward_cursor_ = token.forward_cursor_;
+    for_writes_ = for_writes;
+    route_count_ = 0;
+    reached_end_ = true;
+    return kErrorCodeOk;
+  }
+  resume_hint_ = get_usable_resume_hint(token);
+  DVLOG(2) << "Resuming a cursor. hint=" << (resume_hint_ != nullptr);
+  return open(
+    token.key_,
+    token.key_length_,
+    end_key,
+    end_key_length,
+    token.forward_cursor_,
+    for_writes,
+    true,
+    end_inclusive);
+}
+
+ErrorCode MasstreeCursor::locate_after_resume_hint() {
+  ASSERT_ND(resumed_from_hint_);
+  ASSERT_ND(route_count_ == 0);
+  resumed_from_hint_ = false;
+  const MasstreePage* hint = routes_[0].page_;
+  ASSERT_ND(hint->is_border());
+  ASSERT_ND(hint->get_layer() == 0);
+
+  // We are done with the page. Descend from the root to the next page as open() does.
+  // The smallest key whose first slice is the fence is the fence without trailing zeros.
+  KeySlice fence;
+  if (forward_cursor_) {
+    if (hint->is_high_fence_supremum()) {
+      reached_end_ = true;
+      return kErrorCodeOk;
+    }
+    fence = hint->get_high_fence();
+    search_type_ = kForwardInclusive;
+  } else {
+    if (hint->is_low_fence_infimum()) {
+      reached_end_ = true;
+      return kErrorCodeOk;
+    }
+    fence = hint->get_low_fence();
+    search_type_ = kBackwardExclusive;
+  }
+  ASSERT_ND(fence != 0);
+  assorted::write_bigendian<KeySlice>(fence, search_key_);
+  search_key_length_ = sizeof(KeySlice);
+  while (search_key_[search_key_length_ - 1U] == 0) {
+    --search_key_length_;
+  }
+  search_key_slices_[0] = fence;
+  DVLOG(2) << "Left the border page the cursor resumed from. Descending from the root";
+
+  MasstreeIntermediatePage* root;
+  MasstreeStoragePimpl pimpl(&storage_);
+  CHECK_ERROR_CODE(pimpl.get_first_root(context_, for_writes_, &root));
+  CHECK_ERROR_CODE(push_route(root));
+  return locate_layer(0);
+}
+
+inline KeySlice MasstreeCursor::setup_search_slice(uint8_t layer) {
   KeySlice slice;
   search_key_in_layer_extremum_ = false;
   if (is_search_key_extremum() || search_key_length_ <= layer * sizeof(KeySlice)) {
@@ -1016,23 +1560,31 @@ inline ErrorCode MasstreeCursor::locate_layer(uint8_t layer) {
   } else if (search_key_length_ >= (layer + 1U) * sizeof(KeySlice)) {
     slice = search_key_slices_[layer];
   } else {
-    // if we don't have a full slice for this layer, cursor has to do a bit special thing.
-    // remember that we might be doing backward search.
-    if (forward_cursor_) {
-      // fill unsed bytes with 0
-      slice = kInfimumSlice;
-    } else {
-      // fill unsed bytes with FF
-      slice = kSupremumSlice;
-    }
+    // if we don't have a full slice for this layer, fill unsed bytes with 0 in both directions.
+    // The key is then the smallest one with this slice except shorter keys, so that
+    // compare_cur_key() orders it correctly against longer keys with the same slice.
+    // Filling with FF for backward search would make such longer, hence larger, keys look
+    // smaller than the search key.
+    slice = kInfimumSlice;
     std::memcpy(
       &slice,
       search_key_ + layer * sizeof(KeySlice),
       search_key_length_ - layer * sizeof(KeySlice));
     slice = assorted::read_bigendian<KeySlice>(&slice);
   }
+  return slice;
+}
+
+inline ErrorCode MasstreeCursor::locate_layer(uint8_t layer) {
+  MasstreePage* layer_root = cur_route()->page_;
+  // unless resume() gave us a border page in the first layer to start from
+  ASSERT_ND(layer_root->is_layer_root() || (layer == 0 && resumed_from_hint_));
+  ASSERT_ND(layer_root->get_layer() == layer);
+  // set up the search in this layer. What's the slice we will look for in this layer?
+  KeySlice slice = setup_search_slice(layer);
 
-  ASSERT_ND(layer != 0 || !layer_root->is_border());  // layer0-root is always intermediate
+  // layer0-root is always intermediate
+  ASSERT_ND(layer != 0 || !layer_root->is_border() || resumed_from_hint_);
   if (!layer_root->is_border()) {
     CHECK_ERROR_CODE(locate_descend(slice));
   }
@@ -1118,7 +1670,9 @@ ErrorCode MasstreeCursor::locate_border(KeySlice slice) {
         CHECK_ERROR_CODE(fetch_cur_record_logical(border, record));
         ASSERT_ND(cur_key_in_layer_slice_ <= slice);
         KeyCompareResult result = compare_cur_key_aginst_search_key(slice, layer);
+        // kCurKeyBeingsWith: the next layer has only keys longer than the search key.
         if (result == kCurKeyLarger ||
+          result == kCurKeyBeingsWith ||
           (result == kCurKeyEquals && search_type_ == kBackwardExclusive)) {
           continue;
         }
@@ -1134,7 +1688,9 @@ ErrorCode MasstreeCursor::locate_border(KeySlice slice) {
     break;
   }
 
-  if (is_valid_record() && is_cur_key_next_layer()) {
+  // set_should_skip_cur_route() leaves index_=0 in backward search, so check the flag, too.
+  // Otherwise we would descend into the next layer of the first record we skipped over.
+  if (!should_skip_cur_route_ && is_valid_record() && is_cur_key_next_layer()) {
     return locate_next_layer();
   }
 
@@ -1256,6 +1812,7 @@ ErrorCode MasstreeCursor::locate_descend(KeySlice slice) {
     ASSERT_ND(next->get_high_fence() >= slice);
     CHECK_ERROR_CODE(push_route(next));
     if (next->is_border()) {
+      CHECK_ERROR_CODE(prefetch_next_border_pages(route, false));
       return kErrorCodeOk;
     } else {
       continue;
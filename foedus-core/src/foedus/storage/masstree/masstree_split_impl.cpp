@@ -541,6 +541,10 @@ void SplitIntermediate::split_impl_no_error(thread::GrabFreeVolatilePagesScope*
     piggyback_adopt_child_->set_retired();
     context_->collect_retired_volatile_page(piggyback_adopt_child_->get_volatile_page_id());
   }
+  for (uint16_t i = 0; i < more_adopt_children_count_; ++i) {
+    more_adopt_children_[i]->set_retired();
+    context_->collect_retired_volatile_page(more_adopt_children_[i]->get_volatile_page_id());
+  }
 
   watch.stop();
   DVLOG(1) << "Costed " << watch.elapsed() << " cycles to split a node. original node"
@@ -555,50 +559,68 @@ void SplitIntermediate::decide_strategy(SplitIntermediate::SplitStrategy* out) c
   out->total_separator_count_ = 0;
 
   // While collecting pointers from the old page, we look for the piggyback_adopt_child_
-  // and replace it with new pointers (so, this increases the total # of separators).
-  KeySlice old_separator = 0;
-  KeySlice new_separator = 0;
-  VolatilePagePointer old_pointer;
+  // (and more_adopt_children_) and replace it with new pointers
+  // (so, this increases the total # of separators).
+  MasstreePage* adopt_children[kMaxMoreAdoptChildren + 1U];
+  uint16_t adopt_count = 0;
   if (piggyback_adopt_child_) {
-    ASSERT_ND(piggyback_adopt_child_->is_moved());
-    old_separator = piggyback_adopt_child_->get_low_fence();
-    new_separator = piggyback_adopt_child_->get_foster_fence();
-    old_pointer = VolatilePagePointer(piggyback_adopt_child_->header().page_id_);
+    adopt_children[0] = piggyback_adopt_child_;
+    adopt_count = 1U + more_adopt_children_count_;
+    for (uint16_t i = 0; i < more_adopt_children_count_; ++i) {
+      adopt_children[i + 1U] = more_adopt_children_[i];
+    }
   }
 
-  bool found_old = false;
+  uint16_t found_count = 0;
   for (MasstreeIntermediatePointerIterator iter(target_); iter.is_valid(); iter.next()) {
     const KeySlice low = iter.get_low_key();
     const KeySlice high = iter.get_high_key();
     const DualPagePointer& pointer = iter.get_pointer();
-    if (piggyback_adopt_child_ && low == old_separator) {
+    MasstreePage* adopt_child = nullptr;
+    for (uint16_t i = 0; i < adopt_count; ++i) {
+      if (low == adopt_children[i]->get_low_fence()) {
+        adopt_child = adopt_children[i];
+        break;
+      }
+    }
+    if (adopt_child) {
       // Found the existing pointer to replace with foster-minor
-      ASSERT_ND(pointer.volatile_pointer_.is_equivalent(old_pointer));
-      ASSERT_ND(high == piggyback_adopt_child_->get_high_fence());
-      out->separators_[out->total_separator_count_] = new_separator;
+      ASSERT_ND(adopt_child->is_moved());
+      ASSERT_ND(pointer.volatile_pointer_.is_equivalent(
+        VolatilePagePointer(adopt_child->header().page_id_)));
+      ASSERT_ND(high == adopt_child->get_high_fence());
+      out->separators_[out->total_separator_count_] = adopt_child->get_foster_fence();
       out->pointers_[out->total_separator_count_].volatile_pointer_
-        = piggyback_adopt_child_->get_foster_minor();
+        = adopt_child->get_foster_minor();
       out->pointers_[out->total_separator_count_].snapshot_pointer_ = 0;
       ++(out->total_separator_count_);
 
       // Also add foster-major as a new entry
       out->separators_[out->total_separator_count_] = high;
       out->pointers_[out->total_separator_count_].volatile_pointer_
-        = piggyback_adopt_child_->get_foster_major();
+        = adopt_child->get_foster_major();
       out->pointers_[out->total_separator_count_].snapshot_pointer_ = 0;
       ++(out->total_separator_count_);
-      found_old = true;
+      ++found_count;
     } else {
       out->separators_[out->total_separator_count_] = high;
       out->pointers_[out->total_separator_count_] = pointer;
       ++(out->total_separator_count_);
     }
-    ASSERT_ND(piggyback_adopt_child_ == nullptr || low < old_separator || found_old);
   }
 
-  ASSERT_ND(piggyback_adopt_child_ == nullptr || found_old);
+  ASSERT_ND(found_count == adopt_count);
   ASSERT_ND(out->total_separator_count_ >= 2U);
-  ASSERT_ND(out->total_separator_count_ <= kMaxIntermediatePointers + 1U);
+  ASSERT_ND(out->total_separator_count_ <= kMaxIntermediatePointers + adopt_count);
+
+  // If one of the adopted children was the last one, this seems like a sequential insert.
+  bool last_adopted = false;
+  for (uint16_t i = 0; i < adopt_count; ++i) {
+    if (adopt_children[i]->get_foster_major()
+        == out->pointers_[out->total_separator_count_ - 1].volatile_pointer_) {
+      last_adopted = true;
+    }
+  }
 
   if (out->total_separator_count_ <= kMaxIntermediatePointers) {
     // Then, compact_adopt:
@@ -608,9 +630,7 @@ void SplitIntermediate::decide_strategy(SplitIntermediate::SplitStrategy* out) c
     out->compact_adopt_ = true;
     out->mid_index_ = out->total_separator_count_ - 1U;
     out->mid_separator_ = target_->get_high_fence();
-  } else if (piggyback_adopt_child_
-    && piggyback_adopt_child_->get_foster_major()
-        == out->pointers_[out->total_separator_count_ - 1].volatile_pointer_) {
+  } else if (last_adopted && out->total_separator_count_ <= kMaxIntermediatePointers + 1U) {
     DVLOG(0) << "Seems like a sequential insert. let's do no-record split";
     out->mid_index_ = out->total_separator_count_ - 2U;
     out->mid_separator_ = out->separators_[out->mid_index_];
@@ -681,7 +701,10 @@ void SplitIntermediate::migrate_pointers(
 
   dest->verify_separators();
 }
-static_assert(SplitIntermediate::SplitStrategy::kMaxSeparators > kMaxIntermediatePointers, "WTF");
+static_assert(
+  SplitIntermediate::SplitStrategy::kMaxSeparators
+    > kMaxIntermediatePointers + 1U + SplitIntermediate::kMaxMoreAdoptChildren,
+  "WTF");
 STATIC_SIZE_CHECK(sizeof(SplitIntermediate::SplitStrategy), kPageSize)
 
 }  // namespace masstree
@@ -19,6 +19,8 @@
 
 #include <glog/logging.h>
 
+#include <vector>
+
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/masstree/masstree_page_impl.hpp"
@@ -34,6 +36,49 @@ ErrorCode MasstreeStorage::peek_volatile_page_boundaries(
   return pimpl.peek_volatile_page_boundaries(engine, args);
 }
 
+ErrorCode MasstreeStorage::estimate_key_histogram(
+  Engine* engine,
+  uint32_t bucket_count,
+  KeySlice* boundaries,
+  uint32_t* boundary_count) {
+  *boundary_count = 0;
+  if (bucket_count <= 1U) {
+    return kErrorCodeOk;
+  }
+
+  // Border page boundaries are a few per 4kb page, so this covers a few GBs of records.
+  // Beyond that, the last bucket becomes deeper. It's just an estimate anyways.
+  const uint32_t kMaxFences = 1U << 16;
+  std::vector<KeySlice> fences(kMaxFences);
+  uint32_t fence_count = 0;
+  PeekBoundariesArguments args = {
+    nullptr,
+    0,
+    kMaxFences,
+    kInfimumSlice,
+    kSupremumSlice,
+    &fences[0],
+    &fence_count };
+  CHECK_ERROR_CODE(peek_volatile_page_boundaries(engine, args));
+
+  // fence_count fences split the layer into fence_count + 1 pages.
+  // We pick every (pages / bucket_count)-th fence.
+  const uint64_t pages = fence_count + 1U;
+  for (uint32_t i = 1; i < bucket_count; ++i) {
+    uint64_t fence_index = pages * i / bucket_count;
+    if (fence_index == 0) {
+      continue;
+    }
+    KeySlice boundary = fences[fence_index - 1U];
+    if (*boundary_count > 0 && boundaries[(*boundary_count) - 1U] >= boundary) {
+      continue;
+    }
+    boundaries[*boundary_count] = boundary;
+    ++(*boundary_count);
+  }
+  return kErrorCodeOk;
+}
+
 ErrorCode MasstreeStoragePimpl::peek_volatile_page_boundaries(
   Engine* engine,
   const MasstreeStorage::PeekBoundariesArguments& args) {
@@ -29,12 +29,14 @@
 #include "foedus/memory/numa_core_memory.hpp"
 #include "foedus/memory/numa_node_memory.hpp"
 #include "foedus/memory/page_pool.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/storage_manager_pimpl.hpp"
 #include "foedus/storage/masstree/masstree_adopt_impl.hpp"
 #include "foedus/storage/masstree/masstree_grow_impl.hpp"
+#include "foedus/storage/masstree/masstree_hint_impl.hpp"
 #include "foedus/storage/masstree/masstree_id.hpp"
 #include "foedus/storage/masstree/masstree_log_types.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
@@ -45,6 +47,7 @@
 #include "foedus/storage/masstree/masstree_storage.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
 namespace storage {
@@ -220,8 +223,30 @@ inline ErrorCode MasstreeStoragePimpl::find_border_physical(
   assert_aligned_page(layer_root);
   ASSERT_ND(layer_root->is_high_fence_supremum());
   ASSERT_ND(layer_root->get_low_fence() == kInfimumSlice);
-  MasstreePage* cur = layer_root;
+  return find_border_descend(
+    context,
+    layer_root,
+    current_layer,
+    for_writes,
+    slice,
+    border,
+    nullptr);
+}
+
+inline ErrorCode MasstreeStoragePimpl::find_border_descend(
+  thread::Thread* context,
+  MasstreePage* start,
+  uint8_t   current_layer,
+  bool      for_writes,
+  KeySlice  slice,
+  MasstreeBorderPage** border,
+  MasstreeDescentPath* path) {
+  assert_aligned_page(start);
+  MasstreePage* cur = start;
   cur->prefetch_general();
+  if (path && !cur->header().snapshot_) {
+    path->push(cur);
+  }
   while (true) {
     assert_aligned_page(cur);
     ASSERT_ND(cur->get_layer() == current_layer);
@@ -239,6 +264,9 @@ inline ErrorCode MasstreeStoragePimpl::find_border_physical(
           cur = reinterpret_cast<MasstreePage*>(context->resolve(cur->get_foster_major()));
         }
         ASSERT_ND(cur->within_fences(slice));
+        if (path) {
+          path->push(cur);
+        }
         continue;
       }
       *border = reinterpret_cast<MasstreeBorderPage*>(cur);
@@ -271,6 +299,9 @@ inline ErrorCode MasstreeStoragePimpl::find_border_physical(
           }
         }
         cur = next;
+        if (path && !cur->header().snapshot_) {
+          path->push(cur);
+        }
       } else {
         // even in this case, local retry suffices thanks to foster-twin
         DVLOG(0) << "Interesting. concurrent thread affected the search. local retry";
@@ -280,6 +311,71 @@ inline ErrorCode MasstreeStoragePimpl::find_border_physical(
   }
 }
 
+/**
+ * @return whether we can start find_border_descend() from the page in MasstreeDescentPath.
+ * The epoch check in MasstreeDescentPath::is_usable() guarantees the page is not yet recycled,
+ * but we still check what the page claims to be, which costs nothing compared to a miss.
+ */
+inline bool is_hint_usable(StorageId storage_id, const MasstreePage* page, KeySlice slice) {
+  const PageHeader& header = page->header();
+  return header.storage_id_ == storage_id
+    && !header.snapshot_
+    && page->get_layer() == 0
+    && page->within_fences(slice)
+    && !page->is_moved()
+    && !page->is_retired();
+}
+
+ErrorCode MasstreeStoragePimpl::find_border_hinted(
+  thread::Thread* context,
+  bool      for_writes,
+  KeySlice  slice,
+  MasstreeBorderPage** border) {
+  MasstreeDescentPath* path = context->get_masstree_descent_path(get_id());
+  if (path && UNLIKELY(context->get_current_xct().get_isolation_level() == xct::kSnapshot)) {
+    // The path has only volatile pages. Snapshot transactions must not see them.
+    path = nullptr;
+  }
+  if (path) {
+    const Epoch current_epoch = engine_->get_xct_manager()->get_current_global_epoch_weak();
+    const Epoch snapshot_epoch = engine_->get_snapshot_manager()->get_snapshot_epoch_weak();
+    if (path->is_usable(get_id(), current_epoch, snapshot_epoch)) {
+      // Usually the last border page itself covers the slice.
+      MasstreePage* page = path->pages_[path->depth_ - 1U];
+      if (is_hint_usable(get_id(), page, slice)) {
+        --path->depth_;
+        return find_border_descend(context, page, 0, for_writes, slice, border, path);
+      }
+      // Then border pages we recently visited.
+      for (uint16_t i = 0; i < path->recent_border_count_; ++i) {
+        page = path->recent_borders_[i];
+        if (is_hint_usable(get_id(), page, slice)) {
+          path->swap_border(i, page);
+          --path->depth_;
+          return find_border_descend(context, page, 0, for_writes, slice, border, path);
+        }
+      }
+      // Otherwise, descend from the nearest ancestor that covers the slice.
+      for (uint16_t i = path->depth_ - 1U; i > 0; --i) {
+        page = path->pages_[i - 1U];
+        if (is_hint_usable(get_id(), page, slice)) {
+          path->truncate(i - 1U);
+          return find_border_descend(context, page, 0, for_writes, slice, border, path);
+        }
+      }
+      path->truncate(0);
+    } else {
+      path->reset(get_id(), current_epoch, snapshot_epoch, 0);
+    }
+  }
+
+  MasstreeIntermediatePage* root;
+  CHECK_ERROR_CODE(get_first_root(context, for_writes, &root));
+  ASSERT_ND(root->is_high_fence_supremum());
+  ASSERT_ND(root->get_low_fence() == kInfimumSlice);
+  return find_border_descend(context, root, 0, for_writes, slice, border, path);
+}
+
 ErrorCode MasstreeStoragePimpl::locate_record(
   thread::Thread* context,
   const void* key,
@@ -290,23 +386,23 @@ ErrorCode MasstreeStoragePimpl::locate_record(
   ASSERT_ND(key_length <= kMaxKeyLength);
   result->clear();
   xct::Xct* cur_xct = &context->get_current_xct();
-  MasstreePage* layer_root;
-  CHECK_ERROR_CODE(get_first_root(
-    context,
-    for_writes,
-    reinterpret_cast<MasstreeIntermediatePage**>(&layer_root)));
+  MasstreePage* layer_root = nullptr;
   for (uint16_t current_layer = 0;; ++current_layer) {
     KeyLength remainder_length = key_length - current_layer * 8;
     KeySlice slice = slice_layer(key, key_length, current_layer);
     const void* suffix = reinterpret_cast<const char*>(key) + (current_layer + 1) * 8;
     MasstreeBorderPage* border;
-    CHECK_ERROR_CODE(find_border_physical(
-      context,
-      layer_root,
-      current_layer,
-      for_writes,
-      slice,
-      &border));
+    if (current_layer == 0) {
+      CHECK_ERROR_CODE(find_border_hinted(context, for_writes, slice, &border));
+    } else {
+      CHECK_ERROR_CODE(find_border_physical(
+        context,
+        layer_root,
+        current_layer,
+        for_writes,
+        slice,
+        &border));
+    }
     PageVersionStatus border_version = border->get_version().status_;
     assorted::memory_fence_consume();
     SlotIndex index = border->find_key(slice, suffix, remainder_length);
@@ -342,9 +438,7 @@ ErrorCode MasstreeStoragePimpl::locate_record_normalized(
   result->clear();
   xct::Xct* cur_xct = &context->get_current_xct();
   MasstreeBorderPage* border;
-  MasstreeIntermediatePage* layer_root;
-  CHECK_ERROR_CODE(get_first_root(context, for_writes, &layer_root));
-  CHECK_ERROR_CODE(find_border_physical(context, layer_root, 0, for_writes, key, &border));
+  CHECK_ERROR_CODE(find_border_hinted(context, for_writes, key, &border));
   SlotIndex index = border->find_key_normalized(0, border->get_key_count(), key);
   PageVersionStatus border_version = border->get_version().status_;
   if (index == kBorderPageMaxSlots) {
@@ -597,7 +691,7 @@ inline ErrorCode MasstreeStoragePimpl::check_next_layer_bit(xct::XctId observed)
 }
 
 ErrorCode MasstreeStoragePimpl::retrieve_general(
-  thread::Thread* /*context*/,
+  thread::Thread* context,
   const RecordLocation& location,
   void* payload,
   PayloadLength* payload_capacity) {
@@ -619,11 +713,13 @@ ErrorCode MasstreeStoragePimpl::retrieve_general(
   }
   *payload_capacity = payload_length;
   std::memcpy(payload, border->get_record_payload(location.index_), payload_length);
-  return kErrorCodeOk;
+  return context->get_current_xct().on_record_read_done(
+    border->get_owner_id(location.index_),
+    location.observed_);
 }
 
 ErrorCode MasstreeStoragePimpl::retrieve_part_general(
-  thread::Thread* /*context*/,
+  thread::Thread* context,
   const RecordLocation& location,
   void* payload,
   PayloadLength payload_offset,
@@ -639,7 +735,9 @@ ErrorCode MasstreeStoragePimpl::retrieve_part_general(
     return kErrorCodeStrTooShortPayload;
   }
   std::memcpy(payload, border->get_record_payload(location.index_) + payload_offset, payload_count);
-  return kErrorCodeOk;
+  return context->get_current_xct().on_record_read_done(
+    border->get_owner_id(location.index_),
+    location.observed_);
 }
 
 ErrorCode MasstreeStoragePimpl::register_record_write_log(
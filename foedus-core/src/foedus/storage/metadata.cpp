@@ -22,8 +22,10 @@
 
 #include <string>
 
+#include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_id.hpp"
 #include "foedus/storage/storage_manager_pimpl.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 #include "foedus/storage/array/array_metadata.hpp"
 #include "foedus/storage/hash/hash_metadata.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
@@ -102,6 +104,7 @@ ErrorStack load_from_xml_sequential(tinyxml2::XMLElement* element, Metadata* dat
 }
 
 const char* kChildTagName = "storage";
+const char* kRecordCountTagName = "record_count_";
 
 ErrorStack save_to_xml_array(tinyxml2::XMLElement* parent, Metadata* data) {
   array::ArrayMetadataSerializer serializer(reinterpret_cast<array::ArrayMetadata*>(data));
@@ -157,6 +160,13 @@ ErrorStack MetadataSerializer::load_all_storages_from_xml(
     default:
       return ERROR_STACK(kErrorCodeStrUnsupportedMetadata);
     }
+
+    // Statistics are not part of the metadata, but we remember the record count here.
+    // Optional because older snapshot metadata files don't have it.
+    int64_t record_count = 0;
+    CHECK_ERROR(get_element<int64_t>(element, kRecordCountTagName, &record_count, true, 0));
+    blocks[id].stats_.initialize();
+    blocks[id].stats_.snapshot_record_count_ = record_count;
     ++loaded_count;
   }
   LOG(INFO) << "Loaded metadata of " << loaded_count << " storages";
@@ -191,6 +201,14 @@ ErrorStack MetadataSerializer::save_all_storages_to_xml(
     default:
       return ERROR_STACK(kErrorCodeStrUnsupportedMetadata);
     }
+
+    tinyxml2::XMLElement* element = parent->LastChildElement(kChildTagName);
+    ASSERT_ND(element);
+    CHECK_ERROR(add_element(
+      element,
+      kRecordCountTagName,
+      "Number of records as of this snapshot. Not part of metadata.",
+      blocks[id].stats_.get_gleaned_record_count()));
     ++saved_count;
   }
   LOG(INFO) << "Written metadata of " << saved_count << " storages";
@@ -19,10 +19,12 @@
 
 #include <glog/logging.h>
 
+#include <cstddef>
 #include <ostream>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
+#include "foedus/assorted/crc32c.hpp"
 #include "foedus/memory/page_resolver.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/xct/xct.hpp"
@@ -82,6 +84,23 @@ bool PageHeader::contains_hot_records(thread::Thread* context) {
   return hotness_.value_ >= context->get_current_xct().get_hot_threshold_for_this_xct();
 }
 
+Checksum compute_page_checksum(const Page* page) {
+  const char* address = reinterpret_cast<const char*>(page);
+  const uint64_t checksum_begin = offsetof(PageHeader, checksum_);
+  const uint64_t checksum_end = checksum_begin + sizeof(Checksum);
+  Checksum crc = assorted::crc32c(address, checksum_begin);
+  crc = assorted::crc32c(address + checksum_end, kPageSize - checksum_end, crc);
+  return crc == 0 ? 1U : crc;  // 0 is reserved for "no checksum"
+}
+
+bool verify_page_checksum(const Page* page) {
+  Checksum stored = page->get_header().checksum_;
+  if (stored == 0) {
+    return true;
+  }
+  return stored == compute_page_checksum(page);
+}
+
 void assert_within_valid_volatile_page_impl(
   const memory::GlobalVolatilePageResolver& resolver,
   const void* address) {
@@ -47,7 +47,8 @@ SequentialComposer::SequentialComposer(Composer *parent)
 }
 
 /**
- * Unlike other composers, this one doesn't need merge sort. It's dumb simple.
+ * Unlike other composers, this one doesn't need merge sort by keys.
+ * We just merge the streams by epoch. It's dumb simple.
  */
 struct StreamStatus {
   ErrorCode init(snapshot::SortedBuffer* stream) {
@@ -129,7 +130,7 @@ SequentialPage* SequentialComposer::compose_new_head(snapshot::SnapshotWriter* s
 
 ErrorStack SequentialComposer::dump_pages(
   snapshot::SnapshotWriter* snapshot_writer,
-  bool last_dump,
+  bool end_of_head,
   uint32_t allocated_pages,
   uint64_t* total_pages) {
   SequentialPage* base = reinterpret_cast<SequentialPage*>(snapshot_writer->get_page_base());
@@ -138,7 +139,7 @@ ErrorStack SequentialComposer::dump_pages(
   SequentialPage* tail_page = base + allocated_pages - 1;
   SnapshotPagePointer next_head_page_id = tail_page->header().page_id_ + 1ULL;
   ASSERT_ND(tail_page->next_page().snapshot_pointer_ == 0);
-  if (!last_dump) {
+  if (!end_of_head) {
     // a bit of trick here. Usually, we can't point to a page that is not written yet,
     // but in this case we are sure that we are writing out a page contiguously,
     // so we can set the next-page pointer at this point.
@@ -151,6 +152,22 @@ ErrorStack SequentialComposer::dump_pages(
   return kRetOk;
 }
 
+/** Appends a head pointer to the root info page. */
+inline void add_head_pointer(
+  SequentialComposer::RootInfoPage* root_info_page,
+  SnapshotPagePointer head_page_id,
+  Epoch min_epoch,
+  Epoch max_epoch,
+  uint64_t page_count) {
+  ASSERT_ND(root_info_page->pointer_count_ < SequentialComposer::kMaxHeadsPerCompose);
+  HeadPagePointer& pointer = root_info_page->pointers_[root_info_page->pointer_count_];
+  pointer.page_id_ = head_page_id;
+  pointer.from_epoch_ = min_epoch;
+  pointer.to_epoch_ = max_epoch.one_more();  // to make it exclusive
+  pointer.page_count_ = page_count;
+  ++root_info_page->pointer_count_;
+}
+
 ErrorStack SequentialComposer::compose(const Composer::ComposeArguments& args) {
   debugging::StopWatch stop_watch;
 
@@ -158,71 +175,115 @@ ErrorStack SequentialComposer::compose(const Composer::ComposeArguments& args) {
   // No intermediate pages to track any information.
   snapshot::SnapshotWriter* snapshot_writer = args.snapshot_writer_;
   SequentialPage* base = reinterpret_cast<SequentialPage*>(snapshot_writer->get_page_base());
+  RootInfoPage* root_info_page_casted = reinterpret_cast<RootInfoPage*>(args.root_info_page_);
+  root_info_page_casted->header_.storage_id_ = storage_id_;
+  root_info_page_casted->pointer_count_ = 0;
 
   SequentialPage* cur_page = compose_new_head(snapshot_writer);
   SnapshotPagePointer head_page_id = cur_page->header().page_id_;
+  uint64_t head_page_count = 1;
+  Epoch head_min_epoch;
+  Epoch head_max_epoch;
   uint32_t allocated_pages = 1;
   uint64_t total_pages = 0;
   const uint32_t max_pages = snapshot_writer->get_page_size();
   VLOG(0) << to_string() << " composing with " << args.log_streams_count_ << " streams.";
   Epoch min_epoch;
   Epoch max_epoch;
+  std::vector<StreamStatus> streams(args.log_streams_count_);
   for (uint32_t i = 0; i < args.log_streams_count_; ++i) {
-    StreamStatus status;
-    WRAP_ERROR_CODE(status.init(args.log_streams_[i]));
-    while (!status.ended_) {
-      const SequentialAppendLogType* entry = status.get_entry();
-      Epoch epoch = entry->header_.xct_id_.get_epoch();
-      min_epoch.store_min(epoch);
-      max_epoch.store_max(epoch);
-
-      // need to allocate a new page?
-      if (!cur_page->can_insert_record(entry->payload_count_)) {
-        // need to flush the buffer?
-        if (allocated_pages >= max_pages) {
-          // dump everything and allocate a new head page
-          CHECK_ERROR(dump_pages(snapshot_writer, false, allocated_pages, &total_pages));
-          cur_page = compose_new_head(snapshot_writer);
-          allocated_pages = 1;
-        } else {
-          // sequential storage is a bit special. As every page is written-once, we need only
-          // snapshot pointer. No dual page pointers.
-          SequentialPage* next_page = base + allocated_pages;
-          ++allocated_pages;
-          next_page->initialize_snapshot_page(storage_id_, cur_page->header().page_id_ + 1ULL);
+    WRAP_ERROR_CODE(streams[i].init(args.log_streams_[i]));
+  }
+  while (true) {
+    // Each stream is sorted by epoch (see SequentialPartitioner::sort_batch()).
+    // Take the stream whose current log has the smallest epoch so that we output logs in
+    // epoch order. There are only a few streams, so a linear search suffices.
+    StreamStatus* status = nullptr;
+    for (uint32_t i = 0; i < args.log_streams_count_; ++i) {
+      if (!streams[i].ended_
+        && (status == nullptr
+          || streams[i].cur_owner_id_.get_epoch() < status->cur_owner_id_.get_epoch())) {
+        status = &streams[i];
+      }
+    }
+    if (status == nullptr) {
+      break;
+    }
+
+    const SequentialAppendLogType* entry = status->get_entry();
+    Epoch epoch = entry->header_.xct_id_.get_epoch();
+    min_epoch.store_min(epoch);
+    max_epoch.store_max(epoch);
+
+    // need to allocate a new page?
+    if (!cur_page->can_insert_record(entry->payload_count_)) {
+      // should we start a new linked list here? it's a unit of skipping in cursors.
+      const bool new_head = head_page_count >= kPagesPerHead
+        && root_info_page_casted->pointer_count_ + 1U < kMaxHeadsPerCompose;
+      if (new_head) {
+        add_head_pointer(
+          root_info_page_casted,
+          head_page_id,
+          head_min_epoch,
+          head_max_epoch,
+          head_page_count);
+      }
+
+      // need to flush the buffer?
+      if (allocated_pages >= max_pages) {
+        // dump everything and allocate a new page at the beginning of the buffer
+        CHECK_ERROR(dump_pages(snapshot_writer, new_head, allocated_pages, &total_pages));
+        cur_page = compose_new_head(snapshot_writer);
+        allocated_pages = 1;
+      } else {
+        // sequential storage is a bit special. As every page is written-once, we need only
+        // snapshot pointer. No dual page pointers.
+        SequentialPage* next_page = base + allocated_pages;
+        ++allocated_pages;
+        next_page->initialize_snapshot_page(storage_id_, cur_page->header().page_id_ + 1ULL);
+        if (!new_head) {
           cur_page->next_page().snapshot_pointer_ = next_page->header().page_id_;
-          cur_page = next_page;
-          ASSERT_ND(extract_numa_node_from_snapshot_pointer(cur_page->header().page_id_)
-              == snapshot_writer->get_numa_node());
-          ASSERT_ND(extract_snapshot_id_from_snapshot_pointer(cur_page->header().page_id_)
-              == snapshot_writer->get_snapshot_id());
         }
+        cur_page = next_page;
+        ASSERT_ND(extract_numa_node_from_snapshot_pointer(cur_page->header().page_id_)
+            == snapshot_writer->get_numa_node());
+        ASSERT_ND(extract_snapshot_id_from_snapshot_pointer(cur_page->header().page_id_)
+            == snapshot_writer->get_snapshot_id());
       }
 
-      ASSERT_ND(cur_page->can_insert_record(entry->payload_count_));
-      cur_page->append_record_nosync(
-        status.cur_owner_id_,
-        entry->payload_count_,
-        status.cur_payload_);
-
-      // then, read next
-      WRAP_ERROR_CODE(status.next());
+      if (new_head) {
+        head_page_id = cur_page->header().page_id_;
+        head_page_count = 1;
+        head_min_epoch = INVALID_EPOCH;
+        head_max_epoch = INVALID_EPOCH;
+      } else {
+        ++head_page_count;
+      }
     }
+
+    ASSERT_ND(cur_page->can_insert_record(entry->payload_count_));
+    cur_page->append_record_nosync(
+      status->cur_owner_id_,
+      entry->payload_count_,
+      status->cur_payload_);
+    head_min_epoch.store_min(epoch);
+    head_max_epoch.store_max(epoch);
+
+    // then, read next
+    WRAP_ERROR_CODE(status->next());
   }
   // dump everything
   CHECK_ERROR(dump_pages(snapshot_writer, true, allocated_pages, &total_pages));
-
-  // this compose() emits just one pointer to the head page.
-  RootInfoPage* root_info_page_casted = reinterpret_cast<RootInfoPage*>(args.root_info_page_);
-  root_info_page_casted->header_.storage_id_ = storage_id_;
-  root_info_page_casted->pointer_.page_id_ = head_page_id;
-  root_info_page_casted->pointer_.from_epoch_ = min_epoch;
-  root_info_page_casted->pointer_.to_epoch_ = max_epoch.one_more();  // to make it exclusive
-  root_info_page_casted->pointer_.page_count_ = total_pages;
+  add_head_pointer(
+    root_info_page_casted,
+    head_page_id,
+    head_min_epoch,
+    head_max_epoch,
+    head_page_count);
 
   stop_watch.stop();
   LOG(INFO) << to_string() << " compose() done in " << stop_watch.elapsed_ms() << "ms. # pages="
-    << total_pages << ", head_page=" << assorted::Hex(head_page_id, 16)
+    << total_pages << ", # heads=" << root_info_page_casted->pointer_count_
       << ", min_epoch=" << min_epoch << ", max_epoch=" << max_epoch;
   return kRetOk;
 }
@@ -248,11 +309,15 @@ ErrorStack SequentialComposer::construct_root(const Composer::ConstructRootArgum
     page_id = root_page->get_next_page();
   }
 
-  // each root_info_page contains just one pointer to the head page.
+  // each root_info_page contains pointers to the head pages in epoch order.
   for (uint32_t i = 0; i < args.root_info_pages_count_; ++i) {
     const RootInfoPage* info_page = reinterpret_cast<const RootInfoPage*>(args.root_info_pages_[i]);
-    ASSERT_ND(info_page->pointer_.page_id_ > 0);
-    all_head_pages.push_back(info_page->pointer_);
+    ASSERT_ND(info_page->pointer_count_ > 0);
+    ASSERT_ND(info_page->pointer_count_ <= kMaxHeadsPerCompose);
+    for (uint32_t j = 0; j < info_page->pointer_count_; ++j) {
+      ASSERT_ND(info_page->pointers_[j].page_id_ > 0);
+      all_head_pages.push_back(info_page->pointers_[j]);
+    }
   }
   VLOG(0) << to_string() << " construct_root() total head page pointers=" << all_head_pages.size();
 
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/storage/sequential/sequential_consumer.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/sequential/sequential_cursor.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace storage {
+namespace sequential {
+
+SequentialConsumer::SequentialConsumer(
+  thread::Thread* context,
+  const SequentialStorage& storage,
+  uint16_t group,
+  void* buffer,
+  uint64_t buffer_size)
+  : context_(context),
+    storage_(storage),
+    group_(group),
+    buffer_(buffer),
+    buffer_size_(buffer_size),
+    polled_epoch_(INVALID_EPOCH) {
+  ASSERT_ND(buffer_size >= kPageSize);
+  epoch_counts_.reserve(kInitialEpochCounts);
+}
+
+Epoch SequentialConsumer::get_safe_end_epoch() const {
+  // Same as the default to_epoch of SequentialCursor. No transaction will add records there.
+  Engine* engine = context_->get_engine();
+  Epoch end = engine->get_xct_manager()->get_current_grace_epoch();
+  if (context_->get_current_xct().get_isolation_level() == xct::kSnapshot) {
+    // Such a cursor reads only snapshot pages. Don't skip epochs that are not snapshot yet.
+    const Epoch snapshot_epoch = engine->get_snapshot_manager()->get_snapshot_epoch();
+    if (!snapshot_epoch.is_valid()) {
+      return INVALID_EPOCH;
+    } else if (snapshot_epoch.one_more() < end) {
+      end = snapshot_epoch.one_more();
+    }
+  }
+  return end;
+}
+
+ErrorCode SequentialConsumer::poll(uint32_t max_records) {
+  data_.clear();
+  records_.clear();
+  if (!context_->get_current_xct().is_active()) {
+    return kErrorCodeXctNoXct;
+  }
+  const Epoch group_epoch = storage_.get_consumer_group_epoch(group_);
+  if (!group_epoch.is_valid()) {
+    LOG(ERROR) << "Consumer group-" << group_ << " is not used in " << storage_.get_name();
+    return kErrorCodeInvalidParameter;
+  }
+
+  // Resume from the group's position, or from where this consumer has polled so far.
+  Epoch from = group_epoch;
+  if (polled_epoch_.is_valid() && polled_epoch_ > from) {
+    from = polled_epoch_;
+  }
+  const Epoch safe_end = get_safe_end_epoch();
+  if (!safe_end.is_valid() || safe_end <= from) {
+    DVLOG(1) << "No new safe epochs to poll. from=" << from << ", safe_end=" << safe_end;
+    return kErrorCodeOk;
+  }
+
+  Epoch end;
+  CHECK_ERROR_CODE(decide_end_epoch(from, safe_end, max_records, &end));
+  ASSERT_ND(end > from);
+  ASSERT_ND(end <= safe_end);
+
+  // We know how many records and bytes we copy. Reserve them at once so that the vectors
+  // don't grow record by record. They keep the capacity for following polls.
+  uint64_t total_records = 0;
+  uint64_t total_bytes = 0;
+  for (uint32_t i = 0; i < epoch_counts_.size() && epoch_counts_[i].epoch_ < end; ++i) {
+    total_records += epoch_counts_[i].count_;
+    total_bytes += epoch_counts_[i].bytes_;
+  }
+  records_.reserve(total_records);
+  data_.reserve(total_bytes);
+  CHECK_ERROR_CODE(copy_records(from, end));
+  polled_epoch_ = end;
+  return kErrorCodeOk;
+}
+
+Epoch SequentialConsumer::find_end_epoch(uint32_t max_records) const {
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < epoch_counts_.size(); ++i) {
+    total += epoch_counts_[i].count_;
+    if (i > 0 && total > max_records) {
+      return epoch_counts_[i].epoch_;
+    }
+  }
+  return INVALID_EPOCH;
+}
+
+ErrorCode SequentialConsumer::decide_end_epoch(
+  Epoch from,
+  Epoch to,
+  uint32_t max_records,
+  Epoch* out) {
+  epoch_counts_.clear();
+  SequentialCursor cursor(
+    context_,
+    storage_,
+    buffer_,
+    buffer_size_,
+    SequentialCursor::kNodeFirstMode,
+    from,
+    to);
+  SequentialRecordIterator it;
+  while (cursor.is_valid()) {
+    CHECK_ERROR_CODE(cursor.next_batch(&it));
+    if (!it.is_valid()) {
+      continue;
+    }
+    while (it.is_valid()) {
+      // Records in a page are usually in the same epoch, so check the last one first.
+      const Epoch epoch = it.get_cur_record_epoch();
+      if (epoch_counts_.empty() || epoch_counts_.back().epoch_ != epoch) {
+        std::vector<EpochCount>::iterator found = epoch_counts_.begin();
+        for (; found != epoch_counts_.end() && found->epoch_ != epoch; ++found) {
+          continue;
+        }
+        if (found == epoch_counts_.end()) {
+          EpochCount new_count = {epoch, 0, 0};
+          epoch_counts_.push_back(new_count);
+        } else {
+          std::swap(*found, epoch_counts_.back());
+        }
+      }
+      ++epoch_counts_.back().count_;
+      epoch_counts_.back().bytes_ += it.get_cur_record_length();
+      it.next();
+    }
+
+    // Records at or after the end we would choose now never make it later: more records
+    // only make it earlier. Each core's records are sorted by epoch, so the cursor stops
+    // reading each core there rather than counting all pending records.
+    std::sort(epoch_counts_.begin(), epoch_counts_.end());
+    const Epoch end = find_end_epoch(max_records);
+    if (end.is_valid()) {
+      cursor.narrow_to_epoch(end);
+    }
+  }
+
+  // Take whole epochs as far as they fit in max_records, but at least one epoch.
+  std::sort(epoch_counts_.begin(), epoch_counts_.end());
+  *out = find_end_epoch(max_records);
+  if (!out->is_valid()) {
+    *out = to;
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode SequentialConsumer::copy_records(Epoch from, Epoch to) {
+  SequentialCursor cursor(
+    context_,
+    storage_,
+    buffer_,
+    buffer_size_,
+    SequentialCursor::kNodeFirstMode,
+    from,
+    to);
+  SequentialRecordIterator it;
+  while (cursor.is_valid()) {
+    CHECK_ERROR_CODE(cursor.next_batch(&it));
+    while (it.is_valid()) {
+      PolledRecord record;
+      record.offset_ = data_.size();
+      record.length_ = it.get_cur_record_length();
+      record.epoch_ = it.get_cur_record_epoch();
+      const char* raw = it.get_cur_record_raw();
+      data_.insert(data_.end(), raw, raw + record.length_);
+      records_.push_back(record);
+      it.next();
+    }
+  }
+
+  // The cursor returns records core by core. Order them by epoch.
+  std::stable_sort(
+    records_.begin(),
+    records_.end(),
+    [](const PolledRecord& left, const PolledRecord& right) { return left.epoch_ < right.epoch_; });
+  return kErrorCodeOk;
+}
+
+ErrorStack SequentialConsumer::ack(Epoch* commit_epoch) {
+  *commit_epoch = INVALID_EPOCH;
+  if (!polled_epoch_.is_valid()) {
+    return kRetOk;
+  }
+  return storage_.ack_consumer_group(group_, polled_epoch_, commit_epoch);
+}
+
+}  // namespace sequential
+}  // namespace storage
+}  // namespace foedus
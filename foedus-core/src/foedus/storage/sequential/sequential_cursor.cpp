@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <ostream>
+#include <vector>
 
 #include "foedus/assert_nd.hpp"
 #include "foedus/engine.hpp"
@@ -70,11 +71,16 @@ SequentialCursor::SequentialCursor(
     node_filter_(node_filter),
     node_count_(engine_->get_soc_count()),
     order_mode_(order_mode),
+    predicate_(nullptr),
+    partition_(0),
+    partition_count_(1),
     buffer_(reinterpret_cast<SequentialRecordBatch*>(buffer)),
     buffer_size_(buffer_size),
-    buffer_pages_(buffer_size / kPageSize) {
+    buffer_pages_(buffer_size / kPageSize),
+    snapshot_pages_(buffer_) {
   ASSERT_ND(buffer_size >= kPageSize);
   current_node_ = 0;
+  stat_skipped_pages_ = 0;
   finished_snapshots_ = false;
   finished_safe_volatiles_ = false;
   finished_unsafe_volatiles_ = false;
@@ -134,12 +140,15 @@ SequentialRecordIterator::SequentialRecordIterator()
   cur_offset_ = 0;
   cur_record_epoch_ = INVALID_EPOCH;
   stat_skipped_records_ = 0;
+  stat_filtered_records_ = 0;
+  predicate_ = nullptr;
 }
 
 SequentialRecordIterator::SequentialRecordIterator(
   const SequentialRecordBatch* batch,
   Epoch from_epoch,
-  Epoch to_epoch)
+  Epoch to_epoch,
+  const RecordPredicate* predicate)
   : batch_(batch),
     from_epoch_(from_epoch),
     to_epoch_(to_epoch),
@@ -150,9 +159,14 @@ SequentialRecordIterator::SequentialRecordIterator(
   cur_record_epoch_ = batch->get_epoch_from_offset(0);
   ASSERT_ND(cur_record_epoch_.is_valid());
   stat_skipped_records_ = 0;
+  stat_filtered_records_ = 0;
+  predicate_ = predicate;
   if (!in_epoch_range(cur_record_epoch_)) {
     ++stat_skipped_records_;
     next();
+  } else if (!matches_predicate()) {
+    ++stat_filtered_records_;
+    next();
   }
 }
 
@@ -229,8 +243,12 @@ ErrorCode SequentialCursor::init_states() {
     uint64_t too_old_pointers = 0;
     uint64_t too_new_pointers = 0;
     uint64_t node_filtered_pointers = 0;
+    uint64_t partition_filtered_pointers = 0;
     uint64_t added_pointers = 0;
     uint32_t page_count = 0;
+    // number of pointers in each node that overlap with the epoch range so far.
+    // we assign them to partitions in round-robin.
+    std::vector<uint32_t> node_pointers(node_count_, 0);
     for (SnapshotPagePointer next_page_id = root_snapshot_page_id; next_page_id != 0;) {
       ASSERT_ND(next_page_id != 0);
       ++page_count;
@@ -252,6 +270,10 @@ ErrorCode SequentialCursor::init_states() {
         } else if (node_filter_ >= 0 && numa_node != static_cast<uint32_t>(node_filter_)) {
           ++node_filtered_pointers;
           continue;
+        } else if (node_pointers[numa_node]++ % partition_count_ != partition_) {
+          // another partition reads this head
+          ++partition_filtered_pointers;
+          continue;
         } else {
           ++added_pointers;
           uint16_t node_id = extract_numa_node_from_snapshot_pointer(pointer.page_id_);
@@ -264,7 +286,8 @@ ErrorCode SequentialCursor::init_states() {
 
     DVLOG(0) << "Read " << page_count << " root snapshot pages. added_pointers=" << added_pointers
       << ", too_old_pointers=" << too_old_pointers << ", too_new_pointers=" << too_new_pointers
-      << ", node_filtered_pointers=" << node_filtered_pointers;
+      << ", node_filtered_pointers=" << node_filtered_pointers
+      << ", partition_filtered_pointers=" << partition_filtered_pointers;
     if (added_pointers == 0) {
       finished_snapshots_ = true;
     }
@@ -284,6 +307,11 @@ ErrorCode SequentialCursor::init_states() {
       }
       NodeState& state = states_[node_id];
       for (uint16_t thread_ordinal = 0; thread_ordinal < thread_per_node; ++thread_ordinal) {
+        if (thread_ordinal % partition_count_ != partition_) {
+          // another partition reads this thread's pages
+          state.volatile_cur_pages_.push_back(nullptr);
+          continue;
+        }
         thread::ThreadId thread_id = thread::compose_thread_id(node_id, thread_ordinal);
         memory::PagePoolOffset offset = *pimpl.get_head_pointer(thread_id);
         if (offset == 0) {
@@ -337,11 +365,26 @@ ErrorCode SequentialCursor::next_batch_snapshot(
       }
     }
 
-    // okay, we have a page to return
+    // okay, we have a page to return unless its epochs are out of the range.
     ASSERT_ND(state.snapshot_cur_buffer_ < state.snapshot_buffered_pages_);
-    *out = SequentialRecordIterator(buffer_ + state.snapshot_cur_buffer_, from_epoch_, to_epoch_);
-    *found = true;
+    const SequentialRecordBatch* page = snapshot_pages_ + state.snapshot_cur_buffer_;
     ++state.snapshot_cur_buffer_;
+    if (page->get_record_count() == 0
+      || page->max_epoch_ < from_epoch_
+      || page->min_epoch_ >= to_epoch_) {
+      // Snapshot pages are sorted by epoch, so this skips most pages outside of the range
+      // without iterating over their records.
+      ++stat_skipped_pages_;
+      if (page->get_record_count() > 0 && page->min_epoch_ >= to_epoch_) {
+        // The rest of this head is even newer. Don't read them at all.
+        state.snapshot_buffer_begin_ = state.get_cur_head().page_count_
+          - state.snapshot_buffered_pages_;
+        state.snapshot_cur_buffer_ = state.snapshot_buffered_pages_;
+      }
+      continue;
+    }
+    *out = SequentialRecordIterator(page, from_epoch_, to_epoch_, predicate_);
+    *found = true;
     return kErrorCodeOk;
   }
 
@@ -392,8 +435,16 @@ ErrorCode SequentialCursor::buffer_snapshot_pages(uint16_t node) {
   // an issue considering that we are probably reading millions of pages.
   uint32_t new_begin = state.snapshot_buffer_begin_ + state.snapshot_cur_buffer_;
   SnapshotPagePointer page_id_begin = head.page_id_ + new_begin;
-  CHECK_ERROR_CODE(
-    context_->read_snapshot_pages(page_id_begin, to_read, reinterpret_cast<Page*>(buffer_)));
+  // If the snapshot file is mapped, we don't even have to copy.
+  const Page* mapped;
+  CHECK_ERROR_CODE(context_->get_mapped_snapshot_pages(page_id_begin, to_read, true, &mapped));
+  if (mapped) {
+    snapshot_pages_ = reinterpret_cast<const SequentialRecordBatch*>(mapped);
+  } else {
+    CHECK_ERROR_CODE(
+      context_->read_snapshot_pages(page_id_begin, to_read, reinterpret_cast<Page*>(buffer_)));
+    snapshot_pages_ = buffer_;
+  }
   state.snapshot_buffer_begin_ = new_begin;
   state.snapshot_cur_buffer_ = 0;
   state.snapshot_buffered_pages_ = to_read;
@@ -401,7 +452,7 @@ ErrorCode SequentialCursor::buffer_snapshot_pages(uint16_t node) {
 #ifndef NDEBUG
   // sanity checks
   for (uint32_t i = 0; i < to_read; ++i) {
-    const SequentialRecordBatch* p = buffer_ + i;
+    const SequentialRecordBatch* p = snapshot_pages_ + i;
     ASSERT_ND(p->header_.page_id_ == page_id_begin + i);
     ASSERT_ND(p->header_.snapshot_);
     ASSERT_ND(p->header_.get_page_type() == kSequentialPageType);
@@ -501,7 +552,8 @@ ErrorCode SequentialCursor::next_batch_safe_volatiles(
           *out = SequentialRecordIterator(
             reinterpret_cast<SequentialRecordBatch*>(page),
             from_epoch_volatile_,
-            to_epoch_);
+            to_epoch_,
+            predicate_);
           *found = true;
           return kErrorCodeOk;
         }
@@ -622,7 +674,8 @@ ErrorCode SequentialCursor::next_batch_unsafe_volatiles(
         *out = SequentialRecordIterator(
           reinterpret_cast<SequentialRecordBatch*>(page),
           from_epoch_volatile_,
-          to_epoch_);
+          to_epoch_,
+          predicate_);
         *found = true;
         return kErrorCodeOk;
       }
@@ -656,12 +709,15 @@ std::ostream& operator<<(std::ostream& o, const SequentialCursor& v) {
   o << "  <to_epoch>" << v.get_to_epoch() << "</to_epoch>" << std::endl;
   o << "  <order_mode>" << v.order_mode_ << "</order_mode>" << std::endl;
   o << "  <node_filter>" << v.node_filter_ << "</node_filter>" << std::endl;
+  o << "  <partition_>" << v.partition_ << "</partition_>" << std::endl;
+  o << "  <partition_count_>" << v.partition_count_ << "</partition_count_>" << std::endl;
   o << "  <snapshot_only_>" << v.snapshot_only_ << "</snapshot_only_>" << std::endl;
   o << "  <safe_epoch_only_>" << v.safe_epoch_only_ << "</safe_epoch_only_>" << std::endl;
   o << "  <buffer_>" << v.buffer_ << "</buffer_>" << std::endl;
   o << "  <buffer_size>" << v.buffer_size_ << "</buffer_size>" << std::endl;
   o << "  <buffer_pages_>" << v.buffer_pages_ << "</buffer_pages_>" << std::endl;
   o << "  <current_node_>" << v.current_node_ << "</current_node_>" << std::endl;
+  o << "  <stat_skipped_pages_>" << v.stat_skipped_pages_ << "</stat_skipped_pages_>" << std::endl;
   o << "  <finished_snapshots_>" << v.finished_snapshots_ << "</finished_snapshots_>" << std::endl;
   o << "  <finished_safe_volatiles_>" << v.finished_safe_volatiles_
     << "</finished_safe_volatiles_>" << std::endl;
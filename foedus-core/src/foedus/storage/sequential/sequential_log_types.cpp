@@ -66,6 +66,26 @@ std::ostream& operator<<(std::ostream& o, const SequentialTruncateLogType& v) {
   return o;
 }
 
+void SequentialConsumerGroupLogType::apply_storage(Engine* engine, StorageId storage_id) {
+  SequentialStorage seq(engine, storage_id);
+  seq.apply_consumer_group(*this);
+}
+
+void SequentialConsumerGroupLogType::assert_valid() {
+  ASSERT_ND(header_.log_length_ == sizeof(SequentialConsumerGroupLogType));
+  ASSERT_ND(header_.get_type() == log::get_log_code<SequentialConsumerGroupLogType>());
+  ASSERT_ND(group_ < kMaxConsumerGroups);
+}
+std::ostream& operator<<(std::ostream& o, const SequentialConsumerGroupLogType& v) {
+  o << "<SequentialConsumerGroupLog>"
+    << "<storage_id_>" << v.header_.storage_id_ << "</storage_id_>"
+    << "<group_>" << v.group_ << "</group_>"
+    << "<new_epoch_>" << v.new_epoch_ << "</new_epoch_>"
+    << "<new_truncate_epoch_>" << v.new_truncate_epoch_ << "</new_truncate_epoch_>"
+    << "</SequentialConsumerGroupLog>";
+  return o;
+}
+
 std::ostream& operator<<(std::ostream& o, const SequentialAppendLogType& v) {
   o << "<SequentialAppendLog>"
     << "<payload_count_>" << v.payload_count_ << "</payload_count_>";
@@ -20,6 +20,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "foedus/externalize/externalizable.hpp"
 
@@ -39,12 +40,26 @@ std::ostream& operator<<(std::ostream& o, const SequentialMetadata& v) {
 ErrorStack SequentialMetadataSerializer::load(tinyxml2::XMLElement* element) {
   CHECK_ERROR(load_base(element));
   CHECK_ERROR(get_element(element, "truncate_epoch_", &data_casted_->truncate_epoch_))
+  // optional, for snapshots taken before we versioned the page layout
+  CHECK_ERROR(get_element(element, "page_format_", &data_casted_->page_format_, true, 0U));
+  // optional, for snapshots taken before we had consumer groups
+  std::vector<Epoch::EpochInteger> consumer_epochs;
+  CHECK_ERROR(get_element(element, "consumer_epochs_", &consumer_epochs, true));
+  data_casted_->clear_consumer_groups();
+  for (uint16_t i = 0; i < consumer_epochs.size() && i < kMaxConsumerGroups; ++i) {
+    data_casted_->consumer_epochs_[i] = consumer_epochs[i];
+  }
   return kRetOk;
 }
 
 ErrorStack SequentialMetadataSerializer::save(tinyxml2::XMLElement* element) const {
   CHECK_ERROR(save_base(element));
   CHECK_ERROR(add_element(element, "truncate_epoch_", "", data_casted_->truncate_epoch_));
+  CHECK_ERROR(add_element(element, "page_format_", "", data_casted_->page_format_));
+  std::vector<Epoch::EpochInteger> consumer_epochs(
+    data_casted_->consumer_epochs_,
+    data_casted_->consumer_epochs_ + kMaxConsumerGroups);
+  CHECK_ERROR(add_element(element, "consumer_epochs_", "", consumer_epochs));
   return kRetOk;
 }
 
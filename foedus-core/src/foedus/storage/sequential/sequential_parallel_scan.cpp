@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/storage/sequential/sequential_parallel_scan.hpp"
+
+#include <glog/logging.h>
+
+#include <cstring>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/debugging/stop_watch.hpp"
+#include "foedus/thread/impersonate_session.hpp"
+#include "foedus/thread/thread_id.hpp"
+#include "foedus/thread/thread_pool.hpp"
+
+namespace foedus {
+namespace storage {
+namespace sequential {
+
+SequentialParallelScan::SequentialParallelScan(
+  Engine* engine,
+  const SequentialStorage& storage,
+  const proc::ProcName& proc_name)
+  : engine_(engine),
+    storage_(storage),
+    proc_name_(proc_name),
+    from_epoch_(INVALID_EPOCH),
+    to_epoch_(INVALID_EPOCH),
+    partition_count_(engine->get_options().thread_.thread_count_per_group_) {
+}
+
+ErrorStack SequentialParallelScan::run(
+  const void* user_input,
+  uint32_t user_input_len,
+  MergeFunction merge,
+  void* merge_user_data) {
+  const uint16_t node_count = engine_->get_soc_count();
+  const uint16_t thread_per_node = engine_->get_options().thread_.thread_count_per_group_;
+  if (partition_count_ == 0 || partition_count_ > thread_per_node) {
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  }
+  debugging::StopWatch stop_watch;
+
+  // Each worker receives a copy of this buffer. We just overwrite the header for each of them.
+  std::vector<char> input(sizeof(SequentialScanPartition) + user_input_len);
+  SequentialScanPartition* header = reinterpret_cast<SequentialScanPartition*>(&input[0]);
+  *header = SequentialScanPartition();
+  header->storage_id_ = storage_.get_id();
+  header->partition_count_ = partition_count_;
+  header->from_epoch_ = from_epoch_;
+  header->to_epoch_ = to_epoch_;
+  header->user_input_len_ = user_input_len;
+  if (user_input_len > 0) {
+    std::memcpy(header + 1, user_input, user_input_len);
+  }
+
+  const uint32_t total_partitions = static_cast<uint32_t>(node_count) * partition_count_;
+  std::vector<SequentialScanPartition> partitions(total_partitions);
+  std::vector<thread::ImpersonateSession> sessions(total_partitions);
+  thread::ThreadPool* pool = engine_->get_thread_pool();
+  ErrorStack result = kRetOk;
+  for (uint16_t node = 0; node < node_count && !result.is_error(); ++node) {
+    for (uint16_t partition = 0; partition < partition_count_; ++partition) {
+      header->node_ = node;
+      header->partition_ = partition;
+      uint32_t index = static_cast<uint32_t>(node) * partition_count_ + partition;
+      partitions[index] = *header;
+      // Prefer the thread that wrote the volatile pages of this partition.
+      thread::ThreadId core = thread::compose_thread_id(node, partition);
+      if (!pool->impersonate_on_numa_core(
+          core,
+          proc_name_,
+          &input[0],
+          input.size(),
+          &sessions[index])
+        && !pool->impersonate_on_numa_node(
+          node,
+          proc_name_,
+          &input[0],
+          input.size(),
+          &sessions[index])) {
+        LOG(ERROR) << "No idle thread for parallel scan on node-" << node
+          << ", partition-" << partition << " of sequential-" << storage_.get_id();
+        result = ERROR_STACK(kErrorCodeThrNoThreadAvailable);
+        break;
+      }
+    }
+  }
+
+  // Even on errors, wait for all launched workers. They might be using the user input.
+  for (uint32_t i = 0; i < total_partitions; ++i) {
+    if (!sessions[i].is_valid()) {
+      continue;
+    }
+    ErrorStack worker_result = sessions[i].get_result();
+    if (worker_result.is_error()) {
+      LOG(ERROR) << "Parallel scan on node-" << partitions[i].node_ << ", partition-"
+        << partitions[i].partition_ << " failed: " << worker_result;
+      if (!result.is_error()) {
+        result = worker_result;
+      }
+    } else if (merge && !result.is_error()) {
+      merge(
+        partitions[i],
+        sessions[i].get_raw_output_buffer(),
+        sessions[i].get_output_size(),
+        merge_user_data);
+    }
+  }
+
+  stop_watch.stop();
+  LOG(INFO) << "Parallel scan on sequential-" << storage_.get_id() << " with " << total_partitions
+    << " workers done in " << stop_watch.elapsed_ms() << "ms";
+  return result;
+}
+
+}  // namespace sequential
+}  // namespace storage
+}  // namespace foedus
@@ -81,6 +81,27 @@ ErrorStack SequentialStorage::truncate(Epoch new_truncate_epoch, Epoch* commit_e
 void SequentialStorage::apply_truncate(const SequentialTruncateLogType& the_log) {
   SequentialStoragePimpl(this).apply_truncate(the_log);
 }
+ErrorStack SequentialStorage::add_consumer_group(uint16_t group, Epoch* commit_epoch) {
+  return SequentialStoragePimpl(this).add_consumer_group(group, commit_epoch);
+}
+ErrorStack SequentialStorage::remove_consumer_group(uint16_t group, Epoch* commit_epoch) {
+  return SequentialStoragePimpl(this).remove_consumer_group(group, commit_epoch);
+}
+ErrorStack SequentialStorage::ack_consumer_group(
+  uint16_t group,
+  Epoch acked_epoch,
+  Epoch* commit_epoch) {
+  return SequentialStoragePimpl(this).ack_consumer_group(group, acked_epoch, commit_epoch);
+}
+Epoch SequentialStorage::get_consumer_group_epoch(uint16_t group) const {
+  if (group >= kMaxConsumerGroups) {
+    return INVALID_EPOCH;
+  }
+  return Epoch(control_block_->meta_.consumer_epochs_[group]);
+}
+void SequentialStorage::apply_consumer_group(const SequentialConsumerGroupLogType& the_log) {
+  SequentialStoragePimpl(this).apply_consumer_group(the_log);
+}
 
 
 std::ostream& operator<<(std::ostream& o, const SequentialStorage& v) {
@@ -35,6 +35,7 @@
 #include "foedus/memory/numa_core_memory.hpp"
 #include "foedus/memory/page_pool.hpp"
 #include "foedus/snapshot/snapshot.hpp"
+#include "foedus/soc/shared_mutex.hpp"
 #include "foedus/storage/record.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/storage_manager_pimpl.hpp"
@@ -151,6 +152,8 @@ ErrorStack SequentialStoragePimpl::create(const SequentialMetadata& metadata) {
   }
 
   control_block_->meta_ = metadata;
+  control_block_->meta_.clear_consumer_groups();  // use add_consumer_group()
+  control_block_->meta_.page_format_ = kSequentialPageFormat;
   const Epoch initial_truncate_epoch = engine_->get_earliest_epoch();
   control_block_->meta_.truncate_epoch_ = initial_truncate_epoch.value();
   control_block_->cur_truncate_epoch_.store(initial_truncate_epoch.value());
@@ -167,6 +170,15 @@ ErrorStack SequentialStoragePimpl::load(const StorageControlBlock& snapshot_bloc
   // for sequential storage, whether the snapshot root pointer is null or not doesn't matter.
   // essentially load==create, except that it just sets the snapshot root pointer.
   control_block_->meta_ = static_cast<const SequentialMetadata&>(snapshot_block.meta_);
+  if (control_block_->meta_.root_snapshot_page_id_ != 0
+    && control_block_->meta_.page_format_ != kSequentialPageFormat) {
+    LOG(ERROR) << "Sequential-storage " << get_name() << " has snapshot pages of layout version "
+      << control_block_->meta_.page_format_ << ", but this build reads version "
+      << kSequentialPageFormat;
+    return ERROR_STACK(kErrorCodeStrSequentialIncompatibleFormat);
+  }
+  // without snapshot pages nothing depends on the old layout. new pages use the current one.
+  control_block_->meta_.page_format_ = kSequentialPageFormat;
   Epoch initial_truncate_epoch(control_block_->meta_.truncate_epoch_);
   if (!initial_truncate_epoch.is_valid()) {
     initial_truncate_epoch = engine_->get_earliest_epoch();
@@ -291,25 +303,28 @@ ErrorStack SequentialStoragePimpl::truncate(Epoch new_truncate_epoch, Epoch* com
     }
 
     // Then, apply it. This also clears the being_written flag
-    {
-      xct::XctId xct_id;
-      xct_id.set(commit_epoch->value(), 1);  // no dependency, so minimal ordinal is always correct
-      control_block_->cur_truncate_epoch_.store(new_truncate_epoch.value());  // atomic!
-      control_block_->cur_truncate_epoch_tid_.xct_id_ = xct_id;
-      assorted::memory_fence_release();
-
-      // Also set to the metadata to make this permanent.
-      // The metadata will be written out in next snapshot.
-      // Until that, REDO-operation below will re-apply that after crash.
-      control_block_->meta_.truncate_epoch_ = new_truncate_epoch.value();
-      assorted::memory_fence_release();
-    }
+    install_truncate_epoch(new_truncate_epoch, *commit_epoch);
   }
 
   LOG(INFO) << "Truncated";
   return kRetOk;
 }
 
+void SequentialStoragePimpl::install_truncate_epoch(Epoch new_truncate_epoch, Epoch commit_epoch) {
+  ASSERT_ND(control_block_->cur_truncate_epoch_tid_.xct_id_.is_being_written());
+  xct::XctId xct_id;
+  xct_id.set(commit_epoch.value(), 1);  // no dependency, so minimal ordinal is always correct
+  control_block_->cur_truncate_epoch_.store(new_truncate_epoch.value());  // atomic!
+  control_block_->cur_truncate_epoch_tid_.xct_id_ = xct_id;
+  assorted::memory_fence_release();
+
+  // Also set to the metadata to make this permanent.
+  // The metadata will be written out in next snapshot.
+  // Until that, REDO-operation below will re-apply that after crash.
+  control_block_->meta_.truncate_epoch_ = new_truncate_epoch.value();
+  assorted::memory_fence_release();
+}
+
 void SequentialStoragePimpl::apply_truncate(const SequentialTruncateLogType& the_log) {
   // this method is called only during restart, so no race.
   ASSERT_ND(control_block_->exists());
@@ -320,6 +335,137 @@ void SequentialStoragePimpl::apply_truncate(const SequentialTruncateLogType& the
     << " epoch=" << control_block_->cur_truncate_epoch_;
 }
 
+ErrorStack SequentialStoragePimpl::add_consumer_group(uint16_t group, Epoch* commit_epoch) {
+  if (group >= kMaxConsumerGroups) {
+    LOG(ERROR) << "Consumer group ID out of range: " << group;
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  }
+  soc::SharedMutexScope scope(&control_block_->status_mutex_);
+  if (Epoch(control_block_->meta_.consumer_epochs_[group]).is_valid()) {
+    LOG(INFO) << "Consumer group-" << group << " is already used in " << get_name();
+    *commit_epoch = INVALID_EPOCH;
+    return kRetOk;
+  }
+  // The new group starts from the oldest record we still have.
+  const Epoch truncate_epoch(control_block_->cur_truncate_epoch_.load());
+  set_consumer_group_epoch(group, truncate_epoch, commit_epoch);
+  LOG(INFO) << "Added consumer group-" << group << " to " << get_name()
+    << " from epoch " << truncate_epoch;
+  return kRetOk;
+}
+
+ErrorStack SequentialStoragePimpl::remove_consumer_group(uint16_t group, Epoch* commit_epoch) {
+  if (group >= kMaxConsumerGroups) {
+    LOG(ERROR) << "Consumer group ID out of range: " << group;
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  }
+  {
+    soc::SharedMutexScope scope(&control_block_->status_mutex_);
+    if (!Epoch(control_block_->meta_.consumer_epochs_[group]).is_valid()) {
+      LOG(INFO) << "Consumer group-" << group << " is not used in " << get_name();
+      *commit_epoch = INVALID_EPOCH;
+      return kRetOk;
+    }
+    // The removed group might have been the slowest one. This truncates, too.
+    set_consumer_group_epoch(group, INVALID_EPOCH, commit_epoch);
+  }
+  LOG(INFO) << "Removed consumer group-" << group << " from " << get_name();
+  return kRetOk;
+}
+
+ErrorStack SequentialStoragePimpl::ack_consumer_group(
+  uint16_t group,
+  Epoch acked_epoch,
+  Epoch* commit_epoch) {
+  *commit_epoch = INVALID_EPOCH;
+  if (group >= kMaxConsumerGroups || !acked_epoch.is_valid()) {
+    LOG(ERROR) << "ack_consumer_group() was called with an invalid parameter. group=" << group
+      << ", acked_epoch=" << acked_epoch;
+    return ERROR_STACK(kErrorCodeInvalidParameter);
+  }
+  {
+    soc::SharedMutexScope scope(&control_block_->status_mutex_);
+    const Epoch cur_epoch(control_block_->meta_.consumer_epochs_[group]);
+    if (!cur_epoch.is_valid()) {
+      LOG(ERROR) << "Consumer group-" << group << " is not used in " << get_name();
+      return ERROR_STACK(kErrorCodeInvalidParameter);
+    } else if (acked_epoch <= cur_epoch) {
+      DVLOG(1) << "Consumer group-" << group << " already acked up to " << cur_epoch
+        << ". Requested = " << acked_epoch;
+      return kRetOk;
+    }
+    if (acked_epoch > engine_->get_current_global_epoch()) {
+      LOG(WARNING) << "Ohh? we don't prohibit it, but are you sure? Acknowledging up to a future"
+        << " epoch-" << acked_epoch << ". cur_global=" << engine_->get_current_global_epoch();
+    }
+    // Records that all groups acked are no longer needed. This truncates them, too.
+    set_consumer_group_epoch(group, acked_epoch, commit_epoch);
+  }
+  return kRetOk;
+}
+
+void SequentialStoragePimpl::set_consumer_group_epoch(
+  uint16_t group,
+  Epoch new_epoch,
+  Epoch* commit_epoch) {
+  ASSERT_ND(group < kMaxConsumerGroups);
+  // Records before the slowest group are no longer needed. Instead of another metadata
+  // operation by truncate(), we truncate them in the same log. Each metadata log advances
+  // the global epoch and waits for the logger, so it's worth saving one.
+  Epoch min_epoch = new_epoch;
+  for (uint16_t other = 0; other < kMaxConsumerGroups; ++other) {
+    const Epoch epoch(control_block_->meta_.consumer_epochs_[other]);
+    if (other != group && epoch.is_valid()) {
+      min_epoch.store_min(epoch);
+    }
+  }
+  Epoch new_truncate_epoch = INVALID_EPOCH;
+  if (min_epoch.is_valid() && min_epoch > Epoch(control_block_->cur_truncate_epoch_.load())) {
+    new_truncate_epoch = min_epoch;
+    LOG(INFO) << "Truncating " << get_name() << " upto Epoch " << new_truncate_epoch
+      << " consumed by all groups. old value=" << control_block_->cur_truncate_epoch_;
+    // Same as truncate(), let scanners know that something is happening.
+    control_block_->cur_truncate_epoch_tid_.xct_id_.set_being_written();
+    assorted::memory_fence_acq_rel();
+  }
+
+  // Log this operation as a metadata operation, same as truncate().
+  char log_buffer[sizeof(SequentialConsumerGroupLogType)];
+  std::memset(log_buffer, 0, sizeof(log_buffer));
+  SequentialConsumerGroupLogType* the_log
+    = reinterpret_cast<SequentialConsumerGroupLogType*>(log_buffer);
+  the_log->header_.storage_id_ = get_id();
+  the_log->header_.log_type_code_ = log::get_log_code<SequentialConsumerGroupLogType>();
+  the_log->header_.log_length_ = sizeof(SequentialConsumerGroupLogType);
+  the_log->group_ = group;
+  the_log->new_epoch_ = new_epoch;
+  the_log->new_truncate_epoch_ = new_truncate_epoch;
+  engine_->get_log_manager()->get_meta_buffer()->commit(the_log, commit_epoch);
+
+  // The metadata will be written out in next snapshot.
+  // Until that, REDO-operation below will re-apply that after crash.
+  control_block_->meta_.consumer_epochs_[group] = new_epoch.value();
+  assorted::memory_fence_release();
+  if (new_truncate_epoch.is_valid()) {
+    install_truncate_epoch(new_truncate_epoch, *commit_epoch);
+  }
+}
+
+void SequentialStoragePimpl::apply_consumer_group(const SequentialConsumerGroupLogType& the_log) {
+  // this method is called only during restart, so no race.
+  ASSERT_ND(control_block_->exists());
+  ASSERT_ND(the_log.group_ < kMaxConsumerGroups);
+  control_block_->meta_.consumer_epochs_[the_log.group_] = the_log.new_epoch_.value();
+  if (the_log.new_truncate_epoch_.is_valid()) {
+    control_block_->cur_truncate_epoch_tid_.xct_id_ = the_log.header_.xct_id_;
+    control_block_->cur_truncate_epoch_.store(the_log.new_truncate_epoch_.value());
+    control_block_->meta_.truncate_epoch_ = the_log.new_truncate_epoch_.value();
+  }
+  LOG(INFO) << "Applied redo-log of consumer group-" << the_log.group_ << " on sequential storage-"
+    << get_name() << " epoch=" << the_log.new_epoch_
+    << " truncate_epoch=" << the_log.new_truncate_epoch_;
+}
+
 void SequentialStoragePimpl::append_record(
   thread::Thread* context,
   xct::XctId owner_id,
@@ -17,8 +17,11 @@
  */
 #include "foedus/storage/storage.hpp"
 
+#include <ostream>
+
 #include "foedus/engine.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 
 namespace foedus {
 namespace storage {
@@ -30,5 +33,17 @@ StorageControlBlock* get_storage_control_block(Engine* engine, const StorageName
   return engine->get_storage_manager()->get_storage(name);
 }
 
+std::ostream& operator<<(std::ostream& o, const StorageStatistics& v) {
+  o << "<StorageStatistics>"
+    << "<record_count_estimate>" << v.get_record_count_estimate() << "</record_count_estimate>"
+    << "<snapshot_record_count_>" << v.snapshot_record_count_ << "</snapshot_record_count_>"
+    << "<inserted_records>" << v.get_inserted_records() << "</inserted_records>"
+    << "<deleted_records>" << v.get_deleted_records() << "</deleted_records>"
+    << "<snapshot_pages>" << v.get_snapshot_pages() << "</snapshot_pages>"
+    << "<last_snapshot_id>" << v.get_last_snapshot_id() << "</last_snapshot_id>"
+    << "</StorageStatistics>";
+  return o;
+}
+
 }  // namespace storage
 }  // namespace foedus
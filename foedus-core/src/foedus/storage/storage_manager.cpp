@@ -47,6 +47,9 @@ ErrorStack  StorageManager::uninitialize() { return pimpl_->uninitialize(); }
 StorageControlBlock* StorageManager::get_storage(StorageId id) {
   return pimpl_->get_storage(id);
 }
+const StorageStatistics& StorageManager::get_statistics(StorageId id) {
+  return pimpl_->get_storage(id)->stats_;
+}
 StorageControlBlock* StorageManager::get_storage(const StorageName& name) {
   return pimpl_->get_storage(name);
 }
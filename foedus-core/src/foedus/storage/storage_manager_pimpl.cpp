@@ -119,6 +119,7 @@ ErrorStack StorageManagerPimpl::initialize_read_latest_snapshot() {
       ASSERT_ND(!snapshot_block.meta_.name_.empty());
       ASSERT_ND(!exists(snapshot_block.meta_.name_));
       block->initialize();
+      block->stats_.snapshot_record_count_ = snapshot_block.stats_.snapshot_record_count_;
       block->root_page_pointer_.snapshot_pointer_ = snapshot_block.meta_.root_snapshot_page_id_;
       block->root_page_pointer_.volatile_pointer_.clear();
 
@@ -22,11 +22,17 @@ StorageOptions::StorageOptions() {
   max_storages_ = kDefaultMaxStorages;
   partitioner_data_memory_mb_ = kDefaultPartitionerDataMemoryMb;
   hot_threshold_ = kDefaultHotThreshold;
+  masstree_descent_hint_ = true;
+  hash_bin_hint_ = true;
+  record_statistics_ = false;
 }
 ErrorStack StorageOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, max_storages_);
   EXTERNALIZE_LOAD_ELEMENT(element, partitioner_data_memory_mb_);
   EXTERNALIZE_LOAD_ELEMENT(element, hot_threshold_);
+  EXTERNALIZE_LOAD_ELEMENT(element, masstree_descent_hint_);
+  EXTERNALIZE_LOAD_ELEMENT(element, hash_bin_hint_);
+  EXTERNALIZE_LOAD_ELEMENT(element, record_statistics_);
   return kRetOk;
 }
 ErrorStack StorageOptions::save(tinyxml2::XMLElement* element) const {
@@ -39,6 +45,15 @@ ErrorStack StorageOptions::save(tinyxml2::XMLElement* element) const {
     " information (eg. long keys).");
   EXTERNALIZE_SAVE_ELEMENT(element, hot_threshold_,
     "Hot record threshold; for HCC only.");
+  EXTERNALIZE_SAVE_ELEMENT(element, masstree_descent_hint_,
+    "Whether each thread remembers its last descent in masstree storages and starts the next"
+    " lookup from the deepest remembered page that still covers the key.");
+  EXTERNALIZE_SAVE_ELEMENT(element, hash_bin_hint_,
+    "Whether each thread caches volatile bin-head pages of hash storages it recently visited.");
+  EXTERNALIZE_SAVE_ELEMENT(element, record_statistics_,
+    "Whether transactions count the records they insert/delete in storage statistics."
+    " This costs a shared counter update per inserted/deleted record at commit."
+    " Record counts as of the latest snapshot are maintained regardless of this option.");
   return kRetOk;
 }
 }  // namespace storage
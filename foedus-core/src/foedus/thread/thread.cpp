@@ -73,6 +73,25 @@ void Thread::reset_snapshot_cache_counts() const {
 }
 
 xct::Xct&   Thread::get_current_xct()   { return pimpl_->current_xct_; }
+storage::masstree::MasstreeDescentPath* Thread::get_masstree_descent_path(
+  storage::StorageId id) {
+  if (pimpl_->masstree_descent_hint_) {
+    return pimpl_->masstree_descent_paths_
+      + (id % storage::masstree::MasstreeDescentPath::kSlotsPerThread);
+  } else {
+    return nullptr;
+  }
+}
+storage::hash::HashBinHints* Thread::get_hash_bin_hints() {
+  if (pimpl_->hash_bin_hint_) {
+    return &pimpl_->hash_bin_hints_;
+  } else {
+    return nullptr;
+  }
+}
+xct::PreviousVersionTable* Thread::get_previous_version_table(ThreadGroupId node) {
+  return pimpl_->previous_version_tables_ + node;
+}
 bool        Thread::is_running_xct()    const { return pimpl_->current_xct_.is_active(); }
 
 log::ThreadLogBuffer& Thread::get_thread_log_buffer() { return pimpl_->log_buffer_; }
@@ -92,6 +111,13 @@ ErrorCode Thread::read_snapshot_pages(
   storage::Page* buffer) {
   return pimpl_->read_snapshot_pages(page_id_begin, page_count, buffer);
 }
+ErrorCode Thread::get_mapped_snapshot_pages(
+  storage::SnapshotPagePointer page_id_begin,
+  uint32_t page_count,
+  bool sequential,
+  const storage::Page** out) {
+  return pimpl_->snapshot_file_set_.get_mapped_pages(page_id_begin, page_count, sequential, out);
+}
 ErrorCode Thread::find_or_read_a_snapshot_page(
   storage::SnapshotPagePointer page_id,
   storage::Page** out) {
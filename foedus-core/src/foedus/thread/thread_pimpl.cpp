@@ -44,6 +44,7 @@
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
 #include "foedus/thread/thread_pool_pimpl.hpp"
+#include "foedus/xct/retrospective_lock_list.hpp"
 #include "foedus/xct/sysxct_functor.hpp"
 #include "foedus/xct/sysxct_impl.hpp"
 #include "foedus/xct/xct_id.hpp"
@@ -94,8 +95,35 @@ ErrorStack ThreadPimpl::initialize_once() {
 
   auto mcs_type = engine_->get_options().xct_.mcs_implementation_type_;
   ASSERT_ND(mcs_type == xct::XctOptions::kMcsImplementationTypeSimple
-    || mcs_type == xct::XctOptions::kMcsImplementationTypeExtended);
-  simple_mcs_rw_ = mcs_type == xct::XctOptions::kMcsImplementationTypeSimple;
+    || mcs_type == xct::XctOptions::kMcsImplementationTypeExtended
+    || mcs_type == xct::XctOptions::kMcsImplementationTypeSimpleCohort);
+  simple_mcs_rw_ = mcs_type != xct::XctOptions::kMcsImplementationTypeExtended;
+  if (mcs_type == xct::XctOptions::kMcsImplementationTypeSimpleCohort) {
+    mcs_cohort_bypass_bound_ = engine_->get_options().xct_.mcs_cohort_bypass_bound_;
+    ASSERT_ND(mcs_cohort_bypass_bound_ > 0);
+  } else {
+    mcs_cohort_bypass_bound_ = 0;
+  }
+  if (simple_mcs_rw_) {
+    mcs_reader_bias_threshold_ = engine_->get_options().xct_.hot_threshold_for_reader_biased_locks_;
+  } else {
+    mcs_reader_bias_threshold_ = xct::XctOptions::kDefaultHotThresholdForReaderBiasedLocks;
+  }
+  masstree_descent_hint_ = engine_->get_options().storage_.masstree_descent_hint_;
+  for (uint16_t i = 0; i < storage::masstree::MasstreeDescentPath::kSlotsPerThread; ++i) {
+    masstree_descent_paths_[i].clear();
+  }
+  hash_bin_hint_ = engine_->get_options().storage_.hash_bin_hint_;
+  hash_bin_hints_.clear();
+  numa_node_count_ = engine_->get_options().thread_.group_count_;
+  threads_per_node_ = engine_->get_options().thread_.thread_count_per_group_;
+  const uint32_t previous_versions = engine_->get_options().xct_.previous_version_entries_per_node_;
+  for (uint16_t node = 0; node < numa_node_count_; ++node) {
+    soc::NodeMemoryAnchors* anchors
+      = engine_->get_soc_manager()->get_shared_memory_repo()->get_node_memory_anchors(node);
+    mcs_reader_indicators_[node] = anchors->mcs_reader_indicator_memory_;
+    previous_version_tables_[node].init(anchors->previous_version_memory_, previous_versions);
+  }
   node_memory_ = engine_->get_memory_manager()->get_local_memory();
   core_memory_ = node_memory_->get_core_memory(id_);
   if (engine_->get_options().cache_.snapshot_cache_enabled_) {
@@ -107,7 +135,8 @@ ErrorStack ThreadPimpl::initialize_once() {
   current_xct_.initialize(
     core_memory_,
     &control_block_->mcs_block_current_,
-    &control_block_->mcs_rw_async_mapping_current_);
+    &control_block_->mcs_rw_async_mapping_current_,
+    &control_block_->xct_timestamp_);
   CHECK_ERROR(snapshot_file_set_.initialize());
   CHECK_ERROR(log_buffer_.initialize());
   global_volatile_page_resolver_
@@ -198,6 +227,9 @@ void ThreadPimpl::handle_tasks() {
 
       const proc::ProcName& proc_name = control_block_->proc_name_;
       VLOG(0) << "Thread-" << id_ << " retrieved a task: " << proc_name;
+      // Learned lock lists are per procedure unless the procedure says otherwise.
+      current_xct_.set_rll_profile(
+        xct::LearnedLockListCache::to_profile(proc_name.data(), proc_name.length()));
       proc::Proc proc = nullptr;
       ErrorStack result = engine_->get_proc_manager()->get_proc(proc_name, &proc);
       if (result.is_error()) {
@@ -668,6 +700,16 @@ ErrorCode ThreadPimpl::find_or_read_a_snapshot_page(
     *out = snapshot_page_pool_->get_base() + offset;
   } else {
     ASSERT_ND(!engine_->get_options().cache_.snapshot_cache_enabled_);
+    if (snapshot_file_set_.is_mmap_enabled()) {
+      // Zero-copy. snapshot pages are immutable, so we can directly expose the mapped page.
+      // The mapping is private and writable, so the const_cast is safe just like a cached page.
+      const storage::Page* mapped;
+      CHECK_ERROR_CODE(snapshot_file_set_.get_mapped_pages(page_id, 1, false, &mapped));
+      if (mapped) {
+        *out = const_cast<storage::Page*>(mapped);
+        return kErrorCodeOk;
+      }
+    }
     // Snapshot is disabled. So far this happens only in performance experiments.
     // We use local work memory in this case.
     CHECK_ERROR_CODE(current_xct_.acquire_local_work_memory(
@@ -727,11 +769,11 @@ ErrorCode ThreadPimpl::find_or_read_snapshot_pages_batch(
   } else {
     ASSERT_ND(!engine_->get_options().cache_.snapshot_cache_enabled_);
     for (uint16_t b = 0; b < batch_size; ++b) {
-      CHECK_ERROR_CODE(current_xct_.acquire_local_work_memory(
-        storage::kPageSize,
-        reinterpret_cast<void**>(out + b),
-        storage::kPageSize));
-      CHECK_ERROR_CODE(read_a_snapshot_page(page_ids[b], out[b]));
+      if (page_ids[b] == 0) {
+        out[b] = nullptr;
+        continue;
+      }
+      CHECK_ERROR_CODE(find_or_read_a_snapshot_page(page_ids[b], out + b));
     }
   }
   return kErrorCodeOk;
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include "foedus/xct/previous_version_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "foedus/assert_nd.hpp"
+#include "foedus/assorted/atomic_fences.hpp"
+#include "foedus/assorted/raw_atomics.hpp"
+
+namespace foedus {
+namespace xct {
+
+void PreviousVersionTable::init(PreviousVersion* entries, uint32_t entry_count) {
+  entries_ = entries;
+  if (entries == nullptr) {
+    bucket_count_ = 0;
+  } else {
+    bucket_count_ = entry_count / kWays;
+  }
+}
+
+uint64_t PreviousVersionTable::calculate_memory_size(uint32_t entry_count) {
+  uint64_t bytes = static_cast<uint64_t>(entry_count / kWays) * kWays * PreviousVersion::kSize;
+  return (bytes + (1ULL << 12) - 1ULL) & (~((1ULL << 12) - 1ULL));
+}
+
+inline PreviousVersion* PreviousVersionTable::get_bucket(UniversalLockId lock_id) const {
+  ASSERT_ND(is_enabled());
+  // Records are at least 16 bytes apart. Scramble them so that adjacent records spread.
+  uint64_t hashed = (lock_id >> 4) * 0x9E3779B97F4A7C15ULL;
+  return entries_ + (hashed >> 32) % bucket_count_ * kWays;
+}
+
+void PreviousVersionTable::save(
+  UniversalLockId lock_id,
+  XctId old_id,
+  Epoch new_epoch,
+  const char* payload,
+  uint16_t payload_size) {
+  ASSERT_ND(lock_id != kNullUniversalLockId);
+  PreviousVersion* bucket = get_bucket(lock_id);
+  // Evict the entry for the oldest epoch. Empty entries have 0, the oldest.
+  // This is just a heuristic. Racy reads are fine.
+  PreviousVersion* victim = bucket;
+  for (uint16_t i = 1; i < kWays; ++i) {
+    if (Epoch(bucket[i].new_epoch_) < Epoch(victim->new_epoch_)
+      || !Epoch(bucket[i].new_epoch_).is_valid()) {
+      victim = bucket + i;
+    }
+  }
+
+  uint64_t seq = victim->seq_;
+  if ((seq & 1U) != 0
+    || !assorted::raw_atomic_compare_exchange_strong<uint64_t>(&victim->seq_, &seq, seq + 1U)) {
+    // Someone else is writing it. Just give up. Readers will abort in the worst case.
+    return;
+  }
+  assorted::memory_fence_release();
+  victim->lock_id_ = lock_id;
+  victim->old_id_ = old_id;
+  victim->new_epoch_ = new_epoch.value();
+  uint16_t size = std::min<uint16_t>(payload_size, PreviousVersion::kPayloadSize);
+  victim->payload_size_ = size;
+  std::memcpy(victim->payload_, payload, size);
+  assorted::atomic_store_release<uint64_t>(&victim->seq_, seq + 2U);
+}
+
+bool PreviousVersionTable::load(
+  UniversalLockId lock_id,
+  Epoch consistent_epoch,
+  uint16_t payload_offset,
+  uint16_t payload_count,
+  void* payload,
+  XctId* old_id) const {
+  ASSERT_ND(lock_id != kNullUniversalLockId);
+  const PreviousVersion* bucket = get_bucket(lock_id);
+  for (uint16_t i = 0; i < kWays; ++i) {
+    const PreviousVersion* entry = bucket + i;
+    while (true) {
+      uint64_t seq = assorted::atomic_load_acquire<uint64_t>(&entry->seq_);
+      if ((seq & 1U) != 0) {
+        continue;  // being written. This is short.
+      }
+      if (entry->lock_id_ != lock_id
+        || entry->old_id_.get_epoch() > consistent_epoch
+        || Epoch(entry->new_epoch_) <= consistent_epoch
+        || payload_offset + payload_count > entry->payload_size_) {
+        assorted::memory_fence_acquire();
+        if (entry->seq_ == seq) {
+          break;  // not this one
+        }
+        continue;
+      }
+      XctId observed = entry->old_id_;
+      std::memcpy(payload, entry->payload_ + payload_offset, payload_count);
+      assorted::memory_fence_acquire();
+      if (entry->seq_ == seq) {
+        *old_id = observed;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace xct
+}  // namespace foedus
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <cstring>
 
+#include "foedus/assorted/crc32c.hpp"
 #include "foedus/memory/page_resolver.hpp"
 #include "foedus/storage/page.hpp"
 #include "foedus/thread/thread.hpp"
@@ -76,6 +77,7 @@ void RetrospectiveLockList::uninit() {
 CurrentLockList::CurrentLockList() {
   array_ = nullptr;
   capacity_ = 0;
+  wait_die_ = false;
   clear_entries();
 }
 
@@ -330,6 +332,29 @@ void RetrospectiveLockList::construct(thread::Thread* context, uint32_t read_loc
   assert_sorted();
 }
 
+void RetrospectiveLockList::construct_from_learned(
+  const LearnedLockEntry* entries,
+  uint32_t count,
+  uint16_t min_confidence,
+  Epoch min_epoch) {
+  ASSERT_ND(capacity_ > count);
+  last_active_entry_ = kLockListPositionInvalid;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (entries[i].confidence_ < min_confidence
+      || (min_epoch.is_valid() && Epoch(entries[i].learned_epoch_) < min_epoch)) {
+      continue;
+    }
+    ASSERT_ND(i == 0 || entries[i - 1U].universal_lock_id_ < entries[i].universal_lock_id_);
+    auto pos = issue_new_position();
+    array_[pos].set(
+      entries[i].universal_lock_id_,
+      from_universal_lock_id(volatile_page_resolver_, entries[i].universal_lock_id_),
+      entries[i].preferred_mode_,
+      kNoLock);
+  }
+  assert_sorted();
+}
+
 void CurrentLockList::batch_insert_write_placeholders(
   const WriteXctAccess* write_set,
   uint32_t write_set_size) {
@@ -484,5 +509,231 @@ void CurrentLockList::giveup_all_after_debuglog(
     << " " << already_enough_locks << " already had enough lock mode";
 }
 
+////////////////////////////////////////////////////////////
+/// Learned lock lists
+////////////////////////////////////////////////////////////
+LearnedLockListCache::LearnedLockListCache() {
+  profiles_ = nullptr;
+  profile_count_ = 0;
+  entries_per_profile_ = 0;
+  use_clock_ = 0;
+}
+
+uint64_t LearnedLockListCache::to_profile(const void* name, uint16_t length) {
+  uint64_t key = assorted::crc32c(name, length);
+  return key != 0 ? key : 1U;
+}
+
+uint64_t LearnedLockListCache::calculate_memory_size(
+  uint16_t profiles,
+  uint16_t entries_per_profile) {
+  return sizeof(Profile) * profiles
+    + sizeof(LearnedLockEntry) * profiles * entries_per_profile;
+}
+
+void LearnedLockListCache::init(void* memory, uint16_t profiles, uint16_t entries_per_profile) {
+  profiles_ = reinterpret_cast<Profile*>(memory);
+  profile_count_ = entries_per_profile > 0 ? profiles : 0;
+  entries_per_profile_ = entries_per_profile;
+  LearnedLockEntry* entries = reinterpret_cast<LearnedLockEntry*>(profiles_ + profiles);
+  for (uint16_t i = 0; i < profile_count_; ++i) {
+    profiles_[i].entries_ = entries + static_cast<uint64_t>(i) * entries_per_profile;
+  }
+  clear();
+}
+
+void LearnedLockListCache::clear() {
+  use_clock_ = 0;
+  for (uint16_t i = 0; i < profile_count_; ++i) {
+    profiles_[i].key_ = 0;
+    profiles_[i].last_used_ = 0;
+    profiles_[i].pause_generation_ = 0;
+    profiles_[i].entry_count_ = 0;
+  }
+}
+
+LearnedLockEntry* LearnedLockListCache::search(
+  LearnedLockEntry* entries,
+  uint32_t count,
+  UniversalLockId id) {
+  LearnedLockEntry* entry = std::lower_bound(
+    entries,
+    entries + count,
+    id,
+    LearnedLockEntry::LessThan());
+  if (entry != entries + count && entry->universal_lock_id_ == id) {
+    return entry;
+  }
+  return nullptr;
+}
+
+LearnedLockListCache::Profile* LearnedLockListCache::find(uint64_t key) const {
+  ASSERT_ND(key != 0);
+  for (uint16_t i = 0; i < profile_count_; ++i) {
+    if (profiles_[i].key_ == key) {
+      return profiles_ + i;
+    }
+  }
+  return nullptr;
+}
+
+LearnedLockListCache::Profile* LearnedLockListCache::find_or_recycle(
+  uint64_t key,
+  uint64_t pause_generation) {
+  Profile* profile = find(key);
+  if (profile == nullptr) {
+    // Recycle an unused or the least recently used one
+    profile = profiles_;
+    for (uint16_t i = 1; i < profile_count_ && profile->key_ != 0; ++i) {
+      if (profiles_[i].key_ == 0 || profiles_[i].last_used_ < profile->last_used_) {
+        profile = profiles_ + i;
+      }
+    }
+    DVLOG(1) << "Recycled a learned lock list profile " << profile->key_ << " for " << key;
+    profile->key_ = key;
+    profile->entry_count_ = 0;
+  } else if (profile->pause_generation_ != pause_generation) {
+    // Volatile pages might have been dropped since then.
+    profile->entry_count_ = 0;
+  }
+  profile->pause_generation_ = pause_generation;
+  profile->last_used_ = ++use_clock_;
+  return profile;
+}
+
+uint32_t LearnedLockListCache::get_entry_count(uint64_t key) const {
+  Profile* profile = find(key);
+  return profile ? profile->entry_count_ : 0;
+}
+
+bool LearnedLockListCache::apply(
+  uint64_t key,
+  uint64_t pause_generation,
+  Epoch current_epoch,
+  RetrospectiveLockList* rll) {
+  ASSERT_ND(rll->is_empty());
+  if (!is_enabled()) {
+    return false;
+  }
+  Profile* profile = find(key);
+  if (profile == nullptr
+    || profile->entry_count_ == 0
+    || profile->pause_generation_ != pause_generation) {
+    return false;
+  }
+  profile->last_used_ = ++use_clock_;
+  // Pages of entries learned before the grace epoch might have been recycled.
+  rll->construct_from_learned(
+    profile->entries_,
+    profile->entry_count_,
+    kMinConfidenceToApply,
+    current_epoch.one_less());
+  DVLOG(1) << "Applied " << rll->get_last_active_entry() << " learned locks for " << key;
+  return !rll->is_empty();
+}
+
+void LearnedLockListCache::learn_from_abort(
+  uint64_t key,
+  uint64_t pause_generation,
+  Epoch begin_epoch,
+  const RetrospectiveLockList& rll) {
+  ASSERT_ND(begin_epoch.is_valid());
+  if (!is_enabled() || rll.is_empty()) {
+    return;
+  }
+  Profile* profile = find_or_recycle(key, pause_generation);
+  LearnedLockEntry* entries = profile->entries_;
+
+  // Remove expired entries first to make room. This keeps the order.
+  const Epoch min_epoch = begin_epoch.one_less();
+  uint32_t sorted_count = 0;
+  for (uint32_t i = 0; i < profile->entry_count_; ++i) {
+    if (Epoch(entries[i].learned_epoch_) >= min_epoch) {
+      entries[sorted_count] = entries[i];
+      ++sorted_count;
+    }
+  }
+  profile->entry_count_ = sorted_count;
+
+  for (const LockEntry* it = rll.cbegin(); it != rll.cend(); ++it) {
+    LearnedLockEntry* existing = search(entries, sorted_count, it->universal_lock_id_);
+    if (existing) {
+      existing->confidence_ = std::min<uint16_t>(
+        existing->confidence_ + kConfidenceIncrement,
+        kMaxConfidence);
+      if (existing->preferred_mode_ < it->preferred_mode_) {
+        existing->preferred_mode_ = it->preferred_mode_;
+      }
+      if (Epoch(existing->learned_epoch_) < begin_epoch) {
+        existing->learned_epoch_ = begin_epoch.value();
+      }
+    } else if (profile->entry_count_ < entries_per_profile_) {
+      // Append for now, and sort later. RLL is distinct, so no duplicates in the appended part.
+      LearnedLockEntry* entry = entries + profile->entry_count_;
+      ++profile->entry_count_;
+      entry->universal_lock_id_ = it->universal_lock_id_;
+      entry->learned_epoch_ = begin_epoch.value();
+      entry->preferred_mode_ = it->preferred_mode_;
+      entry->confidence_ = kConfidenceIncrement;
+    }
+    // Otherwise the profile is full. We let aging make room.
+  }
+  if (profile->entry_count_ > sorted_count) {
+    std::sort(entries, entries + profile->entry_count_);
+  }
+}
+
+void LearnedLockListCache::learn_from_commit(uint64_t key, Xct* xct) {
+  if (!is_enabled()) {
+    return;
+  }
+  Profile* profile = find(key);
+  if (profile == nullptr || profile->entry_count_ == 0) {
+    return;
+  }
+  profile->last_used_ = ++use_clock_;
+  LearnedLockEntry* entries = profile->entries_;
+  const uint32_t count = profile->entry_count_;
+  // Temporarily mark accessed entries with this bit, which confidence_ never uses otherwise.
+  const uint16_t kAccessedBit = 1U << 15;
+  const ReadXctAccess* read_set = xct->get_read_set();
+  for (uint32_t i = 0; i < xct->get_read_set_size(); ++i) {
+    LearnedLockEntry* entry = search(entries, count, read_set[i].owner_lock_id_);
+    if (entry) {
+      entry->confidence_ |= kAccessedBit;
+    }
+  }
+  const WriteXctAccess* write_set = xct->get_write_set();
+  for (uint32_t i = 0; i < xct->get_write_set_size(); ++i) {
+    LearnedLockEntry* entry = search(entries, count, write_set[i].owner_lock_id_);
+    if (entry) {
+      entry->confidence_ |= kAccessedBit;
+    }
+  }
+
+  // We have just accessed the records, so their pages are alive as of our begin epoch.
+  const Epoch begin_epoch = xct->get_begin_epoch();
+  ASSERT_ND(begin_epoch.is_valid());
+  uint32_t new_count = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    LearnedLockEntry entry = entries[i];
+    if (entry.confidence_ & kAccessedBit) {
+      entry.confidence_ &= ~kAccessedBit;
+      if (Epoch(entry.learned_epoch_) < begin_epoch) {
+        entry.learned_epoch_ = begin_epoch.value();
+      }
+    } else {
+      --entry.confidence_;
+      if (entry.confidence_ == 0) {
+        continue;
+      }
+    }
+    entries[new_count] = entry;
+    ++new_count;
+  }
+  DVLOG(1) << "Removed " << (count - new_count) << " learned locks for " << key;
+  profile->entry_count_ = new_count;
+}
+
 }  // namespace xct
 }  // namespace foedus
@@ -49,12 +49,15 @@ Xct::Xct(Engine* engine, thread::Thread* context, thread::ThreadId thread_id)
   hot_threshold_for_this_xct_ = default_hot_threshold_for_this_xct_;
   default_rll_threshold_for_this_xct_ = XctOptions::kDefaultHotThreshold;
   rll_threshold_for_this_xct_ = default_rll_threshold_for_this_xct_;
+  rll_profile_ = 0;
 
   sysxct_workspace_ = nullptr;
 
   read_set_ = nullptr;
   read_set_size_ = 0;
   max_read_set_size_ = 0;
+  early_validated_read_set_size_ = 0;
+  early_validation_interval_ = 0;
   write_set_ = nullptr;
   write_set_size_ = 0;
   max_write_set_size_ = 0;
@@ -69,6 +72,8 @@ Xct::Xct(Engine* engine, thread::Thread* context, thread::ThreadId thread_id)
   isolation_level_ = kSerializable;
   mcs_block_current_ = nullptr;
   mcs_rw_async_mapping_current_ = nullptr;
+  xct_timestamp_ = nullptr;
+  retrying_ = false;
   local_work_memory_ = nullptr;
   local_work_memory_size_ = 0;
   local_work_memory_cur_ = 0;
@@ -77,7 +82,8 @@ Xct::Xct(Engine* engine, thread::Thread* context, thread::ThreadId thread_id)
 void Xct::initialize(
   memory::NumaCoreMemory* core_memory,
   uint32_t* mcs_block_current,
-  uint32_t* mcs_rw_async_mapping_current) {
+  uint32_t* mcs_rw_async_mapping_current,
+  uint64_t* xct_timestamp) {
   id_.set_epoch(engine_->get_savepoint_manager()->get_initial_current_epoch());
   id_.set_ordinal(0);  // ordinal 0 is possible only as a dummy "latest" XctId
   ASSERT_ND(id_.is_valid());
@@ -97,6 +103,8 @@ void Xct::initialize(
   read_set_ = reinterpret_cast<ReadXctAccess*>(pieces.xct_read_access_memory_);
   read_set_size_ = 0;
   max_read_set_size_ = xct_opt.max_read_set_size_;
+  early_validated_read_set_size_ = 0;
+  early_validation_interval_ = xct_opt.early_validation_interval_;
   write_set_ = reinterpret_cast<WriteXctAccess*>(pieces.xct_write_access_memory_);
   write_set_size_ = 0;
   max_write_set_size_ = xct_opt.max_write_set_size_;
@@ -116,6 +124,9 @@ void Xct::initialize(
   *mcs_block_current_ = 0;
   mcs_rw_async_mapping_current_ = mcs_rw_async_mapping_current;
   *mcs_rw_async_mapping_current_ = 0;
+  xct_timestamp_ = xct_timestamp;
+  *xct_timestamp_ = 0;
+  retrying_ = false;
   local_work_memory_ = core_memory->get_local_work_memory();
   local_work_memory_size_ = core_memory->get_local_work_memory_size();
   local_work_memory_cur_ = 0;
@@ -125,10 +136,15 @@ void Xct::initialize(
     core_memory->get_current_lock_list_memory(),
     core_memory->get_current_lock_list_capacity(),
     engine_->get_memory_manager()->get_global_volatile_page_resolver());
+  current_lock_list_.set_wait_die(xct_opt.enable_non_canonical_wait_die_);
   retrospective_lock_list_.init(
     core_memory->get_retrospective_lock_list_memory(),
     core_memory->get_retrospective_lock_list_capacity(),
     engine_->get_memory_manager()->get_global_volatile_page_resolver());
+  learned_lock_lists_.init(
+    core_memory->get_learned_lock_list_memory(),
+    xct_opt.learned_lock_list_profiles_,
+    xct_opt.learned_lock_list_entries_);
 }
 
 void Xct::issue_next_id(XctId max_xct_id, Epoch *epoch)  {
@@ -274,15 +290,31 @@ ErrorCode Xct::on_record_read(
     // No read-set, lock, or check for being_written flag needed.
     *observed_xid = tid_address->xct_id_;
     ASSERT_ND(!observed_xid->is_being_written());
+    if (UNLIKELY(isolation_level_ == kEpochConsistent && !is_epoch_consistent(*observed_xid))) {
+      // The snapshot is newer than the consistent epoch. This rarely happens.
+      return kErrorCodeXctRaceAbort;
+    }
     return kErrorCodeOk;
   } else if (isolation_level_ != kSerializable) {
     // No read-set or read-locks needed in non-serializable transactions.
     // Also no point to conservatively take write-locks recommended by RLL
     // because we don't take any read locks in these modes, so the
     // original SILO's write-lock protocol is enough and abort-free.
-    ASSERT_ND(isolation_level_ == kDirtyRead || isolation_level_ == kSnapshot);
+    ASSERT_ND(isolation_level_ == kDirtyRead
+      || isolation_level_ == kSnapshot
+      || isolation_level_ == kEpochConsistent);
     *observed_xid = tid_address->xct_id_.spin_while_being_written();
     ASSERT_ND(!observed_xid->is_being_written());
+    if (isolation_level_ == kEpochConsistent
+      && !observed_xid->is_moved()
+      && !observed_xid->is_next_layer()
+      && !is_epoch_consistent(*observed_xid)) {
+      // Updated after the consistent epoch. The caller does not know the previous image.
+      // Storages that save previous versions (array) don't come here for such records.
+      DVLOG(1) << "Epoch-consistent read missed the previous version. consistent_epoch="
+        << consistent_epoch_ << ", observed=" << *observed_xid;
+      return kErrorCodeXctRaceAbort;
+    }
     return kErrorCodeOk;
   }
 
@@ -328,6 +360,31 @@ ErrorCode Xct::on_record_read(
     tid_address,
     read_set_address));
 
+  if (UNLIKELY(should_validate_early(early_validation_interval_))) {
+    CHECK_ERROR_CODE(validate_read_set_early());
+  }
+  return kErrorCodeOk;
+}
+
+ErrorCode Xct::validate_read_set_early() {
+  if (isolation_level_ != kSerializable) {
+    return kErrorCodeOk;
+  }
+
+  // Unlike precommit, we don't hold locks here. Whatever we see is just a hint, so we don't
+  // prefetch or sort anything either.
+  early_validated_read_set_size_ = read_set_size_;
+  for (uint32_t i = 0; i < read_set_size_; ++i) {
+    const ReadXctAccess& access = read_set_[i];
+    if (access.owner_id_address_->needs_track_moved()) {
+      // Tracking moved records is not cheap. Precommit does it.
+      continue;
+    }
+    if (access.observed_owner_id_ != access.owner_id_address_->xct_id_) {
+      DVLOG(1) << *context_ << " read set changed by other transaction. early abort";
+      return kErrorCodeXctRaceAbort;
+    }
+  }
   return kErrorCodeOk;
 }
 
@@ -549,8 +606,10 @@ ErrorCode Xct::add_to_lock_free_read_set(
 }
 
 ErrorCode Xct::add_to_lock_free_write_set(
-    storage::StorageId storage_id,
-  log::RecordLogType* log_entry) {
+  storage::StorageId storage_id,
+  log::RecordLogType* log_entry,
+  char* payload_address,
+  RwLockableXctId* owner_id_address) {
   ASSERT_ND(storage_id != 0);
   ASSERT_ND(log_entry);
   if (UNLIKELY(lock_free_write_set_size_ >= max_lock_free_write_set_size_)) {
@@ -563,6 +622,8 @@ ErrorCode Xct::add_to_lock_free_write_set(
 
   lock_free_write_set_[lock_free_write_set_size_].storage_id_ = storage_id;
   lock_free_write_set_[lock_free_write_set_size_].log_entry_ = log_entry;
+  lock_free_write_set_[lock_free_write_set_size_].payload_address_ = payload_address;
+  lock_free_write_set_[lock_free_write_set_size_].owner_id_address_ = owner_id_address;
   ++lock_free_write_set_size_;
   return kErrorCodeOk;
 }
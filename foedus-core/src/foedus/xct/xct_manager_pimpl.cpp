@@ -39,11 +39,15 @@
 #include "foedus/savepoint/savepoint_manager.hpp"
 #include "foedus/soc/soc_manager.hpp"
 #include "foedus/storage/record.hpp"
+#include "foedus/storage/storage.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
+#include "foedus/storage/array/array_page_impl.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
 #include "foedus/thread/thread_ref.hpp"
 #include "foedus/xct/in_commit_epoch_guard.hpp"
+#include "foedus/xct/previous_version_table.hpp"
 #include "foedus/xct/retrospective_lock_list.hpp"
 #include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_access.hpp"
@@ -312,9 +316,27 @@ ErrorCode XctManagerPimpl::begin_xct(thread::Thread* context, IsolationLevel iso
   if (UNLIKELY(control_block_->new_transaction_paused_.load())) {
     wait_until_resume_accepting_xct(context);
   }
+  RetrospectiveLockList* rll = current_xct.get_retrospective_lock_list();
+  const Epoch begin_epoch = get_current_global_epoch_weak();
+  if (rll->is_empty()
+    && current_xct.get_rll_profile() != 0
+    && current_xct.is_default_rll_for_this_xct()) {
+    // First run of this transaction. Do we know what it will probably lock?
+    current_xct.get_learned_lock_lists()->apply(
+      current_xct.get_rll_profile(),
+      control_block_->pause_generation_.load(),
+      begin_epoch,
+      rll);
+  }
   DVLOG(1) << *context << " Began new transaction."
-    << " RLL size=" << current_xct.get_retrospective_lock_list()->get_last_active_entry();
+    << " RLL size=" << rll->get_last_active_entry();
   current_xct.activate(isolation_level);
+  current_xct.set_begin_epoch(begin_epoch);
+  if (isolation_level == kEpochConsistent) {
+    // The current global epoch advances only after all transactions in the grace epoch
+    // (current - 1) finish their apply phase. So, current - 2 is closed.
+    current_xct.set_consistent_epoch(get_current_global_epoch_weak().one_less().one_less());
+  }
   ASSERT_ND(current_xct.get_mcs_block_current() == 0);
   ASSERT_ND(context->get_thread_log_buffer().get_offset_tail()
     == context->get_thread_log_buffer().get_offset_committed());
@@ -325,9 +347,11 @@ ErrorCode XctManagerPimpl::begin_xct(thread::Thread* context, IsolationLevel iso
 }
 
 void XctManagerPimpl::pause_accepting_xct() {
+  ++control_block_->pause_generation_;
   control_block_->new_transaction_paused_.store(true);
 }
 void XctManagerPimpl::resume_accepting_xct() {
+  ++control_block_->pause_generation_;
   control_block_->new_transaction_paused_.store(false);
 }
 
@@ -349,7 +373,9 @@ ErrorCode XctManagerPimpl::precommit_xct(thread::Thread* context, Epoch *commit_
 
   ErrorCode result;
   bool read_only = context->get_current_xct().is_read_only();
-  if (read_only) {
+  if (current_xct.get_isolation_level() == kEpochConsistent) {
+    result = precommit_xct_epoch_consistent(context, commit_epoch);
+  } else if (read_only) {
     result = precommit_xct_readonly(context, commit_epoch);
   } else {
     result = precommit_xct_readwrite(context, commit_epoch);
@@ -361,6 +387,11 @@ ErrorCode XctManagerPimpl::precommit_xct(thread::Thread* context, Epoch *commit_
     ASSERT_ND(abort_ret == kErrorCodeOk);
     DVLOG(1) << *context << " Aborting because of contention";
   } else {
+    if (current_xct.is_enable_rll_for_this_xct() && current_xct.get_rll_profile() != 0) {
+      current_xct.get_learned_lock_lists()->learn_from_commit(
+        current_xct.get_rll_profile(),
+        &current_xct);
+    }
     current_xct.get_retrospective_lock_list()->clear_entries();
     release_and_clear_all_current_locks(context);
     current_xct.deactivate();
@@ -381,6 +412,22 @@ ErrorCode XctManagerPimpl::precommit_xct_readonly(thread::Thread* context, Epoch
   }
 }
 
+ErrorCode XctManagerPimpl::precommit_xct_epoch_consistent(
+  thread::Thread* context,
+  Epoch *commit_epoch) {
+  Xct& current_xct = context->get_current_xct();
+  if (!current_xct.is_read_only()) {
+    DVLOG(0) << *context << " Epoch-consistent transaction tried to write. Aborting";
+    return kErrorCodeXctReadOnlyIsolation;
+  }
+  // Every read has been confirmed to be as of the consistent epoch. Nothing to verify.
+  ASSERT_ND(current_xct.get_read_set_size() == 0);
+  ASSERT_ND(current_xct.get_page_version_set_size() == 0);
+  ASSERT_ND(current_xct.get_pointer_set_size() == 0);
+  *commit_epoch = current_xct.get_consistent_epoch();
+  return kErrorCodeOk;
+}
+
 ErrorCode XctManagerPimpl::precommit_xct_readwrite(thread::Thread* context, Epoch *commit_epoch) {
   DVLOG(1) << *context << " Committing read-write";
   XctId max_xct_id;
@@ -401,7 +448,8 @@ ErrorCode XctManagerPimpl::precommit_xct_readwrite(thread::Thread* context, Epoc
   DVLOG(1) << *context << " Acquired read-write commit epoch " << *commit_epoch;
 
   assorted::memory_fence_acq_rel();
-  bool verified = precommit_xct_verify_readwrite(context, &max_xct_id);  // phase 2
+  bool verified = precommit_xct_verify_readwrite(context, &max_xct_id)  // phase 2
+    && precommit_xct_verify_split_increments(context, *commit_epoch);
 #ifndef NDEBUG
   {
     WriteXctAccess* write_set = context->get_current_xct().get_write_set();
@@ -865,6 +913,22 @@ bool XctManagerPimpl::precommit_xct_verify_page_version_set(thread::Thread* cont
   return true;
 }
 
+/** Counts inserted/deleted records in StorageStatistics. Other log types don't change them. */
+inline void count_records_for_statistics(
+  Engine* engine,
+  thread::Thread* context,
+  storage::StorageId storage_id,
+  log::LogCode log_type) {
+  int64_t delta = storage::to_record_count_delta(log_type);
+  if (delta > 0) {
+    engine->get_storage_manager()->get_storage(storage_id)->stats_.on_insert(
+      context->get_thread_global_ordinal());
+  } else if (delta < 0) {
+    engine->get_storage_manager()->get_storage(storage_id)->stats_.on_delete(
+      context->get_thread_global_ordinal());
+  }
+}
+
 void XctManagerPimpl::precommit_xct_apply(
   thread::Thread* context,
   XctId max_xct_id,
@@ -886,6 +950,7 @@ void XctManagerPimpl::precommit_xct_apply(
   new_deleted_xct_id.set_deleted();  // used if the record after apply is in deleted state.
 
   DVLOG(1) << *context << " generated new xct id=" << new_xct_id;
+  const bool record_statistics = engine_->get_options().storage_.record_statistics_;
   for (uint32_t i = 0; i < write_set_size; ++i) {
     WriteXctAccess& write = write_set[i];
     DVLOG(2) << *context << " Applying "
@@ -904,8 +969,11 @@ void XctManagerPimpl::precommit_xct_apply(
       ASSERT_ND(write.owner_id_address_->xct_id_.is_being_written());
     } else {
       ASSERT_ND(!write.owner_id_address_->xct_id_.is_being_written());
+      const XctId old_id = write.owner_id_address_->xct_id_;
       write.owner_id_address_->xct_id_.set_being_written();
       assorted::memory_fence_release();
+      // After being_written, so that split increments can't start without us seeing them.
+      save_previous_version(context, write, old_id, *commit_epoch);
     }
     log::invoke_apply_record(
       write.log_entry_,
@@ -913,6 +981,13 @@ void XctManagerPimpl::precommit_xct_apply(
       write.storage_id_,
       write.owner_id_address_,
       write.payload_address_);
+    if (UNLIKELY(record_statistics)) {
+      count_records_for_statistics(
+        engine_,
+        context,
+        write.storage_id_,
+        write.log_entry_->header_.get_type());
+    }
     ASSERT_ND(!write.owner_id_address_->xct_id_.get_epoch().is_valid() ||
       write.owner_id_address_->xct_id_.before(new_xct_id));  // ordered correctly?
     if (i < write_set_size - 1 &&
@@ -946,11 +1021,116 @@ void XctManagerPimpl::precommit_xct_apply(
     DVLOG(2) << *context << " Applying Lock-Free write "
       << engine_->get_storage_manager()->get_name(write.storage_id_);
     write.log_entry_->header_.set_xct_id(new_xct_id);
-    log::invoke_apply_record(write.log_entry_, context, write.storage_id_, nullptr, nullptr);
+    log::invoke_apply_record(
+      write.log_entry_,
+      context,
+      write.storage_id_,
+      nullptr,
+      write.payload_address_);
+    if (UNLIKELY(record_statistics)) {
+      count_records_for_statistics(
+        engine_,
+        context,
+        write.storage_id_,
+        write.log_entry_->header_.get_type());
+    }
   }
   DVLOG(1) << *context << " applied and unlocked write set";
 }
 
+void XctManagerPimpl::save_previous_version(
+  thread::Thread* context,
+  const WriteXctAccess& write,
+  XctId old_id,
+  Epoch commit_epoch) {
+  const log::LogCode type = write.log_entry_->header_.get_type();
+  if (type != log::kLogCodeArrayOverwrite && type != log::kLogCodeArrayIncrement) {
+    return;  // so far only array storage, whose payload size is fixed.
+  }
+  const Epoch old_epoch = old_id.get_epoch();
+  if (!old_epoch.is_valid() || old_epoch >= commit_epoch) {
+    // If this record was already written in this epoch, the first writer saved the image.
+    return;
+  }
+  const storage::Page* page = storage::to_page(write.payload_address_);
+  PreviousVersionTable* table
+    = context->get_previous_version_table(page->get_volatile_page_id().get_numa_node());
+  if (!table->is_enabled()) {
+    return;
+  }
+  if (old_epoch.one_more() == commit_epoch) {
+    // Split increments in old_epoch might be still applying to this record. They are
+    // part of the image as of old_epoch. Pairs with precommit_xct_verify_split_increments().
+    assorted::memory_fence_seq_cst();
+    const storage::array::ArrayPage* array_page
+      = reinterpret_cast<const storage::array::ArrayPage*>(page);
+    Epoch split_epoch = array_page->get_split_increment_epoch();
+    if (split_epoch.is_valid() && split_epoch >= old_epoch) {
+      wait_for_split_increments(context, old_epoch, commit_epoch);
+    }
+  }
+  // We don't know the payload size here. Save up to the end of the page, which is harmless
+  // for array pages where records are contiguous.
+  const char* page_end = reinterpret_cast<const char*>(page) + storage::kPageSize;
+  uint64_t size = std::min<uint64_t>(
+    page_end - write.payload_address_,
+    PreviousVersion::kPayloadSize);
+  table->save(write.owner_lock_id_, old_id, commit_epoch, write.payload_address_, size);
+}
+
+void XctManagerPimpl::wait_for_split_increments(
+  thread::Thread* context,
+  Epoch epoch,
+  Epoch commit_epoch) {
+  // We are committing in commit_epoch, so we can raise our own in-commit epoch to it.
+  // Otherwise we would wait for ourselves.
+  ASSERT_ND(epoch < commit_epoch);
+  *context->get_in_commit_epoch_address() = commit_epoch;
+  assorted::memory_fence_seq_cst();
+  thread::ThreadPool* pool = engine_->get_thread_pool();
+  const uint16_t nodes = engine_->get_soc_count();
+  for (uint16_t node = 0; node < nodes; ++node) {
+    thread::ThreadGroupRef* group = pool->get_group_ref(node);
+    // Threads in-commit in epoch are already past their locks, so they never wait for us.
+    SPINLOCK_WHILE(true) {
+      Epoch min_epoch = group->get_min_in_commit_epoch();
+      if (!min_epoch.is_valid() || min_epoch > epoch) {
+        break;
+      }
+    }
+  }
+  assorted::memory_fence_acquire();
+}
+
+bool XctManagerPimpl::precommit_xct_verify_split_increments(
+  thread::Thread* context,
+  Epoch commit_epoch) {
+  Xct& current_xct = context->get_current_xct();
+  LockFreeWriteXctAccess* lock_free_write_set = current_xct.get_lock_free_write_set();
+  const uint32_t lock_free_write_set_size = current_xct.get_lock_free_write_set_size();
+  for (uint32_t i = 0; i < lock_free_write_set_size; ++i) {
+    const LockFreeWriteXctAccess& write = lock_free_write_set[i];
+    if (write.owner_id_address_ == nullptr) {
+      continue;  // not a split increment
+    }
+    // Announce ourselves in the page first, then check the TID. A writer that moves the TID
+    // sets being_written first, then checks the page. So either we see being_written/new TID
+    // here and abort, or the writer sees us and waits for our apply in its
+    // save_previous_version() (see wait_for_split_increments()).
+    storage::array::ArrayPage* page
+      = reinterpret_cast<storage::array::ArrayPage*>(storage::to_page(write.payload_address_));
+    page->on_split_increment(commit_epoch);
+    assorted::memory_fence_seq_cst();
+    XctId cur = write.owner_id_address_->xct_id_;
+    if (cur.is_being_written() || cur.get_epoch() != commit_epoch) {
+      DVLOG(1) << *context << " split increment on a record not written in the commit epoch."
+        " will abort";
+      return false;
+    }
+  }
+  return true;
+}
+
 ErrorCode XctManagerPimpl::abort_xct(thread::Thread* context) {
   Xct& current_xct = context->get_current_xct();
   if (!current_xct.is_active()) {
@@ -984,11 +1164,20 @@ ErrorCode XctManagerPimpl::abort_xct(thread::Thread* context) {
   if (current_xct.is_enable_rll_for_this_xct()) {
     const uint32_t threshold = current_xct.get_rll_threshold_for_this_xct();
     current_xct.get_retrospective_lock_list()->construct(context, threshold);
+    if (current_xct.get_rll_profile() != 0) {
+      // Also remember it for the first run of following transactions of the same profile
+      current_xct.get_learned_lock_lists()->learn_from_abort(
+        current_xct.get_rll_profile(),
+        control_block_->pause_generation_.load(),
+        current_xct.get_begin_epoch(),
+        *current_xct.get_retrospective_lock_list());
+    }
   } else {
     current_xct.get_retrospective_lock_list()->clear_entries();
   }
 
   release_and_clear_all_current_locks(context);
+  current_xct.on_abort();
   current_xct.deactivate();
   context->get_thread_log_buffer().discard_current_xct_log();
   return kErrorCodeOk;
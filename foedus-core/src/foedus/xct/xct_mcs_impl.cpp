@@ -24,6 +24,8 @@
 #include "foedus/assert_nd.hpp"
 #include "foedus/assorted/atomic_fences.hpp"
 #include "foedus/assorted/spin_until_impl.hpp"
+#include "foedus/storage/page.hpp"
+#include "foedus/thread/thread_id.hpp"
 #include "foedus/thread/thread_pimpl.hpp"  // just for explicit instantiation at the end
 #include "foedus/xct/xct_id.hpp"
 #include "foedus/xct/xct_mcs_adapter_impl.hpp"
@@ -36,6 +38,36 @@ inline void assert_mcs_aligned(const void* address) {
   ASSERT_ND(reinterpret_cast<uintptr_t>(address) % 8 == 0);
 }
 
+/**
+ * How many queued waiters a NUMA-cohort handoff looks at (and might bypass) at most.
+ * The scan stays in the part of the queue that is already linked, so this is just
+ * a cap on the cost of a release. Fairness is bounded by XctOptions::mcs_cohort_bypass_bound_.
+ */
+const uint16_t kMcsCohortScanDepth = 8;
+
+/**
+ * Shared by the RW implementations. Compares the timestamp of this thread's transaction with
+ * that of the thread at the tail of the queue, breaking ties by thread ID.
+ * If no one is in the queue, we consider ourselves older.
+ */
+template <typename ADAPTOR>
+inline bool is_older_than_tail_waiter_impl(ADAPTOR* adaptor, McsRwLock* lock) {
+  const uint32_t tail_int = lock->get_tail_int();
+  if (tail_int == 0) {
+    return true;
+  }
+  McsRwLock tail_tmp;
+  tail_tmp.tail_ = tail_int;
+  const thread::ThreadId tail_waiter = tail_tmp.get_tail_waiter();
+  const thread::ThreadId my_id = adaptor->get_my_id();
+  if (tail_waiter == my_id) {
+    return true;
+  }
+  const uint64_t mine = adaptor->get_xct_timestamp(my_id);
+  const uint64_t theirs = adaptor->get_xct_timestamp(tail_waiter);
+  return mine < theirs || (mine == theirs && my_id < tail_waiter);
+}
+
 // will be removed soon. should directly call assorted::spin_until
 template <typename COND>
 void spin_until(COND spin_until_cond) {
@@ -254,6 +286,9 @@ void McsWwImpl<ADAPTOR>::release(McsWwLock* mcs_lock, McsBlockIndex block_index)
   // Relax: In either case above, we confirmed that block->has_successor with fences.
   // We thus can just read in relaxed mode here.
   thread::ThreadId successor_id = block->get_successor_thread_id_relaxed();
+  if (adaptor_.get_cohort_bypass_bound() > 0) {
+    successor_id = pick_cohort_successor(block);
+  }
   DVLOG(1) << "Okay, I have a successor. me=" << id << ", succ=" << successor_id;
   ASSERT_ND(successor_id != id);
   ASSERT_ND(address->copy_atomic() != myself);
@@ -266,6 +301,58 @@ void McsWwImpl<ADAPTOR>::release(McsWwLock* mcs_lock, McsBlockIndex block_index)
   ASSERT_ND(address->copy_atomic() != myself);
 }
 
+template <typename ADAPTOR>
+thread::ThreadId McsWwImpl<ADAPTOR>::pick_cohort_successor(McsWwBlock* block) {
+  // We are the owner, so every waiter in the queue is blocked and spinning on its own flag.
+  // Only the waiters whose successor_ is already set are touched, so no one else is writing to
+  // the blocks we rewire. In other words, we never touch the tail of the queue.
+  const uint16_t bound = adaptor_.get_cohort_bypass_bound();
+  const thread::ThreadGroupId my_node = adaptor_.get_my_numa_node();
+  const McsWwBlockData first = block->successor_.copy_once();
+  const thread::ThreadId first_id = first.get_thread_id_relaxed();
+  thread::ThreadId chosen_id = first_id;
+  if (thread::decompose_numa_node(first_id) != my_node) {
+    thread::ThreadId skipped_ids[kMcsCohortScanDepth];
+    McsWwBlock* prev_block = adaptor_.get_ww_other_block(first_id, first.get_block_relaxed());
+    thread::ThreadId prev_id = first_id;
+    for (uint16_t skipped = 0; skipped < kMcsCohortScanDepth; ++skipped) {
+      if (*adaptor_.other_cohort_bypassed(prev_id) >= bound) {
+        break;  // prev has waited long enough. no more bypassing
+      }
+      skipped_ids[skipped] = prev_id;
+      if (!prev_block->has_successor_acquire()) {
+        break;
+      }
+      const McsWwBlockData candidate = prev_block->successor_.copy_once();
+      const thread::ThreadId candidate_id = candidate.get_thread_id_relaxed();
+      McsWwBlock* candidate_block
+        = adaptor_.get_ww_other_block(candidate_id, candidate.get_block_relaxed());
+      if (thread::decompose_numa_node(candidate_id) == my_node) {
+        if (!candidate_block->has_successor_acquire()) {
+          break;  // the candidate might be the tail. leave it.
+        }
+        // [first ... prev] [candidate] [after] => [candidate] [first ... prev] [after]
+        const McsWwBlockData after = candidate_block->successor_.copy_once();
+        prev_block->set_successor_release(
+          after.get_thread_id_relaxed(),
+          after.get_block_relaxed());
+        candidate_block->set_successor_release(first_id, first.get_block_relaxed());
+        for (uint16_t i = 0; i <= skipped; ++i) {
+          ++(*adaptor_.other_cohort_bypassed(skipped_ids[i]));
+        }
+        chosen_id = candidate_id;
+        DVLOG(1) << "NUMA-cohort handoff. me=" << adaptor_.get_my_id() << ", succ=" << chosen_id
+          << ", bypassed=" << first_id;
+        break;
+      }
+      prev_block = candidate_block;
+      prev_id = candidate_id;
+    }
+  }
+  *adaptor_.other_cohort_bypassed(chosen_id) = 0;
+  return chosen_id;
+}
+
 //////////////////////////////////////////////////////////////
 ///  Ownerless interface for WW-lock implementations
 //////////////////////////////////////////////////////////////
@@ -360,7 +447,14 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
   }
 
   static bool does_support_try_rw_reader() { return false; }
+  bool is_older_than_tail_waiter(McsRwLock* lock) {
+    return is_older_than_tail_waiter_impl(&adaptor_, lock);
+  }
   McsBlockIndex acquire_try_rw_reader(McsRwLock* lock) {
+    const McsBlockIndex biased_block = try_biased_read_lock(lock);
+    if (biased_block) {
+      return biased_block;
+    }
     McsBlockIndex block_index = adaptor_.issue_new_block();
     bool success = retry_async_rw_reader(lock, block_index);
     if (success) {
@@ -378,6 +472,10 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
   }
 
   McsBlockIndex acquire_unconditional_rw_reader(McsRwLock* mcs_rw_lock) {
+    const McsBlockIndex biased_block = try_biased_read_lock(mcs_rw_lock);
+    if (biased_block) {
+      return biased_block;
+    }
     ASSERT_ND(adaptor_.get_cur_block() < 0xFFFFU);
     const thread::ThreadId id = adaptor_.get_my_id();
     const McsBlockIndex block_index = adaptor_.issue_new_block();
@@ -429,6 +527,10 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
   void release_rw_reader(
     McsRwLock* mcs_rw_lock,
     McsBlockIndex block_index) {
+    if (is_biased_read_block(block_index)) {
+      release_biased_read_lock(block_index);
+      return;
+    }
     const thread::ThreadId id = adaptor_.get_my_id();
     ASSERT_ND(block_index > 0);
     ASSERT_ND(adaptor_.get_cur_block() >= block_index);
@@ -502,6 +604,7 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
           McsRwLock::kNextWriterNone);
         if (old_next_writer == id) {
           my_block->unblock();
+          has_biased_readers(mcs_rw_lock, true);
           return block_index;
         }
       }
@@ -511,6 +614,7 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
       pred_block->set_successor_next_only(id, block_index);
     }
     spin_until([my_block]{ return my_block->is_granted(); });
+    has_biased_readers(mcs_rw_lock, true);
     return block_index;
   }
 
@@ -529,9 +633,14 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
         spin_until([my_block]{ return my_block->successor_is_ready(); });
       }
       ASSERT_ND(my_block->successor_is_ready());
-      auto* successor_block = adaptor_.get_rw_other_block(
-        my_block->successor_thread_id_,
-        my_block->successor_block_index_);
+      McsRwSimpleBlock* successor_block;
+      if (adaptor_.get_cohort_bypass_bound() > 0) {
+        successor_block = pick_cohort_successor(my_block);
+      } else {
+        successor_block = adaptor_.get_rw_other_block(
+          my_block->successor_thread_id_,
+          my_block->successor_block_index_);
+      }
       ASSERT_ND(successor_block->is_blocked());
       if (successor_block->is_reader()) {
         mcs_rw_lock->increment_nreaders();
@@ -542,6 +651,10 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
 
 
   AcquireAsyncRet acquire_async_rw_reader(McsRwLock* lock) {
+    const McsBlockIndex biased_block = try_biased_read_lock(lock);
+    if (biased_block) {
+      return {true, biased_block};
+    }
     // In simple version, no distinction between try/async/retry. Same logic.
     McsBlockIndex block_index = adaptor_.issue_new_block();
     bool success = retry_async_rw_reader(lock, block_index);
@@ -636,8 +749,16 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
     tmp2.tail_ = McsRwLock::to_tail_int(id, block_index);
     uint64_t desired = *reinterpret_cast<uint64_t*>(&tmp2);
     my_block->unblock();
-    return assorted::raw_atomic_compare_exchange_weak<uint64_t>(
-      reinterpret_cast<uint64_t*>(lock), &expected, desired);
+    if (!assorted::raw_atomic_compare_exchange_weak<uint64_t>(
+      reinterpret_cast<uint64_t*>(lock), &expected, desired)) {
+      return false;
+    }
+    if (UNLIKELY(has_biased_readers(lock, false))) {
+      // We can't wait for them here (this is not necessarily in canonical mode). Give up.
+      release_rw_writer(lock, block_index);
+      return false;
+    }
+    return true;
   }
 
   void cancel_async_rw_reader(McsRwLock* /*lock*/, McsBlockIndex /*block_index*/) {
@@ -663,6 +784,168 @@ class McsImpl<ADAPTOR, McsRwSimpleBlock> {  // partial specialization for McsRwS
     my_block->set_finalized();
   }
 
+  /**
+   * Used in release_rw_writer() when NUMA-cohort handoffs are enabled.
+   * If the successor is a writer on another node, moves a waiting writer on this node to the
+   * head of the queue. Readers are never reordered or bypassed.
+   * We hold the lock in writer mode, so all the waiters are blocked. We only rewire waiters whose
+   * successors are ready, so no one else is writing to their successor fields.
+   * @return the block to hand over the lock
+   */
+  McsRwSimpleBlock* pick_cohort_successor(McsRwSimpleBlock* my_block) {
+    const uint16_t bound = adaptor_.get_cohort_bypass_bound();
+    const thread::ThreadGroupId my_node = adaptor_.get_my_numa_node();
+    const thread::ThreadId first_id = my_block->successor_thread_id_;
+    const McsBlockIndex first_block_index = my_block->successor_block_index_;
+    McsRwSimpleBlock* first_block = adaptor_.get_rw_other_block(first_id, first_block_index);
+    thread::ThreadId chosen_id = first_id;
+    McsRwSimpleBlock* chosen_block = first_block;
+    if (!first_block->is_reader() && thread::decompose_numa_node(first_id) != my_node) {
+      thread::ThreadId skipped_ids[kMcsCohortScanDepth];
+      McsRwSimpleBlock* prev_block = first_block;
+      thread::ThreadId prev_id = first_id;
+      for (uint16_t skipped = 0; skipped < kMcsCohortScanDepth; ++skipped) {
+        if (*adaptor_.other_cohort_bypassed(prev_id) >= bound) {
+          break;  // prev has waited long enough. no more bypassing
+        }
+        skipped_ids[skipped] = prev_id;
+        if (!prev_block->successor_is_ready()) {
+          break;
+        }
+        const thread::ThreadId candidate_id = prev_block->successor_thread_id_;
+        McsRwSimpleBlock* candidate_block = adaptor_.get_rw_other_block(
+          candidate_id,
+          prev_block->successor_block_index_);
+        if (candidate_block->is_reader()) {
+          break;
+        }
+        if (thread::decompose_numa_node(candidate_id) == my_node) {
+          if (!candidate_block->successor_is_ready()) {
+            break;  // the candidate might be the tail. leave it.
+          }
+          // [first ... prev] [candidate] [after] => [candidate] [first ... prev] [after]
+          // Successor fields are separated from the state byte, so plain stores suffice.
+          // unblock() of the candidate (an atomic op) publishes them.
+          assorted::atomic_store_release<uint8_t>(
+            &prev_block->self_.components_.successor_class_,
+            assorted::atomic_load_acquire<uint8_t>(
+              &candidate_block->self_.components_.successor_class_));
+          prev_block->successor_thread_id_ = candidate_block->successor_thread_id_;
+          prev_block->successor_block_index_ = candidate_block->successor_block_index_;
+          assorted::atomic_store_release<uint8_t>(
+            &candidate_block->self_.components_.successor_class_,
+            McsRwSimpleBlock::kSuccessorClassWriter);
+          candidate_block->successor_thread_id_ = first_id;
+          candidate_block->successor_block_index_ = first_block_index;
+          for (uint16_t i = 0; i <= skipped; ++i) {
+            ++(*adaptor_.other_cohort_bypassed(skipped_ids[i]));
+          }
+          chosen_id = candidate_id;
+          chosen_block = candidate_block;
+          break;
+        }
+        prev_block = candidate_block;
+        prev_id = candidate_id;
+      }
+    }
+    *adaptor_.other_cohort_bypassed(chosen_id) = 0;
+    return chosen_block;
+  }
+
+  /**
+   * Tries to take a read-lock in the reader-biased mode, which doesn't write to the lock word.
+   * We publish the lock in our slot, increment the reader indicator of our node, then
+   * check that no one is in the MCS queue. Writers do the opposite in has_biased_readers().
+   * The atomic increment and the atomic ops on the lock word are full barriers, so either
+   * the writer sees our slot or we see the writer in the lock word.
+   * @return the block index denoting the reader-biased lock, 0 if we should take the usual path
+   */
+  McsBlockIndex try_biased_read_lock(McsRwLock* lock) {
+    const uint16_t threshold = adaptor_.get_reader_bias_threshold();
+    if (LIKELY(threshold > 0xFFU)
+      || storage::to_page(lock)->get_header().hotness_.value_ < threshold
+      || lock->get_tail_int() != 0) {
+      return 0;
+    }
+    UniversalLockId* slots = adaptor_.get_biased_read_locks(adaptor_.get_my_id());
+    uint32_t slot;
+    for (slot = 0; slot < kMcsMaxBiasedReadLocks; ++slot) {
+      if (slots[slot] == kNullUniversalLockId) {
+        break;
+      }
+    }
+    if (UNLIKELY(slot == kMcsMaxBiasedReadLocks)) {
+      return 0;
+    }
+    const UniversalLockId lock_id = adaptor_.to_universal_lock_id(lock);
+    uint32_t* indicator
+      = adaptor_.get_reader_indicators(adaptor_.get_my_numa_node())
+        + to_reader_indicator_index(lock_id);
+    assorted::atomic_store_release<UniversalLockId>(slots + slot, lock_id);
+    assorted::raw_atomic_fetch_add<uint32_t>(indicator, 1U);
+    const McsBlockIndex block_index = kMcsBiasedReadBlockBase + slot;
+    if (lock->get_tail_int() == 0) {
+      return block_index;
+    }
+    // Someone has come in. Withdraw and take the usual path.
+    release_biased_read_lock(block_index);
+    return 0;
+  }
+
+  void release_biased_read_lock(McsBlockIndex block_index) {
+    ASSERT_ND(is_biased_read_block(block_index));
+    const uint32_t slot = block_index - kMcsBiasedReadBlockBase;
+    ASSERT_ND(slot < kMcsMaxBiasedReadLocks);
+    UniversalLockId* slots = adaptor_.get_biased_read_locks(adaptor_.get_my_id());
+    const UniversalLockId lock_id = slots[slot];
+    ASSERT_ND(lock_id != kNullUniversalLockId);
+    uint32_t* indicator
+      = adaptor_.get_reader_indicators(adaptor_.get_my_numa_node())
+        + to_reader_indicator_index(lock_id);
+    assorted::atomic_store_release<UniversalLockId>(slots + slot, kNullUniversalLockId);
+    assorted::raw_atomic_fetch_add<uint32_t>(indicator, static_cast<uint32_t>(-1));
+  }
+
+  /**
+   * Called right after a writer takes the MCS lock to check readers in the reader-biased mode.
+   * This is the "revocation" part. We check the reader indicator of each node, and only if
+   * it's non-zero, look into the slots of the threads in the node.
+   * @param[in] wait whether to wait for such readers to release the lock
+   * @return whether there are such readers. Always false if wait is true.
+   */
+  bool has_biased_readers(McsRwLock* lock, bool wait) {
+    if (LIKELY(adaptor_.get_reader_bias_threshold() > 0xFFU)) {
+      return false;
+    }
+    const UniversalLockId lock_id = adaptor_.to_universal_lock_id(lock);
+    const uint32_t index = to_reader_indicator_index(lock_id);
+    const uint16_t nodes = adaptor_.get_numa_node_count();
+    const thread::ThreadLocalOrdinal threads_per_node = adaptor_.get_threads_per_node();
+    for (thread::ThreadGroupId node = 0; node < nodes; ++node) {
+      uint32_t* indicator = adaptor_.get_reader_indicators(node) + index;
+      if (assorted::atomic_load_acquire<uint32_t>(indicator) == 0) {
+        continue;
+      }
+      for (thread::ThreadLocalOrdinal ordinal = 0; ordinal < threads_per_node; ++ordinal) {
+        UniversalLockId* slots
+          = adaptor_.get_biased_read_locks(thread::compose_thread_id(node, ordinal));
+        for (uint32_t slot = 0; slot < kMcsMaxBiasedReadLocks; ++slot) {
+          UniversalLockId* address = slots + slot;
+          if (assorted::atomic_load_acquire<UniversalLockId>(address) != lock_id) {
+            continue;
+          }
+          if (!wait) {
+            return true;
+          }
+          spin_until([address, lock_id]{
+            return assorted::atomic_load_acquire<UniversalLockId>(address) != lock_id;
+          });
+        }
+      }
+    }
+    return false;
+  }
+
   ADAPTOR adaptor_;
 };  // end of McsImpl<ADAPTOR, McsRwSimpleBlock> specialization
 
@@ -676,6 +959,9 @@ template <typename ADAPTOR>
 class McsImpl<ADAPTOR, McsRwExtendedBlock> {  // partial specialization for McsRwExtendedBlock
  public:
   static bool does_support_try_rw_reader() { return true; }
+  bool is_older_than_tail_waiter(McsRwLock* lock) {
+    return is_older_than_tail_waiter_impl(&adaptor_, lock);
+  }
   McsBlockIndex acquire_unconditional_rw_reader(McsRwLock* lock) {
     McsBlockIndex block_index = 0;
     auto ret = acquire_reader_lock(lock, &block_index, McsRwExtendedBlock::kTimeoutNever);
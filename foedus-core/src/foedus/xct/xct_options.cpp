@@ -28,8 +28,15 @@ XctOptions::XctOptions() {
   epoch_advance_interval_ms_ = kDefaultEpochAdvanceIntervalMs;
   enable_retrospective_lock_list_ = false;  // TODO(Hideaki) tentative!
   hot_threshold_for_retrospective_lock_list_ = kDefaultHotThreshold;
+  learned_lock_list_profiles_ = kDefaultLearnedLockListProfiles;
+  learned_lock_list_entries_ = kDefaultLearnedLockListEntries;
   force_canonical_xlocks_in_precommit_ = true;  // TODO(Hideaki) tentative!
+  enable_non_canonical_wait_die_ = false;
   mcs_implementation_type_ = kMcsImplementationTypeSimple;
+  mcs_cohort_bypass_bound_ = kDefaultMcsCohortBypassBound;
+  hot_threshold_for_reader_biased_locks_ = kDefaultHotThresholdForReaderBiasedLocks;
+  previous_version_entries_per_node_ = kDefaultPreviousVersionEntriesPerNode;
+  early_validation_interval_ = 0;
 }
 
 ErrorStack XctOptions::load(tinyxml2::XMLElement* element) {
@@ -41,8 +48,15 @@ ErrorStack XctOptions::load(tinyxml2::XMLElement* element) {
   EXTERNALIZE_LOAD_ELEMENT(element, epoch_advance_interval_ms_);
   EXTERNALIZE_LOAD_ELEMENT(element, enable_retrospective_lock_list_);
   EXTERNALIZE_LOAD_ELEMENT(element, hot_threshold_for_retrospective_lock_list_);
+  EXTERNALIZE_LOAD_ELEMENT(element, learned_lock_list_profiles_);
+  EXTERNALIZE_LOAD_ELEMENT(element, learned_lock_list_entries_);
   EXTERNALIZE_LOAD_ELEMENT(element, force_canonical_xlocks_in_precommit_);
+  EXTERNALIZE_LOAD_ELEMENT(element, enable_non_canonical_wait_die_);
   EXTERNALIZE_LOAD_ELEMENT(element, mcs_implementation_type_);
+  EXTERNALIZE_LOAD_ELEMENT(element, mcs_cohort_bypass_bound_);
+  EXTERNALIZE_LOAD_ELEMENT(element, hot_threshold_for_reader_biased_locks_);
+  EXTERNALIZE_LOAD_ELEMENT(element, previous_version_entries_per_node_);
+  EXTERNALIZE_LOAD_ELEMENT(element, early_validation_interval_);
   return kRetOk;
 }
 
@@ -77,12 +91,37 @@ ErrorStack XctOptions::save(tinyxml2::XMLElement* element) const {
   EXTERNALIZE_SAVE_ELEMENT(element, hot_threshold_for_retrospective_lock_list_,
     "When we construct Retrospective Lock List (RLL) after aborts, we add"
     " read-locks on records whose hotness exceeds this value.");
+  EXTERNALIZE_SAVE_ELEMENT(element, learned_lock_list_profiles_,
+    "Number of profiles in each thread's cache of RLLs learned across transactions."
+    " The first run of a transaction uses the RLL learned for its profile. 0 disables it.");
+  EXTERNALIZE_SAVE_ELEMENT(element, learned_lock_list_entries_,
+    "Maximum number of locks each learned lock list profile remembers.");
   EXTERNALIZE_SAVE_ELEMENT(element, force_canonical_xlocks_in_precommit_,
     "Whether precommit always releases all locks that violate canonical mode before"
     " taking X-locks.");
+  EXTERNALIZE_SAVE_ELEMENT(element, enable_non_canonical_wait_die_,
+    "Whether to apply the wait-die policy when a lock in non-canonical mode is contended."
+    " Older transactions restore canonical mode and wait, younger ones abort.");
   EXTERNALIZE_SAVE_ELEMENT(element, mcs_implementation_type_,
     "Defines which implementation of MCS locks to use for RW locks."
-    " So far we allow kMcsImplementationTypeSimple and kMcsImplementationTypeExtended.");
+    " So far we allow kMcsImplementationTypeSimple, kMcsImplementationTypeExtended,"
+    " and kMcsImplementationTypeSimpleCohort (simple RW lock with NUMA-cohort handoffs).");
+  EXTERNALIZE_SAVE_ELEMENT(element, mcs_cohort_bypass_bound_,
+    "With kMcsImplementationTypeSimpleCohort, how many times a waiter can be bypassed"
+    " by waiters on the lock owner's NUMA node before it receives the lock.");
+  EXTERNALIZE_SAVE_ELEMENT(element, hot_threshold_for_reader_biased_locks_,
+    "Read-locks on records in pages whose hotness is this value or more are taken in the"
+    " reader-biased mode, which doesn't write to the lock word. Only with simple MCS-RW locks."
+    " 256 (default) disables it.");
+  EXTERNALIZE_SAVE_ELEMENT(element, previous_version_entries_per_node_,
+    "Number of entries (256 bytes each) in the previous-version table of each NUMA node,"
+    " which keeps record images for epoch-consistent reads. 0 disables it, in which case"
+    " epoch-consistent transactions abort when they see a record updated after the epoch.");
+  EXTERNALIZE_SAVE_ELEMENT(element, early_validation_interval_,
+    "Minimal number of new reads before a serializable transaction re-verifies its whole"
+    " read-set and aborts early if any entry has changed. The read-set must also have doubled"
+    " since the previous check. Masstree cursors also check it at each border page."
+    " 0 (default) disables it.");
   return kRetOk;
 }
 
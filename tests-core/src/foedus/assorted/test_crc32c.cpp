@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "foedus/test_common.hpp"
+#include "foedus/assorted/crc32c.hpp"
+#include "foedus/assorted/uniform_random.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/storage/page.hpp"
+
+namespace foedus {
+namespace assorted {
+
+DEFINE_TEST_CASE_PACKAGE(Crc32cTest, foedus.assorted);
+
+TEST(Crc32cTest, KnownValues) {
+  // Check values from RFC 3720 (iSCSI), B.4.
+  EXPECT_EQ(0U, crc32c("", 0));
+  const std::string digits("123456789");
+  EXPECT_EQ(0xE3069283U, crc32c(digits.data(), digits.size()));
+  char zeros[32];
+  std::memset(zeros, 0, sizeof(zeros));
+  EXPECT_EQ(0x8A9136AAU, crc32c(zeros, sizeof(zeros)));
+  char ones[32];
+  std::memset(ones, 0xFF, sizeof(ones));
+  EXPECT_EQ(0x62A8AB43U, crc32c(ones, sizeof(ones)));
+  char ascending[32];
+  for (int i = 0; i < 32; ++i) {
+    ascending[i] = static_cast<char>(i);
+  }
+  EXPECT_EQ(0x46DD794EU, crc32c(ascending, sizeof(ascending)));
+}
+
+TEST(Crc32cTest, Incremental) {
+  char data[1000];
+  UniformRandom rnd(1234);
+  for (uint32_t i = 0; i < sizeof(data); ++i) {
+    data[i] = static_cast<char>(rnd.next_uint32());
+  }
+  const uint32_t whole = crc32c(data, sizeof(data));
+  for (uint32_t split = 0; split <= sizeof(data); split += 37) {
+    uint32_t crc = crc32c(data, split);
+    crc = crc32c(data + split, sizeof(data) - split, crc);
+    EXPECT_EQ(whole, crc) << split;
+  }
+}
+
+TEST(Crc32cTest, PageChecksum) {
+  memory::AlignedMemory memory;
+  memory.alloc(storage::kPageSize, storage::kPageSize, memory::AlignedMemory::kPosixMemalign, 0);
+  UniformRandom rnd(5678);
+  rnd.fill_memory(&memory);
+  storage::Page* page = reinterpret_cast<storage::Page*>(memory.get_block());
+
+  page->get_header().checksum_ = 0;
+  EXPECT_TRUE(storage::verify_page_checksum(page));  // no checksum
+  storage::Checksum checksum = storage::compute_page_checksum(page);
+  EXPECT_NE(0U, checksum);
+  page->get_header().checksum_ = checksum;
+  EXPECT_EQ(checksum, storage::compute_page_checksum(page));  // checksum_ itself is excluded
+  EXPECT_TRUE(storage::verify_page_checksum(page));
+
+  page->get_data()[123] ^= 1;
+  EXPECT_FALSE(storage::verify_page_checksum(page));
+  page->get_data()[123] ^= 1;
+  EXPECT_TRUE(storage::verify_page_checksum(page));
+  page->get_header().storage_id_ ^= 1;
+  EXPECT_FALSE(storage::verify_page_checksum(page));
+}
+
+}  // namespace assorted
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(Crc32cTest, foedus.assorted);
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/common_log_types.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/log/log_subscriber.hpp"
+#include "foedus/log/log_type.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/array/array_log_types.hpp"
+#include "foedus/storage/array/array_metadata.hpp"
+#include "foedus/storage/array/array_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+/**
+ * @file test_log_subscriber.cpp
+ * Testcases for LogSubscriber.
+ */
+namespace foedus {
+namespace log {
+DEFINE_TEST_CASE_PACKAGE(LogSubscriberTest, foedus.log);
+
+const uint32_t kXcts = 10;
+const uint32_t kBigXctRecords = 200;
+
+/** Each transaction writes the same value to both arrays, one epoch per transaction. */
+ErrorStack write_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = context->get_engine();
+  storage::array::ArrayStorage subscribed = engine->get_storage_manager()->get_array("subscribed");
+  storage::array::ArrayStorage other = engine->get_storage_manager()->get_array("other");
+  xct::XctManager* xct_manager = engine->get_xct_manager();
+  for (uint32_t i = 0; i < kXcts; ++i) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    uint64_t buf[2];
+    buf[0] = i;
+    buf[1] = i * 3;
+    CHECK_ERROR(subscribed.overwrite_record(context, i, buf));
+    CHECK_ERROR(other.overwrite_record(context, i, buf));
+    Epoch commit_epoch;
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+    CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+    xct_manager->advance_current_global_epoch();
+  }
+  return kRetOk;
+}
+
+ErrorStack big_write_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  Engine* engine = context->get_engine();
+  storage::array::ArrayStorage subscribed = engine->get_storage_manager()->get_array("subscribed");
+  xct::XctManager* xct_manager = engine->get_xct_manager();
+  xct_manager->advance_current_global_epoch();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t i = 0; i < kBigXctRecords; ++i) {
+    uint64_t buf[2];
+    buf[0] = i;
+    buf[1] = i;
+    CHECK_ERROR(subscribed.overwrite_record(context, i, buf));
+  }
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+void create_arrays(Engine* engine, storage::StorageId* subscribed_id) {
+  storage::array::ArrayMetadata meta("subscribed", 16, kBigXctRecords);
+  storage::array::ArrayStorage storage;
+  Epoch epoch;
+  COERCE_ERROR(engine->get_storage_manager()->create_array(&meta, &storage, &epoch));
+  *subscribed_id = storage.get_id();
+  storage::array::ArrayMetadata meta2("other", 16, kBigXctRecords);
+  storage::array::ArrayStorage storage2;
+  COERCE_ERROR(engine->get_storage_manager()->create_array(&meta2, &storage2, &epoch));
+}
+
+/** Consumes all logs delivered now, checking the order. */
+void consume_all(
+  LogSubscriber* subscriber,
+  storage::StorageId subscribed_id,
+  std::vector<uint64_t>* values,
+  std::vector<Epoch>* epochs) {
+  while (true) {
+    Epoch consumed_before = subscriber->get_consumed_epoch();
+    ErrorCode code = subscriber->next_epoch(0);
+    if (code == kErrorCodeTimeout) {
+      break;
+    }
+    ASSERT_EQ(kErrorCodeOk, code);
+    ASSERT_TRUE(subscriber->get_epoch().is_valid());
+    EXPECT_EQ(subscriber->get_epoch(), subscriber->get_consumed_epoch());
+    if (consumed_before.is_valid()) {
+      EXPECT_LT(consumed_before, subscriber->get_epoch());
+    }
+    EXPECT_GT(subscriber->get_log_count(), 0U);
+    for (uint32_t i = 0; i < subscriber->get_log_count(); ++i) {
+      const LogHeader* header = subscriber->get_log(i);
+      EXPECT_EQ(subscribed_id, header->storage_id_);
+      EXPECT_EQ(kLogCodeArrayOverwrite, header->get_type());
+      EXPECT_EQ(subscriber->get_epoch(), header->xct_id_.get_epoch());
+      if (i > 0) {
+        EXPECT_FALSE(header->xct_id_.before(subscriber->get_log(i - 1)->xct_id_));
+      }
+      const storage::array::ArrayOverwriteLogType* casted
+        = reinterpret_cast<const storage::array::ArrayOverwriteLogType*>(header);
+      values->push_back(casted->offset_);
+      epochs->push_back(subscriber->get_epoch());
+    }
+  }
+}
+
+TEST(LogSubscriberTest, Subscribe) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::StorageId subscribed_id;
+    create_arrays(&engine, &subscribed_id);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("write_task"));
+
+    std::vector<uint64_t> values;
+    std::vector<Epoch> epochs;
+    {
+      LogSubscriber subscriber(&engine, INVALID_EPOCH);
+      subscriber.add_storage(subscribed_id);
+      COERCE_ERROR(subscriber.initialize());
+      consume_all(&subscriber, subscribed_id, &values, &epochs);
+      COERCE_ERROR(subscriber.uninitialize());
+    }
+    ASSERT_EQ(kXcts, values.size());
+    for (uint32_t i = 0; i < kXcts; ++i) {
+      EXPECT_EQ(i, values[i]);
+    }
+
+    // Resume after the first epoch. We should receive the rest.
+    std::vector<uint64_t> resumed_values;
+    std::vector<Epoch> resumed_epochs;
+    {
+      LogSubscriber subscriber(&engine, epochs[0]);
+      subscriber.add_storage(subscribed_id);
+      COERCE_ERROR(subscriber.initialize());
+      consume_all(&subscriber, subscribed_id, &resumed_values, &resumed_epochs);
+      COERCE_ERROR(subscriber.uninitialize());
+    }
+    uint32_t first_epoch_count = 0;
+    while (first_epoch_count < kXcts && epochs[first_epoch_count] == epochs[0]) {
+      ++first_epoch_count;
+    }
+    ASSERT_EQ(kXcts - first_epoch_count, resumed_values.size());
+    for (uint32_t i = 0; i < resumed_values.size(); ++i) {
+      EXPECT_EQ(values[first_epoch_count + i], resumed_values[i]);
+      EXPECT_EQ(epochs[first_epoch_count + i], resumed_epochs[i]);
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+/** Consumes all logs from the consumed epoch with a new subscriber. */
+void consume_from(
+  Engine* engine,
+  Epoch consumed_epoch,
+  storage::StorageId subscribed_id,
+  std::vector<uint64_t>* values,
+  std::vector<Epoch>* epochs) {
+  LogSubscriber subscriber(engine, consumed_epoch);
+  subscriber.add_storage(subscribed_id);
+  COERCE_ERROR(subscriber.initialize());
+  consume_all(&subscriber, subscribed_id, values, epochs);
+  COERCE_ERROR(subscriber.uninitialize());
+}
+
+TEST(LogSubscriberTest, ResumeAfterRestart) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("write_task", write_task);
+  storage::StorageId subscribed_id;
+  std::vector<uint64_t> values;
+  std::vector<Epoch> epochs;
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    create_arrays(&engine, &subscribed_id);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("write_task"));
+    consume_from(&engine, INVALID_EPOCH, subscribed_id, &values, &epochs);
+    ASSERT_EQ(kXcts, values.size());
+    COERCE_ERROR(engine.uninitialize());
+  }
+
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    // Loggers don't remember epochs before restart, but we should receive them all.
+    std::vector<uint64_t> all_values;
+    std::vector<Epoch> all_epochs;
+    consume_from(&engine, INVALID_EPOCH, subscribed_id, &all_values, &all_epochs);
+    EXPECT_EQ(values, all_values);
+    EXPECT_EQ(epochs, all_epochs);
+
+    // Resume after the first epoch, which we consumed before restart.
+    std::vector<uint64_t> resumed_values;
+    std::vector<Epoch> resumed_epochs;
+    consume_from(&engine, epochs[0], subscribed_id, &resumed_values, &resumed_epochs);
+    uint32_t first_epoch_count = 0;
+    while (first_epoch_count < kXcts && epochs[first_epoch_count] == epochs[0]) {
+      ++first_epoch_count;
+    }
+    ASSERT_EQ(kXcts - first_epoch_count, resumed_values.size());
+    for (uint32_t i = 0; i < resumed_values.size(); ++i) {
+      EXPECT_EQ(values[first_epoch_count + i], resumed_values[i]);
+      EXPECT_EQ(epochs[first_epoch_count + i], resumed_epochs[i]);
+    }
+
+    // Logs before and after restart are delivered in one sequence.
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("write_task"));
+    std::vector<uint64_t> mixed_values;
+    std::vector<Epoch> mixed_epochs;
+    consume_from(&engine, epochs[0], subscribed_id, &mixed_values, &mixed_epochs);
+    ASSERT_EQ(kXcts - first_epoch_count + kXcts, mixed_values.size());
+    for (uint32_t i = 0; i < kXcts; ++i) {
+      EXPECT_EQ(i, mixed_values[kXcts - first_epoch_count + i]);
+      EXPECT_LT(epochs.back(), mixed_epochs[kXcts - first_epoch_count + i]);
+    }
+
+    // Resume from the last epoch before restart. Only the new logs.
+    std::vector<uint64_t> new_values;
+    std::vector<Epoch> new_epochs;
+    consume_from(&engine, epochs.back(), subscribed_id, &new_values, &new_epochs);
+    ASSERT_EQ(kXcts, new_values.size());
+    for (uint32_t i = 0; i < kXcts; ++i) {
+      EXPECT_EQ(i, new_values[i]);
+    }
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(LogSubscriberTest, BufferTooSmall) {
+  EngineOptions options = get_tiny_options();
+  options.log_.log_buffer_kb_ = 1 << 10;  // larger to do all writes in one shot
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("big_write_task", big_write_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    storage::StorageId subscribed_id;
+    create_arrays(&engine, &subscribed_id);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("big_write_task"));
+
+    LogSubscriber small(&engine, INVALID_EPOCH, 1 << 12);
+    COERCE_ERROR(small.initialize());
+    EXPECT_EQ(kErrorCodeLogSubscriberBufferTooSmall, small.next_epoch(0));
+    EXPECT_EQ(0U, small.get_log_count());
+    EXPECT_FALSE(small.get_epoch().is_valid());
+    // The epoch is not consumed. The same error again.
+    Epoch consumed = small.get_consumed_epoch();
+    EXPECT_EQ(kErrorCodeLogSubscriberBufferTooSmall, small.next_epoch(0));
+    EXPECT_EQ(consumed, small.get_consumed_epoch());
+    COERCE_ERROR(small.uninitialize());
+
+    // Large enough buffer receives all of them in one epoch.
+    LogSubscriber large(&engine, consumed);
+    COERCE_ERROR(large.initialize());
+    EXPECT_EQ(kErrorCodeOk, large.next_epoch(0));
+    EXPECT_EQ(kBigXctRecords, large.get_log_count());
+    EXPECT_EQ(kErrorCodeTimeout, large.next_epoch(0));
+    COERCE_ERROR(large.uninitialize());
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace log
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(LogSubscriberTest, foedus.log);
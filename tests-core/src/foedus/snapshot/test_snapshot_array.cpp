@@ -243,6 +243,41 @@ ErrorStack verify_holes_task(const proc::ProcArguments& args) {
   return kRetOk;
 }
 
+/** Input of split_increments_task */
+struct SplitInput {
+  uint64_t increments[2];  // split increments on record 0 in one epoch. 0 to skip
+  uint64_t expected;       // value of record 0 after the increments
+};
+const uint32_t kSplitInput = sizeof(SplitInput);
+
+ErrorStack split_increments_task(const proc::ProcArguments& args) {
+  EXPECT_EQ(kSplitInput, args.input_len_);
+  const SplitInput* input = reinterpret_cast<const SplitInput*>(args.input_buffer_);
+  thread::Thread* context = args.context_;
+  storage::array::ArrayStorage array(args.engine_, kName);
+  ASSERT_ND(array.exists());
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t i = 0; i < 2U; ++i) {
+    if (input->increments[i] == 0) {
+      continue;
+    }
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    WRAP_ERROR_CODE(array.increment_record_split<uint64_t>(context, 0, input->increments[i], 0));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  if (commit_epoch.is_valid()) {
+    WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  }
+
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  uint64_t value;
+  WRAP_ERROR_CODE(array.get_record_primitive<uint64_t>(context, 0, &value, 0));
+  EXPECT_EQ(input->expected, value);
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
 const proc::ProcName kOv("overwrites_task");
 const proc::ProcName kInc("increments_task");
 const proc::ProcName kInc2("increments_twice_task");
@@ -253,11 +288,15 @@ void test_run(
   const proc::ProcName& proc_name,
   bool multiple_loggers,
   bool multiple_partitions,
-  int levels) {
+  int levels,
+  bool sync_writer = false) {
   ASSERT_ND(levels >= 1 && levels <= 3);
   const bool three_levels = levels == 3;
   uint16_t payload = three_levels ? kThreeLevelPayload : kTwoLevelPayload;
   EngineOptions options = get_tiny_options();
+  if (sync_writer) {
+    options.snapshot_.snapshot_writer_async_buffers_ = 0;
+  }
   if (multiple_partitions) {
     options.thread_.thread_count_per_group_ = 1;
     options.thread_.group_count_ = 2;
@@ -385,6 +424,74 @@ TEST(SnapshotArrayTest, HolesOneLogger3Lv) { test_run(kHoles, false, false, 3);
 TEST(SnapshotArrayTest, HolesTwoLoggers3Lv) { test_run(kHoles, true, false, 3); }
 TEST(SnapshotArrayTest, HolesTwoPartitions3Lv) { test_run(kHoles, true, true, 3); }
 
+TEST(SnapshotArrayTest, IncrementsTwiceTwoPartitions2LvSyncWriter) {
+  test_run(kInc2, true, true, 2, true);
+}
+TEST(SnapshotArrayTest, TwoArraysTwoPartitions3LvSyncWriter) {
+  test_run(kTwo, true, true, 3, true);
+}
+
+// Split increments after the snapshot epoch must survive the drop of volatile pages.
+TEST(SnapshotArrayTest, SplitIncrementsAcrossSnapshots) {
+  EngineOptions options = get_tiny_options();
+  options.xct_.epoch_advance_interval_ms_ = 10000;  // we explicitly advance epochs
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("split_increments_task", split_increments_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::array::ArrayStorage out;
+      Epoch commit_epoch;
+      storage::array::ArrayMetadata meta(kName, sizeof(uint64_t), k1LvRecords);
+      COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &out, &commit_epoch));
+      thread::ThreadPool* pool = engine.get_thread_pool();
+      SnapshotManager* snapshot_manager = engine.get_snapshot_manager();
+
+      SplitInput input = {{1, 0}, 1};
+      COERCE_ERROR(pool->impersonate_synchronous("split_increments_task", &input, kSplitInput));
+      snapshot_manager->trigger_snapshot_immediate(true);
+
+      // The first increment in an epoch is locked, the second one is lock-free.
+      input.increments[0] = 2;
+      input.increments[1] = 4;
+      input.expected = 7;
+      COERCE_ERROR(pool->impersonate_synchronous("split_increments_task", &input, kSplitInput));
+      const Epoch snapshot_epoch = engine.get_log_manager()->get_durable_global_epoch();
+
+      input.increments[0] = 8;
+      input.increments[1] = 0;
+      input.expected = 15;
+      COERCE_ERROR(pool->impersonate_synchronous("split_increments_task", &input, kSplitInput));
+
+      // This snapshot doesn't contain the last increment, so its page must stay.
+      snapshot_manager->trigger_snapshot_immediate(true, snapshot_epoch);
+      EXPECT_EQ(snapshot_epoch, snapshot_manager->get_snapshot_epoch());
+      input.increments[0] = 0;
+      COERCE_ERROR(pool->impersonate_synchronous("split_increments_task", &input, kSplitInput));
+
+      snapshot_manager->trigger_snapshot_immediate(true);
+      COERCE_ERROR(pool->impersonate_synchronous("split_increments_task", &input, kSplitInput));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("split_increments_task", split_increments_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      SplitInput input = {{0, 0}, 15};
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous(
+        "split_increments_task",
+        &input,
+        kSplitInput));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
 }  // namespace snapshot
 }  // namespace foedus
 
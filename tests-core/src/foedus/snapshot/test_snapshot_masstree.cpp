@@ -17,20 +17,27 @@
  */
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/test_common.hpp"
 #include "foedus/log/log_manager.hpp"
+#include "foedus/memory/engine_memory.hpp"
+#include "foedus/memory/page_resolver.hpp"
 #include "foedus/proc/proc_manager.hpp"
 #include "foedus/snapshot/snapshot_id.hpp"
 #include "foedus/snapshot/snapshot_manager.hpp"
 #include "foedus/snapshot/snapshot_manager_pimpl.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 #include "foedus/storage/masstree/masstree_id.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_page_impl.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/storage/masstree/masstree_storage_pimpl.hpp"
 #include "foedus/thread/thread_pool.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
@@ -230,6 +237,281 @@ void test_run(
   cleanup_test(options);
 }
 
+/**
+ * Large payloads and a tiny page pool in the snapshot writer so that the composer flushes
+ * pages in the middle of the run and re-opens them. With asynchronous writes, the flushed
+ * pages might be still in the staging buffers when the composer re-reads them.
+ */
+const uint32_t kLargeRecords = 2048;
+const uint32_t kLargePayload = 512;
+const uint32_t kLargeRecordsPerXct = 64;
+
+ErrorStack inserts_large_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::masstree::MasstreeStorage masstree(args.engine_, kName);
+  ASSERT_ND(masstree.exists());
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  char payload[kLargePayload];
+  std::memset(payload, 0, sizeof(payload));
+  for (uint32_t i = 0; i < kLargeRecords; i += kLargeRecordsPerXct) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint32_t j = i; j < i + kLargeRecordsPerXct; ++j) {
+      uint64_t rec = j;
+      std::memcpy(payload, &rec, sizeof(rec));
+      storage::masstree::KeySlice slice = storage::masstree::normalize_primitive<uint64_t>(rec);
+      WRAP_ERROR_CODE(masstree.insert_record_normalized(context, slice, payload, sizeof(payload)));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack verify_large_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::masstree::MasstreeStorage masstree(args.engine_, kName);
+  ASSERT_ND(masstree.exists());
+  CHECK_ERROR(masstree.verify_single_thread(context));
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t i = 0; i < kLargeRecords; ++i) {
+    uint64_t rec = i;
+    storage::masstree::KeySlice slice = storage::masstree::normalize_primitive<uint64_t>(rec);
+    char payload[kLargePayload];
+    uint16_t capacity = sizeof(payload);
+    ErrorCode ret = masstree.get_record_normalized(context, slice, payload, &capacity, true);
+    EXPECT_EQ(kErrorCodeOk, ret) << i;
+    EXPECT_EQ(sizeof(payload), capacity) << i;
+    uint64_t data;
+    std::memcpy(&data, payload, sizeof(data));
+    EXPECT_EQ(rec, data) << i;
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+TEST(SnapshotMasstreeTest, ReopenFlushedPages) {
+  EngineOptions options = get_tiny_options();
+  options.snapshot_.snapshot_writer_page_pool_size_mb_ = 1;
+  options.memory_.page_pool_size_mb_per_node_ *= 4;
+  options.cache_.snapshot_cache_size_mb_per_node_ *= 4;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("inserts_large_task", inserts_large_task);
+    engine.get_proc_manager()->pre_register("verify_large_task", verify_large_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::masstree::MasstreeStorage out;
+      Epoch commit_epoch;
+      storage::masstree::MasstreeMetadata meta(kName);
+      COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &out, &commit_epoch));
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("inserts_large_task"));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify_large_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    // Only snapshot pages after restart.
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("verify_large_task", verify_large_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify_large_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+/**
+ * Overwrites every 4th record inserted by inserts_large_task.
+ * Run it in a later epoch than the snapshot, so that the snapshot can't drop volatile pages
+ * while page boundaries stay the same as the snapshot pages.
+ */
+ErrorStack overwrites_large_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::masstree::MasstreeStorage masstree(args.engine_, kName);
+  ASSERT_ND(masstree.exists());
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t i = 0; i < kLargeRecords; i += 4U) {
+    uint64_t rec = i;
+    storage::masstree::KeySlice slice = storage::masstree::normalize_primitive<uint64_t>(rec);
+    WRAP_ERROR_CODE(masstree.overwrite_record_normalized(context, slice, &rec, 0, sizeof(rec)));
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Collects snapshot pointers in volatile intermediate pages, in key order. */
+void collect_snapshot_pointers(
+  const memory::GlobalVolatilePageResolver& resolver,
+  storage::VolatilePagePointer pointer,
+  std::vector<storage::SnapshotPagePointer>* out) {
+  storage::masstree::MasstreePage* page
+    = reinterpret_cast<storage::masstree::MasstreePage*>(resolver.resolve_offset(pointer));
+  if (page->is_border()) {
+    return;
+  } else if (page->is_moved()) {
+    collect_snapshot_pointers(resolver, page->get_foster_minor(), out);
+    collect_snapshot_pointers(resolver, page->get_foster_major(), out);
+    return;
+  }
+  typedef storage::masstree::MasstreeIntermediatePage IntermediatePage;
+  typedef storage::masstree::MasstreeIntermediatePointerIterator PointerIterator;
+  for (PointerIterator it(reinterpret_cast<IntermediatePage*>(page)); it.is_valid(); it.next()) {
+    const storage::DualPagePointer& child = it.get_pointer();
+    out->push_back(child.snapshot_pointer_);
+    if (!child.volatile_pointer_.is_null()) {
+      collect_snapshot_pointers(resolver, child.volatile_pointer_, out);
+    }
+  }
+}
+
+void install_pointers_run(
+  uint16_t composer_parallel_threads,
+  std::vector<storage::SnapshotPagePointer>* out) {
+  EngineOptions options = get_tiny_options();
+  options.snapshot_.composer_parallel_threads_ = composer_parallel_threads;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("inserts_large_task", inserts_large_task);
+    engine.get_proc_manager()->pre_register("overwrites_large_task", overwrites_large_task);
+    engine.get_proc_manager()->pre_register("verify_large_task", verify_large_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::masstree::MasstreeStorage out_storage;
+      Epoch commit_epoch;
+      storage::masstree::MasstreeMetadata meta(kName);
+      COERCE_ERROR(engine.get_storage_manager()->create_masstree(
+        &meta,
+        &out_storage,
+        &commit_epoch));
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("inserts_large_task"));
+      Epoch snapshot_epoch = engine.get_xct_manager()->get_current_global_epoch();
+      engine.get_xct_manager()->advance_current_global_epoch();
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("overwrites_large_task"));
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true, snapshot_epoch);
+      EXPECT_EQ(snapshot_epoch, engine.get_snapshot_manager()->get_snapshot_epoch());
+
+      collect_snapshot_pointers(
+        engine.get_memory_manager()->get_global_volatile_page_resolver(),
+        out_storage.get_control_block()->root_page_pointer_.volatile_pointer_,
+        out);
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("verify_large_task"));
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
+TEST(SnapshotMasstreeTest, InstallPointersParallel) {
+  std::vector<storage::SnapshotPagePointer> serial;
+  install_pointers_run(1U, &serial);
+  std::vector<storage::SnapshotPagePointer> parallel;
+  install_pointers_run(4U, &parallel);
+
+  // The volatile pages survived the snapshot. Those whose boundaries match snapshot pages
+  // received snapshot pointers.
+  uint32_t installed = 0;
+  for (storage::SnapshotPagePointer pointer : serial) {
+    if (pointer != 0) {
+      ++installed;
+    }
+  }
+  EXPECT_GT(installed, 0U);
+  // Same snapshot pages in both runs, so the same pointers in the same pages.
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (uint32_t i = 0; i < serial.size(); ++i) {
+    EXPECT_EQ(serial[i], parallel[i]) << i;
+  }
+}
+
+/** Deletes every 4th record inserted by inserts_large_task. */
+ErrorStack deletes_large_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  storage::masstree::MasstreeStorage masstree(args.engine_, kName);
+  ASSERT_ND(masstree.exists());
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t i = 0; i < kLargeRecords; i += 4U) {
+    uint64_t rec = i;
+    storage::masstree::KeySlice slice = storage::masstree::normalize_primitive<uint64_t>(rec);
+    WRAP_ERROR_CODE(masstree.delete_record_normalized(context, slice));
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+TEST(SnapshotMasstreeTest, RecordCountStatistics) {
+  const int64_t kInserted = kLargeRecords;
+  const int64_t kRemaining = kLargeRecords - kLargeRecords / 4U;
+  EngineOptions options = get_tiny_options();
+  options.memory_.page_pool_size_mb_per_node_ *= 4;
+  // Both snapshots sort their logs in memory without dumping sorted runs.
+  options.snapshot_.log_reducer_buffer_mb_ = 8;
+  options.storage_.record_statistics_ = true;
+  {
+    Engine engine(options);
+    engine.get_proc_manager()->pre_register("inserts_large_task", inserts_large_task);
+    engine.get_proc_manager()->pre_register("deletes_large_task", deletes_large_task);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::masstree::MasstreeStorage out;
+      Epoch commit_epoch;
+      storage::masstree::MasstreeMetadata meta(kName);
+      COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &out, &commit_epoch));
+      const storage::StorageStatistics& stats
+        = engine.get_storage_manager()->get_statistics(out.get_id());
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("inserts_large_task"));
+      EXPECT_EQ(0, stats.get_snapshot_record_count());
+      EXPECT_EQ(kInserted, stats.get_record_count_estimate());
+
+      // The snapshot counts the same records, so the estimate must not double-count them.
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      EXPECT_EQ(kInserted, stats.get_snapshot_record_count());
+      EXPECT_EQ(kInserted, stats.get_record_count_estimate());
+
+      COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("deletes_large_task"));
+      EXPECT_EQ(kInserted, stats.get_snapshot_record_count());
+      EXPECT_EQ(kRemaining, stats.get_record_count_estimate());
+      engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+      EXPECT_EQ(kRemaining, stats.get_snapshot_record_count());
+      EXPECT_EQ(kRemaining, stats.get_record_count_estimate());
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  {
+    // The count as of the latest snapshot survives restart, even without online counting.
+    options.storage_.record_statistics_ = false;
+    Engine engine(options);
+    COERCE_ERROR(engine.initialize());
+    {
+      UninitializeGuard guard(&engine);
+      storage::masstree::MasstreeStorage out(&engine, kName);
+      ASSERT_ND(out.exists());
+      const storage::StorageStatistics& stats
+        = engine.get_storage_manager()->get_statistics(out.get_id());
+      EXPECT_EQ(kRemaining, stats.get_snapshot_record_count());
+      EXPECT_EQ(kRemaining, stats.get_record_count_estimate());
+      EXPECT_EQ(0, stats.get_inserted_records());
+      COERCE_ERROR(engine.uninitialize());
+    }
+  }
+  cleanup_test(options);
+}
+
 const proc::ProcName kInsN("inserts_normalized_task");
 const proc::ProcName kInsV("inserts_varlen_task");
 const proc::ProcName kVerN("verify_task");
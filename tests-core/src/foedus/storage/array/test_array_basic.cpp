@@ -33,6 +33,7 @@
 #include "foedus/storage/array/array_storage_pimpl.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -243,6 +244,169 @@ TEST(ArrayBasicTest, CreateAndReadWrite) {
   cleanup_test(options);
 }
 
+ErrorStack epoch_consistent_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ArrayStorage array = context->get_engine()->get_storage_manager()->get_array("test5");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+
+  // v1. Then advance epochs so that it is as of the consistent epoch of later readers.
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (int i = 0; i < 100; ++i) {
+    uint64_t buf[2];
+    buf[0] = i;
+    buf[1] = i * 10;
+    CHECK_ERROR(array.overwrite_record(context, i, buf));
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  xct_manager->advance_current_global_epoch();
+  xct_manager->advance_current_global_epoch();
+
+  // v2 for even records, in the current epoch.
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (int i = 0; i < 100; i += 2) {
+    uint64_t buf[2];
+    buf[0] = i + 1000;
+    buf[1] = i * 10 + 1000;
+    CHECK_ERROR(array.overwrite_record(context, i, buf));
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+
+  // Epoch-consistent readers still see v1 without aborts. Serializable readers see v2.
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kEpochConsistent));
+  EXPECT_TRUE(context->get_current_xct().get_consistent_epoch() < commit_epoch);
+  for (int i = 0; i < 100; ++i) {
+    uint64_t buf[2];
+    CHECK_ERROR(array.get_record(context, i, buf));
+    EXPECT_EQ(static_cast<uint64_t>(i), buf[0]) << i;
+    EXPECT_EQ(static_cast<uint64_t>(i * 10), buf[1]) << i;
+    uint64_t second;
+    CHECK_ERROR(array.get_record_primitive<uint64_t>(context, i, &second, sizeof(uint64_t)));
+    EXPECT_EQ(static_cast<uint64_t>(i * 10), second) << i;
+  }
+  EXPECT_EQ(0, context->get_current_xct().get_read_set_size());
+  Epoch consistent_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &consistent_epoch));
+  EXPECT_TRUE(consistent_epoch < commit_epoch);
+
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  for (int i = 0; i < 100; ++i) {
+    uint64_t buf[2];
+    CHECK_ERROR(array.get_record(context, i, buf));
+    EXPECT_EQ(static_cast<uint64_t>(i % 2 == 0 ? i + 1000 : i), buf[0]) << i;
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+
+  // Once the epoch is closed, epoch-consistent readers see v2, too.
+  xct_manager->advance_current_global_epoch();
+  xct_manager->advance_current_global_epoch();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kEpochConsistent));
+  for (int i = 0; i < 100; ++i) {
+    uint64_t buf[2];
+    CHECK_ERROR(array.get_record(context, i, buf));
+    EXPECT_EQ(static_cast<uint64_t>(i % 2 == 0 ? i + 1000 : i), buf[0]) << i;
+  }
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+
+  // Writes are not allowed
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kEpochConsistent));
+  uint64_t buf[2] = {0, 0};
+  CHECK_ERROR(array.overwrite_record(context, 0, buf));
+  EXPECT_EQ(kErrorCodeXctReadOnlyIsolation, xct_manager->precommit_xct(context, &commit_epoch));
+  EXPECT_FALSE(context->is_running_xct());
+  return foedus::kRetOk;
+}
+
+TEST(ArrayBasicTest, EpochConsistentRead) {
+  EngineOptions options = get_tiny_options();
+  options.log_.log_buffer_kb_ = 1 << 10;
+  options.xct_.epoch_advance_interval_ms_ = 10000;  // we explicitly advance epochs
+  options.xct_.previous_version_entries_per_node_ = 1 << 10;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("epoch_consistent_task", epoch_consistent_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ArrayMetadata meta("test5", 16, 100);
+    ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("epoch_consistent_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+ErrorStack read_epoch_consistent(thread::Thread* context, ArrayStorage array, uint64_t expected) {
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kEpochConsistent));
+  uint64_t value;
+  CHECK_ERROR(array.get_record_primitive<uint64_t>(context, 0, &value, 0));
+  EXPECT_EQ(expected, value);
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return foedus::kRetOk;
+}
+
+ErrorStack split_increment(thread::Thread* context, ArrayStorage array, uint64_t value) {
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+  CHECK_ERROR(array.increment_record_split<uint64_t>(context, 0, value, 0));
+  Epoch commit_epoch;
+  CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  return foedus::kRetOk;
+}
+
+ErrorStack epoch_consistent_split_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ArrayStorage array(args.engine_, "test6");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  CHECK_ERROR(split_increment(context, array, 1));
+  xct_manager->advance_current_global_epoch();
+  xct_manager->advance_current_global_epoch();
+  CHECK_ERROR(read_epoch_consistent(context, array, 1));
+
+  // The first one moves the TID and saves the previous version. The second one is lock-free.
+  CHECK_ERROR(split_increment(context, array, 2));
+  CHECK_ERROR(split_increment(context, array, 4));
+  CHECK_ERROR(read_epoch_consistent(context, array, 1));
+
+  // The previous version saved in the next epoch must contain the lock-free increment.
+  xct_manager->advance_current_global_epoch();
+  CHECK_ERROR(split_increment(context, array, 8));
+  xct_manager->advance_current_global_epoch();
+  CHECK_ERROR(read_epoch_consistent(context, array, 7));
+
+  xct_manager->advance_current_global_epoch();
+  xct_manager->advance_current_global_epoch();
+  CHECK_ERROR(read_epoch_consistent(context, array, 15));
+  return foedus::kRetOk;
+}
+
+TEST(ArrayBasicTest, EpochConsistentSplitIncrements) {
+  EngineOptions options = get_tiny_options();
+  options.log_.log_buffer_kb_ = 1 << 10;
+  options.xct_.epoch_advance_interval_ms_ = 10000;  // we explicitly advance epochs
+  options.xct_.previous_version_entries_per_node_ = 1 << 10;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register(
+    "epoch_consistent_split_task",
+    epoch_consistent_split_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    ArrayMetadata meta("test6", sizeof(uint64_t), 100);
+    ArrayStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_array(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("epoch_consistent_split_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 }  // namespace array
 }  // namespace storage
 }  // namespace foedus
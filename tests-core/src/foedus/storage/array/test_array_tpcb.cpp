@@ -102,6 +102,8 @@ enum AccessorType {
   kPrimitive,
   kIncrement,
   kIncrementOneShot,
+  /** split increments on branch/teller balances, which are the hot counters in TPC-B */
+  kIncrementSplit,
 };
 
 
@@ -255,6 +257,8 @@ class RunTpcbTask {
       branch_balance_old = branch_balance_new - amount;
     } else if (accessor_type == kIncrementOneShot) {
       CHECK_ERROR(branches.increment_record_oneshot<int64_t>(context, branch_id, amount, 0));
+    } else if (accessor_type == kIncrementSplit) {
+      CHECK_ERROR(branches.increment_record_split<int64_t>(context, branch_id, amount, 0));
     } else if (accessor_type == kPrimitive) {
       CHECK_ERROR(branches.get_record_primitive<int64_t>(context, branch_id,
                                 &branch_balance_old, 0));
@@ -269,7 +273,7 @@ class RunTpcbTask {
       CHECK_ERROR(branches.overwrite_record(context, branch_id,
                       &branch_balance_new, 0, sizeof(branch_balance_new)));
     }
-    if (accessor_type != kIncrementOneShot) {
+    if (accessor_type != kIncrementOneShot && accessor_type != kIncrementSplit) {
       EXPECT_GE(branch_balance_old, 0);
     }
 
@@ -290,6 +294,14 @@ class RunTpcbTask {
         teller_id,
         amount,
         sizeof(uint64_t)));
+    } else if (accessor_type == kIncrementSplit) {
+      CHECK_ERROR(tellers.get_record_primitive<uint64_t>(context, teller_id,
+                                &teller_branch_id, 0));
+      CHECK_ERROR(tellers.increment_record_split<int64_t>(
+        context,
+        teller_id,
+        amount,
+        sizeof(uint64_t)));
     } else if (accessor_type == kPrimitive) {
       CHECK_ERROR(tellers.get_record_primitive<uint64_t>(context, teller_id,
                                 &teller_branch_id, 0));
@@ -307,7 +319,7 @@ class RunTpcbTask {
       CHECK_ERROR(tellers.overwrite_record(context, teller_id,
           &teller_balance_new, sizeof(teller.branch_id_), sizeof(teller_balance_new)));
     }
-    if (accessor_type != kIncrementOneShot) {
+    if (accessor_type != kIncrementOneShot && accessor_type != kIncrementSplit) {
       EXPECT_GE(teller_balance_old, 0);
     }
     EXPECT_EQ(branch_id, teller_branch_id);
@@ -321,7 +333,7 @@ class RunTpcbTask {
       CHECK_ERROR(accounts.increment_record<int64_t>(context, account_id,
                             &account_balance_new, sizeof(uint64_t)));
       account_balance_old = account_balance_new - amount;
-    } else if (accessor_type == kIncrementOneShot) {
+    } else if (accessor_type == kIncrementOneShot || accessor_type == kIncrementSplit) {
       CHECK_ERROR(accounts.get_record_primitive<uint64_t>(context, account_id,
                             &account_branch_id, 0));
       CHECK_ERROR(accounts.increment_record_oneshot<int64_t>(
@@ -346,7 +358,7 @@ class RunTpcbTask {
       CHECK_ERROR(accounts.overwrite_record(context, account_id,
           &account_balance_new, sizeof(account.branch_id_), sizeof(account_balance_new)));
     }
-    if (accessor_type != kIncrementOneShot) {
+    if (accessor_type != kIncrementOneShot && accessor_type != kIncrementSplit) {
       EXPECT_GE(account_balance_old, 0);
     }
     EXPECT_EQ(branch_id, account_branch_id);
@@ -368,7 +380,7 @@ class RunTpcbTask {
     ASSERT_ND(context->get_current_xct().get_write_set_size() > 0);
     CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
 
-    if (accessor_type != kIncrementOneShot) {
+    if (accessor_type != kIncrementOneShot && accessor_type != kIncrementSplit) {
       std::cout << "Committed! Thread-" << context->get_thread_id() << " Updated "
         << " branch[" << branch_id << "] " << branch_balance_old << " -> " << branch_balance_new
         << " teller[" << teller_id << "] " << teller_balance_old << " -> " << teller_balance_new
@@ -536,6 +548,10 @@ TEST(ArrayTpcbTest, SingleThreadedContendedInc1S)    { run_test(1, true, kIncrem
 TEST(ArrayTpcbTest, TwoThreadedContendedInc1S)       { run_test(2, true, kIncrementOneShot); }
 TEST(ArrayTpcbTest, FourThreadedContendedInc1S)      { run_test(4, true, kIncrementOneShot); }
 
+TEST(ArrayTpcbTest, SingleThreadedContendedIncSplit) { run_test(1, true, kIncrementSplit); }
+TEST(ArrayTpcbTest, TwoThreadedContendedIncSplit)    { run_test(2, true, kIncrementSplit); }
+TEST(ArrayTpcbTest, FourThreadedContendedIncSplit)   { run_test(4, true, kIncrementSplit); }
+
 }  // namespace array
 }  // namespace storage
 }  // namespace foedus
@@ -26,7 +26,10 @@
 #include "foedus/test_common.hpp"
 #include "foedus/proc/proc_manager.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
+#include "foedus/storage/hash/hash_hint_impl.hpp"
 #include "foedus/storage/hash/hash_metadata.hpp"
+#include "foedus/storage/hash/hash_page_impl.hpp"
 #include "foedus/storage/hash/hash_storage.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
@@ -330,6 +333,131 @@ void test_expand(bool update_case) {
 
 TEST(HashBasicTest, ExpandInsert) { test_expand(false); }
 TEST(HashBasicTest, ExpandUpdate) { test_expand(true); }
+
+ErrorStack statistics_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  StorageManager* str_manager = context->get_engine()->get_storage_manager();
+  HashStorage hash = str_manager->get_hash("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  const uint64_t kRecords = 100;
+  for (uint64_t key = 0; key < kRecords; ++key) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    uint64_t data = key * 3;
+    CHECK_ERROR(hash.insert_record(context, key, &data, sizeof(data)));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  for (uint64_t key = 0; key < 10U; ++key) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    CHECK_ERROR(hash.delete_record(context, key));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+
+  const StorageStatistics& stats = str_manager->get_statistics(hash.get_id());
+  EXPECT_EQ(static_cast<int64_t>(kRecords), stats.get_inserted_records());
+  EXPECT_EQ(10, stats.get_deleted_records());
+  EXPECT_EQ(static_cast<int64_t>(kRecords - 10U), stats.get_record_count_estimate());
+
+  // deleted records are still physically there
+  HashStorage::BinHistogram histogram;
+  CHECK_ERROR(hash.estimate_bin_histogram(hash.get_bin_count(), &histogram));
+  EXPECT_EQ(hash.get_bin_count(), histogram.sampled_bins_);
+  EXPECT_EQ(kRecords, histogram.sampled_records_);
+  uint32_t total_bins = 0;
+  for (uint32_t i = 0; i <= HashStorage::BinHistogram::kMaxRecordCount; ++i) {
+    total_bins += histogram.bins_[i];
+  }
+  EXPECT_EQ(histogram.sampled_bins_, total_bins);
+  return foedus::kRetOk;
+}
+
+TEST(HashBasicTest, Statistics) {
+  EngineOptions options = get_tiny_options();
+  options.storage_.record_statistics_ = true;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("statistics_task", statistics_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    HashMetadata meta("ggg", 8);
+    HashStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_hash(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("statistics_task"));
+    COERCE_ERROR(storage.verify_single_thread(&engine));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+ErrorStack bin_hint_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  HashStorage hash = context->get_engine()->get_storage_manager()->get_hash("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  const uint64_t kRecords = 100;
+  for (uint64_t key = 0; key < kRecords; ++key) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    uint64_t data = key * 3;
+    CHECK_ERROR(hash.insert_record(context, key, &data, sizeof(data)));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  HashBinHints* hints = context->get_hash_bin_hints();
+  EXPECT_TRUE(hints != nullptr);
+  for (uint32_t rep = 0; rep < 2U; ++rep) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint64_t key = 0; key < kRecords; ++key) {
+      uint64_t data = 0;
+      uint16_t capacity = sizeof(data);
+      CHECK_ERROR(hash.get_record(context, &key, sizeof(key), &data, &capacity, true));
+      EXPECT_EQ(key * 3, data);
+      // Twice in a row. The second one should hit the hint.
+      data = 0;
+      CHECK_ERROR(hash.get_record(context, &key, sizeof(key), &data, &capacity, true));
+      EXPECT_EQ(key * 3, data);
+    }
+    uint64_t key = kRecords + 1U;
+    uint64_t data = 0;
+    uint16_t capacity = sizeof(data);
+    EXPECT_EQ(
+      kErrorCodeStrKeyNotFound,
+      hash.get_record(context, &key, sizeof(key), &data, &capacity, true));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  uint32_t cached = 0;
+  for (uint16_t i = 0; i < HashBinHints::kSlots; ++i) {
+    const HashBinHints::Entry& entry = hints->entries_[i];
+    if (entry.storage_id_ == hash.get_id()) {
+      ++cached;
+      EXPECT_EQ(entry.bin_, entry.page_->get_bin());
+      EXPECT_EQ(i, HashBinHints::to_slot(entry.storage_id_, entry.bin_));
+    }
+  }
+  EXPECT_GT(cached, 0U);
+  return foedus::kRetOk;
+}
+
+TEST(HashBasicTest, BinHint) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("bin_hint_task", bin_hint_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    HashMetadata meta("ggg", 8);
+    HashStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_hash(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("bin_hint_task"));
+    COERCE_ERROR(storage.verify_single_thread(&engine));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
 // TASK(Hideaki): we don't have multi-thread cases here. it's not a "basic" test.
 // no multi-key cases either. we have to make sure the keys hit the same bucket..
 
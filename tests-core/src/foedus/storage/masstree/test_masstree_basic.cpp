@@ -28,8 +28,11 @@
 #include "foedus/assorted/uniform_random.hpp"
 #include "foedus/proc/proc_manager.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/storage_statistics.hpp"
 #include "foedus/storage/hash/hash_hashinate.hpp"
+#include "foedus/storage/masstree/masstree_hint_impl.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_page_impl.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
@@ -537,6 +540,146 @@ TEST(MasstreeBasicTest, ExpandInsertNormalized) { test_expand(false, true, false
 TEST(MasstreeBasicTest, ExpandUpdate) { test_expand(true, false, false); }
 TEST(MasstreeBasicTest, ExpandUpdateNextLayer) { test_expand(true, false, true); }
 TEST(MasstreeBasicTest, ExpandUpdateNormalized) { test_expand(true, true, false); }
+
+ErrorStack statistics_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  StorageManager* str_manager = context->get_engine()->get_storage_manager();
+  MasstreeStorage masstree = str_manager->get_masstree("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  const KeySlice kRecords = 1000;
+  char data[200];
+  std::memset(data, 0, sizeof(data));
+  for (KeySlice key = 0; key < kRecords; ++key) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    CHECK_ERROR(masstree.insert_record_normalized(context, key, data, sizeof(data)));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  for (KeySlice key = 0; key < 10U; ++key) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    CHECK_ERROR(masstree.delete_record_normalized(context, key));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  CHECK_ERROR(xct_manager->wait_for_commit(commit_epoch));
+
+  const StorageStatistics& stats = str_manager->get_statistics(masstree.get_id());
+  EXPECT_EQ(static_cast<int64_t>(kRecords), stats.get_inserted_records());
+  EXPECT_EQ(10, stats.get_deleted_records());
+  EXPECT_EQ(static_cast<int64_t>(kRecords - 10U), stats.get_record_count_estimate());
+
+  const uint32_t kBuckets = 4;
+  KeySlice boundaries[kBuckets];
+  uint32_t boundary_count;
+  CHECK_ERROR(masstree.estimate_key_histogram(
+    context->get_engine(),
+    kBuckets,
+    boundaries,
+    &boundary_count));
+  // 1000 records of 200 bytes span dozens of border pages.
+  EXPECT_EQ(kBuckets - 1U, boundary_count);
+  for (uint32_t i = 0; i < boundary_count; ++i) {
+    EXPECT_GT(boundaries[i], 0U) << i;
+    EXPECT_LT(boundaries[i], kRecords) << i;
+    if (i > 0) {
+      EXPECT_LT(boundaries[i - 1U], boundaries[i]) << i;
+    }
+  }
+  CHECK_ERROR(masstree.verify_single_thread(context));
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeBasicTest, Statistics) {
+  EngineOptions options = get_tiny_options();
+  options.storage_.record_statistics_ = true;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("statistics_task", statistics_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("ggg");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("statistics_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+ErrorStack descent_hint_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  const KeySlice kRecords = 1000;
+  char data[200];
+  std::memset(data, 0, sizeof(data));
+  for (KeySlice key = 0; key < kRecords; ++key) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    std::memcpy(data, &key, sizeof(key));
+    CHECK_ERROR(masstree.insert_record_normalized(context, key, data, sizeof(data)));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  MasstreeDescentPath* path = context->get_masstree_descent_path(masstree.get_id());
+  EXPECT_TRUE(path != nullptr);
+  assorted::UniformRandom rnd(1234);
+  for (uint32_t rep = 0; rep < 3U; ++rep) {
+    CHECK_ERROR(xct_manager->begin_xct(context, xct::kSerializable));
+    for (KeySlice i = 0; i < kRecords; ++i) {
+      KeySlice key;
+      if (rep == 0) {
+        key = i;  // sequential
+      } else if (rep == 1) {
+        key = kRecords - 1U - i;  // reverse
+      } else {
+        key = rnd.uniform_within(0, kRecords - 1U);
+      }
+      char buf[200];
+      PayloadLength capacity = sizeof(buf);
+      CHECK_ERROR(masstree.get_record_normalized(context, key, buf, &capacity, true));
+      EXPECT_EQ(sizeof(buf), capacity);
+      KeySlice read_key;
+      std::memcpy(&read_key, buf, sizeof(read_key));
+      EXPECT_EQ(key, read_key);
+
+      // The path ends with the border page that has the key
+      ASSERT_ND(path->depth_ > 0);
+      EXPECT_EQ(masstree.get_id(), path->storage_id_);
+      MasstreePage* last = path->pages_[path->depth_ - 1U];
+      EXPECT_TRUE(last->is_border());
+      EXPECT_TRUE(last->within_fences(key));
+    }
+    // Non-existing keys beyond the range
+    char buf[200];
+    PayloadLength capacity = sizeof(buf);
+    EXPECT_EQ(
+      kErrorCodeStrKeyNotFound,
+      masstree.get_record_normalized(context, kRecords + 10U, buf, &capacity, true));
+    CHECK_ERROR(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  CHECK_ERROR(masstree.verify_single_thread(context));
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeBasicTest, DescentHint) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("descent_hint_task", descent_hint_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("ggg");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("descent_hint_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 // TASK(Hideaki): we don't have multi-thread cases here. it's not a "basic" test.
 // no multi-key cases either.
 
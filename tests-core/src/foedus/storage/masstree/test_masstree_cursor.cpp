@@ -17,23 +17,29 @@
  */
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
 #include "foedus/epoch.hpp"
 #include "foedus/test_common.hpp"
+#include "foedus/assorted/endianness.hpp"
 #include "foedus/assorted/uniform_random.hpp"
 #include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/record_predicate.hpp"
 #include "foedus/storage/storage_manager.hpp"
 #include "foedus/storage/masstree/masstree_cursor.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -152,6 +158,635 @@ TEST(MasstreeCursorTest, OnePage) {
   cleanup_test(options);
 }
 
+ErrorStack next_batch_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("test2");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+
+  // enough records for several border pages. some of them are deleted.
+  const uint64_t kCount = 1000;
+  std::vector<uint64_t> answers;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kCount; ++i) {
+    uint64_t datum = i * 3U;
+    WRAP_ERROR_CODE(masstree.insert_record_normalized(context, i, &datum, sizeof(datum)));
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kCount; ++i) {
+    if (i % 7U == 3U) {
+      WRAP_ERROR_CODE(masstree.delete_record_normalized(context, i));
+    } else {
+      answers.push_back(i);
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  for (int backward = 0; backward < 2; ++backward) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    MasstreeCursor cursor(masstree, context);
+    if (backward) {
+      WRAP_ERROR_CODE(cursor.open_normalized(kCount - 10U, 5U, false));
+    } else {
+      WRAP_ERROR_CODE(cursor.open_normalized(5U, kCount - 10U));
+    }
+    std::vector<uint64_t> expected;
+    for (uint64_t key : answers) {
+      if (!backward && key >= 5U && key < kCount - 10U) {
+        expected.push_back(key);
+      } else if (backward && key > 5U && key <= kCount - 10U) {
+        expected.push_back(key);
+      }
+    }
+    if (backward) {
+      std::reverse(expected.begin(), expected.end());
+    }
+
+    // the first record via usual next(), the rest via next_batch()
+    std::vector<uint64_t> results;
+    EXPECT_TRUE(cursor.is_valid_record());
+    results.push_back(cursor.get_normalized_key());
+    WRAP_ERROR_CODE(cursor.next());
+    MasstreeRecordBatch* batch = new MasstreeRecordBatch();
+    uint32_t batches = 0;
+    while (cursor.is_valid_record()) {
+      WRAP_ERROR_CODE(cursor.next_batch(batch));
+      EXPECT_FALSE(batch->is_empty());
+      ++batches;
+      for (uint16_t i = 0; i < batch->get_count(); ++i) {
+        const MasstreeRecordBatch::Entry& entry = batch->get_entry(i);
+        KeySlice key = batch->get_normalized_key(i);
+        EXPECT_EQ(sizeof(KeySlice), entry.key_length_);
+        EXPECT_EQ(sizeof(uint64_t), entry.payload_length_);
+        EXPECT_FALSE(entry.observed_.is_deleted());
+        uint64_t datum;
+        std::memcpy(&datum, entry.payload_, sizeof(datum));
+        EXPECT_EQ(key * 3U, datum) << key;
+        char key_be[sizeof(KeySlice)];
+        batch->copy_combined_key(i, key_be);
+        EXPECT_EQ(key, normalize_be_bytes_full(key_be));
+        results.push_back(key);
+      }
+    }
+    WRAP_ERROR_CODE(cursor.next_batch(batch));
+    EXPECT_TRUE(batch->is_empty());
+    delete batch;
+    EXPECT_GT(batches, 1U);
+    EXPECT_LT(batches, expected.size());
+    EXPECT_EQ(expected, results);
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  CHECK_ERROR(masstree.verify_single_thread(context));
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeCursorTest, NextBatch) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("next_batch_task", next_batch_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("test2");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("next_batch_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+bool is_multiple_of_five(const char* payload, uint16_t payload_length, void* /*user_data*/) {
+  uint64_t datum;
+  EXPECT_EQ(sizeof(datum), payload_length);
+  std::memcpy(&datum, payload, sizeof(datum));
+  return datum % 5U == 0;
+}
+
+ErrorStack predicate_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("test2");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+
+  const uint64_t kCount = 1000;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kCount; ++i) {
+    uint64_t datum = i * 3U;
+    WRAP_ERROR_CODE(masstree.insert_record_normalized(context, i, &datum, sizeof(datum)));
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  // datum >= 600 (key >= 200) and datum % 5 == 0 (key % 5 == 0), key < 500.
+  RecordPredicate field_predicate
+    = RecordPredicate::make_field<uint64_t>(0, RecordPredicate::kGreaterEqual, 600U);
+  field_predicate.filter_function_ = is_multiple_of_five;
+  std::vector<uint64_t> expected;
+  for (uint64_t key = 200; key < 500U; key += 5U) {
+    expected.push_back(key);
+  }
+
+  for (int use_batch = 0; use_batch < 2; ++use_batch) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    MasstreeCursor cursor(masstree, context);
+    cursor.set_predicate(&field_predicate);
+    WRAP_ERROR_CODE(cursor.open_normalized(0, 500U));
+    std::vector<uint64_t> results;
+    MasstreeRecordBatch* batch = new MasstreeRecordBatch();
+    while (cursor.is_valid_record()) {
+      if (use_batch) {
+        WRAP_ERROR_CODE(cursor.next_batch(batch));
+        for (uint16_t i = 0; i < batch->get_count(); ++i) {
+          results.push_back(batch->get_normalized_key(i));
+        }
+      } else {
+        results.push_back(cursor.get_normalized_key());
+        WRAP_ERROR_CODE(cursor.next());
+      }
+    }
+    delete batch;
+    EXPECT_EQ(expected, results);
+    // Filtered-out records are still in the read-set.
+    EXPECT_GE(context->get_current_xct().get_read_set_size(), 500U);
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  // Matches nothing. Should stop at the end key rather than scanning everything.
+  {
+    RecordPredicate none
+      = RecordPredicate::make_field<uint64_t>(0, RecordPredicate::kGreater, kCount * 3U);
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    MasstreeCursor cursor(masstree, context);
+    cursor.set_predicate(&none);
+    WRAP_ERROR_CODE(cursor.open_normalized(0, 100U));
+    EXPECT_FALSE(cursor.is_valid_record());
+    EXPECT_LT(context->get_current_xct().get_read_set_size(), 200U);
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeCursorTest, Predicate) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("predicate_task", predicate_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("test2");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("predicate_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+// enough records for many border pages under a few intermediate pages.
+const uint64_t kPrefetchCount = 5000;
+
+ErrorStack prefetch_insert(thread::Thread* context, MasstreeStorage masstree) {
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kPrefetchCount; ++i) {
+    uint64_t datum = i;
+    WRAP_ERROR_CODE(masstree.insert_record_normalized(context, i, &datum, sizeof(datum)));
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return foedus::kRetOk;
+}
+
+ErrorStack prefetch_scan(thread::Thread* context, MasstreeStorage masstree) {
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  // Prefetching must not change what the cursor returns, whatever the window and the range.
+  const uint16_t kMaxPages[] = {0, 1, MasstreeCursor::kDefaultMaxPrefetchPages, 32};
+  const uint64_t kRanges[][2] = {
+    {0, kPrefetchCount}, {10, 20}, {100, 3000}, {4990, kPrefetchCount}};
+  for (uint16_t max_pages : kMaxPages) {
+    for (const uint64_t* range : kRanges) {
+      for (int forward = 0; forward < 2; ++forward) {
+        WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+        MasstreeCursor cursor(masstree, context);
+        cursor.set_max_prefetch_pages(max_pages);
+        if (forward) {
+          WRAP_ERROR_CODE(cursor.open_normalized(range[0], range[1]));
+        } else {
+          WRAP_ERROR_CODE(cursor.open_normalized(range[1], range[0], false, false, false, true));
+        }
+        uint64_t count = 0;
+        while (cursor.is_valid_record()) {
+          uint64_t expected = forward ? range[0] + count : range[1] - 1U - count;
+          EXPECT_EQ(expected, cursor.get_normalized_key()) << max_pages << "," << forward;
+          uint64_t datum;
+          std::memcpy(&datum, cursor.get_payload(), sizeof(datum));
+          EXPECT_EQ(expected, datum) << max_pages << "," << forward;
+          ++count;
+          WRAP_ERROR_CODE(cursor.next());
+        }
+        EXPECT_EQ(range[1] - range[0], count) << max_pages << "," << range[0] << "," << forward;
+        WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+      }
+    }
+  }
+  return foedus::kRetOk;
+}
+
+ErrorStack prefetch_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("test2");
+  CHECK_ERROR(prefetch_insert(context, masstree));
+  {
+    MasstreeCursor cursor(masstree, context);
+    EXPECT_EQ(MasstreeCursor::kDefaultMaxPrefetchPages, cursor.get_max_prefetch_pages());
+    cursor.set_max_prefetch_pages(1000);
+    EXPECT_EQ(thread::Thread::kMaxFindPagesBatch, cursor.get_max_prefetch_pages());
+  }
+  CHECK_ERROR(prefetch_scan(context, masstree));
+  return foedus::kRetOk;
+}
+
+ErrorStack prefetch_insert_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("test2");
+  return prefetch_insert(context, masstree);
+}
+
+ErrorStack prefetch_scan_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("test2");
+  return prefetch_scan(context, masstree);
+}
+
+TEST(MasstreeCursorTest, Prefetch) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("prefetch_task", prefetch_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("test2");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("prefetch_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+/** Same as Prefetch, but on snapshot pages after the snapshot drops volatile pages */
+void test_prefetch_snapshot(bool snapshot_cache) {
+  EngineOptions options = get_tiny_options();
+  options.cache_.snapshot_cache_enabled_ = snapshot_cache;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("prefetch_insert_task", prefetch_insert_task);
+  engine.get_proc_manager()->pre_register("prefetch_scan_task", prefetch_scan_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("test2");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("prefetch_insert_task"));
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true);
+    EXPECT_TRUE(engine.get_snapshot_manager()->get_snapshot_epoch().is_valid());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("prefetch_scan_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+TEST(MasstreeCursorTest, PrefetchSnapshot) { test_prefetch_snapshot(true); }
+TEST(MasstreeCursorTest, PrefetchSnapshotNoCache) { test_prefetch_snapshot(false); }
+
+ErrorStack resume_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("test2");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+
+  // normalized keys in the first layer and longer keys in the second layer.
+  const uint64_t kCount = 1000;
+  const uint16_t kPageSize = 30;
+  std::vector<std::string> answers;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint64_t i = 0; i < kCount; ++i) {
+    char key[16];
+    std::memset(key, 0, sizeof(key));
+    assorted::write_bigendian<uint64_t>(i / 2U, key);
+    assorted::write_bigendian<uint64_t>(i, key + 8);
+    KeyLength key_length = (i % 2U == 0) ? 8U : 16U;
+    WRAP_ERROR_CODE(masstree.insert_record(context, key, key_length, &i, sizeof(i)));
+    answers.push_back(std::string(key, key_length));
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  for (int forward = 0; forward < 2; ++forward) {
+    std::vector<std::string> results;
+    MasstreeCursorToken token;
+    bool first = true;
+    while (true) {
+      WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+      MasstreeCursor cursor(masstree, context);
+      if (first) {
+        WRAP_ERROR_CODE(cursor.open(nullptr, 0, nullptr, 0, forward));
+        first = false;
+      } else {
+        WRAP_ERROR_CODE(cursor.resume(token));
+      }
+      for (uint16_t i = 0; i < kPageSize && cursor.is_valid_record(); ++i) {
+        char key[16];
+        cursor.copy_combined_key(key);
+        results.push_back(std::string(key, cursor.get_key_length()));
+        WRAP_ERROR_CODE(cursor.next());
+      }
+      cursor.export_token(&token);
+      WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+      EXPECT_EQ(masstree.get_id(), token.storage_id_);
+      EXPECT_EQ(static_cast<bool>(forward), token.forward_cursor_);
+      if (token.finished_) {
+        break;
+      }
+    }
+    if (!forward) {
+      std::reverse(results.begin(), results.end());
+    }
+    EXPECT_EQ(answers, results) << forward;
+
+    // a finished token gives an exhausted cursor
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    MasstreeCursor cursor(masstree, context);
+    WRAP_ERROR_CODE(cursor.resume(token));
+    EXPECT_FALSE(cursor.is_valid_record());
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  // If the record in the token is deleted, resume from the next one. Also with an end key.
+  {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    MasstreeCursor cursor(masstree, context);
+    WRAP_ERROR_CODE(cursor.open(answers[100].data(), answers[100].size()));
+    EXPECT_TRUE(cursor.is_valid_record());
+    MasstreeCursorToken token;
+    cursor.export_token(&token);
+    EXPECT_FALSE(token.finished_);
+    EXPECT_EQ(answers[100], std::string(token.key_, token.key_length_));
+    WRAP_ERROR_CODE(masstree.delete_record(context, answers[100].data(), answers[100].size()));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    MasstreeCursor resumed(masstree, context);
+    WRAP_ERROR_CODE(resumed.resume(token, answers[110].data(), answers[110].size()));
+    for (uint16_t i = 101; i < 110U; ++i) {
+      EXPECT_TRUE(resumed.is_valid_record());
+      char key[16];
+      resumed.copy_combined_key(key);
+      EXPECT_EQ(answers[i], std::string(key, resumed.get_key_length()));
+      WRAP_ERROR_CODE(resumed.next());
+    }
+    EXPECT_FALSE(resumed.is_valid_record());
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+    // a token of another storage is rejected
+    token.storage_id_ = masstree.get_id() + 1U;
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    MasstreeCursor another(masstree, context);
+    EXPECT_EQ(kErrorCodeInvalidParameter, another.resume(token));
+    WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+  }
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeCursorTest, Resume) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("resume_task", resume_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("test2");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("resume_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+/** Reads all keys via next() or next_distinct_prefix(skip_prefix_length) if it's not 0. */
+ErrorCode read_keys(
+  MasstreeCursor* cursor,
+  KeyLength skip_prefix_length,
+  std::vector<std::string>* results) {
+  results->clear();
+  while (cursor->is_valid_record()) {
+    char key[kMaxKeyLength];
+    cursor->copy_combined_key(key);
+    results->push_back(std::string(key, cursor->get_key_length()));
+    if (skip_prefix_length > 0) {
+      CHECK_ERROR_CODE(cursor->next_distinct_prefix(skip_prefix_length));
+    } else {
+      CHECK_ERROR_CODE(cursor->next());
+    }
+  }
+  return kErrorCodeOk;
+}
+
+ErrorStack prefix_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("test2");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+
+  // composite keys of (4-byte a, 4-byte b, 8-byte c), so c is in the second layer.
+  // the last key has an all-FF prefix to test the end of key space.
+  std::vector<std::string> answers;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t a = 0; a <= 20U; ++a) {
+    for (uint32_t b = 0; b < 5U; ++b) {
+      for (uint64_t c = 0; c < 10U; ++c) {
+        char key[16];
+        assorted::write_bigendian<uint32_t>(a == 20U ? 0xFFFFFFFFU : a, key);
+        assorted::write_bigendian<uint32_t>(b, key + 4);
+        assorted::write_bigendian<uint64_t>(c, key + 8);
+        WRAP_ERROR_CODE(masstree.insert_record(context, key, sizeof(key), &c, sizeof(c)));
+        answers.push_back(std::string(key, sizeof(key)));
+      }
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  const KeyLength kPrefixLengths[] = {4, 8, 12, 16};
+  for (KeyLength prefix_length : kPrefixLengths) {
+    for (int forward = 0; forward < 2; ++forward) {
+      // prefix scan. answers[320] is (6, 2, 0).
+      const std::string prefix = answers[320].substr(0, prefix_length);
+      std::vector<std::string> expected;
+      for (const std::string& key : answers) {
+        if (key.compare(0, prefix_length, prefix) == 0) {
+          expected.push_back(key);
+        }
+      }
+      if (!forward) {
+        std::reverse(expected.begin(), expected.end());
+      }
+      WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+      std::vector<std::string> results;
+      MasstreeCursor cursor(masstree, context);
+      WRAP_ERROR_CODE(cursor.open_prefix(prefix.data(), prefix_length, forward));
+      WRAP_ERROR_CODE(read_keys(&cursor, 0, &results));
+      EXPECT_EQ(expected, results) << prefix_length << "," << forward;
+
+      // skip scan. the first key of each distinct prefix in the scan order.
+      expected.clear();
+      for (uint32_t i = 0; i < answers.size(); ++i) {
+        uint32_t index = forward ? i : answers.size() - 1U - i;
+        if (expected.empty()
+          || expected.back().compare(0, prefix_length, answers[index], 0, prefix_length) != 0) {
+          expected.push_back(answers[index]);
+        }
+      }
+      MasstreeCursor skip_cursor(masstree, context);
+      WRAP_ERROR_CODE(skip_cursor.open(nullptr, 0, nullptr, 0, forward));
+      WRAP_ERROR_CODE(read_keys(&skip_cursor, prefix_length, &results));
+      EXPECT_EQ(expected, results) << prefix_length << "," << forward;
+
+      // skip scan within a prefix scan. stops at the end of the prefix.
+      const std::string outer_prefix = answers[320].substr(0, 4);
+      expected.clear();
+      for (uint32_t i = 0; i < answers.size(); ++i) {
+        uint32_t index = forward ? i : answers.size() - 1U - i;
+        if (answers[index].compare(0, 4, outer_prefix) == 0
+          && (expected.empty()
+          || expected.back().compare(0, prefix_length, answers[index], 0, prefix_length) != 0)) {
+          expected.push_back(answers[index]);
+        }
+      }
+      MasstreeCursor both_cursor(masstree, context);
+      WRAP_ERROR_CODE(both_cursor.open_prefix(outer_prefix.data(), 4, forward));
+      WRAP_ERROR_CODE(read_keys(&both_cursor, prefix_length, &results));
+      EXPECT_EQ(expected, results) << prefix_length << "," << forward;
+      WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    }
+  }
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeCursorTest, Prefix) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("prefix_task", prefix_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("test2");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("prefix_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+int sign_of(int value) { return value < 0 ? -1 : (value > 0 ? 1 : 0); }
+
+ErrorStack key_view_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("test2");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+
+  // keys of various lengths spanning up to three layers, sharing prefixes with each other.
+  std::vector<std::string> answers;
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t i = 0; i < 200U; ++i) {
+    std::string key(1U + (i * 7U) % 24U, static_cast<char>('a' + i % 3U));
+    key[key.size() - 1U] = static_cast<char>(i);
+    uint64_t payload = i;
+    ErrorCode code = masstree.insert_record(context, key.data(), key.size(), &payload, 8);
+    if (code == kErrorCodeStrKeyAlreadyExists) {
+      continue;
+    }
+    WRAP_ERROR_CODE(code);
+    answers.push_back(key);
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  std::sort(answers.begin(), answers.end());
+
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  MasstreeCursor cursor(masstree, context);
+  WRAP_ERROR_CODE(cursor.open());
+  for (uint32_t i = 0; i < answers.size(); ++i) {
+    EXPECT_TRUE(cursor.is_valid_record()) << i;
+    MasstreeKeyView view = cursor.get_key_view();
+    const std::string& key = answers[i];
+    EXPECT_EQ(key, view.to_string()) << i;
+    EXPECT_TRUE(view.equals(key.data(), key.size())) << i;
+    for (uint32_t j = 0; j < answers.size(); ++j) {
+      const std::string& other = answers[j];
+      EXPECT_EQ(sign_of(key.compare(other)), sign_of(view.compare(other.data(), other.size())))
+        << i << "," << j;
+    }
+    for (KeyLength offset = 0; offset <= key.size(); ++offset) {
+      EXPECT_TRUE(view.starts_with(key.data(), offset)) << i << "," << offset;
+      char part[kMaxKeyLength];
+      view.copy_part(offset, key.size() - offset, part);
+      EXPECT_EQ(key.substr(offset), std::string(part, key.size() - offset)) << i << "," << offset;
+      if (offset % sizeof(KeySlice) == 0 && offset < key.size()) {
+        EXPECT_EQ(
+          slice_key(key.data() + offset, key.size() - offset),
+          view.get_slice(offset / sizeof(KeySlice))) << i << "," << offset;
+      }
+    }
+    std::string longer = key + "x";
+    EXPECT_FALSE(view.starts_with(longer.data(), longer.size())) << i;
+    std::string different = key;
+    different[different.size() - 1U] ^= 1;
+    EXPECT_FALSE(view.starts_with(different.data(), different.size())) << i;
+    WRAP_ERROR_CODE(cursor.next());
+  }
+  EXPECT_FALSE(cursor.is_valid_record());
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeCursorTest, KeyView) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("key_view_task", key_view_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("test2");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("key_view_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 TEST(MasstreeCursorTest, OneLayer) {
   // TODO(Hideaki) write testcases!
 }
@@ -17,9 +17,11 @@
  */
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "foedus/engine.hpp"
 #include "foedus/engine_options.hpp"
@@ -28,10 +30,16 @@
 #include "foedus/assorted/uniform_random.hpp"
 #include "foedus/proc/proc_manager.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/masstree/masstree_adopt_impl.hpp"
 #include "foedus/storage/masstree/masstree_metadata.hpp"
+#include "foedus/storage/masstree/masstree_page_impl.hpp"
+#include "foedus/storage/masstree/masstree_split_impl.hpp"
 #include "foedus/storage/masstree/masstree_storage.hpp"
+#include "foedus/storage/masstree/masstree_storage_pimpl.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/retrospective_lock_list.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_manager.hpp"
 
 namespace foedus {
@@ -294,6 +302,198 @@ TEST(MasstreeSplitTest, SplitIntermediateSequentialWithHint) {
   test_split_intermediate_sequential(true);
 }
 
+uint32_t count_children(const MasstreeIntermediatePage* page) {
+  uint32_t count = 0;
+  for (uint8_t i = 0; i <= page->get_key_count(); ++i) {
+    count += page->get_minipage(i).key_count_ + 1U;
+  }
+  return count;
+}
+
+ErrorStack batched_adopt_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  // 500 bytes payload -> a few tuples per page, so we get a dozen border pages under root.
+  const uint32_t kRecords = 100;
+  for (uint32_t rep = 0; rep < kRecords; ++rep) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    KeySlice key = normalize_primitive<uint64_t>(rep);
+    char data[500];
+    std::memset(data, 0, sizeof(data));
+    std::memcpy(data + 123, &key, sizeof(key));
+    WRAP_ERROR_CODE(masstree.insert_record_normalized(context, key, data, sizeof(data)));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  // Split root-children without adopting them, as if many threads split them at once.
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  MasstreeStoragePimpl pimpl(&masstree);
+  MasstreeIntermediatePage* root;
+  WRAP_ERROR_CODE(pimpl.get_first_root(context, true, &root));
+  std::vector<MasstreePage*> split_children;
+  for (uint8_t i = 0; i <= root->get_key_count(); ++i) {
+    const MasstreeIntermediatePage::MiniPage& minipage = root->get_minipage(i);
+    for (uint8_t j = 0; j <= minipage.key_count_; ++j) {
+      MasstreePage* child
+        = context->resolve_cast<MasstreePage>(minipage.pointers_[j].volatile_pointer_);
+      if (!child->is_border() || child->get_key_count() < 2U) {
+        continue;
+      }
+      MasstreeBorderPage* casted = reinterpret_cast<MasstreeBorderPage*>(child);
+      SplitBorder split(context, casted, casted->get_slice(casted->get_key_count() / 2U), true);
+      WRAP_ERROR_CODE(context->run_nested_sysxct(&split, 2U));
+      EXPECT_TRUE(child->is_moved());
+      split_children.push_back(child);
+    }
+  }
+  EXPECT_GE(split_children.size(), 3U);
+  const uint32_t before_count = count_children(root);
+
+  // One adoption adopts the other split children, too. The root might be split (compacted)
+  // to adopt all of them, but it happens only once.
+  Adopt adopt(context, root, split_children[0]);
+  WRAP_ERROR_CODE(context->run_nested_sysxct(&adopt, 2U));
+  const uint32_t batched = std::min<uint32_t>(split_children.size(), Adopt::kMaxBatchedAdoptions);
+  for (uint32_t i = 0; i < split_children.size(); ++i) {
+    EXPECT_EQ(i < batched, split_children[i]->is_retired()) << i;
+  }
+  MasstreeIntermediatePage* adopted_root = root;
+  if (root->is_moved()) {
+    // compact-adopt. the foster-major is empty-range.
+    EXPECT_EQ(root->get_high_fence(), root->get_foster_fence());
+    adopted_root = context->resolve_cast<MasstreeIntermediatePage>(root->get_foster_minor());
+  }
+  EXPECT_EQ(before_count + batched, count_children(adopted_root));
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  // now read
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  CHECK_ERROR(masstree.verify_single_thread(context));
+  for (uint32_t rep = 0; rep < kRecords; ++rep) {
+    KeySlice key = normalize_primitive<uint64_t>(rep);
+    char data[500];
+    uint16_t capacity = sizeof(data);
+    WRAP_ERROR_CODE(masstree.get_record_normalized(context, key, data, &capacity, true));
+    EXPECT_EQ(sizeof(data), capacity);
+    KeySlice stored;
+    std::memcpy(&stored, data + 123, sizeof(stored));
+    EXPECT_EQ(key, stored) << rep;
+  }
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeSplitTest, BatchedAdopt) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("the_task", batched_adopt_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("ggg");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("the_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+ErrorStack learned_locks_after_split_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  MasstreeStorage masstree = context->get_engine()->get_storage_manager()->get_masstree("ggg");
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  xct::Xct& current_xct = context->get_current_xct();
+  EXPECT_NE(0U, current_xct.get_rll_profile());  // the hash of the proc name
+  const uint32_t kKeys = 256;
+  const uint32_t kLearnedKey = 3;
+  char data[200];
+  std::memset(data, 0, sizeof(data));
+  Epoch commit_epoch;
+  for (uint32_t rep = 0; rep < 8U; ++rep) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    WRAP_ERROR_CODE(masstree.insert_record_normalized(context, rep, data, sizeof(data)));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+
+  // Learn the lock of kLearnedKey, and renew it with a committed run
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  WRAP_ERROR_CODE(masstree.overwrite_record_normalized(context, kLearnedKey, data, 0, 8U));
+  WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+  EXPECT_EQ(1U, current_xct.get_learned_lock_lists()->get_entry_count(
+    current_xct.get_rll_profile()));
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  WRAP_ERROR_CODE(masstree.overwrite_record_normalized(context, kLearnedKey, data, 0, 8U));
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  // The first run of the next transaction uses it in the same epoch
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  EXPECT_FALSE(current_xct.get_retrospective_lock_list()->is_empty());
+  WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+  EXPECT_TRUE(current_xct.get_retrospective_lock_list()->is_empty());
+
+  // Split the page of kLearnedKey many times. The old pages are retired, and they
+  // go back to the page pool after two epochs.
+  for (uint32_t rep = 8U; rep < kKeys; ++rep) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    WRAP_ERROR_CODE(masstree.insert_record_normalized(context, rep, data, sizeof(data)));
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  xct_manager->advance_current_global_epoch();
+  xct_manager->advance_current_global_epoch();
+
+  // Now the learned lock might be in a recycled page. It must not be used.
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  EXPECT_TRUE(current_xct.get_retrospective_lock_list()->is_empty());
+  uint64_t value = 42;
+  WRAP_ERROR_CODE(masstree.overwrite_record_normalized(
+    context,
+    kLearnedKey,
+    &value,
+    0,
+    sizeof(value)));
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  for (uint32_t rep = 0; rep < kKeys; ++rep) {
+    char buf[500];
+    uint16_t capacity = 500;
+    WRAP_ERROR_CODE(masstree.get_record_normalized(context, rep, buf, &capacity, true));
+    EXPECT_EQ(sizeof(data), capacity) << rep;
+    uint64_t first;
+    std::memcpy(&first, buf, sizeof(first));
+    EXPECT_EQ(rep == kLearnedKey ? value : 0U, first) << rep;
+  }
+  CHECK_ERROR(masstree.verify_single_thread(context));
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return foedus::kRetOk;
+}
+
+TEST(MasstreeSplitTest, LearnedLocksAfterSplit) {
+  EngineOptions options = get_tiny_options();
+  options.xct_.enable_retrospective_lock_list_ = true;
+  options.xct_.epoch_advance_interval_ms_ = 10000;  // we explicitly advance epochs
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("the_task", learned_locks_after_split_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    MasstreeMetadata meta("ggg");
+    MasstreeStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_masstree(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("the_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 }  // namespace masstree
 }  // namespace storage
 }  // namespace foedus
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/sequential/sequential_consumer.hpp"
+#include "foedus/storage/sequential/sequential_metadata.hpp"
+#include "foedus/storage/sequential/sequential_storage.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace storage {
+namespace sequential {
+DEFINE_TEST_CASE_PACKAGE(SequentialConsumerTest, foedus.storage.sequential);
+
+const uint32_t kEpochs = 4;
+const uint32_t kRecordsPerEpoch = 10;
+
+/** Appends kRecordsPerEpoch records in each of kEpochs epochs. Value is epoch * 100 + i. */
+ErrorStack append_records(thread::Thread* context, SequentialStorage sequential) {
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  Epoch commit_epoch;
+  for (uint32_t e = 0; e < kEpochs; ++e) {
+    xct_manager->advance_current_global_epoch();
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint32_t i = 0; i < kRecordsPerEpoch; ++i) {
+      uint64_t data = e * 100U + i;
+      WRAP_ERROR_CODE(sequential.append_record(context, &data, sizeof(data)));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  // Make all of them safe epochs.
+  xct_manager->advance_current_global_epoch();
+  xct_manager->advance_current_global_epoch();
+  return kRetOk;
+}
+
+/** Polls in a transaction and verifies the number of records and epochs and their order. */
+ErrorStack poll_and_check(
+  thread::Thread* context,
+  SequentialConsumer* consumer,
+  uint32_t max_records,
+  uint32_t expected_epochs) {
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  WRAP_ERROR_CODE(consumer->poll(max_records));
+  EXPECT_EQ(expected_epochs * kRecordsPerEpoch, consumer->get_record_count());
+  uint32_t epochs = 0;
+  for (uint32_t i = 0; i < consumer->get_record_count(); ++i) {
+    EXPECT_EQ(sizeof(uint64_t), consumer->get_record_length(i));
+    EXPECT_LT(consumer->get_record_epoch(i), consumer->get_polled_epoch());
+    if (i == 0 || consumer->get_record_epoch(i) != consumer->get_record_epoch(i - 1)) {
+      if (i > 0) {
+        EXPECT_LT(consumer->get_record_epoch(i - 1), consumer->get_record_epoch(i));
+      }
+      ++epochs;
+    }
+  }
+  EXPECT_EQ(expected_epochs, epochs);
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack consume_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  SequentialStorage sequential
+    = context->get_engine()->get_storage_manager()->get_sequential("queue");
+  Epoch commit_epoch;
+  CHECK_ERROR(sequential.add_consumer_group(0, &commit_epoch));
+  CHECK_ERROR(sequential.add_consumer_group(1, &commit_epoch));
+  const Epoch initial_epoch = sequential.get_truncate_epoch();
+  EXPECT_EQ(initial_epoch, sequential.get_consumer_group_epoch(0));
+  EXPECT_EQ(initial_epoch, sequential.get_consumer_group_epoch(1));
+  EXPECT_FALSE(sequential.get_consumer_group_epoch(2).is_valid());
+  CHECK_ERROR(append_records(context, sequential));
+
+  memory::AlignedMemory buffer(1U << 16, 1U << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
+
+  // Group 0 takes one epoch at a time, because two epochs don't fit in 15 records.
+  SequentialConsumer consumer0(context, sequential, 0, buffer.get_block(), buffer.get_size());
+  CHECK_ERROR(poll_and_check(context, &consumer0, 15, 1));
+  const uint64_t first_value = *reinterpret_cast<const uint64_t*>(consumer0.get_record(0));
+  EXPECT_EQ(0U, first_value % 100U);
+  CHECK_ERROR(poll_and_check(context, &consumer0, 15, 1));
+  EXPECT_EQ(
+    first_value + 100U,
+    *reinterpret_cast<const uint64_t*>(consumer0.get_record(0)));
+  const Epoch polled0 = consumer0.get_polled_epoch();
+  CHECK_ERROR(consumer0.ack(&commit_epoch));
+  EXPECT_EQ(polled0, sequential.get_consumer_group_epoch(0));
+  // Group 1 has not consumed anything, so nothing is truncated yet.
+  EXPECT_EQ(initial_epoch, sequential.get_truncate_epoch());
+
+  // Group 1 takes everything at once.
+  SequentialConsumer consumer1(context, sequential, 1, buffer.get_block(), buffer.get_size());
+  CHECK_ERROR(poll_and_check(context, &consumer1, 1000, kEpochs));
+  CHECK_ERROR(consumer1.ack(&commit_epoch));
+  // Now truncated up to the slower group.
+  EXPECT_EQ(polled0, sequential.get_truncate_epoch());
+
+  // Nothing new for group 1.
+  CHECK_ERROR(poll_and_check(context, &consumer1, 1000, 0));
+
+  // A new consumer of group 0 resumes from the acked position.
+  SequentialConsumer consumer0b(context, sequential, 0, buffer.get_block(), buffer.get_size());
+  CHECK_ERROR(poll_and_check(context, &consumer0b, 1000, kEpochs - 2));
+  EXPECT_EQ(
+    first_value + 200U,
+    *reinterpret_cast<const uint64_t*>(consumer0b.get_record(0)));
+
+  // Removing the slow group lets the truncate-epoch follow the other group.
+  CHECK_ERROR(sequential.remove_consumer_group(0, &commit_epoch));
+  EXPECT_FALSE(sequential.get_consumer_group_epoch(0).is_valid());
+  EXPECT_EQ(sequential.get_consumer_group_epoch(1), sequential.get_truncate_epoch());
+
+  // Unused groups can't be polled or acked.
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  EXPECT_EQ(kErrorCodeInvalidParameter, consumer0b.poll(1000));
+  WRAP_ERROR_CODE(xct_manager->abort_xct(context));
+  EXPECT_TRUE(sequential.ack_consumer_group(0, polled0.one_more(), &commit_epoch).is_error());
+  EXPECT_TRUE(sequential.add_consumer_group(kMaxConsumerGroups, &commit_epoch).is_error());
+  return kRetOk;
+}
+
+TEST(SequentialConsumerTest, PollAndAck) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("consume_task", consume_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    SequentialMetadata meta("queue");
+    SequentialStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_sequential(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("consume_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+Epoch acked_truncate_epoch;
+
+ErrorStack ack_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  SequentialStorage sequential
+    = context->get_engine()->get_storage_manager()->get_sequential("queue");
+  Epoch commit_epoch;
+  CHECK_ERROR(sequential.add_consumer_group(0, &commit_epoch));
+  CHECK_ERROR(append_records(context, sequential));
+
+  memory::AlignedMemory buffer(1U << 16, 1U << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
+  SequentialConsumer consumer(context, sequential, 0, buffer.get_block(), buffer.get_size());
+  CHECK_ERROR(poll_and_check(context, &consumer, 15, 1));
+  CHECK_ERROR(consumer.ack(&commit_epoch));
+  EXPECT_TRUE(commit_epoch.is_valid());
+  // The only group moved, so the same metadata log truncated the storage.
+  EXPECT_EQ(consumer.get_polled_epoch(), sequential.get_consumer_group_epoch(0));
+  EXPECT_EQ(consumer.get_polled_epoch(), sequential.get_truncate_epoch());
+  acked_truncate_epoch = sequential.get_truncate_epoch();
+  WRAP_ERROR_CODE(context->get_engine()->get_xct_manager()->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+TEST(SequentialConsumerTest, AckAfterRestart) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("ack_task", ack_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    SequentialMetadata meta("queue");
+    SequentialStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_sequential(&meta, &storage, &epoch));
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("ack_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    SequentialStorage storage(&engine, "queue");
+    EXPECT_EQ(acked_truncate_epoch, storage.get_consumer_group_epoch(0));
+    EXPECT_EQ(acked_truncate_epoch, storage.get_truncate_epoch());
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace sequential
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(SequentialConsumerTest, foedus.storage.sequential);
@@ -19,6 +19,7 @@
 #include <gtest/gtest.h>
 
 #include <atomic>
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -31,7 +32,9 @@
 #include "foedus/memory/engine_memory.hpp"
 #include "foedus/proc/proc_manager.hpp"
 #include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/record_predicate.hpp"
 #include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/sequential/sequential_composer_impl.hpp"
 #include "foedus/storage/sequential/sequential_cursor.hpp"
 #include "foedus/storage/sequential/sequential_metadata.hpp"
 #include "foedus/storage/sequential/sequential_page_impl.hpp"
@@ -166,6 +169,91 @@ TEST(SequentialCursorTest, IteratorRawPage) {
   }
 }
 
+bool is_multiple_of(const char* payload, uint16_t payload_length, void* user_data) {
+  uint64_t value;
+  EXPECT_EQ(sizeof(value), payload_length);
+  std::memcpy(&value, payload, sizeof(value));
+  return value % *reinterpret_cast<uint64_t*>(user_data) == 0;
+}
+
+TEST(SequentialCursorTest, IteratorPredicate) {
+  memory::AlignedMemory memory;
+  memory.alloc(1 << 12, 1 << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
+  SequentialPage* page = reinterpret_cast<SequentialPage*>(memory.get_block());
+  page->initialize_snapshot_page(1, to_snapshot_page_pointer(1, 0, 1));
+
+  const uint16_t kRecords = 30;
+  const Epoch::EpochInteger kBeginEpoch = 42;
+  for (uint64_t i = 0; i < kRecords; ++i) {
+    xct::XctId xct_id;
+    xct_id.set(i % 2 == 0 ? kBeginEpoch : kBeginEpoch + 1, 123);
+    uint64_t payload = i * 10U;
+    page->append_record_nosync(xct_id, sizeof(payload), &payload);
+  }
+  const SequentialRecordBatch* batch = reinterpret_cast<const SequentialRecordBatch*>(page);
+
+  // typed predicate on the field, combined with the epoch range
+  {
+    RecordPredicate predicate
+      = RecordPredicate::make_field<uint64_t>(0, RecordPredicate::kGreaterEqual, 100U);
+    SequentialRecordIterator it(batch, Epoch(kBeginEpoch), Epoch(kBeginEpoch + 1), &predicate);
+    for (uint64_t i = 10; i < kRecords; i += 2U) {
+      EXPECT_TRUE(it.is_valid());
+      uint64_t payload;
+      it.copy_cur_record(reinterpret_cast<char*>(&payload), sizeof(payload));
+      EXPECT_EQ(i * 10U, payload);
+      it.next();
+    }
+    EXPECT_FALSE(it.is_valid());
+    EXPECT_EQ(kRecords / 2U, it.get_stat_skipped_records());
+    EXPECT_EQ(5U, it.get_stat_filtered_records());
+  }
+
+  // user-defined function
+  {
+    uint64_t divisor = 30;
+    RecordPredicate predicate = RecordPredicate::make_function(is_multiple_of, &divisor);
+    SequentialRecordIterator it(batch, Epoch(1), Epoch(100), &predicate);
+    for (uint64_t i = 0; i < kRecords; i += 3U) {
+      EXPECT_TRUE(it.is_valid());
+      uint64_t payload;
+      it.copy_cur_record(reinterpret_cast<char*>(&payload), sizeof(payload));
+      EXPECT_EQ(i * 10U, payload);
+      it.next();
+    }
+    EXPECT_FALSE(it.is_valid());
+    EXPECT_EQ(0U, it.get_stat_skipped_records());
+    EXPECT_EQ(kRecords - kRecords / 3U, it.get_stat_filtered_records());
+  }
+}
+
+TEST(SequentialCursorTest, PageEpochRange) {
+  memory::AlignedMemory memory;
+  memory.alloc(1 << 12, 1 << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
+  SequentialPage* page = reinterpret_cast<SequentialPage*>(memory.get_block());
+  page->initialize_snapshot_page(1, to_snapshot_page_pointer(1, 0, 1));
+  EXPECT_FALSE(page->get_min_epoch().is_valid());
+  EXPECT_FALSE(page->get_max_epoch().is_valid());
+
+  const Epoch::EpochInteger kEpochs[] = {45, 43, 47, 44};
+  for (uint16_t i = 0; i < sizeof(kEpochs) / sizeof(kEpochs[0]); ++i) {
+    xct::XctId xct_id;
+    xct_id.set(kEpochs[i], 123);
+    uint64_t payload = i;
+    page->append_record_nosync(xct_id, sizeof(payload), &payload);
+  }
+  EXPECT_EQ(Epoch(43), page->get_min_epoch());
+  EXPECT_EQ(Epoch(47), page->get_max_epoch());
+
+  // SequentialRecordBatch has the same layout
+  const SequentialRecordBatch* batch = reinterpret_cast<const SequentialRecordBatch*>(page);
+  EXPECT_EQ(4U, batch->get_record_count());
+  EXPECT_EQ(Epoch(43), batch->min_epoch_);
+  EXPECT_EQ(Epoch(47), batch->max_epoch_);
+  EXPECT_EQ(page->next_page().snapshot_pointer_, batch->next_page_.snapshot_pointer_);
+  EXPECT_EQ(Epoch(45), batch->get_epoch_from_offset(0));
+}
+
 const uint32_t kRecordsPerXct = 1 << 6;
 const uint32_t kXctsPerCore = 1 << 6;
 const uint32_t kMaxXctsPerEpoch = 1 << 3;
@@ -519,8 +607,12 @@ ErrorStack scan_task(const proc::ProcArguments& args) {
 void test_cursor(
   bool has_volatile,
   bool has_snapshot,
-  bool multi_node) {
+  bool multi_node,
+  bool mmap = false,
+  bool verify_checksum = false) {
   EngineOptions options = get_tiny_options();
+  options.cache_.snapshot_file_mmap_ = mmap;
+  options.cache_.verify_snapshot_checksum_ = verify_checksum;
   const uint16_t kRecordsPerPageConservative = 8;
   uint32_t pages_conservative
     = kRecordsPerXct * kXctsPerCore / kRecordsPerPageConservative;
@@ -658,6 +750,194 @@ TEST(SequentialCursorTest, Volatile2Node) { test_cursor(true, false, true); }
 TEST(SequentialCursorTest, Snapshot2Node) { test_cursor(false, true, true); }
 TEST(SequentialCursorTest, Both2Node)     { test_cursor(true, true, true); }
 
+TEST(SequentialCursorTest, Snapshot1NodeMmap) { test_cursor(false, true, false, true); }
+TEST(SequentialCursorTest, Both2NodeMmap)     { test_cursor(true, true, true, true); }
+
+TEST(SequentialCursorTest, Snapshot2NodeChecksum) { test_cursor(false, true, true, false, true); }
+TEST(SequentialCursorTest, Snapshot2NodeMmapChecksum) {
+  test_cursor(false, true, true, true, true);
+}
+
+// Large records over a few epochs so that one compose() writes several head pages.
+const uint32_t kHeadsRecordsPerXct = 25;
+const uint32_t kHeadsXcts = 24;
+const uint32_t kHeadsXctsPerEpoch = 3;
+const uint32_t kHeadsRecords = kHeadsRecordsPerXct * kHeadsXcts;
+const uint16_t kHeadsPayload = 1000;
+
+struct HeadsSharedData {
+  Epoch xct_epochs_[kHeadsXcts];
+};
+
+ErrorStack heads_load_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  SequentialStorage sequential(context->get_engine(), kStorageName);
+  HeadsSharedData* shared_data = reinterpret_cast<HeadsSharedData*>(
+    context->get_engine()->get_memory_manager()->get_shared_user_memory());
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  char payload[kHeadsPayload];
+  std::memset(payload, 0, sizeof(payload));
+  Epoch commit_epoch;
+  for (uint32_t x = 0; x < kHeadsXcts; ++x) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint32_t t = 0; t < kHeadsRecordsPerXct; ++t) {
+      uint64_t data = x * kHeadsRecordsPerXct + t;
+      std::memcpy(payload, &data, sizeof(data));
+      WRAP_ERROR_CODE(sequential.append_record(context, payload, sizeof(payload)));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    shared_data->xct_epochs_[x] = commit_epoch;
+    if ((x + 1U) % kHeadsXctsPerEpoch == 0) {
+      xct_manager->advance_current_global_epoch();
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+/** Reads [from_epoch, to_epoch) and checks that it returns exactly the records there. */
+ErrorStack heads_scan(
+  thread::Thread* context,
+  Epoch from_epoch,
+  Epoch to_epoch,
+  uint64_t* read_pages,
+  uint64_t* skipped_pages) {
+  SequentialStorage sequential(context->get_engine(), kStorageName);
+  HeadsSharedData* shared_data = reinterpret_cast<HeadsSharedData*>(
+    context->get_engine()->get_memory_manager()->get_shared_user_memory());
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  memory::AlignedMemory read_buffer(
+    1U << 16,
+    1U << 12,
+    memory::AlignedMemory::kNumaAllocOnnode,
+    context->get_numa_node());
+
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSnapshot));
+  SequentialCursor cursor(
+    context,
+    sequential,
+    read_buffer.get_block(),
+    read_buffer.get_size(),
+    SequentialCursor::kNodeFirstMode,
+    from_epoch,
+    to_epoch);
+  std::vector<bool> observed(kHeadsRecords, false);
+  uint64_t batches = 0;
+  SequentialRecordIterator it;
+  while (cursor.is_valid()) {
+    WRAP_ERROR_CODE(cursor.next_batch(&it));
+    if (it.is_valid()) {
+      ++batches;
+    }
+    while (it.is_valid()) {
+      EXPECT_EQ(kHeadsPayload, it.get_cur_record_length());
+      uint64_t data;
+      it.copy_cur_record(reinterpret_cast<char*>(&data), sizeof(data));
+      EXPECT_LT(data, kHeadsRecords);
+      if (data < kHeadsRecords) {
+        EXPECT_FALSE(observed[data]) << data;
+        observed[data] = true;
+        EXPECT_EQ(shared_data->xct_epochs_[data / kHeadsRecordsPerXct], it.get_cur_record_epoch());
+      }
+      it.next();
+    }
+  }
+  EXPECT_TRUE(cursor.is_finished_snapshots());
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  for (uint32_t i = 0; i < kHeadsRecords; ++i) {
+    Epoch epoch = shared_data->xct_epochs_[i / kHeadsRecordsPerXct];
+    EXPECT_EQ(epoch >= from_epoch && epoch < to_epoch, observed[i]) << i;
+  }
+  *read_pages = batches;
+  *skipped_pages = cursor.get_stat_skipped_pages();
+  return kRetOk;
+}
+
+ErrorStack heads_scan_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  SequentialStorage sequential(context->get_engine(), kStorageName);
+  HeadsSharedData* shared_data = reinterpret_cast<HeadsSharedData*>(
+    context->get_engine()->get_memory_manager()->get_shared_user_memory());
+
+  // compose() must have split the pages into several heads in epoch order
+  SnapshotPagePointer root_page_id = sequential.get_metadata()->root_snapshot_page_id_;
+  EXPECT_NE(0U, root_page_id);
+  SequentialRootPage* root;
+  WRAP_ERROR_CODE(context->find_or_read_a_snapshot_page(
+    root_page_id,
+    reinterpret_cast<Page**>(&root)));
+  EXPECT_EQ(0U, root->get_next_page());
+  const uint16_t heads = root->get_pointer_count();
+  EXPECT_GE(heads, 3U);
+  uint64_t total_pages = 0;
+  for (uint16_t i = 0; i < heads; ++i) {
+    const HeadPagePointer& pointer = root->get_pointers()[i];
+    EXPECT_LT(pointer.from_epoch_, pointer.to_epoch_);
+    if (i + 1U < heads) {
+      EXPECT_EQ(static_cast<uint64_t>(SequentialComposer::kPagesPerHead), pointer.page_count_);
+      EXPECT_LE(pointer.to_epoch_, root->get_pointers()[i + 1U].from_epoch_.one_more());
+    }
+    total_pages += pointer.page_count_;
+  }
+
+  const Epoch first_epoch = shared_data->xct_epochs_[0];
+  const Epoch last_epoch = shared_data->xct_epochs_[kHeadsXcts - 1U];
+  uint64_t read_pages;
+  uint64_t skipped_pages;
+
+  // everything
+  CHECK_ERROR(heads_scan(context, first_epoch, last_epoch.one_more(), &read_pages, &skipped_pages));
+  EXPECT_EQ(total_pages, read_pages);
+  EXPECT_EQ(0U, skipped_pages);
+
+  // only the first epoch. the first page beyond it ends the scan of the head, and the other
+  // heads are not even opened.
+  CHECK_ERROR(heads_scan(context, first_epoch, first_epoch.one_more(), &read_pages,
+                         &skipped_pages));
+  EXPECT_LT(read_pages, static_cast<uint64_t>(SequentialComposer::kPagesPerHead));
+  EXPECT_LE(skipped_pages, 1U);
+
+  // one epoch in the middle. at most the two heads that contain the epoch are read.
+  const Epoch middle_epoch = shared_data->xct_epochs_[kHeadsXcts / 2U];
+  CHECK_ERROR(heads_scan(context, middle_epoch, middle_epoch.one_more(), &read_pages,
+                         &skipped_pages));
+  EXPECT_GT(read_pages, 0U);
+  EXPECT_LE(read_pages + skipped_pages, 2U * SequentialComposer::kPagesPerHead);
+  EXPECT_LT(read_pages + skipped_pages, total_pages);
+  return kRetOk;
+}
+
+TEST(SequentialCursorTest, SnapshotHeads) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = 1;
+  options.thread_.group_count_ = 1;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("heads_load_task", heads_load_task);
+  engine.get_proc_manager()->pre_register("heads_scan_task", heads_scan_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    SequentialMetadata meta(kStorageName);
+    SequentialStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_sequential(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+    std::memset(engine.get_memory_manager()->get_shared_user_memory(), 0, sizeof(HeadsSharedData));
+
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("heads_load_task"));
+    Epoch snapshot_epoch = engine.get_log_manager()->get_durable_global_epoch();
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(true, snapshot_epoch);
+    EXPECT_EQ(snapshot_epoch, engine.get_snapshot_manager()->get_snapshot_epoch());
+    EXPECT_EQ(kSequentialPageFormat, storage.get_sequential_metadata()->page_format_);
+
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("heads_scan_task"));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 }  // namespace sequential
 }  // namespace storage
 }  // namespace foedus
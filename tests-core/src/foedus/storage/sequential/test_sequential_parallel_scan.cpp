@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2014-2015, Hewlett-Packard Development Company, LP.
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details. You should have received a copy of the GNU General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * HP designates this particular file as subject to the "Classpath" exception
+ * as provided by HP in the LICENSE.txt file that accompanied this code.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "foedus/engine.hpp"
+#include "foedus/engine_options.hpp"
+#include "foedus/epoch.hpp"
+#include "foedus/test_common.hpp"
+#include "foedus/log/log_manager.hpp"
+#include "foedus/memory/aligned_memory.hpp"
+#include "foedus/proc/proc_manager.hpp"
+#include "foedus/snapshot/snapshot_manager.hpp"
+#include "foedus/storage/storage_manager.hpp"
+#include "foedus/storage/sequential/sequential_cursor.hpp"
+#include "foedus/storage/sequential/sequential_metadata.hpp"
+#include "foedus/storage/sequential/sequential_parallel_scan.hpp"
+#include "foedus/storage/sequential/sequential_storage.hpp"
+#include "foedus/thread/impersonate_session.hpp"
+#include "foedus/thread/thread.hpp"
+#include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
+#include "foedus/xct/xct_manager.hpp"
+
+namespace foedus {
+namespace storage {
+namespace sequential {
+DEFINE_TEST_CASE_PACKAGE(SequentialParallelScanTest, foedus.storage.sequential);
+
+const uint32_t kXctsPerThread = 20;
+const uint32_t kRecordsPerXct = 10;
+const uint64_t kRecordsPerThread = kXctsPerThread * kRecordsPerXct;
+/** Each record is thread ordinal * kValueBase + i */
+const uint64_t kValueBase = 1000000;
+
+struct ScanOutput {
+  uint64_t  count_;
+  uint64_t  sum_;
+  /** Number of records appended by a thread other than the partition. */
+  uint64_t  other_threads_;
+};
+
+ErrorStack load_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  SequentialStorage sequential = args.engine_->get_storage_manager()->get_sequential("history");
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  const uint64_t ordinal = context->get_thread_global_ordinal();
+  Epoch commit_epoch;
+  for (uint32_t x = 0; x < kXctsPerThread; ++x) {
+    WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+    for (uint32_t i = 0; i < kRecordsPerXct; ++i) {
+      uint64_t data = ordinal * kValueBase + x * kRecordsPerXct + i;
+      WRAP_ERROR_CODE(sequential.append_record(context, &data, sizeof(data)));
+    }
+    WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+    if (x % 5U == 0) {
+      xct_manager->advance_current_global_epoch();
+    }
+  }
+  WRAP_ERROR_CODE(xct_manager->wait_for_commit(commit_epoch));
+  return kRetOk;
+}
+
+ErrorStack scan_task(const proc::ProcArguments& args) {
+  const SequentialScanPartition* partition = SequentialScanPartition::from_args(args);
+  EXPECT_EQ(sizeof(uint32_t), partition->user_input_len_);
+  const uint32_t check_threads = *reinterpret_cast<const uint32_t*>(partition->get_user_input());
+  thread::Thread* context = args.context_;
+  SequentialStorage sequential(args.engine_, partition->storage_id_);
+  xct::XctManager* xct_manager = args.engine_->get_xct_manager();
+  memory::AlignedMemory buffer(1U << 16, 1U << 12, memory::AlignedMemory::kNumaAllocOnnode, 0);
+
+  ScanOutput output;
+  std::memset(&output, 0, sizeof(output));
+  WRAP_ERROR_CODE(xct_manager->begin_xct(context, xct::kSerializable));
+  SequentialCursor cursor(
+    context,
+    sequential,
+    buffer.get_block(),
+    buffer.get_size(),
+    SequentialCursor::kNodeFirstMode,
+    partition->from_epoch_,
+    partition->to_epoch_,
+    partition->node_);
+  cursor.set_partition(partition->partition_, partition->partition_count_);
+  SequentialRecordIterator it;
+  while (cursor.is_valid()) {
+    WRAP_ERROR_CODE(cursor.next_batch(&it));
+    for (; it.is_valid(); it.next()) {
+      uint64_t data;
+      it.copy_cur_record(reinterpret_cast<char*>(&data), sizeof(data));
+      ++output.count_;
+      output.sum_ += data;
+      uint64_t writer = data / kValueBase;
+      if (check_threads && writer % partition->partition_count_ != partition->partition_) {
+        ++output.other_threads_;
+      }
+    }
+  }
+  Epoch commit_epoch;
+  WRAP_ERROR_CODE(xct_manager->precommit_xct(context, &commit_epoch));
+
+  std::memcpy(args.output_buffer_, &output, sizeof(output));
+  *args.output_used_ = sizeof(output);
+  return kRetOk;
+}
+
+void merge_outputs(
+  const SequentialScanPartition& /*partition*/,
+  const void* output,
+  uint64_t output_size,
+  void* user_data) {
+  EXPECT_EQ(sizeof(ScanOutput), output_size);
+  const ScanOutput* partial = reinterpret_cast<const ScanOutput*>(output);
+  ScanOutput* total = reinterpret_cast<ScanOutput*>(user_data);
+  total->count_ += partial->count_;
+  total->sum_ += partial->sum_;
+  total->other_threads_ += partial->other_threads_;
+}
+
+void run_and_check(Engine* engine, uint32_t check_threads, uint16_t partition_count) {
+  const uint16_t threads = engine->get_options().thread_.thread_count_per_group_;
+  SequentialStorage sequential = engine->get_storage_manager()->get_sequential("history");
+  SequentialParallelScan scan(engine, sequential, "scan_task");
+  EXPECT_EQ(threads, scan.get_partition_count());
+  if (partition_count > 0) {
+    scan.set_partition_count(partition_count);
+  }
+  ScanOutput total;
+  std::memset(&total, 0, sizeof(total));
+  COERCE_ERROR(scan.run(&check_threads, sizeof(check_threads), merge_outputs, &total));
+
+  uint64_t expected_sum = 0;
+  for (uint64_t ordinal = 0; ordinal < threads; ++ordinal) {
+    for (uint64_t i = 0; i < kRecordsPerThread; ++i) {
+      expected_sum += ordinal * kValueBase + i;
+    }
+  }
+  EXPECT_EQ(threads * kRecordsPerThread, total.count_);
+  EXPECT_EQ(expected_sum, total.sum_);
+  EXPECT_EQ(0U, total.other_threads_);
+}
+
+TEST(SequentialParallelScanTest, VolatileAndSnapshot) {
+  EngineOptions options = get_tiny_options();
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("load_task", load_task);
+  engine.get_proc_manager()->pre_register("scan_task", scan_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    SequentialMetadata meta("history");
+    SequentialStorage storage;
+    Epoch epoch;
+    COERCE_ERROR(engine.get_storage_manager()->create_sequential(&meta, &storage, &epoch));
+    EXPECT_TRUE(storage.exists());
+
+    const uint16_t threads = options.thread_.thread_count_per_group_;
+    std::vector< thread::ImpersonateSession > sessions;
+    for (uint16_t core = 0; core < threads; ++core) {
+      thread::ImpersonateSession session;
+      EXPECT_TRUE(engine.get_thread_pool()->impersonate_on_numa_core(
+        thread::compose_thread_id(0, core),
+        "load_task",
+        nullptr,
+        0,
+        &session));
+      sessions.emplace_back(std::move(session));
+    }
+    for (thread::ImpersonateSession& s : sessions) {
+      COERCE_ERROR(s.get_result());
+      s.release();
+    }
+    // Make all of them safe epochs.
+    engine.get_xct_manager()->advance_current_global_epoch();
+    engine.get_xct_manager()->advance_current_global_epoch();
+
+    // Volatile pages. Each partition reads the pages written by the threads of the same ordinal
+    // modulo the partition count. Both with the default and fewer partitions than threads.
+    run_and_check(&engine, 1U, 0);
+    run_and_check(&engine, 1U, std::max<uint16_t>(1U, threads - 1U));
+
+    // Snapshot pages. The snapshot merges threads, so we check only the totals.
+    engine.get_snapshot_manager()->trigger_snapshot_immediate(
+      true,
+      engine.get_log_manager()->get_durable_global_epoch());
+    run_and_check(&engine, 0U, 0);
+    run_and_check(&engine, 0U, std::max<uint16_t>(1U, threads - 1U));
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
+}  // namespace sequential
+}  // namespace storage
+}  // namespace foedus
+
+TEST_MAIN_CAPTURE_SIGNALS(SequentialParallelScanTest, foedus.storage.sequential);
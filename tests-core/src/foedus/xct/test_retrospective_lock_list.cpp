@@ -20,6 +20,9 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 #include "foedus/test_common.hpp"
 #include "foedus/assorted/uniform_random.hpp"
@@ -386,8 +389,173 @@ void test_cll_release_after() {
   }
 }
 
+template <class RW_BLOCK>
+void test_cll_wait_die(bool older) {
+  RwLockableXctId* lock_addresses[2];
+  UniversalLockId lock_ids[2];
+  McsMockContext< RW_BLOCK > con;
+  con.init(kDummyStorageId, kNodes, 2U, 1U << 16, kMaxLockCount);
+  for (uint32_t i = 0; i < 2U; ++i) {
+    lock_addresses[i] = con.get_rw_lock_address(kDefaultNodeId, i);
+    lock_ids[i] = xct::to_universal_lock_id(
+      con.page_memory_resolver_,
+      reinterpret_cast<uintptr_t>(lock_addresses[i]));
+  }
+  con.nodes_[kDefaultNodeId].threads_[0].xct_timestamp_ = older ? 1U : 2U;
+  con.nodes_[kDefaultNodeId].threads_[1].xct_timestamp_ = older ? 2U : 1U;
+
+  // The other thread holds lock-0
+  McsMockAdaptor<RW_BLOCK> other_adaptor(1U, &con);
+  McsImpl< McsMockAdaptor<RW_BLOCK> , RW_BLOCK> other_impl(other_adaptor);
+  McsRwLock* other_lock = lock_addresses[0]->get_key_lock();
+  McsBlockIndex other_block = other_impl.acquire_unconditional_rw_writer(other_lock);
+
+  const uint32_t kBufferSize = 1024;
+  LockEntry cll_buffer[kBufferSize];
+  CurrentLockList list;
+  list.init(cll_buffer, kBufferSize, con.page_memory_resolver_);
+  list.set_wait_die(true);
+  McsMockAdaptor<RW_BLOCK> adaptor(0, &con);
+  McsImpl< McsMockAdaptor<RW_BLOCK> , RW_BLOCK> impl(adaptor);
+
+  // We hold lock-1, then want lock-0. Not in canonical mode.
+  EXPECT_EQ(1U, list.get_or_add_entry(lock_ids[1], lock_addresses[1], kWriteLock));
+  EXPECT_EQ(kErrorCodeOk, list.try_or_acquire_single_lock(1U, &impl));
+  EXPECT_EQ(1U, list.get_or_add_entry(lock_ids[0], lock_addresses[0], kWriteLock));
+  EXPECT_EQ(2U, list.get_last_locked_entry());
+
+  if (!older) {
+    // Die
+    EXPECT_EQ(kErrorCodeXctLockAbort, list.try_or_acquire_single_lock(1U, &impl));
+    EXPECT_EQ(2U, list.get_last_locked_entry());
+    EXPECT_TRUE(lock_addresses[1]->is_keylocked());
+  } else {
+    // Wait, after releasing lock-1
+    std::thread releaser([&other_impl, other_lock, other_block]{
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      other_impl.release_rw_writer(other_lock, other_block);
+    });
+    EXPECT_EQ(kErrorCodeOk, list.try_or_acquire_single_lock(1U, &impl));
+    releaser.join();
+    EXPECT_EQ(1U, list.get_last_locked_entry());
+    EXPECT_TRUE(list.get_entry(1U)->is_locked());
+    EXPECT_FALSE(list.get_entry(2U)->is_locked());
+    EXPECT_FALSE(lock_addresses[1]->is_keylocked());
+  }
+  list.release_all_locks(&impl);
+  if (!older) {
+    other_impl.release_rw_writer(other_lock, other_block);
+  }
+  EXPECT_FALSE(lock_addresses[0]->is_keylocked());
+  EXPECT_FALSE(lock_addresses[1]->is_keylocked());
+}
+
 TEST(RllTest, CllReleaseAfterSimple)    { test_cll_release_after<McsRwSimpleBlock>(); }
 TEST(RllTest, CllReleaseAfterExtended)  { test_cll_release_after<McsRwExtendedBlock>(); }
+TEST(RllTest, CllWaitSimple)    { test_cll_wait_die<McsRwSimpleBlock>(true); }
+TEST(RllTest, CllWaitExtended)  { test_cll_wait_die<McsRwExtendedBlock>(true); }
+TEST(RllTest, CllDieSimple)     { test_cll_wait_die<McsRwSimpleBlock>(false); }
+TEST(RllTest, CllDieExtended)   { test_cll_wait_die<McsRwExtendedBlock>(false); }
+
+TEST(RllTest, LearnedProfile) {
+  RwLockableXctId* lock_addresses[kMaxLockCount];
+  UniversalLockId lock_ids[kMaxLockCount];
+  McsMockContext<McsRwSimpleBlock> con;
+  con.init(kDummyStorageId, kNodes, 1U, 1U << 16, kMaxLockCount);
+  for (uint32_t i = 0; i < kMaxLockCount; ++i) {
+    lock_addresses[i] = con.get_rw_lock_address(kDefaultNodeId, i);
+    lock_ids[i] = xct::to_universal_lock_id(
+      con.page_memory_resolver_,
+      reinterpret_cast<uintptr_t>(lock_addresses[i]));
+  }
+
+  // Emulates an RLL constructed after an abort: [1(R), 3(W)]
+  LearnedLockEntry aborted[2];
+  aborted[0].universal_lock_id_ = lock_ids[1];
+  aborted[0].preferred_mode_ = kReadLock;
+  aborted[0].confidence_ = LearnedLockListCache::kConfidenceIncrement;
+  aborted[1] = aborted[0];
+  aborted[1].universal_lock_id_ = lock_ids[3];
+  aborted[1].preferred_mode_ = kWriteLock;
+  const uint32_t kBufferSize = 1024;
+  LockEntry rll_buffer[kBufferSize];
+  RetrospectiveLockList rll;
+  rll.init(rll_buffer, kBufferSize, con.page_memory_resolver_);
+  rll.construct_from_learned(aborted, 2U, 0, Epoch());
+  EXPECT_EQ(2U, rll.get_last_active_entry());
+  EXPECT_EQ(lock_addresses[1], rll.get_entry(1U)->lock_);
+  EXPECT_EQ(lock_addresses[3], rll.get_entry(2U)->lock_);
+
+  const uint16_t kProfiles = 2;
+  const uint16_t kEntries = 4;
+  std::vector<char> memory(LearnedLockListCache::calculate_memory_size(kProfiles, kEntries));
+  LearnedLockListCache cache;
+  cache.init(memory.data(), kProfiles, kEntries);
+  EXPECT_TRUE(cache.is_enabled());
+  const uint64_t kProfileA = LearnedLockListCache::to_profile("a", 1U);
+  const uint64_t kProfileB = LearnedLockListCache::to_profile("b", 1U);
+  const uint64_t kProfileC = LearnedLockListCache::to_profile("c", 1U);
+  const uint64_t kGeneration = 3U;
+  const Epoch kEpoch(5U);
+
+  LockEntry applied_buffer[kBufferSize];
+  RetrospectiveLockList applied;
+  applied.init(applied_buffer, kBufferSize, con.page_memory_resolver_);
+  EXPECT_FALSE(cache.apply(kProfileA, kGeneration, kEpoch, &applied));
+
+  // Learn [1(R), 3(W)], then [0(R), 3(R)] on profile A
+  cache.learn_from_abort(kProfileA, kGeneration, kEpoch, rll);
+  aborted[0].universal_lock_id_ = lock_ids[0];
+  aborted[1].preferred_mode_ = kReadLock;
+  rll.construct_from_learned(aborted, 2U, 0, Epoch());
+  cache.learn_from_abort(kProfileA, kGeneration, kEpoch, rll);
+  EXPECT_EQ(3U, cache.get_entry_count(kProfileA));
+  EXPECT_EQ(0U, cache.get_entry_count(kProfileB));
+
+  // The first run of profile A gets [0(R), 1(R), 3(W)]
+  EXPECT_TRUE(cache.apply(kProfileA, kGeneration, kEpoch, &applied));
+  EXPECT_EQ(3U, applied.get_last_active_entry());
+  EXPECT_EQ(lock_ids[0], applied.get_entry(1U)->universal_lock_id_);
+  EXPECT_EQ(lock_ids[1], applied.get_entry(2U)->universal_lock_id_);
+  EXPECT_EQ(lock_ids[3], applied.get_entry(3U)->universal_lock_id_);
+  EXPECT_EQ(lock_addresses[0], applied.get_entry(1U)->lock_);
+  EXPECT_EQ(lock_addresses[3], applied.get_entry(3U)->lock_);
+  EXPECT_EQ(kReadLock, applied.get_entry(1U)->preferred_mode_);
+  EXPECT_EQ(kWriteLock, applied.get_entry(3U)->preferred_mode_);
+  EXPECT_EQ(kNoLock, applied.get_entry(3U)->taken_mode_);
+  applied.clear_entries();
+
+  // Profiles learned before XctManager paused transactions are not used
+  EXPECT_FALSE(cache.apply(kProfileA, kGeneration + 1U, kEpoch, &applied));
+  EXPECT_TRUE(applied.is_empty());
+
+  // Entries are used in the next epoch, but not after that as their pages might be recycled
+  EXPECT_TRUE(cache.apply(kProfileA, kGeneration, kEpoch.one_more(), &applied));
+  EXPECT_EQ(3U, applied.get_last_active_entry());
+  applied.clear_entries();
+  EXPECT_FALSE(cache.apply(kProfileA, kGeneration, kEpoch.one_more().one_more(), &applied));
+  EXPECT_TRUE(applied.is_empty());
+
+  // B and then C recycle the least recently used profile, A.
+  cache.learn_from_abort(kProfileB, kGeneration, kEpoch, rll);
+  EXPECT_EQ(3U, cache.get_entry_count(kProfileA));
+  EXPECT_EQ(2U, cache.get_entry_count(kProfileB));
+  cache.learn_from_abort(kProfileC, kGeneration, kEpoch, rll);
+  EXPECT_EQ(0U, cache.get_entry_count(kProfileA));
+  EXPECT_EQ(2U, cache.get_entry_count(kProfileB));
+  EXPECT_EQ(2U, cache.get_entry_count(kProfileC));
+
+  // Learning two epochs later removes the expired entries and renews the relearned ones.
+  // rll is [0(R), 3(R)] and the profile C has the same entries. Now it learns only [3(R)]
+  const Epoch kLaterEpoch = kEpoch.one_more().one_more();
+  aborted[0] = aborted[1];
+  rll.construct_from_learned(aborted, 1U, 0, Epoch());
+  cache.learn_from_abort(kProfileC, kGeneration, kLaterEpoch, rll);
+  EXPECT_EQ(1U, cache.get_entry_count(kProfileC));
+  EXPECT_TRUE(cache.apply(kProfileC, kGeneration, kLaterEpoch, &applied));
+  EXPECT_EQ(1U, applied.get_last_active_entry());
+  EXPECT_EQ(lock_ids[3], applied.get_entry(1U)->universal_lock_id_);
+}
 
 }  // namespace xct
 }  // namespace foedus
@@ -37,6 +37,7 @@
 #include "foedus/thread/rendezvous_impl.hpp"
 #include "foedus/thread/thread.hpp"
 #include "foedus/thread/thread_pool.hpp"
+#include "foedus/xct/xct.hpp"
 #include "foedus/xct/xct_access.hpp"
 #include "foedus/xct/xct_id.hpp"
 #include "foedus/xct/xct_manager.hpp"
@@ -211,6 +212,77 @@ void test_main(ASSIGN_FUNC assign_func) {
   cleanup_test(options);
 }
 
+/** The reader's first read is clobbered by the writer. The second read should abort early. */
+ErrorStack early_reader_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  ASSERT_ND(args.output_buffer_size_ >= sizeof(ErrorCode));
+  *args.output_used_ = sizeof(ErrorCode);
+  void* user_memory
+    = context->get_engine()->get_soc_manager()->get_shared_memory_repo()->get_global_user_memory();
+  soc::SharedRendezvous* rendezvous = reinterpret_cast<soc::SharedRendezvous*>(user_memory);
+  xct::XctManager* xct_manager = context->get_engine()->get_xct_manager();
+  storage::array::ArrayStorage storage
+    = context->get_engine()->get_storage_manager()->get_array("test");
+  context->get_current_xct().set_early_validation_interval(1U);
+  CHECK_ERROR(xct_manager->begin_xct(context, kSerializable));
+  Payload payload;
+  CHECK_ERROR(storage.get_record(context, 0, &payload));
+  rendezvous[0].signal();
+  rendezvous[1].wait();
+  ErrorCode ret = storage.get_record(context, 1, &payload);
+  *reinterpret_cast<ErrorCode*>(args.output_buffer_) = ret;
+  CHECK_ERROR(xct_manager->abort_xct(context));
+  return kRetOk;
+}
+
+ErrorStack early_writer_task(const proc::ProcArguments& args) {
+  thread::Thread* context = args.context_;
+  void* user_memory
+    = context->get_engine()->get_soc_manager()->get_shared_memory_repo()->get_global_user_memory();
+  soc::SharedRendezvous* rendezvous = reinterpret_cast<soc::SharedRendezvous*>(user_memory);
+  storage::array::ArrayStorage storage
+    = context->get_engine()->get_storage_manager()->get_array("test");
+  rendezvous[0].wait();
+  CHECK_ERROR(try_transaction(context, &storage, 0, 1));
+  rendezvous[1].signal();
+  return kRetOk;
+}
+
+TEST(XctCommitConflictTest, EarlyValidation) {
+  EngineOptions options = get_tiny_options();
+  options.thread_.thread_count_per_group_ = 2;
+  Engine engine(options);
+  engine.get_proc_manager()->pre_register("init_task", init_task);
+  engine.get_proc_manager()->pre_register("early_reader_task", early_reader_task);
+  engine.get_proc_manager()->pre_register("early_writer_task", early_writer_task);
+  COERCE_ERROR(engine.initialize());
+  {
+    UninitializeGuard guard(&engine);
+    COERCE_ERROR(engine.get_thread_pool()->impersonate_synchronous("init_task"));
+    soc::SharedRendezvous* rendezvous
+      = reinterpret_cast<soc::SharedRendezvous*>(
+        engine.get_soc_manager()->get_shared_memory_repo()->get_global_user_memory());
+    rendezvous[0].initialize();
+    rendezvous[1].initialize();
+    thread::ImpersonateSession reader;
+    thread::ImpersonateSession writer;
+    EXPECT_TRUE(engine.get_thread_pool()->impersonate("early_reader_task", nullptr, 0, &reader));
+    EXPECT_TRUE(engine.get_thread_pool()->impersonate("early_writer_task", nullptr, 0, &writer));
+    COERCE_ERROR(writer.get_result());
+    COERCE_ERROR(reader.get_result());
+    EXPECT_EQ(sizeof(ErrorCode), reader.get_output_size());
+    ErrorCode ret;
+    reader.get_output(&ret);
+    EXPECT_EQ(kErrorCodeXctRaceAbort, ret);
+    reader.release();
+    writer.release();
+    rendezvous[0].uninitialize();
+    rendezvous[1].uninitialize();
+    COERCE_ERROR(engine.uninitialize());
+  }
+  cleanup_test(options);
+}
+
 TEST(XctCommitConflictTest, NoConflict) {
   test_main([] (int i) { return i; } );  // no conflict
 }
@@ -539,6 +539,91 @@ struct Runner {
       sessions[i].join();
     }
   }
+
+  void cohort_task(
+    McsMockContext<RW_BLOCK>* con,
+    thread::ThreadId id,
+    std::atomic<int>* seq,
+    int* order) {
+    McsMockAdaptor<RW_BLOCK> adaptor(id, con);
+    McsImpl< McsMockAdaptor<RW_BLOCK> , RW_BLOCK> impl(adaptor);
+    McsRwLock* lock = &con->get_rw_lock_address(kDefaultNodeId, 0)->lock_;
+    McsBlockIndex block = impl.acquire_unconditional_rw_writer(lock);
+    *order = ++(*seq);
+    impl.release_rw_writer(lock, block);
+  }
+
+  void test_cohort() {
+    // This needs two nodes, so we use a separate context
+    McsMockContext<RW_BLOCK> con;
+    con.init(kDummyStorageId, 2U, 3U, kMaxBlocks, kKeys);
+    con.cohort_bypass_bound_ = 1U;
+    McsRwLock* lock = &con.get_rw_lock_address(kDefaultNodeId, 0)->lock_;
+    lock->reset();
+    // A writer on node-0 holds the lock while these writers queue up in this order.
+    const int kWaiters = 4;
+    const thread::ThreadId waiters[kWaiters] = {
+      thread::compose_thread_id(1U, 0),  // remote
+      thread::compose_thread_id(0, 1U),  // local
+      thread::compose_thread_id(0, 2U),  // local
+      thread::compose_thread_id(1U, 1U),  // remote
+    };
+    McsMockAdaptor<RW_BLOCK> adaptor(thread::compose_thread_id(0, 0), &con);
+    McsImpl< McsMockAdaptor<RW_BLOCK> , RW_BLOCK> impl(adaptor);
+    McsBlockIndex block = impl.acquire_unconditional_rw_writer(lock);
+    std::atomic<int> seq(0);
+    int order[kWaiters];
+    std::vector<std::thread> sessions;
+    for (int i = 0; i < kWaiters; ++i) {
+      sessions.emplace_back(&Runner::cohort_task, this, &con, waiters[i], &seq, order + i);
+      sleep_enough();
+    }
+    impl.release_rw_writer(lock, block);
+    for (int i = 0; i < kWaiters; ++i) {
+      sessions[i].join();
+    }
+    // The first local waiter bypasses the first remote waiter, which can't be bypassed again.
+    EXPECT_EQ(2, order[0]);
+    EXPECT_EQ(1, order[1]);
+    EXPECT_EQ(3, order[2]);
+    EXPECT_EQ(4, order[3]);
+    EXPECT_FALSE(lock->is_locked());
+  }
+
+  void biased_writer_task(std::atomic<bool>* acquired) {
+    McsMockAdaptor<RW_BLOCK> adaptor(thread::compose_thread_id(0, 1U), &context);
+    McsImpl< McsMockAdaptor<RW_BLOCK> , RW_BLOCK> impl(adaptor);
+    McsBlockIndex block = impl.acquire_unconditional_rw_writer(get_lock(0));
+    *acquired = true;
+    impl.release_rw_writer(get_lock(0), block);
+  }
+
+  void test_biased_read() {
+    init();
+    context.reader_bias_threshold_ = 0;
+    McsMockAdaptor<RW_BLOCK> reader_adaptor(thread::compose_thread_id(kNodes - 1U, 0), &context);
+    McsImpl< McsMockAdaptor<RW_BLOCK> , RW_BLOCK> reader(reader_adaptor);
+    McsBlockIndex block = reader.acquire_unconditional_rw_reader(get_lock(0));
+    EXPECT_TRUE(is_biased_read_block(block));
+    // Reader-biased locks don't touch the lock word
+    EXPECT_FALSE(get_lock(0)->is_locked());
+
+    // Try-writers see the reader and give up
+    McsMockAdaptor<RW_BLOCK> try_adaptor(thread::compose_thread_id(0, 2U), &context);
+    McsImpl< McsMockAdaptor<RW_BLOCK> , RW_BLOCK> try_writer(try_adaptor);
+    EXPECT_EQ(0, try_writer.acquire_try_rw_writer(get_lock(0)));
+    EXPECT_FALSE(get_lock(0)->is_locked());
+
+    // Unconditional writers wait for the reader
+    std::atomic<bool> acquired(false);
+    std::thread writer(&Runner::biased_writer_task, this, &acquired);
+    sleep_enough();
+    EXPECT_FALSE(acquired);
+    reader.release_rw_reader(get_lock(0), block);
+    writer.join();
+    EXPECT_TRUE(acquired);
+    EXPECT_FALSE(get_lock(0)->is_locked());
+  }
 };
 
 TEST(XctMcsImplTest, InstantiateSimple) { Runner<McsRwSimpleBlock>::test_instantiate(); }
@@ -558,6 +643,9 @@ TEST(XctMcsImplTest, NonCanonical2Extended) { Runner<McsRwExtendedBlock>().test_
 TEST(XctMcsImplTest, RandomSimple) { Runner<McsRwSimpleBlock>().test_random(); }
 TEST(XctMcsImplTest, RandomExtended) { Runner<McsRwExtendedBlock>().test_random(); }
 
+TEST(XctMcsImplTest, CohortSimple) { Runner<McsRwSimpleBlock>().test_cohort(); }
+TEST(XctMcsImplTest, BiasedReadSimple) { Runner<McsRwSimpleBlock>().test_biased_read(); }
+
 TEST(XctMcsImplTest, AsyncReadOnlySimple) { Runner<McsRwSimpleBlock>().test_async_read_only(); }
 TEST(XctMcsImplTest, AsyncReadOnlyExtended) { Runner<McsRwExtendedBlock>().test_async_read_only(); }
 
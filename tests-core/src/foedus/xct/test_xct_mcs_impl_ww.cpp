@@ -289,6 +289,56 @@ struct Runner {
       sessions[i].join();
     }
   }
+
+  void cohort_task(
+    McsMockContext<McsRwSimpleBlock>* con,
+    thread::ThreadId id,
+    std::atomic<int>* seq,
+    int* order) {
+    McsMockAdaptor<McsRwSimpleBlock> adaptor(id, con);
+    McsWwImpl< McsMockAdaptor<McsRwSimpleBlock> > impl(adaptor);
+    McsWwLock* lock = con->get_ww_lock_address(kDefaultNodeId, 0);
+    McsBlockIndex block = impl.acquire_unconditional(lock);
+    *order = ++(*seq);
+    impl.release(lock, block);
+  }
+
+  void test_cohort() {
+    // This needs two nodes, so we use a separate context
+    McsMockContext<McsRwSimpleBlock> con;
+    con.init(kDummyStorageId, 2U, 3U, 1U << 16, kKeys);
+    con.cohort_bypass_bound_ = 1U;
+    McsWwLock* lock = con.get_ww_lock_address(kDefaultNodeId, 0);
+    lock->reset();
+    // A thread on node-0 holds the lock while these threads queue up in this order.
+    const int kWaiters = 4;
+    const thread::ThreadId waiters[kWaiters] = {
+      thread::compose_thread_id(1U, 0),  // remote
+      thread::compose_thread_id(0, 1U),  // local
+      thread::compose_thread_id(0, 2U),  // local
+      thread::compose_thread_id(1U, 1U),  // remote
+    };
+    McsMockAdaptor<McsRwSimpleBlock> adaptor(thread::compose_thread_id(0, 0), &con);
+    McsWwImpl< McsMockAdaptor<McsRwSimpleBlock> > impl(adaptor);
+    McsBlockIndex block = impl.acquire_unconditional(lock);
+    std::atomic<int> seq(0);
+    int order[kWaiters];
+    std::vector<std::thread> sessions;
+    for (int i = 0; i < kWaiters; ++i) {
+      sessions.emplace_back(&Runner::cohort_task, this, &con, waiters[i], &seq, order + i);
+      sleep_enough();
+    }
+    impl.release(lock, block);
+    for (int i = 0; i < kWaiters; ++i) {
+      sessions[i].join();
+    }
+    // The first local waiter bypasses the first remote waiter, which can't be bypassed again.
+    EXPECT_EQ(2, order[0]);
+    EXPECT_EQ(1, order[1]);
+    EXPECT_EQ(3, order[2]);
+    EXPECT_EQ(4, order[3]);
+    EXPECT_FALSE(lock->is_locked());
+  }
 };
 
 TEST(XctMcsImplWwTest, Instantiate) { Runner::test_instantiate(); }
@@ -296,6 +346,7 @@ TEST(XctMcsImplWwTest, NoConflict) { Runner().test_no_conflict(); }
 TEST(XctMcsImplWwTest, Conflict) { Runner().test_conflict(); }
 TEST(XctMcsImplWwTest, Initial) { Runner().test_initial(); }
 TEST(XctMcsImplWwTest, Random) { Runner().test_random(); }
+TEST(XctMcsImplWwTest, Cohort) { Runner().test_cohort(); }
 
 }  // namespace xct
 }  // namespace foedus